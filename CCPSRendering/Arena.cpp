@@ -0,0 +1,137 @@
+/**
+	@file
+	@brief Per-page bump allocator for the captured page data
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "Arena.h"
+
+/// Alignment of all allocations
+#define ARENA_ALIGN		8
+
+/**
+	@param nBlockSize Size of each memory block
+*/
+PageArena::PageArena(size_t nBlockSize /* = DEFAULT_BLOCK_SIZE */) : m_nBlockSize(nBlockSize), m_pFirst(NULL), m_pCurrent(NULL), m_pPos(NULL), m_pEnd(NULL), m_nBlockAllocations(0)
+{
+}
+
+/**
+	
+*/
+PageArena::~PageArena()
+{
+	// Free all the blocks
+	while (m_pFirst != NULL)
+	{
+		Block* pNext = m_pFirst->pNext;
+		delete [] (char*)m_pFirst;
+		m_pFirst = pNext;
+	}
+}
+
+/**
+	@param nSize Size of the memory to allocate
+	@return Pointer to the allocated memory
+*/
+void* PageArena::Alloc(size_t nSize)
+{
+	// Keep everything aligned
+	nSize = (nSize + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if ((size_t)(m_pEnd - m_pPos) < nSize)
+		NextBlock(nSize);
+
+	void* pRet = m_pPos;
+	m_pPos += nSize;
+	return pRet;
+}
+
+/**
+	
+*/
+void PageArena::Reset()
+{
+	// Start again from the first block
+	m_pCurrent = m_pFirst;
+	if (m_pCurrent == NULL)
+	{
+		m_pPos = NULL;
+		m_pEnd = NULL;
+	}
+	else
+	{
+		m_pPos = (char*)(m_pCurrent + 1);
+		m_pEnd = m_pPos + m_pCurrent->nSize;
+	}
+}
+
+/**
+	@param other The arena to swap with
+
+	Anything allocated from either arena now belongs to the other one.
+*/
+void PageArena::Swap(PageArena& other)
+{
+	std::swap(m_nBlockSize, other.m_nBlockSize);
+	std::swap(m_pFirst, other.m_pFirst);
+	std::swap(m_pCurrent, other.m_pCurrent);
+	std::swap(m_pPos, other.m_pPos);
+	std::swap(m_pEnd, other.m_pEnd);
+	std::swap(m_nBlockAllocations, other.m_nBlockAllocations);
+}
+
+/**
+	@param nSize Size of the memory that must fit in the block
+*/
+void PageArena::NextBlock(size_t nSize)
+{
+	// Can we use one of the blocks we already have?
+	Block* pPrev = m_pCurrent;
+	Block* pBlock = (m_pCurrent == NULL) ? m_pFirst : m_pCurrent->pNext;
+	while ((pBlock != NULL) && (pBlock->nSize < nSize))
+	{
+		// Too small for this one; it will be used later
+		pPrev = pBlock;
+		pBlock = pBlock->pNext;
+	}
+
+	if (pBlock == NULL)
+	{
+		// No, allocate a new one at the end of the chain
+		size_t nBlockSize = (nSize > m_nBlockSize) ? nSize : m_nBlockSize;
+		pBlock = (Block*)new char[sizeof(Block) + nBlockSize];
+		pBlock->pNext = NULL;
+		pBlock->nSize = nBlockSize;
+		m_nBlockAllocations++;
+		if (pPrev == NULL)
+			m_pFirst = pBlock;
+		else
+			pPrev->pNext = pBlock;
+	}
+
+	// Allocate from the new block
+	m_pCurrent = pBlock;
+	m_pPos = (char*)(m_pCurrent + 1);
+	m_pEnd = m_pPos + m_pCurrent->nSize;
+}
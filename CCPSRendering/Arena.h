@@ -0,0 +1,222 @@
+/**
+	@file
+	@brief Per-page bump allocator for the captured page data
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <string.h>
+#include <algorithm>
+
+/**
+    @brief Bump allocator: hands out memory from large blocks, and releases it all at once
+
+	Reset() makes all the memory available again without freeing the blocks, so after the first
+	few pages of a print job no more heap allocations are needed.
+*/
+class PageArena
+{
+public:
+	/// Default size of each memory block
+	enum {DEFAULT_BLOCK_SIZE = 64 * 1024};
+
+	// Ctors
+	/// Constructor
+	PageArena(size_t nBlockSize = DEFAULT_BLOCK_SIZE);
+	/// Destructor
+	~PageArena();
+
+protected:
+	/**
+		@brief Header of a memory block (the memory follows it)
+	*/
+	struct Block
+	{
+		/// Next block in the chain
+		Block*			pNext;
+		/// Usable size of the block
+		size_t			nSize;
+	};
+
+	// Members
+	/// Size of new blocks
+	size_t				m_nBlockSize;
+	/// First block in the chain
+	Block*				m_pFirst;
+	/// Block currently allocated from
+	Block*				m_pCurrent;
+	/// Next free byte in the current block
+	char*				m_pPos;
+	/// End of the current block
+	char*				m_pEnd;
+	/// Amount of blocks allocated from the heap
+	size_t				m_nBlockAllocations;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the amount of heap allocations the arena made so far
+		@return Number of blocks allocated
+	*/
+	size_t				GetBlockAllocations() const {return m_nBlockAllocations;};
+
+	// Methods
+	/// Allocates memory (aligned for any built-in type)
+	void*				Alloc(size_t nSize);
+	/// Makes all the memory available again (keeps the blocks)
+	void				Reset();
+	/// Exchanges the memory of two arenas
+	void				Swap(PageArena& other);
+
+protected:
+	// Helpers
+	/// Moves to the next block that can hold the requested size, allocating it if needed
+	void				NextBlock(size_t nSize);
+
+private:
+	/// Not copyable
+	PageArena(const PageArena&);
+	/// Not copyable
+	PageArena& operator=(const PageArena&);
+};
+
+/**
+    @brief Growing array of simple (POD) elements, allocated from a PageArena
+
+	When the array grows the old memory is abandoned in the arena; it is reclaimed when the arena is reset,
+	so the array must be reset together with its arena.
+*/
+template <class T>
+class ArenaArray
+{
+public:
+	// Ctors
+	/**
+		@brief Default constructor
+	*/
+	ArenaArray() : m_pData(NULL), m_nSize(0), m_nCapacity(0) {};
+
+protected:
+	// Members
+	/// The elements
+	T*					m_pData;
+	/// Amount of elements used
+	size_t				m_nSize;
+	/// Amount of elements allocated
+	size_t				m_nCapacity;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the amount of elements in the array
+		@return Number of elements
+	*/
+	size_t				size() const {return m_nSize;};
+	/**
+		@brief Checks if the array has any elements
+		@return true if the array is empty, false if not
+	*/
+	bool				empty() const {return m_nSize == 0;};
+	/**
+		@brief Returns the elements
+		@return Pointer to the first element
+	*/
+	T*					data() {return m_pData;};
+	/**
+		@brief Returns the elements
+		@return Pointer to the first element
+	*/
+	const T*			data() const {return m_pData;};
+	/**
+		@brief Element access
+		@param n Index of the element
+		@return The element
+	*/
+	T&					operator[](size_t n) {return m_pData[n];};
+	/**
+		@brief Element access
+		@param n Index of the element
+		@return The element
+	*/
+	const T&			operator[](size_t n) const {return m_pData[n];};
+	/**
+		@brief Returns the last element
+		@return The element
+	*/
+	T&					back() {return m_pData[m_nSize - 1];};
+
+	// Methods
+	/**
+		@brief Adds elements at the end of the array
+		@param arena The arena to allocate from
+		@param nCount Amount of elements to add
+		@return Pointer to the first added element (uninitialized)
+	*/
+	T*					Grow(PageArena& arena, size_t nCount)
+	{
+		if (m_nSize + nCount > m_nCapacity)
+		{
+			// Double the size (at least), and move the data to the new place
+			size_t nCapacity = (m_nCapacity < 64) ? 64 : m_nCapacity * 2;
+			if (nCapacity < m_nSize + nCount)
+				nCapacity = m_nSize + nCount;
+			T* pData = (T*)arena.Alloc(nCapacity * sizeof(T));
+			if (m_nSize > 0)
+				memcpy(pData, m_pData, m_nSize * sizeof(T));
+			m_pData = pData;
+			m_nCapacity = nCapacity;
+		}
+		T* pRet = m_pData + m_nSize;
+		m_nSize += nCount;
+		return pRet;
+	};
+	/**
+		@brief Adds an element at the end of the array
+		@param arena The arena to allocate from
+		@param t The element to add
+	*/
+	void				push_back(PageArena& arena, const T& t) {*Grow(arena, 1) = t;};
+	/**
+		@brief Removes elements from the end of the array
+		@param nSize The new size of the array
+	*/
+	void				resize(size_t nSize) {if (nSize < m_nSize) m_nSize = nSize;};
+	/**
+		@brief Removes an element from the array, moving the following elements back
+		@param n Index of the element to remove
+	*/
+	void				erase(size_t n) {memmove(m_pData + n, m_pData + n + 1, (m_nSize - n - 1) * sizeof(T)); m_nSize--;};
+	/**
+		@brief Forgets the array data; call when (or before) the arena is reset
+	*/
+	void				Reset() {m_pData = NULL; m_nSize = 0; m_nCapacity = 0;};
+	/**
+		@brief Exchanges the data of two arrays (swap their arenas too)
+		@param other The array to swap with
+	*/
+	void				Swap(ArenaArray<T>& other) {std::swap(m_pData, other.m_pData); std::swap(m_nSize, other.m_nSize); std::swap(m_nCapacity, other.m_nCapacity);};
+};
+
+#endif   //#define _ARENA_H_
@@ -0,0 +1,377 @@
+/**
+	@file
+	@brief Process-wide cache of glyph translation tables
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include <wctype.h>
+#include "debug.h"
+#include "GlyphCache.h"
+
+/// FNV-1a hash start value
+#define HASH_START		2166136261UL
+/// FNV-1a hash multiplier
+#define HASH_PRIME		16777619UL
+
+/// The process-wide cache
+static GlyphCache s_cache;
+
+/**
+	@param lf Font description
+*/
+FontKey::FontKey(const LOGFONT& lf) : lWeight(lf.lfWeight), bItalic(lf.lfItalic ? 1 : 0), bCharSet(lf.lfCharSet), bPitchAndFamily(lf.lfPitchAndFamily)
+{
+	// Face names are not case sensitive
+	memset(cFace, 0, sizeof(cFace));
+	for (int i = 0; (i < LF_FACESIZE - 1) && (lf.lfFaceName[i] != '\0'); i++)
+		cFace[i] = (WCHAR)towlower(lf.lfFaceName[i]);
+
+	// Hash it all
+	dwHash = HASH_START;
+	for (int i = 0; cFace[i] != '\0'; i++)
+		dwHash = (dwHash ^ cFace[i]) * HASH_PRIME;
+	dwHash = (dwHash ^ (DWORD)lWeight) * HASH_PRIME;
+	dwHash = (dwHash ^ bItalic) * HASH_PRIME;
+	dwHash = (dwHash ^ bCharSet) * HASH_PRIME;
+	dwHash = (dwHash ^ bPitchAndFamily) * HASH_PRIME;
+}
+
+/**
+	@param other The key to compare to
+	@return true if both keys are of the same font, false if not
+*/
+bool FontKey::operator==(const FontKey& other) const
+{
+	return (dwHash == other.dwHash) && (lWeight == other.lWeight) && (bItalic == other.bItalic) && (bCharSet == other.bCharSet) &&
+		(bPitchAndFamily == other.bPitchAndFamily) && (wcscmp(cFace, other.cFace) == 0);
+}
+
+/**
+	@param nMaxSize Memory limit for the cached tables
+*/
+GlyphCache::GlyphCache(size_t nMaxSize /* = DEFAULT_MAX_SIZE */) : m_pRetired(NULL), m_nReaders(0), m_nMaxSize(nMaxSize), m_nSize(0), m_nEntries(0), m_nHits(0), m_nMisses(0), m_nWaits(0)
+{
+	for (int i = 0; i < BUCKETS; i++)
+		m_pBuckets[i] = NULL;
+	::InitializeCriticalSection(&m_cs);
+}
+
+/**
+	
+*/
+GlyphCache::~GlyphCache()
+{
+	// Free everything
+	for (int i = 0; i < BUCKETS; i++)
+	{
+		while (m_pBuckets[i] != NULL)
+		{
+			GlyphCacheEntry* pEntry = m_pBuckets[i];
+			m_pBuckets[i] = pEntry->m_pNext;
+			delete pEntry;
+		}
+	}
+	while (m_pRetired != NULL)
+	{
+		GlyphCacheEntry* pEntry = m_pRetired;
+		m_pRetired = pEntry->m_pNextRetired;
+		delete pEntry;
+	}
+	::DeleteCriticalSection(&m_cs);
+}
+
+/**
+	@return The cache object
+*/
+GlyphCache& GlyphCache::Instance()
+{
+	return s_cache;
+}
+
+/**
+	@param lf Font description
+	@param hDC Handle to the DC to use for translation (if NULL, uses the default screen DC)
+	@return The cache entry (call Release when done with it); its table is NULL if the font cannot be translated
+
+	If another thread is building the font's table, waits for it to be done.
+*/
+const GlyphCacheEntry* GlyphCache::Acquire(const LOGFONT& lf, HDC hDC /* = NULL */)
+{
+	// Do we have it?
+	FontKey key(lf);
+	GlyphCacheEntry* pEntry = Find(key);
+	if (pEntry == NULL)
+	{
+		::EnterCriticalSection(&m_cs);
+		// Someone may have added it while we waited for the lock
+		pEntry = Find(key);
+		bool bBuild = (pEntry == NULL);
+		if (bBuild)
+			// No, add it (others will wait for us to build it)
+			pEntry = Create(key);
+		Reclaim();
+		::LeaveCriticalSection(&m_cs);
+
+		if (bBuild)
+		{
+			::InterlockedIncrement(&m_nMisses);
+			Build(pEntry, lf, hDC);
+			return pEntry;
+		}
+	}
+
+	::InterlockedIncrement(&m_nHits);
+	Wait(pEntry);
+	return pEntry;
+}
+
+/**
+	@param pEntry The entry to let go of
+*/
+void GlyphCache::Release(const GlyphCacheEntry* pEntry)
+{
+	if (pEntry != NULL)
+		::InterlockedDecrement(&((GlyphCacheEntry*)pEntry)->m_nRefs);
+}
+
+/**
+	@return true if the tables were saved (or there was nothing to save), false if failed
+*/
+bool GlyphCache::Save()
+{
+	::EnterCriticalSection(&m_cs);
+	bool bRet = m_disk.Flush();
+	::LeaveCriticalSection(&m_cs);
+	return bRet;
+}
+
+/**
+	@param key The font to search for
+	@return The entry of the font (held), or NULL if not in the cache
+*/
+GlyphCacheEntry* GlyphCache::Find(const FontKey& key)
+{
+	// Let the writers know we're traversing the lists
+	::InterlockedIncrement(&m_nReaders);
+	GlyphCacheEntry* pEntry;
+	for (pEntry = m_pBuckets[key.dwHash % BUCKETS]; pEntry != NULL; pEntry = pEntry->m_pNext)
+	{
+		if (pEntry->m_key == key)
+		{
+			// Found it, hold it
+			::InterlockedIncrement(&pEntry->m_nRefs);
+			pEntry->m_dwLastUse = ::GetTickCount();
+			break;
+		}
+	}
+	::InterlockedDecrement(&m_nReaders);
+	return pEntry;
+}
+
+/**
+	@param key The font identity
+	@return The new entry (held; call Build to create its table)
+
+	Must be called with the lock held.
+*/
+GlyphCacheEntry* GlyphCache::Create(const FontKey& key)
+{
+	GlyphCacheEntry* pEntry = new GlyphCacheEntry(key);
+	pEntry->m_nRefs = 1;
+	pEntry->m_dwLastUse = ::GetTickCount();
+	pEntry->m_hReady = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+	pEntry->m_nSize = sizeof(GlyphCacheEntry);
+
+	// Publish it at the head of its bucket (the exchange makes sure it's complete before it can be seen)
+	GlyphCacheEntry* volatile* ppBucket = &m_pBuckets[key.dwHash % BUCKETS];
+	pEntry->m_pNext = *ppBucket;
+	::InterlockedExchangePointer((PVOID volatile*)ppBucket, pEntry);
+	m_nSize += pEntry->m_nSize;
+	m_nEntries++;
+	return pEntry;
+}
+
+/**
+	@param pEntry The entry (created by this thread with Create, and not built yet)
+	@param lf Font description
+	@param hDC Handle to the DC to use for translation (if NULL, uses the default screen DC)
+
+	Called without the lock: the lock is only taken for the disk cache. If the table cannot be built, the
+	lookups waiting for it get no table, but the entry is removed from the cache so the next lookup tries again.
+*/
+void GlyphCache::Build(GlyphCacheEntry* pEntry, const LOGFONT& lf, HDC hDC)
+{
+	// Create the translation table
+	GlyphToText* pTable = NULL;
+	FontPrint print;
+	bool bPrint = false, bStore = false;
+	HDC hUseDC = (hDC == NULL) ? ::GetDC(NULL) : hDC;
+	if (hUseDC != NULL)
+	{
+		pTable = new GlyphToText;
+		// Maybe an earlier process already built it?
+		bPrint = GlyphDiskCache::GetFontPrint(lf, hUseDC, print);
+		bool bFound = false;
+		if (bPrint)
+		{
+			::EnterCriticalSection(&m_cs);
+			bFound = m_disk.Find(pEntry->m_key, print, *pTable);
+			::LeaveCriticalSection(&m_cs);
+		}
+		if (!bFound)
+		{
+			if (pTable->Initialize(lf, hUseDC))
+				// Let the next processes use it too (only fonts we can fingerprint)
+				bStore = bPrint;
+			else
+			{
+				delete pTable;
+				pTable = NULL;
+			}
+		}
+		if (hUseDC != hDC)
+			::ReleaseDC(NULL, hUseDC);
+	}
+	size_t nTableSize = (pTable == NULL) ? 0 : pTable->GetMemorySize();
+	VERBOSE(DLLTEXT("GlyphCache: created table for %s (%d bytes)\r\n"), pEntry->m_key.cFace, nTableSize);
+
+	::EnterCriticalSection(&m_cs);
+	if (bStore)
+		m_disk.Store(pEntry->m_key, print, *pTable);
+	if (pTable == NULL)
+	{
+		// Don't keep the failure: the DC or the font may work next time
+		GlyphCacheEntry* volatile* ppEntry = &m_pBuckets[pEntry->m_key.dwHash % BUCKETS];
+		while ((*ppEntry != NULL) && (*ppEntry != pEntry))
+			ppEntry = &(*ppEntry)->m_pNext;
+		if (*ppEntry != NULL)
+			Retire(ppEntry);
+	}
+	else
+	{
+		pEntry->m_nSize += nTableSize;
+		m_nSize += nTableSize;
+		// Keep the memory in check
+		Trim();
+	}
+	::LeaveCriticalSection(&m_cs);
+
+	// Let the waiting lookups have it (the exchange makes sure the table is set before it's seen as ready)
+	pEntry->m_pTable = pTable;
+	::InterlockedExchange(&pEntry->m_bReady, 1);
+	if (pEntry->m_hReady != NULL)
+		::SetEvent(pEntry->m_hReady);
+}
+
+/**
+	@param pEntry The entry (held by the caller)
+*/
+void GlyphCache::Wait(GlyphCacheEntry* pEntry)
+{
+	if (pEntry->m_bReady != 0)
+		return;
+
+	::InterlockedIncrement(&m_nWaits);
+	if (pEntry->m_hReady != NULL)
+		::WaitForSingleObject(pEntry->m_hReady, INFINITE);
+	else
+	{
+		// No event, so poll
+		while (pEntry->m_bReady == 0)
+			::Sleep(1);
+	}
+}
+
+/**
+	Must be called with the lock held.
+*/
+void GlyphCache::Trim()
+{
+	DWORD dwNow = ::GetTickCount();
+	while (m_nSize > m_nMaxSize)
+	{
+		// Find the least recently used entry that nobody holds
+		GlyphCacheEntry* volatile* ppOldest = NULL;
+		DWORD dwOldestAge = 0;
+		for (int i = 0; i < BUCKETS; i++)
+		{
+			for (GlyphCacheEntry* volatile* ppEntry = &m_pBuckets[i]; *ppEntry != NULL; ppEntry = &(*ppEntry)->m_pNext)
+			{
+				GlyphCacheEntry* pEntry = *ppEntry;
+				if ((pEntry->m_nRefs == 0) && ((ppOldest == NULL) || (dwNow - pEntry->m_dwLastUse > dwOldestAge)))
+				{
+					ppOldest = ppEntry;
+					dwOldestAge = dwNow - pEntry->m_dwLastUse;
+				}
+			}
+		}
+		if (ppOldest == NULL)
+			// Everything is in use
+			break;
+
+		Retire(ppOldest);
+	}
+}
+
+/**
+	@param ppEntry The link to the entry in its bucket
+
+	Must be called with the lock held.
+*/
+void GlyphCache::Retire(GlyphCacheEntry* volatile* ppEntry)
+{
+	// Remove it from its bucket (lookups that are already on it can still move on from it)
+	GlyphCacheEntry* pEntry = *ppEntry;
+	::InterlockedExchangePointer((PVOID volatile*)ppEntry, pEntry->m_pNext);
+	m_nSize -= pEntry->m_nSize;
+	m_nEntries--;
+
+	// And free it when it's safe
+	pEntry->m_pNextRetired = m_pRetired;
+	m_pRetired = pEntry;
+}
+
+/**
+	Must be called with the lock held.
+*/
+void GlyphCache::Reclaim()
+{
+	// A running lookup may still be looking at a removed entry
+	if (m_nReaders != 0)
+		return;
+
+	// Free all the entries nobody holds anymore
+	GlyphCacheEntry** ppEntry = &m_pRetired;
+	while (*ppEntry != NULL)
+	{
+		GlyphCacheEntry* pEntry = *ppEntry;
+		if (pEntry->m_nRefs == 0)
+		{
+			*ppEntry = pEntry->m_pNextRetired;
+			delete pEntry;
+		}
+		else
+			ppEntry = &pEntry->m_pNextRetired;
+	}
+}
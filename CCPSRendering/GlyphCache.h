@@ -0,0 +1,225 @@
+/**
+	@file
+	@brief Process-wide cache of glyph translation tables
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _GLYPHCACHE_H_
+#define _GLYPHCACHE_H_
+
+#include "GlyphTranslator.h"
+#include "GlyphDiskCache.h"
+
+/**
+    @brief Identity of a font for glyph translation purposes
+
+	Only the parts of the font that select the actual font file are used: the size, underline and
+	strike-out don't change the glyphs.
+*/
+struct FontKey
+{
+	// Ctors
+	/// Constructor: from a font description
+	FontKey(const LOGFONT& lf);
+
+	// Members
+	/// Hash of all the other members
+	DWORD			dwHash;
+	/// The face name (lowercase)
+	WCHAR			cFace[LF_FACESIZE];
+	/// Font weight
+	LONG			lWeight;
+	/// Italic flag
+	BYTE			bItalic;
+	/// Character set
+	BYTE			bCharSet;
+	/// Pitch and family
+	BYTE			bPitchAndFamily;
+
+	// Operators
+	/// Comparison operator
+	bool operator==(const FontKey& other) const;
+};
+
+/**
+    @brief A cached translation table
+
+	Entries are added to the cache before their table is built, so other lookups of the same font
+	wait for the table instead of building it again.
+*/
+class GlyphCacheEntry
+{
+	friend class GlyphCache;
+public:
+	/**
+		@brief Returns the translation table
+		@return The table, or NULL if the font cannot be translated
+	*/
+	const GlyphToText*	GetTable() const {return m_pTable;};
+	/**
+		@brief Returns the font identity
+		@return The font key
+	*/
+	const FontKey&		GetKey() const {return m_key;};
+
+protected:
+	/// Constructor
+	GlyphCacheEntry(const FontKey& key) : m_key(key), m_pTable(NULL), m_bReady(0), m_hReady(NULL), m_nRefs(0), m_dwLastUse(0), m_nSize(0), m_pNext(NULL), m_pNextRetired(NULL) {};
+	/// Destructor
+	~GlyphCacheEntry() {if (m_pTable != NULL) delete m_pTable; if (m_hReady != NULL) ::CloseHandle(m_hReady);};
+
+	/// The font identity
+	FontKey				m_key;
+	/// The translation table (NULL if the font cannot be translated)
+	GlyphToText*		m_pTable;
+	/// Set to 1 once the table is built
+	volatile LONG		m_bReady;
+	/// Signaled once the table is built (NULL if could not be created: waiting lookups poll instead)
+	HANDLE				m_hReady;
+	/// Amount of users holding the entry
+	volatile LONG		m_nRefs;
+	/// Last time the entry was used (tick count)
+	volatile DWORD		m_dwLastUse;
+	/// Memory used by the entry
+	size_t				m_nSize;
+	/// Next entry in the hash bucket
+	GlyphCacheEntry* volatile	m_pNext;
+	/// Next entry in the list of removed entries
+	GlyphCacheEntry*	m_pNextRetired;
+};
+
+/**
+    @brief Process-wide cache of glyph translation tables, shared by all the print jobs
+
+	Lookups don't lock: the hash buckets are linked lists that are only changed with interlocked
+	operations, and entries removed from them are freed only when no lookup is running and nobody holds them.
+	Adding and removing entries is done under a critical section; tables are built outside it, so
+	a slow font doesn't hold up lookups of other fonts.
+	Entries are reference counted; when the tables take more than the memory limit, the least recently
+	used entries that nobody holds are removed.
+	New tables are first looked for in the disk cache (built by earlier processes), and the ones that
+	had to be built are added to it when Save is called.
+*/
+class GlyphCache
+{
+public:
+	/// Default memory limit
+	enum {DEFAULT_MAX_SIZE = 4 * 1024 * 1024};
+	/// Amount of hash buckets
+	enum {BUCKETS = 64};
+
+	// Ctors
+	/// Constructor
+	GlyphCache(size_t nMaxSize = DEFAULT_MAX_SIZE);
+	/// Destructor
+	~GlyphCache();
+
+protected:
+	// Members
+	/// The hash buckets
+	GlyphCacheEntry* volatile	m_pBuckets[BUCKETS];
+	/// Entries removed from the buckets, waiting to be freed
+	GlyphCacheEntry*	m_pRetired;
+	/// Lock for changes
+	CRITICAL_SECTION	m_cs;
+	/// Amount of lookups currently running
+	volatile LONG		m_nReaders;
+	/// Memory limit
+	size_t				m_nMaxSize;
+	/// Memory used by all the entries
+	size_t				m_nSize;
+	/// Amount of entries
+	size_t				m_nEntries;
+	/// Amount of lookups that found the table in the cache
+	volatile LONG		m_nHits;
+	/// Amount of lookups that had to create the table
+	volatile LONG		m_nMisses;
+	/// Amount of lookups that waited for a table being built by another thread
+	volatile LONG		m_nWaits;
+	/// The tables cache file
+	GlyphDiskCache		m_disk;
+
+public:
+	/// Returns the process-wide cache
+	static GlyphCache&	Instance();
+
+	// Data Access
+	/**
+		@brief Returns the amount of lookups that found the table in the cache
+		@return Number of hits
+	*/
+	LONG				GetHits() const {return m_nHits;};
+	/**
+		@brief Returns the amount of lookups that had to create the table
+		@return Number of misses
+	*/
+	LONG				GetMisses() const {return m_nMisses;};
+	/**
+		@brief Returns the amount of lookups that waited for a table being built by another thread
+		@return Number of waits
+	*/
+	LONG				GetWaits() const {return m_nWaits;};
+	/**
+		@brief Returns the memory used by the cached tables
+		@return Size in bytes
+	*/
+	size_t				GetSize() const {return m_nSize;};
+	/**
+		@brief Returns the amount of cached tables
+		@return Number of tables
+	*/
+	size_t				GetEntryCount() const {return m_nEntries;};
+
+	// Methods
+	/// Gets (and holds) the translation table of a font, creating it if needed
+	const GlyphCacheEntry*	Acquire(const LOGFONT& lf, HDC hDC = NULL);
+	/// Lets go of an entry received from Acquire
+	void				Release(const GlyphCacheEntry* pEntry);
+	/// Writes the newly built tables to the disk cache
+	bool				Save();
+
+protected:
+	// Helpers
+	/// Searches for a font in the cache (without locking), and holds it if found
+	GlyphCacheEntry*	Find(const FontKey& key);
+	/// Creates an entry for a font (with no table yet) and adds it to the cache
+	GlyphCacheEntry*	Create(const FontKey& key);
+	/// Builds the translation table of a new entry
+	void				Build(GlyphCacheEntry* pEntry, const LOGFONT& lf, HDC hDC);
+	/// Waits until an entry's table is built
+	void				Wait(GlyphCacheEntry* pEntry);
+	/// Removes least recently used entries until the cache is under the memory limit
+	void				Trim();
+	/// Removes an entry from the cache (it's freed by Reclaim once nobody holds it)
+	void				Retire(GlyphCacheEntry* volatile* ppEntry);
+	/// Frees removed entries that are not used anymore
+	void				Reclaim();
+
+private:
+	/// Not copyable
+	GlyphCache(const GlyphCache&);
+	/// Not copyable
+	GlyphCache& operator=(const GlyphCache&);
+};
+
+#endif   //#define _GLYPHCACHE_H_
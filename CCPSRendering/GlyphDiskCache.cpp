@@ -0,0 +1,522 @@
+/**
+	@file
+	@brief Glyph translation tables cache file, shared between processes
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include <algorithm>
+#include "debug.h"
+#include "CCTChar.h"
+#include "GlyphCache.h"
+#include "GlyphDiskCache.h"
+
+/// Name of a cache file generation (in the temporary folder)
+#define GLYPHCACHE_FILE			_T("CCGlyphMaps.%08X.dat")
+/// Search pattern of the cache file generations
+#define GLYPHCACHE_FILES		_T("CCGlyphMaps.*.dat")
+/// Length of the name up to the generation number
+#define GLYPHCACHE_FILE_PREFIX	12
+/// Name of the mutex that protects writing the cache file
+#define GLYPHCACHE_MUTEX		_T("CCPDFConverterGlyphCache")
+/// How long to wait for another process to finish writing the file (milliseconds)
+#define GLYPHCACHE_WAIT			5000
+/// Cache file signature ('CCGM')
+#define GLYPHCACHE_MAGIC		0x4D474343
+/// Cache file format version: change it whenever the format or the way tables are built changes
+#define GLYPHCACHE_VERSION		1
+/// Maximal size of the cache file (older tables are dropped beyond it)
+#define GLYPHCACHE_MAX_SIZE		(8 * 1024 * 1024)
+
+/// Tag of the TrueType 'head' table, as used by GetFontData
+#define TT_TAG_HEAD				0x64616568
+/// Offset of the checksum adjustment in the 'head' table
+#define TT_HEAD_CHECKSUM		8
+/// Offset of the modification date in the 'head' table
+#define TT_HEAD_MODIFIED		28
+
+/**
+    @brief Cache file header
+*/
+struct GlyphFileHeader
+{
+	/// File signature (GLYPHCACHE_MAGIC)
+	DWORD			dwMagic;
+	/// Format version (GLYPHCACHE_VERSION)
+	DWORD			dwVersion;
+	/// Amount of entries following the header
+	DWORD			dwCount;
+	/// Reserved (0)
+	DWORD			dwReserved;
+};
+
+/**
+    @brief Cache file entry: a font and the location of its table
+
+	The table data is the page index (256 WORDs) followed by the pages (dwPages * 256 WCHARs).
+*/
+struct GlyphFileEntry
+{
+	/// Hash of the font key
+	DWORD			dwHash;
+	/// The face name (lowercase)
+	WCHAR			cFace[LF_FACESIZE];
+	/// Font weight
+	LONG			lWeight;
+	/// Italic flag
+	BYTE			bItalic;
+	/// Character set
+	BYTE			bCharSet;
+	/// Pitch and family
+	BYTE			bPitchAndFamily;
+	/// Reserved (0)
+	BYTE			bReserved;
+	/// The fingerprint of the font file the table was built from
+	FontPrint		print;
+	/// Offset of the table data from the start of the file
+	DWORD			dwOffset;
+	/// Amount of pages in the table
+	DWORD			dwPages;
+};
+
+/**
+	@param dwPages Amount of pages in the table
+	@return Size of the table data in bytes
+*/
+static DWORD GetTableSize(DWORD dwPages)
+{
+	return 256 * sizeof(WORD) + dwPages * 256 * sizeof(WCHAR);
+}
+
+/**
+	@param entry The entry to fill
+	@param key The font identity
+*/
+static void SetEntryFont(GlyphFileEntry& entry, const FontKey& key)
+{
+	memset(&entry, 0, sizeof(entry));
+	entry.dwHash = key.dwHash;
+	memcpy(entry.cFace, key.cFace, sizeof(entry.cFace));
+	entry.lWeight = key.lWeight;
+	entry.bItalic = key.bItalic;
+	entry.bCharSet = key.bCharSet;
+	entry.bPitchAndFamily = key.bPitchAndFamily;
+}
+
+/**
+	@param entry1 First entry
+	@param entry2 Second entry
+	@return true if both entries are of the same font, false if not
+*/
+static bool IsSameFont(const GlyphFileEntry& entry1, const GlyphFileEntry& entry2)
+{
+	return (entry1.dwHash == entry2.dwHash) && (entry1.lWeight == entry2.lWeight) && (entry1.bItalic == entry2.bItalic) &&
+		(entry1.bCharSet == entry2.bCharSet) && (entry1.bPitchAndFamily == entry2.bPitchAndFamily) &&
+		(wcsncmp(entry1.cFace, entry2.cFace, LF_FACESIZE) == 0);
+}
+
+/**
+	@param pFile The file contents
+	@param dwSize Size of the file
+	@param[out] dwCount Amount of entries in the file
+	@return Pointer to the entries, or NULL if the file is not a valid cache file of this version
+*/
+static const GlyphFileEntry* GetFileEntries(const BYTE* pFile, DWORD dwSize, DWORD& dwCount)
+{
+	// Check out the header
+	if ((pFile == NULL) || (dwSize < sizeof(GlyphFileHeader)))
+		return NULL;
+	const GlyphFileHeader* pHeader = (const GlyphFileHeader*)pFile;
+	if ((pHeader->dwMagic != GLYPHCACHE_MAGIC) || (pHeader->dwVersion != GLYPHCACHE_VERSION))
+		return NULL;
+	if (pHeader->dwCount > (dwSize - sizeof(GlyphFileHeader)) / sizeof(GlyphFileEntry))
+		return NULL;
+
+	dwCount = pHeader->dwCount;
+	return (const GlyphFileEntry*)(pFile + sizeof(GlyphFileHeader));
+}
+
+/**
+	@param pFile The file contents
+	@param dwSize Size of the file
+	@param entry The entry of the table
+	@return Pointer to the table data, or NULL if the entry is not valid
+*/
+static const BYTE* GetEntryData(const BYTE* pFile, DWORD dwSize, const GlyphFileEntry& entry)
+{
+	if ((entry.dwPages == 0) || (entry.dwPages > 257) || ((entry.dwOffset % sizeof(WORD)) != 0))
+		return NULL;
+	if ((entry.dwOffset > dwSize) || (GetTableSize(entry.dwPages) > dwSize - entry.dwOffset))
+		return NULL;
+	return pFile + entry.dwOffset;
+}
+
+/**
+	@param hFile The file to write to
+	@param pData The data to write
+	@param dwSize Size of the data
+	@return true if all the data was written, false if failed
+*/
+static bool WriteData(HANDLE hFile, const void* pData, DWORD dwSize)
+{
+	DWORD dwWritten;
+	return ::WriteFile(hFile, pData, dwSize, &dwWritten, NULL) && (dwWritten == dwSize);
+}
+
+/**
+	
+*/
+GlyphDiskCache::GlyphDiskCache() : m_pView(NULL), m_dwViewSize(0), m_bLoaded(false)
+{
+}
+
+/**
+	
+*/
+GlyphDiskCache::~GlyphDiskCache()
+{
+	if (m_pView != NULL)
+		::UnmapViewOfFile(m_pView);
+}
+
+/**
+	@param lpPath Buffer to receive the path (the folder, ending with a backslash)
+	@param nSize Size of the buffer in characters
+	@return true if successful, false if failed
+*/
+bool GlyphDiskCache::GetFolder(LPTSTR lpPath, size_t nSize)
+{
+	DWORD dwLen = ::GetTempPath((DWORD)nSize, lpPath);
+	return (dwLen != 0) && (dwLen < nSize);
+}
+
+/**
+	@param lpPath Buffer to receive the path
+	@param nSize Size of the buffer in characters
+	@param dwGeneration The generation of the file
+	@return true if successful, false if failed
+*/
+bool GlyphDiskCache::GetFilePath(LPTSTR lpPath, size_t nSize, DWORD dwGeneration)
+{
+	TCHAR cName[MAX_PATH];
+	_stprintf_s(cName, _S(cName), GLYPHCACHE_FILE, dwGeneration);
+	return GetFolder(lpPath, nSize) && (_tcscat_s(lpPath, nSize, cName) == 0);
+}
+
+/**
+	@param[out] arGenerations The generations of the cache files that exist, newest first
+*/
+void GlyphDiskCache::GetGenerations(std::vector<DWORD>& arGenerations)
+{
+	arGenerations.clear();
+	TCHAR cPath[MAX_PATH + 1];
+	if (!GetFolder(cPath, _S(cPath)) || (_tcscat_s(cPath, _S(cPath), GLYPHCACHE_FILES) != 0))
+		return;
+
+	WIN32_FIND_DATA data;
+	HANDLE hFind = ::FindFirstFile(cPath, &data);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		// Only names we write (CCGlyphMaps.XXXXXXXX.dat)
+		if (_tcslen(data.cFileName) != GLYPHCACHE_FILE_PREFIX + 12)
+			continue;
+		LPTSTR pEnd = NULL;
+		DWORD dwGeneration = (DWORD)_tcstoul(data.cFileName + GLYPHCACHE_FILE_PREFIX, &pEnd, 16);
+		if (pEnd == data.cFileName + GLYPHCACHE_FILE_PREFIX + 8)
+			arGenerations.push_back(dwGeneration);
+	} while (::FindNextFile(hFind, &data));
+	::FindClose(hFind);
+	std::sort(arGenerations.rbegin(), arGenerations.rend());
+}
+
+/**
+	@param lf Font description
+	@param hDC Handle to the DC to use
+	@param[out] print The font fingerprint
+	@return true if successful, false if failed (the font is not a TrueType/OpenType font)
+*/
+bool GlyphDiskCache::GetFontPrint(const LOGFONT& lf, HDC hDC, FontPrint& print)
+{
+	// Get the font Windows uses for this description
+	HFONT hFont = ::CreateFontIndirect(&lf);
+	if (hFont == NULL)
+		return false;
+	HGDIOBJ hOldFont = ::SelectObject(hDC, hFont);
+
+	// Fingerprint it using its size and its header
+	print.dwSize = ::GetFontData(hDC, 0, 0, NULL, 0);
+	bool bRet = (print.dwSize != GDI_ERROR) &&
+		(::GetFontData(hDC, TT_TAG_HEAD, TT_HEAD_CHECKSUM, &print.dwChecksum, sizeof(print.dwChecksum)) == sizeof(print.dwChecksum)) &&
+		(::GetFontData(hDC, TT_TAG_HEAD, TT_HEAD_MODIFIED, print.dwModified, sizeof(print.dwModified)) == sizeof(print.dwModified));
+
+	::SelectObject(hDC, hOldFont);
+	::DeleteObject(hFont);
+	return bRet;
+}
+
+/**
+	
+*/
+void GlyphDiskCache::Load()
+{
+	// Only try once
+	if (m_bLoaded)
+		return;
+	m_bLoaded = true;
+
+	// Use the newest file we can (an older one may still be there if it was in use when it was replaced)
+	std::vector<DWORD> arGenerations;
+	GetGenerations(arGenerations);
+	for (size_t i = 0; (m_pView == NULL) && (i < arGenerations.size()); i++)
+		m_pView = MapFile(arGenerations[i], m_dwViewSize);
+}
+
+/**
+	@param dwGeneration The generation of the file
+	@param[out] dwSize Size of the file
+	@return The mapped file, or NULL if it cannot be used
+*/
+const BYTE* GlyphDiskCache::MapFile(DWORD dwGeneration, DWORD& dwSize)
+{
+	// Open the file (allowing it to be deleted while we use it)
+	TCHAR cPath[MAX_PATH + 1];
+	if (!GetFilePath(cPath, _S(cPath), dwGeneration))
+		return NULL;
+	HANDLE hFile = ::CreateFile(cPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		// Deleted since
+		return NULL;
+
+	// Map it
+	const BYTE* pRet = NULL;
+	dwSize = ::GetFileSize(hFile, NULL);
+	if ((dwSize != INVALID_FILE_SIZE) && (dwSize >= sizeof(GlyphFileHeader)))
+	{
+		HANDLE hMapping = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping != NULL)
+		{
+			// The view keeps the mapping alive
+			const BYTE* pView = (const BYTE*)::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+			::CloseHandle(hMapping);
+
+			// Make sure we can use it
+			DWORD dwCount;
+			if (GetFileEntries(pView, dwSize, dwCount) != NULL)
+			{
+				pRet = pView;
+				VERBOSE(DLLTEXT("GlyphDiskCache: mapped %d tables (generation %d)\r\n"), dwCount, dwGeneration);
+			}
+			else if (pView != NULL)
+				::UnmapViewOfFile(pView);
+		}
+	}
+	::CloseHandle(hFile);
+	return pRet;
+}
+
+/**
+	@param key The font identity
+	@param print The fingerprint of the font
+	@param table The table to attach to the file data
+	@return true if found (and attached), false if not in the file or the font has changed
+*/
+bool GlyphDiskCache::Find(const FontKey& key, const FontPrint& print, GlyphToText& table)
+{
+	Load();
+	DWORD dwCount;
+	const GlyphFileEntry* pEntries = GetFileEntries(m_pView, m_dwViewSize, dwCount);
+	if (pEntries == NULL)
+		return false;
+
+	// Look for the font
+	GlyphFileEntry entry;
+	SetEntryFont(entry, key);
+	for (DWORD i = 0; i < dwCount; i++)
+	{
+		if (!IsSameFont(pEntries[i], entry))
+			continue;
+
+		// Found it; is it of the same font file?
+		if (!(pEntries[i].print == print))
+			return false;
+		const BYTE* pData = GetEntryData(m_pView, m_dwViewSize, pEntries[i]);
+		if (pData == NULL)
+			return false;
+		return table.Attach((const WORD*)pData, (const WCHAR*)(pData + 256 * sizeof(WORD)), pEntries[i].dwPages);
+	}
+
+	// Not there
+	return false;
+}
+
+/**
+	@param key The font identity
+	@param print The fingerprint of the font
+	@param table The table to store
+*/
+void GlyphDiskCache::Store(const FontKey& key, const FontPrint& print, const GlyphToText& table)
+{
+	// Prepare the entry
+	GlyphFileEntry entry;
+	SetEntryFont(entry, key);
+	entry.print = print;
+	entry.dwPages = (DWORD)table.GetPageCount();
+
+	// And copy it with the table data, as the table may be gone by the time we flush
+	m_arPending.push_back(std::vector<BYTE>());
+	std::vector<BYTE>& arRecord = m_arPending.back();
+	arRecord.resize(sizeof(entry) + GetTableSize(entry.dwPages));
+	memcpy(&arRecord[0], &entry, sizeof(entry));
+	memcpy(&arRecord[sizeof(entry)], table.GetIndex(), 256 * sizeof(WORD));
+	memcpy(&arRecord[sizeof(entry) + 256 * sizeof(WORD)], table.GetPages(), entry.dwPages * 256 * sizeof(WCHAR));
+}
+
+/**
+	@return true if the file was written (or nothing needed writing), false if failed
+*/
+bool GlyphDiskCache::Flush()
+{
+	// Anything new?
+	if (m_arPending.empty())
+		return true;
+
+	TCHAR cPath[MAX_PATH + 1], cTemp[MAX_PATH + 1], cFolder[MAX_PATH + 1];
+	if (!GetFolder(cFolder, _S(cFolder)))
+		return false;
+
+	// Only one writer at a time
+	HANDLE hMutex = ::CreateMutex(NULL, FALSE, GLYPHCACHE_MUTEX);
+	if (hMutex == NULL)
+		return false;
+	DWORD dwWait = ::WaitForSingleObject(hMutex, GLYPHCACHE_WAIT);
+	if ((dwWait != WAIT_OBJECT_0) && (dwWait != WAIT_ABANDONED))
+	{
+		// Someone's taking too long, we'll try again next time
+		::CloseHandle(hMutex);
+		return false;
+	}
+
+	// Read the newest file: another process may have written it since we mapped ours
+	std::vector<DWORD> arGenerations;
+	GetGenerations(arGenerations);
+	std::vector<BYTE> arOld;
+	DWORD dwOldCount = 0;
+	const GlyphFileEntry* pOld = NULL;
+	for (size_t i = 0; (pOld == NULL) && (i < arGenerations.size()); i++)
+	{
+		HANDLE hFile = INVALID_HANDLE_VALUE;
+		if (GetFilePath(cPath, _S(cPath), arGenerations[i]))
+			hFile = ::CreateFile(cPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+			continue;
+		DWORD dwSize = ::GetFileSize(hFile, NULL), dwRead = 0;
+		arOld.clear();
+		if ((dwSize != INVALID_FILE_SIZE) && (dwSize > 0) && (dwSize <= GLYPHCACHE_MAX_SIZE * 2))
+		{
+			arOld.resize(dwSize);
+			if (::ReadFile(hFile, &arOld[0], dwSize, &dwRead, NULL) && (dwRead == dwSize))
+				pOld = GetFileEntries(&arOld[0], dwSize, dwOldCount);
+		}
+		::CloseHandle(hFile);
+	}
+
+	// Collect the entries: ours first, then the old ones we don't replace (as long as there's room)
+	std::vector<GlyphFileEntry> arEntries;
+	std::vector<const BYTE*> arData;
+	DWORD dwSize = sizeof(GlyphFileHeader);
+	for (size_t i = 0; i < m_arPending.size(); i++)
+	{
+		const GlyphFileEntry& entry = *(const GlyphFileEntry*)&m_arPending[i][0];
+		bool bFound = false;
+		for (size_t j = 0; !bFound && (j < arEntries.size()); j++)
+			bFound = IsSameFont(arEntries[j], entry);
+		if (bFound)
+			continue;
+		arEntries.push_back(entry);
+		arData.push_back(&m_arPending[i][sizeof(GlyphFileEntry)]);
+		dwSize += sizeof(GlyphFileEntry) + GetTableSize(entry.dwPages);
+	}
+	for (DWORD i = 0; (pOld != NULL) && (i < dwOldCount); i++)
+	{
+		const BYTE* pData = GetEntryData(&arOld[0], (DWORD)arOld.size(), pOld[i]);
+		if ((pData == NULL) || (dwSize + sizeof(GlyphFileEntry) + GetTableSize(pOld[i].dwPages) > GLYPHCACHE_MAX_SIZE))
+			continue;
+		bool bFound = false;
+		for (size_t j = 0; !bFound && (j < arEntries.size()); j++)
+			bFound = IsSameFont(arEntries[j], pOld[i]);
+		if (bFound)
+			continue;
+		arEntries.push_back(pOld[i]);
+		arData.push_back(pData);
+		dwSize += sizeof(GlyphFileEntry) + GetTableSize(pOld[i].dwPages);
+	}
+
+	// Set the data locations
+	DWORD dwOffset = sizeof(GlyphFileHeader) + (DWORD)arEntries.size() * sizeof(GlyphFileEntry);
+	for (size_t i = 0; i < arEntries.size(); i++)
+	{
+		arEntries[i].dwOffset = dwOffset;
+		dwOffset += GetTableSize(arEntries[i].dwPages);
+	}
+
+	// Write it all to a new file
+	bool bRet = false;
+	DWORD dwGeneration = arGenerations.empty() ? 0 : arGenerations[0] + 1;
+	if (GetFilePath(cPath, _S(cPath), dwGeneration) && (::GetTempFileName(cFolder, _T("CCG"), 0, cTemp) != 0))
+	{
+		HANDLE hFile = ::CreateFile(cTemp, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile != INVALID_HANDLE_VALUE)
+		{
+			GlyphFileHeader header = {GLYPHCACHE_MAGIC, GLYPHCACHE_VERSION, (DWORD)arEntries.size(), 0};
+			bRet = WriteData(hFile, &header, sizeof(header)) && WriteData(hFile, &arEntries[0], (DWORD)arEntries.size() * sizeof(GlyphFileEntry));
+			for (size_t i = 0; bRet && (i < arEntries.size()); i++)
+				bRet = WriteData(hFile, arData[i], GetTableSize(arEntries[i].dwPages));
+			::CloseHandle(hFile);
+		}
+
+		// And make it the next generation in one step: the older files can't be replaced while they're
+		// mapped (by us or by other processes), so they're deleted instead once nobody uses them
+		if (bRet)
+			bRet = ::MoveFileEx(cTemp, cPath, 0) != FALSE;
+		if (!bRet)
+			::DeleteFile(cTemp);
+	}
+	VERBOSE(DLLTEXT("GlyphDiskCache: wrote %d tables (generation %d, %s)\r\n"), (int)arEntries.size(), dwGeneration, bRet ? _T("OK") : _T("failed"));
+	if (bRet)
+	{
+		for (size_t i = 0; i < arGenerations.size(); i++)
+			if (GetFilePath(cPath, _S(cPath), arGenerations[i]))
+				// Fails while still mapped: the next flush tries again
+				::DeleteFile(cPath);
+	}
+
+	::ReleaseMutex(hMutex);
+	::CloseHandle(hMutex);
+
+	// Written: don't write these again (if not, we'll try with the next flush)
+	if (bRet)
+		m_arPending.clear();
+	return bRet;
+}
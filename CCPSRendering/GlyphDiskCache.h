@@ -0,0 +1,114 @@
+/**
+	@file
+	@brief Glyph translation tables cache file, shared between processes
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _GLYPHDISKCACHE_H_
+#define _GLYPHDISKCACHE_H_
+
+#include <vector>
+
+struct FontKey;
+class GlyphToText;
+
+/**
+    @brief Fingerprint of an actual font file, used to detect fonts that were replaced
+*/
+struct FontPrint
+{
+	/// Size of the font data
+	DWORD			dwSize;
+	/// Checksum adjustment from the font 'head' table
+	DWORD			dwChecksum;
+	/// Modification date from the font 'head' table
+	DWORD			dwModified[2];
+
+	// Operators
+	/// Comparison operator
+	bool operator==(const FontPrint& other) const {return (dwSize == other.dwSize) && (dwChecksum == other.dwChecksum) && (dwModified[0] == other.dwModified[0]) && (dwModified[1] == other.dwModified[1]);};
+};
+
+/**
+    @brief Memory-mapped file of glyph translation tables, so new processes don't have to build them again
+
+	The file is mapped read-only the first time it's needed and tables are used directly from the mapping.
+	New tables are collected and written together by Flush: under a named mutex, the newest file is merged
+	with them into a temporary file that then becomes the next generation, so readers always see a complete
+	file. A mapped file cannot be replaced, so each flush writes a new generation and deletes the older ones
+	that nobody maps anymore; Load maps the newest one it can use.
+	Each table is stored with the fingerprint of its font file; a table whose font has changed is not used
+	and gets replaced on the next flush. Files with a different version are ignored (and replaced).
+*/
+class GlyphDiskCache
+{
+public:
+	// Ctors
+	/// Constructor
+	GlyphDiskCache();
+	/// Destructor
+	~GlyphDiskCache();
+
+protected:
+	// Members
+	/// The mapped file (NULL if none)
+	const BYTE*		m_pView;
+	/// Size of the mapped file
+	DWORD			m_dwViewSize;
+	/// true if already tried to map the file
+	bool			m_bLoaded;
+	/// Tables waiting to be written (each an entry record followed by the table data)
+	std::vector<std::vector<BYTE> >	m_arPending;
+
+public:
+	// Methods
+	/// Retrieves the fingerprint of a font
+	static bool		GetFontPrint(const LOGFONT& lf, HDC hDC, FontPrint& print);
+	/// Searches the file for a font's table
+	bool			Find(const FontKey& key, const FontPrint& print, GlyphToText& table);
+	/// Adds a table to be written on the next flush
+	void			Store(const FontKey& key, const FontPrint& print, const GlyphToText& table);
+	/// Writes the added tables to the file
+	bool			Flush();
+
+protected:
+	// Helpers
+	/// Maps the newest file (once)
+	void			Load();
+	/// Maps a generation of the file
+	static const BYTE*	MapFile(DWORD dwGeneration, DWORD& dwSize);
+	/// Retrieves the folder of the cache files
+	static bool		GetFolder(LPTSTR lpPath, size_t nSize);
+	/// Retrieves the path of a generation of the cache file
+	static bool		GetFilePath(LPTSTR lpPath, size_t nSize, DWORD dwGeneration);
+	/// Lists the generations of the cache file
+	static void		GetGenerations(std::vector<DWORD>& arGenerations);
+
+private:
+	/// Not copyable
+	GlyphDiskCache(const GlyphDiskCache&);
+	/// Not copyable
+	GlyphDiskCache& operator=(const GlyphDiskCache&);
+};
+
+#endif   //#define _GLYPHDISKCACHE_H_
@@ -0,0 +1,218 @@
+/**
+	@file
+	@brief Background building of glyph translation tables for the fonts a print job is likely to use
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "debug.h"
+#include "GlyphPrewarmer.h"
+#include "GlyphCache.h"
+
+volatile LONG GlyphPrewarmer::s_bActive = 0;
+
+/**
+	
+*/
+GlyphPrewarmer::~GlyphPrewarmer()
+{
+	if (m_hThread != NULL)
+	{
+		::InterlockedExchange(&m_bStop, 1);
+		::WaitForSingleObject(m_hThread, INFINITE);
+		::CloseHandle(m_hThread);
+		// Let the next job start one
+		::InterlockedExchange(&s_bActive, 0);
+	}
+}
+
+/**
+	@param sFonts The fonts to prepare (see the class description for the format)
+	@return true if the thread is running, false if failed (or already started, here or by another prewarmer)
+*/
+bool GlyphPrewarmer::Start(const std::tstring& sFonts)
+{
+	if (m_hThread != NULL)
+		return false;
+	if (::InterlockedCompareExchange(&s_bActive, 1, 0) != 0)
+		return false;
+
+	m_sFonts = sFonts;
+	m_bStop = 0;
+	DWORD dwThreadID;
+	m_hThread = ::CreateThread(NULL, 0, PrewarmThreadProc, (LPVOID)this, 0, &dwThreadID);
+	if (m_hThread == NULL)
+	{
+		VERBOSE(DLLTEXT("GlyphPrewarmer: cannot create thread\r\n"));
+		::InterlockedExchange(&s_bActive, 0);
+		return false;
+	}
+	// Don't compete with the printing thread
+	::SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+	return true;
+}
+
+/**
+	@param translator The print job's translator
+	@return The font list (up to \ref PREWARM_MAX_RECENT fonts, in order of first use)
+*/
+std::tstring GlyphPrewarmer::FormatFonts(const GlyphTranslator& translator)
+{
+	std::tstring sRet;
+	TCHAR cFont[LF_FACESIZE + 64];
+	for (size_t i = 0; (i < translator.GetFontCount()) && (i < PREWARM_MAX_RECENT); i++)
+	{
+		const FontKey& key = translator.GetFont(i);
+		_stprintf_s(cFont, _S(cFont), _T("%s,%d,%d,%d,%d"), key.cFace, (int)key.lWeight, (int)key.bItalic, (int)key.bCharSet, (int)key.bPitchAndFamily);
+		if (!sRet.empty())
+			sRet += ';';
+		sRet += cFont;
+	}
+	return sRet;
+}
+
+/**
+	@param lpData Pointer to the prewarmer object
+	@return 0
+*/
+DWORD WINAPI GlyphPrewarmer::PrewarmThreadProc(LPVOID lpData)
+{
+	((GlyphPrewarmer*)lpData)->Run();
+	return 0;
+}
+
+/**
+	
+*/
+void GlyphPrewarmer::Run()
+{
+	HDC hDC = ::GetDC(NULL);
+	if (hDC == NULL)
+		return;
+
+	GlyphCache& cache = GlyphCache::Instance();
+	std::tstring::size_type nPos = 0;
+	while ((nPos < m_sFonts.size()) && (m_bStop == 0))
+	{
+		// Get the next item (without surrounding spaces)
+		std::tstring::size_type nEnd = m_sFonts.find(';', nPos);
+		if (nEnd == std::tstring::npos)
+			nEnd = m_sFonts.size();
+		std::tstring::size_type nStart = m_sFonts.find_first_not_of(_T(" \t"), nPos);
+		nPos = nEnd + 1;
+		if ((nStart == std::tstring::npos) || (nStart >= nEnd))
+			continue;
+		std::tstring::size_type nLast = m_sFonts.find_last_not_of(_T(" \t"), nEnd - 1);
+		std::tstring sFont = m_sFonts.substr(nStart, nLast - nStart + 1);
+
+		LOGFONT lf;
+		if (sFont.find(',') != std::tstring::npos)
+		{
+			// Exact font
+			if (ParseFont(sFont, lf))
+				cache.Release(cache.Acquire(lf));
+		}
+		else
+		{
+			// Face name: the regular and bold fonts
+			if (ResolveFont(hDC, sFont, FW_NORMAL, lf))
+				cache.Release(cache.Acquire(lf));
+			if ((m_bStop == 0) && ResolveFont(hDC, sFont, FW_BOLD, lf))
+				cache.Release(cache.Acquire(lf));
+		}
+	}
+	::ReleaseDC(NULL, hDC);
+}
+
+/**
+	@param sFont The font identity (face,weight,italic,charset,pitch-and-family)
+	@param lf Receives the font description
+	@return true if read, false if the identity is not valid
+*/
+bool GlyphPrewarmer::ParseFont(const std::tstring& sFont, LOGFONT& lf)
+{
+	// The numbers are the last four items (face names don't have commas, but let's be safe)
+	int nValues[4];
+	std::tstring::size_type nEnd = sFont.size();
+	for (int i = 3; i >= 0; i--)
+	{
+		std::tstring::size_type nComma = sFont.rfind(',', nEnd - 1);
+		if ((nComma == std::tstring::npos) || (nComma == 0))
+			return false;
+		nValues[i] = _ttoi(sFont.substr(nComma + 1, nEnd - nComma - 1).c_str());
+		nEnd = nComma;
+	}
+	if (nEnd >= LF_FACESIZE)
+		return false;
+
+	memset(&lf, 0, sizeof(lf));
+	_tcsncpy_s(lf.lfFaceName, _S(lf.lfFaceName), sFont.c_str(), nEnd);
+	lf.lfWeight = nValues[0];
+	lf.lfItalic = (BYTE)nValues[1];
+	lf.lfCharSet = (BYTE)nValues[2];
+	lf.lfPitchAndFamily = (BYTE)nValues[3];
+	return true;
+}
+
+/**
+	@param hDC Handle to the DC to use
+	@param sFace The font's face name
+	@param lWeight The font weight
+	@param lf Receives the font description, as the driver will report it when printing
+	@return true if found, false if there's no such font
+
+	The driver's font description is rebuilt from the text metrics; if it turns out different, the table
+	prepared is simply not used.
+*/
+bool GlyphPrewarmer::ResolveFont(HDC hDC, const std::tstring& sFace, LONG lWeight, LOGFONT& lf)
+{
+	if (sFace.size() >= LF_FACESIZE)
+		return false;
+
+	// Have GDI choose the font
+	memset(&lf, 0, sizeof(lf));
+	_tcscpy_s(lf.lfFaceName, _S(lf.lfFaceName), sFace.c_str());
+	lf.lfWeight = lWeight;
+	lf.lfCharSet = DEFAULT_CHARSET;
+	HFONT hFont = ::CreateFontIndirect(&lf);
+	if (hFont == NULL)
+		return false;
+	HGDIOBJ hOld = ::SelectObject(hDC, hFont);
+
+	// Make sure it's the font we asked for (not a substitute)
+	TCHAR cFace[LF_FACESIZE];
+	TEXTMETRIC tm;
+	bool bRet = (::GetTextFace(hDC, _S(cFace), cFace) > 0) && (_tcsicmp(cFace, sFace.c_str()) == 0) && ::GetTextMetrics(hDC, &tm);
+	if (bRet)
+	{
+		// The driver reports the LOGFONT pitch values, while the metrics have a "not fixed" flag in that bit
+		lf.lfWeight = tm.tmWeight;
+		lf.lfItalic = tm.tmItalic ? TRUE : FALSE;
+		lf.lfCharSet = tm.tmCharSet;
+		lf.lfPitchAndFamily = (BYTE)((tm.tmPitchAndFamily & 0xF0) | (((tm.tmPitchAndFamily & TMPF_FIXED_PITCH) != 0) ? VARIABLE_PITCH : FIXED_PITCH));
+	}
+
+	::SelectObject(hDC, hOld);
+	::DeleteObject(hFont);
+	return bRet;
+}
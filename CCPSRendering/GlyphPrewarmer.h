@@ -0,0 +1,94 @@
+/**
+	@file
+	@brief Background building of glyph translation tables for the fonts a print job is likely to use
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _GLYPHPREWARMER_H_
+#define _GLYPHPREWARMER_H_
+
+#include "CCTChar.h"
+
+/// Fonts prepared when the printer doesn't list its own (see \ref SETTINGS_PREWARMFONTS)
+#define PREWARM_DEFAULT_FONTS	_T("Arial;Times New Roman;Calibri")
+/// Maximal amount of fonts remembered from a print job
+#define PREWARM_MAX_RECENT		16
+
+/**
+    @brief Builds glyph translation tables in the process-wide cache on a background thread
+
+	The font list is separated by semicolons. Each item is either a face name, which prepares the regular
+	and bold fonts of the face, or an exact font identity as written by FormatFonts
+	(face,weight,italic,charset,pitch-and-family). A print job that needs a table still being built
+	waits for it instead of building it again (see GlyphCache::Acquire).
+	Only one prewarmer runs in the process at a time; the cache is shared, so other jobs gain nothing
+	from starting their own.
+*/
+class GlyphPrewarmer
+{
+public:
+	// Ctors
+	/**
+		@brief Default constructor
+	*/
+	GlyphPrewarmer() : m_hThread(NULL), m_bStop(0) {};
+	/// Destructor: stops the thread (after the font it's working on)
+	~GlyphPrewarmer();
+
+protected:
+	// Members
+	/// The worker thread (NULL if not running)
+	HANDLE				m_hThread;
+	/// Set to 1 when the thread should stop
+	volatile LONG		m_bStop;
+	/// The fonts to prepare
+	std::tstring		m_sFonts;
+	/// Set to 1 while a prewarmer of the process is started (until it's destroyed)
+	static volatile LONG	s_bActive;
+
+public:
+	// Methods
+	/// Starts preparing the fonts (unless another prewarmer is active)
+	bool				Start(const std::tstring& sFonts);
+	/// Creates the font list of the fonts used by a print job
+	static std::tstring	FormatFonts(const class GlyphTranslator& translator);
+
+protected:
+	// Helpers
+	/// Worker thread function
+	static DWORD WINAPI	PrewarmThreadProc(LPVOID lpData);
+	/// Prepares all the fonts in the list (unless told to stop)
+	void				Run();
+	/// Reads an exact font identity
+	static bool			ParseFont(const std::tstring& sFont, LOGFONT& lf);
+	/// Finds the identity of an installed font by its face name
+	static bool			ResolveFont(HDC hDC, const std::tstring& sFace, LONG lWeight, LOGFONT& lf);
+
+private:
+	/// Not copyable
+	GlyphPrewarmer(const GlyphPrewarmer&);
+	/// Not copyable
+	GlyphPrewarmer& operator=(const GlyphPrewarmer&);
+};
+
+#endif   //#define _GLYPHPREWARMER_H_
@@ -26,8 +26,65 @@
 
 #include "precomp.h"
 #include "debug.h"
-#include "oemps.h"
 #include "GlyphTranslator.h"
+#include "GlyphCache.h"
+
+/**
+	
+*/
+GlyphToText::GlyphToText()
+{
+	// Everything points to the empty page
+	memset(m_wIndex, 0, sizeof(m_wIndex));
+	m_arPages.assign(256, GLYPH_UNKNOWN);
+	m_pPages = &m_arPages[0];
+	m_nPages = 1;
+}
+
+/**
+	@param wGlyph The glyph index
+	@param wChar The character
+*/
+void GlyphToText::Add(WORD wGlyph, WCHAR wChar)
+{
+	// Do we have a page for this glyph?
+	WORD& wPage = m_wIndex[wGlyph >> 8];
+	if (wPage == 0)
+	{
+		// No, add one
+		wPage = (WORD)(m_arPages.size() / 256);
+		m_arPages.resize(m_arPages.size() + 256, GLYPH_UNKNOWN);
+		m_pPages = &m_arPages[0];
+		m_nPages = m_arPages.size() / 256;
+	}
+
+	// Replace it if not already there (there can be two glyphs for the same character)
+	WCHAR& wEntry = m_arPages[(wPage << 8) | (wGlyph & 0xFF)];
+	if (wEntry == GLYPH_UNKNOWN)
+		wEntry = wChar;
+}
+
+/**
+	@param pGlyphs The glyph indexes
+	@param nCount Amount of glyphs
+	@param[out] pText Buffer to receive the characters (at least nCount long)
+*/
+void GlyphToText::Translate(const WCHAR* pGlyphs, size_t nCount, WCHAR* pText) const
+{
+	const WCHAR* pPages = m_pPages;
+	size_t i = 0;
+	// Four at a time (the lookups are independent)
+	for (; i + 4 <= nCount; i += 4)
+	{
+		WCHAR w0 = pGlyphs[i], w1 = pGlyphs[i + 1], w2 = pGlyphs[i + 2], w3 = pGlyphs[i + 3];
+		pText[i] = pPages[(m_wIndex[w0 >> 8] << 8) | (w0 & 0xFF)];
+		pText[i + 1] = pPages[(m_wIndex[w1 >> 8] << 8) | (w1 & 0xFF)];
+		pText[i + 2] = pPages[(m_wIndex[w2 >> 8] << 8) | (w2 & 0xFF)];
+		pText[i + 3] = pPages[(m_wIndex[w3 >> 8] << 8) | (w3 & 0xFF)];
+	}
+	for (; i < nCount; i++)
+		pText[i] = pPages[(m_wIndex[pGlyphs[i] >> 8] << 8) | (pGlyphs[i] & 0xFF)];
+}
 
 /**
 	@param lf Font description
@@ -49,6 +106,7 @@ bool GlyphToText::Initialize(const LOGFONT& lf, HDC hDC)
 	{
 		// None - nothing to add
 		::SelectObject(hDC, hOldFont);
+		::DeleteObject(hFont);
 		return true;
 	}
 
@@ -56,37 +114,76 @@ bool GlyphToText::Initialize(const LOGFONT& lf, HDC hDC)
 	LPGLYPHSET pSet = (LPGLYPHSET)new char[dwSize];
 	::GetFontUnicodeRanges(hDC, pSet);
 
-	// Go over the set:
-	WORD dwGlyphs[1];
-	TCHAR c[1];
-	int nCount = 0;
+	// Go over the set, translating a whole range in one call
+	std::vector<WCHAR> arChars;
+	std::vector<WORD> arGlyphs;
+	bool bRet = true;
 	for (UINT i=0;i<pSet->cRanges;i++)
 	{
-		// For each range
-		for (UINT u=0;u<pSet->ranges[i].cGlyphs;u++)
+		// Put all the range's characters in a buffer
+		UINT uCount = pSet->ranges[i].cGlyphs;
+		if (uCount == 0)
+			continue;
+		arChars.resize(uCount);
+		arGlyphs.resize(uCount);
+		for (UINT u=0;u<uCount;u++)
+			arChars[u] = (WCHAR)(pSet->ranges[i].wcLow + u);
+
+		// And retrieve the glyphs for them
+		if (::GetGlyphIndices(hDC, &arChars[0], (int)uCount, &arGlyphs[0], GGI_MARK_NONEXISTING_GLYPHS) != uCount)
 		{
-			// Put the glyph in a buffer
-			c[0] = pSet->ranges[i].wcLow + u;
-			// And retrieve the character for it
-			if (::GetGlyphIndices(hDC, c, 1, (LPWORD)&dwGlyphs, GGI_MARK_NONEXISTING_GLYPHS) != 1)
-			{
-				// Cannot get it, fail
-				delete [] pSet;
-				::SelectObject(hDC, hOldFont);
-				return false;
-			}
-			// OK, replace it if not already there (there can be two glyphs for the same character)
-			if (find(dwGlyphs[0]) == end())
-				operator[](dwGlyphs[0]) = c[0];
+			// Cannot get it, fail
+			bRet = false;
+			break;
 		}
+		for (UINT u=0;u<uCount;u++)
+			// Characters without a glyph are marked with 0xFFFF
+			if (arGlyphs[u] != 0xFFFF)
+				Add(arGlyphs[u], arChars[u]);
 	}
 
 	// OK, this is it
 	delete [] pSet;
 	::SelectObject(hDC, hOldFont);
+	::DeleteObject(hFont);
+	return bRet;
+}
+
+/**
+	@param pIndex The page index (256 page numbers)
+	@param pPages The pages (nPages * 256 characters)
+	@param nPages Amount of pages
+	@return true if the data is valid and was attached, false if not
+
+	The data is not copied, so it must stay valid as long as this object is used.
+*/
+bool GlyphToText::Attach(const WORD* pIndex, const WCHAR* pPages, size_t nPages)
+{
+	// Make sure all the page numbers are in range
+	if ((nPages == 0) || (nPages > 257))
+		return false;
+	for (int i = 0; i < 256; i++)
+		if (pIndex[i] >= nPages)
+			return false;
+
+	// Use it
+	memcpy(m_wIndex, pIndex, sizeof(m_wIndex));
+	std::vector<WCHAR>().swap(m_arPages);
+	m_pPages = pPages;
+	m_nPages = nPages;
 	return true;
 }
 
+/**
+	
+*/
+GlyphTranslator::~GlyphTranslator()
+{
+	// Let go of all the maps we used
+	for (size_t i = 0; i < m_arEntries.size(); i++)
+		GlyphCache::Instance().Release(m_arEntries[i]);
+}
+
 /**
 	@param lf Font description
 	@param hDC Handle to the DC to use for translation (if NULL, uses the default screen DC)
@@ -94,32 +191,40 @@ bool GlyphToText::Initialize(const LOGFONT& lf, HDC hDC)
 */
 const GlyphToText* GlyphTranslator::GetFontTranslation(const LOGFONT& lf, HDC hDC /* = NULL */)
 {
-	// Check out if we have this font cached
-	TCHAR cFontID[LF_FACESIZE + 128];
-	_stprintf_s(cFontID, _S(cFontID), _T("%.*s|%d|%d|%d|%d|%d"), LF_FACESIZE, lf.lfFaceName, lf.lfHeight, lf.lfWeight, (lf.lfItalic ? 1 : 0) | (lf.lfUnderline ? 2 : 0) | (lf.lfStrikeOut ? 4 : 0), lf.lfPitchAndFamily);
-	iterator iGlyphData;
+	// Same font as last time?
+	FontKey key(lf);
+	if ((m_pLast != NULL) && (m_pLast->GetKey() == key))
+		return m_pLast->GetTable();
 
-	if ((iGlyphData = find(cFontID)) == end())
+	// Do we already hold it?
+	for (size_t i = 0; i < m_arEntries.size(); i++)
 	{
-		// Nope, so add an empty translation map
-		insert(std::pair<std::tstring, GlyphToText>(cFontID, GlyphToText()));
-		iGlyphData = find(cFontID);
-		_ASSERT(iGlyphData != end());
-		// And initialize it for the font
-		HDC hUseDC = (hDC == NULL) ? GetDC(NULL) : hDC;
-		if (hUseDC == NULL)
-			return NULL;
-		bool bRet = !(*iGlyphData).second.Initialize(lf, hUseDC);
-		if (hUseDC != hDC)
-			DeleteDC(hUseDC);
-		if (!bRet)
+		if (m_arEntries[i]->GetKey() == key)
 		{
-			// Cannot, so fail
-			erase(iGlyphData);
-			return NULL;
+			m_pLast = m_arEntries[i];
+			return m_pLast->GetTable();
 		}
 	}
 
-	// OK, found it
-	return &((*iGlyphData).second);
+	// No, get it from the cache (and hold it until we're done)
+	const GlyphCacheEntry* pEntry = GlyphCache::Instance().Acquire(lf, hDC);
+	const GlyphToText* pTable = pEntry->GetTable();
+	if (pTable == NULL)
+	{
+		// Not translatable now: don't hold on to the failure, so the next call tries again
+		GlyphCache::Instance().Release(pEntry);
+		return NULL;
+	}
+	m_pLast = pEntry;
+	m_arEntries.push_back(m_pLast);
+	return pTable;
+}
+
+/**
+	@param n Index of the font (in order of first use)
+	@return The font's identity
+*/
+const FontKey& GlyphTranslator::GetFont(size_t n) const
+{
+	return m_arEntries[n]->GetKey();
 }
@@ -27,31 +27,124 @@
 #ifndef _GLYPHTRANSLATOR_H_
 #define _GLYPHTRANSLATOR_H_
 
-#include <map>
+#include <vector>
 #include "CCTChar.h"
 
+/// The character used for glyphs that have no known character
+#define GLYPH_UNKNOWN		((WCHAR)0x7F)
+
 /**
     @brief This class holds glyph-to-Unicode-character data for a specific font
+
+	The data is a two-level table: the high byte of the glyph index selects a page of 256 characters,
+	and the low byte selects the character in it. Pages that have no glyphs all share page 0 (filled with
+	GLYPH_UNKNOWN), so a lookup is always two array reads with no checks.
+	The pages are either owned by the object or attached from a read-only memory block (such as the
+	mapped disk cache), which must stay valid for the life of the object.
 */
-struct GlyphToText : public std::map<WORD, WCHAR>
+class GlyphToText
 {
 public:
+	/// Constructor
+	GlyphToText();
+
+protected:
+	// Members
+	/// Page number for each high byte of the glyph index
+	WORD				m_wIndex[256];
+	/// The pages, 256 characters each (unless attached to external pages)
+	std::vector<WCHAR>	m_arPages;
+	/// The pages used for translation (either m_arPages or the attached pages)
+	const WCHAR*		m_pPages;
+	/// Amount of pages
+	size_t				m_nPages;
+
+public:
+	// Data Access
+	/**
+		@brief Translates a glyph into its character
+		@param wGlyph The glyph index
+		@return The character (GLYPH_UNKNOWN if not known)
+	*/
+	WCHAR	Translate(WORD wGlyph) const {return m_pPages[(m_wIndex[wGlyph >> 8] << 8) | (wGlyph & 0xFF)];};
+	/// Translates a string of glyphs into characters
+	void	Translate(const WCHAR* pGlyphs, size_t nCount, WCHAR* pText) const;
+	/**
+		@brief Returns the memory used by the table
+		@return Size in bytes
+	*/
+	size_t	GetMemorySize() const {return sizeof(*this) + m_arPages.size() * sizeof(WCHAR);};
 	/**
-		@brief Default constructor
+		@brief Returns the page index
+		@return Pointer to the 256 page numbers
 	*/
-	GlyphToText() {};
+	const WORD*		GetIndex() const {return m_wIndex;};
+	/**
+		@brief Returns the pages
+		@return Pointer to the pages (GetPageCount() * 256 characters)
+	*/
+	const WCHAR*	GetPages() const {return m_pPages;};
+	/**
+		@brief Returns the amount of pages
+		@return Number of pages (including the empty page 0)
+	*/
+	size_t			GetPageCount() const {return m_nPages;};
+
+	// Methods
 	/// Adds the font data to the object
 	bool	Initialize(const LOGFONT& lf, HDC hDC);
+	/// Uses external table data instead of the object's own
+	bool	Attach(const WORD* pIndex, const WCHAR* pPages, size_t nPages);
+
+protected:
+	// Helpers
+	/// Adds a glyph to the table (unless it's already there)
+	void	Add(WORD wGlyph, WCHAR wChar);
+
+private:
+	/// Not copyable (may point into its own pages)
+	GlyphToText(const GlyphToText&);
+	/// Not copyable (may point into its own pages)
+	GlyphToText& operator=(const GlyphToText&);
 };
 
 /**
-    @brief This class retrieves a glyph-to-Unicode map for a font (and caches the map)
+    @brief This class retrieves glyph-to-Unicode maps for a print job
+
+	The maps themselves live in the process-wide GlyphCache; this object holds the ones used by the job
+	until it's destroyed, and remembers the last one so consecutive strings in the same font don't search.
 */
-class GlyphTranslator : protected std::map<std::tstring, GlyphToText>
+class GlyphTranslator
 {
+public:
+	/// Constructor
+	GlyphTranslator() : m_pLast(NULL) {};
+	/// Destructor: releases the held maps
+	~GlyphTranslator();
+
+protected:
+	// Members
+	/// The cache entries held by this object
+	std::vector<const class GlyphCacheEntry*>	m_arEntries;
+	/// The last entry used
+	const class GlyphCacheEntry*	m_pLast;
+
 public:
 	/// Get a translation map for a font
 	const GlyphToText* GetFontTranslation(const LOGFONT& lf, HDC hDC = NULL);
+	/**
+		@brief Returns the amount of fonts used so far
+		@return Number of fonts
+	*/
+	size_t			GetFontCount() const {return m_arEntries.size();};
+	/// Returns the identity of a font used so far
+	const struct FontKey&	GetFont(size_t n) const;
+
+private:
+	/// Not copyable
+	GlyphTranslator(const GlyphTranslator&);
+	/// Not copyable
+	GlyphTranslator& operator=(const GlyphTranslator&);
 };
 
 #endif   //#define _GLYPHTRANSLATOR_H_
@@ -0,0 +1,86 @@
+/**
+	@file
+	@brief Per-job counters and hook timers of the rendering plugin
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "HookStats.h"
+#include "GlyphCache.h"
+
+/// Names of the counters in the statistics record (in \ref HookStats::Counter order)
+static const char* s_lpCounterNames[HookStats::MAX_COUNTERS] =
+{
+	"pages", "textout", "glyphs", "glyphmisses", "linkmatches", "links", "spoolbytes"
+};
+
+/// Names of the hooks in the statistics record (in \ref HookStats::Timer order)
+static const char* s_lpTimerNames[HookStats::MAX_TIMERS] =
+{
+	"startpage", "sendpage", "startdoc", "enddoc", "escape", "textout"
+};
+
+/**
+	
+*/
+void HookStats::Reset()
+{
+	for (int i = 0; i < MAX_COUNTERS; i++)
+		m_nCounters[i] = 0;
+	for (int i = 0; i < MAX_TIMERS; i++)
+	{
+		m_nCalls[i] = 0;
+		m_nTicks[i] = 0;
+	}
+}
+
+/**
+	@return The statistics as a single PostScript comment line
+
+	The record is a list of name=value pairs: the counters, the glyph cache's totals (for the whole
+	process), and the number of calls and time in microseconds of each hook (as hook.calls and hook.us).
+*/
+std::string HookStats::Format() const
+{
+	LARGE_INTEGER liFrequency;
+	if (!::QueryPerformanceFrequency(&liFrequency) || (liFrequency.QuadPart == 0))
+		liFrequency.QuadPart = 1000000;
+
+	std::string sRet = "%%CCStats:";
+	char cBuffer[64];
+	for (int i = 0; i < MAX_COUNTERS; i++)
+	{
+		sprintf_s(cBuffer, sizeof(cBuffer), " %s=%I64u", s_lpCounterNames[i], m_nCounters[i]);
+		sRet += cBuffer;
+	}
+	GlyphCache& cache = GlyphCache::Instance();
+	sprintf_s(cBuffer, sizeof(cBuffer), " cachehits=%ld cachemisses=%ld cachewaits=%ld", cache.GetHits(), cache.GetMisses(), cache.GetWaits());
+	sRet += cBuffer;
+	for (int i = 0; i < MAX_TIMERS; i++)
+	{
+		sprintf_s(cBuffer, sizeof(cBuffer), " %s.calls=%I64u %s.us=%I64d", s_lpTimerNames[i], m_nCalls[i], s_lpTimerNames[i], m_nTicks[i] * 1000000 / liFrequency.QuadPart);
+		sRet += cBuffer;
+	}
+	sRet += "\r\n";
+	return sRet;
+}
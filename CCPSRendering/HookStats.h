@@ -0,0 +1,153 @@
+/**
+	@file
+	@brief Per-job counters and hook timers of the rendering plugin
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _HOOKSTATS_H_
+#define _HOOKSTATS_H_
+
+#include <string>
+
+/**
+    @brief Counters and timers for a single print job
+
+	Each printer device object has its own statistics; GDI calls a device's hooks one at a time, so the
+	values are simple integers updated without locking. Only the hooks may use them: the background
+	threads (LinkWorker, GlyphPrewarmer) never do, and what they found is added by OEMEndDoc after
+	LinkWorker::Finish has waited for the thread to end. The glyph cache totals in the record are the
+	cache's own interlocked counters. The timers use the performance counter, and
+	each hook's time includes the base driver call it makes, but not the time of our own hooks it calls
+	(such as the license page started from OEMEndDoc), which are counted under their own timers.
+*/
+class HookStats
+{
+public:
+	/// Counted events
+	enum Counter
+	{
+		/// Pages started
+		SC_PAGES,
+		/// Text output calls
+		SC_TEXTOUT,
+		/// Glyphs captured as text
+		SC_GLYPHS,
+		/// Glyph text that could not be translated into characters
+		SC_GLYPHMISSES,
+		/// Links found in the page text (text links and automatic URLs)
+		SC_LINKMATCHES,
+		/// Links written into the document
+		SC_LINKS,
+		/// Bytes written by the plugin into the spool file
+		SC_SPOOLBYTES,
+
+		MAX_COUNTERS
+	};
+	/// Timed hooks
+	enum Timer
+	{
+		ST_STARTPAGE,
+		ST_SENDPAGE,
+		ST_STARTDOC,
+		ST_ENDDOC,
+		ST_ESCAPE,
+		ST_TEXTOUT,
+
+		MAX_TIMERS
+	};
+
+	/**
+		@brief Default constructor
+	*/
+	HookStats() {Reset();};
+
+protected:
+	// Members
+	/// The event counters
+	ULONGLONG		m_nCounters[MAX_COUNTERS];
+	/// Number of calls to each hook
+	ULONGLONG		m_nCalls[MAX_TIMERS];
+	/// Time spent in each hook (performance counter ticks)
+	LONGLONG		m_nTicks[MAX_TIMERS];
+
+public:
+	// Data Access
+	/**
+		@brief Returns an event counter
+		@param eCounter The counter to return
+		@return The counter's value
+	*/
+	ULONGLONG		Get(Counter eCounter) const {return m_nCounters[eCounter];};
+
+	// Methods
+	/**
+		@brief Adds to an event counter
+		@param eCounter The counter to update
+		@param nCount The amount to add
+	*/
+	void			Add(Counter eCounter, ULONGLONG nCount = 1) {m_nCounters[eCounter] += nCount;};
+	/**
+		@brief Adds a hook call
+		@param eTimer The hook called
+		@param nTicks Time spent in the call (performance counter ticks)
+	*/
+	void			AddCall(Timer eTimer, LONGLONG nTicks) {m_nCalls[eTimer]++; m_nTicks[eTimer] += nTicks;};
+	/// Zeros all the counters and timers
+	void			Reset();
+	/// Creates the job's statistics record
+	std::string		Format() const;
+};
+
+/**
+    @brief Times a hook call from construction to destruction
+*/
+class HookTimer
+{
+public:
+	/**
+		@brief Constructor: starts timing
+		@param stats The statistics to add the call to
+		@param eTimer The hook being called
+	*/
+	HookTimer(HookStats& stats, HookStats::Timer eTimer) : m_stats(stats), m_eTimer(eTimer) {::QueryPerformanceCounter(&m_liStart);};
+	/**
+		@brief Destructor: adds the call's time to the statistics
+	*/
+	~HookTimer() {LARGE_INTEGER liEnd; ::QueryPerformanceCounter(&liEnd); m_stats.AddCall(m_eTimer, liEnd.QuadPart - m_liStart.QuadPart);};
+
+protected:
+	// Members
+	/// The statistics to update
+	HookStats&			m_stats;
+	/// The timed hook
+	HookStats::Timer	m_eTimer;
+	/// Time of the call's start
+	LARGE_INTEGER		m_liStart;
+
+private:
+	// No copying or assignment
+	HookTimer(const HookTimer&);
+	HookTimer& operator=(const HookTimer&);
+};
+
+#endif   //#define _HOOKSTATS_H_
@@ -0,0 +1,524 @@
+/**
+	@file
+	@brief Finds the location of text links in the page text
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include <algorithm>
+
+#include "debug.h"
+#include "LinkMatcher.h"
+
+/// FNV-1a hash start value
+#define HASH_START		2166136261UL
+/// FNV-1a hash multiplier
+#define HASH_PRIME		16777619UL
+
+/**
+	@brief Adds a letter to a hash value
+	@param dwHash The current hash
+	@param w The letter to add
+	@return The new hash
+*/
+inline DWORD HashLetter(DWORD dwHash, WCHAR w)
+{
+	return (dwHash ^ (DWORD)w) * HASH_PRIME;
+}
+
+/**
+	@brief Calculates the hash of a word read from its end backwards (so all suffixes of a page word
+			can be hashed in one pass)
+	@param pText The word's letters
+	@param nLen Length of the word
+	@return The hash
+*/
+DWORD HashBackwards(const WCHAR* pText, size_t nLen)
+{
+	DWORD dwHash = HASH_START;
+	while (nLen > 0)
+		dwHash = HashLetter(dwHash, pText[--nLen]);
+	return dwHash;
+}
+
+/**
+	@brief Checks if a printed character separates words
+	@param w The character
+	@return true for spaces and line breaks
+*/
+inline bool IsWordBreak(WCHAR w)
+{
+	return (w == ' ') || (w == '\r') || (w == '\n') || (w == '\t');
+}
+
+/**
+	@brief Compares two hash entries by their hash value
+	@param entry1 The first entry
+	@param entry2 The second entry
+	@return true if the first entry's hash is smaller
+*/
+bool CompareHash(const std::pair<DWORD, size_t>& entry1, const std::pair<DWORD, size_t>& entry2)
+{
+	return entry1.first < entry2.first;
+}
+
+/**
+	@param sText The link's text
+	@param nRepeat Which appearance of the text is the link (1 for the first)
+	@param nLink The link's ID, returned in the matches
+*/
+void LinkMatcher::AddLink(const std::tstring& sText, int nRepeat, size_t nLink)
+{
+	// Break the text into words
+	Pattern pattern;
+	std::tstring::size_type pos = sText.find(' '), oldpos = 0;
+	while ((oldpos < sText.size()) && (pos != std::tstring::npos))
+	{
+		if (pos > oldpos)
+			pattern.words.push_back(sText.substr(oldpos, pos - oldpos));
+		oldpos = pos + 1;
+		pos = sText.find(' ', oldpos);
+	}
+	if (oldpos < sText.size())
+		pattern.words.push_back(sText.substr(oldpos));
+
+	// Anything to look for?
+	if (pattern.words.empty())
+		return;
+
+	pattern.nRepeat = max(nRepeat, 1);
+	pattern.nLink = nLink;
+	pattern.nFound = 0;
+	pattern.nNextWord = 0;
+	m_patterns.push_back(pattern);
+	m_bCompiled = false;
+}
+
+/**
+	
+*/
+void LinkMatcher::Compile()
+{
+	// Index all the patterns by their first word
+	m_index.clear();
+	m_bLengths.clear();
+	m_index.reserve(m_patterns.size());
+	for (size_t i = 0; i < m_patterns.size(); i++)
+	{
+		const std::tstring& sFirst = m_patterns[i].words.front();
+		m_index.push_back(HASHENTRY(HashBackwards(sFirst.data(), sFirst.size()), i));
+		if (m_bLengths.size() <= sFirst.size())
+			m_bLengths.resize(sFirst.size() + 1, false);
+		m_bLengths[sFirst.size()] = true;
+	}
+	std::stable_sort(m_index.begin(), m_index.end(), CompareHash);
+	m_bCompiled = true;
+}
+
+/**
+	@param text The page text
+	@param[out] matches The found links, in the order they appear in the page
+
+	Links that were not found (or not found enough times) are not returned.
+*/
+void LinkMatcher::Search(const TextArea& text, MATCHES& matches)
+{
+	// Anything to search for?
+	if (m_patterns.empty())
+		return;
+	if (!m_bCompiled)
+		Compile();
+
+	// Start over
+	for (std::vector<Pattern>::iterator i = m_patterns.begin(); i != m_patterns.end(); i++)
+	{
+		(*i).nFound = 0;
+		(*i).nNextWord = 0;
+	}
+
+	// One pass over the text
+	for (size_t nLine = 0; nLine < text.GetLineCount(); nLine++)
+		MatchLine(text, text.GetLine(nLine), matches);
+}
+
+/**
+	@param text The page text
+	@param line The line to search in
+	@param[out] matches The list to add found links to
+*/
+void LinkMatcher::MatchLine(const TextArea& text, const TextLine& line, MATCHES& matches)
+{
+	size_t nEndWord = line.nFirstWord + line.nWords;
+	for (size_t nWord = line.nFirstWord; nWord < nEndWord; nWord++)
+	{
+		const TextWord& word = text.GetWord(nWord);
+		const WCHAR* pLetters = text.GetLetters(word);
+
+		// Hash each suffix of the word, from the shortest to the longest
+		DWORD dwHash = HASH_START;
+		size_t nMaxLen = min(word.nCount, m_bLengths.size() - 1);
+		for (size_t nLen = 1; nLen <= nMaxLen; nLen++)
+		{
+			dwHash = HashLetter(dwHash, pLetters[word.nCount - nLen]);
+			// Does any link start with a word this long?
+			if (!m_bLengths[nLen])
+				continue;
+
+			// Check all the links with this hash
+			std::vector<HASHENTRY>::const_iterator iEntry = std::lower_bound(m_index.begin(), m_index.end(), HASHENTRY(dwHash, 0), CompareHash);
+			for (; (iEntry != m_index.end()) && ((*iEntry).first == dwHash); iEntry++)
+			{
+				Pattern& pattern = m_patterns[(*iEntry).second];
+				// Already found or overlapping the previous appearance?
+				if ((pattern.nFound >= pattern.nRepeat) || (nWord < pattern.nNextWord))
+					continue;
+				if (!MatchAt(text, line, nWord, word.nCount - nLen, pattern))
+					continue;
+
+				// Found it; is this the right appearance?
+				pattern.nNextWord = nWord + pattern.words.size();
+				pattern.nFound++;
+				if (pattern.nFound < pattern.nRepeat)
+					continue;
+
+				// Yes, mark the location
+				const TextWord& last = text.GetWord(pattern.nNextWord - 1);
+				Match match;
+				match.nLink = pattern.nLink;
+				match.rcArea = line.rcArea;
+				match.rcArea.left = text.GetStart(word.nFirst + word.nCount - nLen);
+				match.rcArea.right = text.GetEnd(last.nFirst + last.nCount - 1);
+				matches.push_back(match);
+			}
+		}
+	}
+}
+
+/**
+	@param text The page text
+	@param line The line to search in
+	@param nWord The page word the pattern's first word ends
+	@param nPos The location in the page word where the pattern starts
+	@param pattern The pattern to check
+	@return true if the pattern appears in this location, false if not
+*/
+bool LinkMatcher::MatchAt(const TextArea& text, const TextLine& line, size_t nWord, size_t nPos, const Pattern& pattern) const
+{
+	// Enough words in the line?
+	size_t nWords = pattern.words.size();
+	if (nWord + nWords > line.nFirstWord + line.nWords)
+		return false;
+
+	// Check the first word (the hash may be wrong)
+	const TextWord& first = text.GetWord(nWord);
+	const std::tstring& sFirst = pattern.words.front();
+	if (wmemcmp(text.GetLetters(first) + nPos, sFirst.data(), sFirst.size()) != 0)
+		return false;
+
+	// Check the rest of the words
+	for (size_t i = 1; i < nWords; i++)
+	{
+		const TextWord& word = text.GetWord(nWord + i);
+		const std::tstring& s = pattern.words[i];
+		if (i == nWords - 1)
+		{
+			// Partial word at the end
+			if (word.nCount < s.size())
+				return false;
+		}
+		else if (word.nCount != s.size())
+			return false;
+		if (wmemcmp(text.GetLetters(word), s.data(), s.size()) != 0)
+			return false;
+	}
+	return true;
+}
+
+/**
+	
+*/
+void LinkMatcher::Clear()
+{
+	m_patterns.clear();
+	m_index.clear();
+	m_bLengths.clear();
+	m_bCompiled = true;
+	Start();
+}
+
+/**
+	Call after all the links were added, before feeding the first string.
+*/
+void LinkMatcher::Start()
+{
+	if (!m_bCompiled)
+		Compile();
+
+	// Start over
+	for (std::vector<Pattern>::iterator i = m_patterns.begin(); i != m_patterns.end(); i++)
+	{
+		(*i).nFound = 0;
+		(*i).nNextWord = 0;
+	}
+	m_partials.clear();
+	m_word.clear();
+	m_wordX.clear();
+	m_matches.clear();
+	m_text.Reset();
+	m_nWord = 0;
+}
+
+/**
+	@param pText The printed text
+	@param nLen Length of the text
+	@param rc The text's printed location
+	@param arGlyphPos Array of glyph locations (NULL for a fixed-width font)
+	@param pWidths Array of glyph widths (NULL for a fixed-width font)
+	@param nCharWidth The width of each glyph (fixed-width font only)
+*/
+void LinkMatcher::Feed(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths, int nCharWidth)
+{
+	if (m_patterns.empty())
+		return;
+
+	// Find the actual range of the letters
+	size_t nFirst = 0, nLast = nLen;
+	while ((nFirst < nLen) && IsWordBreak(pText[nFirst]))
+		nFirst++;
+	while ((nLast > nFirst) && IsWordBreak(pText[nLast - 1]))
+		nLast--;
+	if (nFirst == nLast)
+		// Only spaces, nothing to do
+		return;
+	RECTL rcRun = rc;
+	if (arGlyphPos != NULL)
+	{
+		rcRun.left = arGlyphPos[nFirst].ptl.x;
+		rcRun.right = arGlyphPos[nLast - 1].ptl.x + (pWidths[nLast - 1].x.HighPart >> 4);
+	}
+	else
+	{
+		rcRun.left = rc.left + (long)(nFirst * nCharWidth);
+		rcRun.right = rc.left + (long)(nLast * nCharWidth);
+	}
+
+	// Capture it in its line
+	size_t nLines = m_text.GetBandCount();
+	if (arGlyphPos != NULL)
+		m_text.AddRun(pText, nLen, rc, arGlyphPos, pWidths);
+	else
+		m_text.AddRun(pText, nLen, rc, nCharWidth);
+	if (!m_text.IsInOrder())
+		// Not in reading order, Finish will search the lines
+		return;
+
+	// Does it continue the current line?
+	if (m_text.GetBandCount() == nLines)
+	{
+		// Yes; does it continue the last word too?
+		if ((nFirst > 0) || (m_lLineRight < rcRun.left - 2))
+			EndWord();
+		m_lLineRight = max(m_lLineRight, rcRun.right);
+	}
+	else
+	{
+		EndLine();
+		m_lLineRight = rcRun.right;
+	}
+
+	// Go over the text, break on spaces and such
+	for (size_t i = nFirst; i < nLen; i++)
+	{
+		WCHAR w = pText[i];
+		if (IsWordBreak(w))
+		{
+			// Space: the word is complete
+			EndWord();
+			continue;
+		}
+
+		// Add the letter with its location
+		long lX, lWidth;
+		if (arGlyphPos != NULL)
+		{
+			lX = arGlyphPos[i].ptl.x;
+			lWidth = pWidths[i].x.HighPart >> 4;
+		}
+		else
+		{
+			lX = rc.left + (long)(i * nCharWidth);
+			lWidth = nCharWidth;
+		}
+		if (m_word.empty())
+		{
+			m_lWordTop = rc.top;
+			m_lWordBottom = rc.bottom;
+		}
+		else
+		{
+			m_lWordTop = min(m_lWordTop, rc.top);
+			m_lWordBottom = max(m_lWordBottom, rc.bottom);
+		}
+		m_word.push_back(w);
+		m_wordX.push_back(lX);
+		m_lWordRight = lX + lWidth;
+	}
+	// The last word is kept: the next string may continue it
+}
+
+/**
+	@return The links found in all the text fed since Start(), in the order they appear in the page
+*/
+const LinkMatcher::MATCHES& LinkMatcher::Finish()
+{
+	EndLine();
+	if (!m_text.IsInOrder())
+	{
+		// Some strings joined earlier lines: search the whole lines instead
+		m_text.Finalize();
+		m_matches.clear();
+		Search(m_text, m_matches);
+	}
+	return m_matches;
+}
+
+/**
+	
+*/
+void LinkMatcher::EndLine()
+{
+	// Appearances cannot continue into another line
+	EndWord();
+	m_partials.clear();
+}
+
+/**
+	
+*/
+void LinkMatcher::EndWord()
+{
+	if (m_word.empty())
+		return;
+	const WCHAR* pLetters = &m_word[0];
+	size_t nCount = m_word.size();
+
+	// Continue the appearances in progress
+	size_t nKeep = 0;
+	for (size_t i = 0; i < m_partials.size(); i++)
+	{
+		Partial partial = m_partials[i];
+		Pattern& pattern = m_patterns[partial.nPattern];
+		// Already found, or overlapping an appearance that was completed?
+		if ((pattern.nFound >= pattern.nRepeat) || (partial.nStartWord < pattern.nNextWord))
+			continue;
+
+		// Middle words must match exactly, the last word only has to start the page word
+		const std::tstring& s = pattern.words[partial.nWords];
+		bool bLast = partial.nWords == pattern.words.size() - 1;
+		if ((bLast ? (nCount < s.size()) : (nCount != s.size())) || (wmemcmp(pLetters, s.data(), s.size()) != 0))
+			continue;
+		partial.lTop = min(partial.lTop, m_lWordTop);
+		partial.lBottom = max(partial.lBottom, m_lWordBottom);
+		if (bLast)
+			Found(pattern, partial.nStartWord, partial.lLeft, partial.lTop, partial.lBottom);
+		else
+		{
+			partial.nWords++;
+			m_partials[nKeep++] = partial;
+		}
+	}
+	m_partials.resize(nKeep);
+
+	// Hash each suffix of the word, from the shortest to the longest, to find new appearances
+	DWORD dwHash = HASH_START;
+	size_t nMaxLen = min(nCount, m_bLengths.size() - 1);
+	for (size_t nLen = 1; nLen <= nMaxLen; nLen++)
+	{
+		dwHash = HashLetter(dwHash, pLetters[nCount - nLen]);
+		// Does any link start with a word this long?
+		if (!m_bLengths[nLen])
+			continue;
+
+		// Check all the links with this hash
+		std::vector<HASHENTRY>::const_iterator iEntry = std::lower_bound(m_index.begin(), m_index.end(), HASHENTRY(dwHash, 0), CompareHash);
+		for (; (iEntry != m_index.end()) && ((*iEntry).first == dwHash); iEntry++)
+		{
+			Pattern& pattern = m_patterns[(*iEntry).second];
+			// Already found or overlapping the previous appearance?
+			if ((pattern.nFound >= pattern.nRepeat) || (m_nWord < pattern.nNextWord))
+				continue;
+			// Check the first word (the hash may be wrong)
+			const std::tstring& sFirst = pattern.words.front();
+			if (wmemcmp(pLetters + nCount - nLen, sFirst.data(), sFirst.size()) != 0)
+				continue;
+
+			if (pattern.words.size() == 1)
+				// That's all of it
+				Found(pattern, m_nWord, m_wordX[nCount - nLen], m_lWordTop, m_lWordBottom);
+			else
+			{
+				// Continue with the next words
+				Partial partial;
+				partial.nPattern = (*iEntry).second;
+				partial.nWords = 1;
+				partial.nStartWord = m_nWord;
+				partial.lLeft = m_wordX[nCount - nLen];
+				partial.lTop = m_lWordTop;
+				partial.lBottom = m_lWordBottom;
+				m_partials.push_back(partial);
+			}
+		}
+	}
+
+	// Next word
+	m_nWord++;
+	m_word.clear();
+	m_wordX.clear();
+}
+
+/**
+	@param pattern The found pattern
+	@param nStartWord The page word the appearance starts on
+	@param lLeft Left border of the appearance
+	@param lTop Top border of the appearance
+	@param lBottom Bottom border of the appearance
+
+	Called while the appearance's last word is the current word.
+*/
+void LinkMatcher::Found(Pattern& pattern, size_t nStartWord, long lLeft, long lTop, long lBottom)
+{
+	// Found it; is this the right appearance?
+	pattern.nNextWord = nStartWord + pattern.words.size();
+	pattern.nFound++;
+	if (pattern.nFound < pattern.nRepeat)
+		return;
+
+	// Yes, mark the location
+	Match match;
+	match.nLink = pattern.nLink;
+	match.rcArea.left = lLeft;
+	match.rcArea.top = lTop;
+	match.rcArea.right = m_lWordRight;
+	match.rcArea.bottom = lBottom;
+	m_matches.push_back(match);
+}
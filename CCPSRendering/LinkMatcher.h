@@ -0,0 +1,200 @@
+/**
+	@file
+	@brief Finds the location of text links in the page text
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _LINKMATCHER_H_
+#define _LINKMATCHER_H_
+
+#include <string>
+#include <vector>
+#include "CCTChar.h"
+#include "TextPart.h"
+
+/**
+    @brief Searches for all the text links of a page in one pass over the page text
+
+	Each link is an expression of words that must be found on the same line: the first word matches the end
+	of a page word, the last word matches the start of a page word, and the words between them must match exactly.
+	A link with a repeat count of N is placed on the N-th (non-overlapping) place its text is found.
+
+	The links are indexed by a hash of their first word, so each page word is only compared with the
+	links that can actually start on it.
+
+	The page can be searched in two ways: Search() goes over a whole captured TextArea, while Feed() matches
+	the printed strings as they arrive, keeping only the appearances that were started but not completed
+	yet (and the last word, which the next string may continue). Feed() also captures the strings in a
+	TextArea of its own, which decides if a string continues the current line or starts a new one. As long as
+	the text is printed in reading order, Finish() returns the links matched on the way, without putting the
+	page's lines together. If a string joins an earlier line (or goes left of the current line's strings),
+	matching in printing order would miss links split between strings, so the rest of the page is only
+	captured, and Finish() searches the merged lines instead. Either way the text is kept in the TextArea's
+	page arena, which is reused from page to page.
+*/
+class LinkMatcher
+{
+public:
+	/**
+		@brief A found link location
+	*/
+	struct Match
+	{
+		/// The link's ID (as specified in AddLink)
+		size_t			nLink;
+		/// The page location of the link's text
+		RECTL			rcArea;
+	};
+	/// Definition: list of found links
+	typedef std::vector<Match> MATCHES;
+
+	// Ctors
+	/**
+		@brief Default constructor
+	*/
+	LinkMatcher() : m_bCompiled(true), m_lWordRight(0), m_lWordTop(0), m_lWordBottom(0), m_lLineRight(0), m_nWord(0) {};
+
+protected:
+	/**
+		@brief A link to search for
+	*/
+	struct Pattern
+	{
+		/// The link's words
+		std::vector<std::tstring>	words;
+		/// Which appearance of the text is the link
+		int							nRepeat;
+		/// The link's ID
+		size_t						nLink;
+		/// Amount of times the text was found so far
+		int							nFound;
+		/// The first page word the next appearance can start on (appearances don't overlap)
+		size_t						nNextWord;
+	};
+	/**
+		@brief An appearance of a link that was started but not completed yet
+	*/
+	struct Partial
+	{
+		/// Index of the pattern
+		size_t						nPattern;
+		/// Amount of the pattern's words found so far
+		size_t						nWords;
+		/// The page word the appearance starts on
+		size_t						nStartWord;
+		/// Left border of the appearance
+		long						lLeft;
+		/// Top border of the appearance
+		long						lTop;
+		/// Bottom border of the appearance
+		long						lBottom;
+	};
+	/// Definition: first-word hash to pattern index
+	typedef std::pair<DWORD, size_t> HASHENTRY;
+
+	// Members
+	/// The links to search for
+	std::vector<Pattern>		m_patterns;
+	/// Hash of each pattern's first word, sorted by hash
+	std::vector<HASHENTRY>		m_index;
+	/// Flags for the first word lengths in use
+	std::vector<bool>			m_bLengths;
+	/// true if the index is up to date
+	bool						m_bCompiled;
+	/// Appearances in progress (Feed only)
+	std::vector<Partial>		m_partials;
+	/// The letters of the word being read (Feed only)
+	std::vector<WCHAR>			m_word;
+	/// The x-location of each letter of the word being read
+	std::vector<long>			m_wordX;
+	/// Right border of the word being read
+	long						m_lWordRight;
+	/// Top border of the word being read
+	long						m_lWordTop;
+	/// Bottom border of the word being read
+	long						m_lWordBottom;
+	/// Right border of the current line's strings
+	long						m_lLineRight;
+	/// Number of the next page word (Feed only)
+	size_t						m_nWord;
+	/// The links found so far (Feed only)
+	MATCHES						m_matches;
+	/// The strings fed, in lines (searched by Finish if they were not printed in reading order)
+	TextArea					m_text;
+
+public:
+	// Data Access
+	/**
+		@brief Checks if there are any links to search for
+		@return true if no links were added, false if there are links
+	*/
+	bool			IsEmpty() const {return m_patterns.empty();};
+
+	// Methods
+	/// Adds a link to search for
+	void			AddLink(const std::tstring& sText, int nRepeat, size_t nLink);
+	/// Searches for all the links in the page text
+	void			Search(const TextArea& text, MATCHES& matches);
+	/// Removes all the links
+	void			Clear();
+	/// Prepares for searching the text with Feed
+	void			Start();
+	/**
+		@brief Searches a printed string of a variable-width font
+		@param pText The printed text
+		@param nLen Length of the text
+		@param rc The text's printed location
+		@param arGlyphPos Array of glyph locations
+		@param pWidths Array of glyph widths
+	*/
+	void			Feed(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths) {Feed(pText, nLen, rc, arGlyphPos, pWidths, 0);};
+	/**
+		@brief Searches a printed string of a fixed-width font
+		@param pText The printed text
+		@param nLen Length of the text
+		@param rc The text's printed location
+		@param nCharWidth The width of each glyph
+	*/
+	void			Feed(const WCHAR* pText, size_t nLen, const RECTL& rc, int nCharWidth) {Feed(pText, nLen, rc, NULL, NULL, nCharWidth);};
+	/// Completes the search of the fed text
+	const MATCHES&	Finish();
+
+protected:
+	// Helpers
+	/// Builds the first-word index
+	void			Compile();
+	/// Searches for the links in one text line
+	void			MatchLine(const TextArea& text, const TextLine& line, MATCHES& matches);
+	/// Checks if a pattern matches the line at the specified word
+	bool			MatchAt(const TextArea& text, const TextLine& line, size_t nWord, size_t nPos, const Pattern& pattern) const;
+	/// Searches a printed string (variable-width if arGlyphPos is specified, fixed-width if not)
+	void			Feed(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths, int nCharWidth);
+	/// Matches the word that was read against the links
+	void			EndWord();
+	/// Drops the appearances in progress at the end of a line
+	void			EndLine();
+	/// Marks an appearance of a pattern as found
+	void			Found(Pattern& pattern, size_t nStartWord, long lLeft, long lTop, long lBottom);
+};
+
+#endif   //#define _LINKMATCHER_H_
@@ -0,0 +1,204 @@
+/**
+	@file
+	@brief Background thread that finds the links in printed pages
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "debug.h"
+#include "CCTChar.h"
+#include "LinkWorker.h"
+#include "URLScanner.h"
+
+/**
+	@param uURLFlags Link types to find (see URLScanner::Flags)
+*/
+LinkWorker::LinkWorker(UINT uURLFlags) : m_uURLFlags(uURLFlags), m_hThread(NULL), m_hWork(NULL), m_bStop(false)
+{
+	::InitializeCriticalSection(&m_cs);
+}
+
+/**
+	
+*/
+LinkWorker::~LinkWorker()
+{
+	// Make sure the thread is done
+	Finish();
+
+	// Free the text objects
+	for (std::deque<Job>::iterator i = m_queue.begin(); i != m_queue.end(); i++)
+		delete (*i).pText;
+	for (std::vector<TextArea*>::iterator i = m_free.begin(); i != m_free.end(); i++)
+		delete *i;
+	if (m_hWork != NULL)
+		::CloseHandle(m_hWork);
+	::DeleteCriticalSection(&m_cs);
+}
+
+/**
+	@return true if the thread is running, false if failed (pages will be processed when submitted)
+*/
+bool LinkWorker::Start()
+{
+	if (m_hThread != NULL)
+		return true;
+
+	// Create the event and the thread
+	m_bStop = false;
+	if (m_hWork == NULL)
+		m_hWork = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (m_hWork == NULL)
+		return false;
+	DWORD dwThreadID;
+	m_hThread = ::CreateThread(NULL, 0, WorkerThreadProc, (LPVOID)this, 0, &dwThreadID);
+	if (m_hThread == NULL)
+	{
+		// Failed!
+		VERBOSE(DLLTEXT("LinkWorker: cannot create thread, processing pages directly\r\n"));
+		return false;
+	}
+	return true;
+}
+
+/**
+	@param nPage The page number
+	@param text The page text; it's swapped with an empty object, so it's empty when the function returns
+*/
+void LinkWorker::Submit(UINT nPage, TextArea& text)
+{
+	// Get an empty object to swap with
+	Job job;
+	job.nPage = nPage;
+	::EnterCriticalSection(&m_cs);
+	if (m_free.empty())
+		job.pText = NULL;
+	else
+	{
+		job.pText = m_free.back();
+		m_free.pop_back();
+	}
+	::LeaveCriticalSection(&m_cs);
+	if (job.pText == NULL)
+		job.pText = new TextArea;
+	job.pText->Swap(text);
+
+	if (m_hThread == NULL)
+	{
+		// No thread, do it now
+		Process(job);
+		return;
+	}
+
+	// Queue it for the thread
+	::EnterCriticalSection(&m_cs);
+	m_queue.push_back(job);
+	::LeaveCriticalSection(&m_cs);
+	::SetEvent(m_hWork);
+}
+
+/**
+	@return The links found in all the submitted pages, in page order
+*/
+const LinkWorker::ANNOTATIONS& LinkWorker::Finish()
+{
+	if (m_hThread != NULL)
+	{
+		// Tell the thread to stop when it's done, and wait for it
+		::EnterCriticalSection(&m_cs);
+		m_bStop = true;
+		::LeaveCriticalSection(&m_cs);
+		::SetEvent(m_hWork);
+		::WaitForSingleObject(m_hThread, INFINITE);
+		::CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+	return m_annotations;
+}
+
+/**
+	@param lpData Pointer to the worker object
+	@return 0
+*/
+DWORD WINAPI LinkWorker::WorkerThreadProc(LPVOID lpData)
+{
+	((LinkWorker*)lpData)->Run();
+	return 0;
+}
+
+/**
+	
+*/
+void LinkWorker::Run()
+{
+	while (true)
+	{
+		::WaitForSingleObject(m_hWork, INFINITE);
+
+		// Process everything in the queue
+		while (true)
+		{
+			::EnterCriticalSection(&m_cs);
+			if (m_queue.empty())
+			{
+				bool bStop = m_bStop;
+				::LeaveCriticalSection(&m_cs);
+				if (bStop)
+					// All done
+					return;
+				break;
+			}
+			Job job = m_queue.front();
+			m_queue.pop_front();
+			::LeaveCriticalSection(&m_cs);
+
+			Process(job);
+		}
+	}
+}
+
+/**
+	@param job The page to process
+*/
+void LinkWorker::Process(const Job& job)
+{
+	// Find the URLs
+	job.pText->Finalize();
+	std::wstring sURL;
+	RECTL rcArea;
+	URLScanner scanner(*job.pText, m_uURLFlags);
+	while (scanner.Next(rcArea, sURL))
+	{
+		Annotation annotation;
+		annotation.nPage = job.nPage;
+		annotation.rcArea = rcArea;
+		annotation.sURL = MakeAnsiString(sURL);
+		m_annotations.push_back(annotation);
+	}
+
+	// Keep the object for another page
+	job.pText->Reset();
+	::EnterCriticalSection(&m_cs);
+	m_free.push_back(job.pText);
+	::LeaveCriticalSection(&m_cs);
+}
@@ -0,0 +1,122 @@
+/**
+	@file
+	@brief Background thread that finds the links in printed pages
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _LINKWORKER_H_
+#define _LINKWORKER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include "TextPart.h"
+
+/**
+    @brief Finds URLs in page text on a background thread, so the printing thread doesn't wait for it
+
+	Submit() takes the page text by swapping it with an empty (recycled) TextArea, so handing it over costs
+	no copy. The worker finds the URLs of each page and keeps them as annotations with their page number;
+	Finish() waits for all the pages and returns the annotations, to be written with explicit page targets.
+	If the thread cannot be started, pages are processed when submitted.
+*/
+class LinkWorker
+{
+public:
+	/**
+		@brief A link found in a page
+	*/
+	struct Annotation
+	{
+		/// The page the link is in (1 based)
+		UINT			nPage;
+		/// The link's area in the page
+		RECTL			rcArea;
+		/// The link's URL
+		std::string		sURL;
+	};
+	/// Definition: list of found links
+	typedef std::vector<Annotation> ANNOTATIONS;
+
+	// Ctors
+	/// Constructor
+	LinkWorker(UINT uURLFlags);
+	/// Destructor
+	~LinkWorker();
+
+protected:
+	/**
+		@brief A page waiting to be processed
+	*/
+	struct Job
+	{
+		/// Page number
+		UINT			nPage;
+		/// The page text (owned by the worker)
+		TextArea*		pText;
+	};
+
+	// Members
+	/// Link types to find (see URLScanner::Flags)
+	UINT				m_uURLFlags;
+	/// The worker thread (NULL if not running)
+	HANDLE				m_hThread;
+	/// Signaled when there's work to do (or the thread should stop)
+	HANDLE				m_hWork;
+	/// Lock for the queue and the free list
+	CRITICAL_SECTION	m_cs;
+	/// true when the thread should stop (once the queue is empty)
+	bool				m_bStop;
+	/// Pages waiting to be processed
+	std::deque<Job>		m_queue;
+	/// Processed (empty) text objects, ready to be swapped with the next page
+	std::vector<TextArea*>	m_free;
+	/// The links found (only used by the worker until Finish returns)
+	ANNOTATIONS			m_annotations;
+
+public:
+	// Methods
+	/// Starts the worker thread
+	bool				Start();
+	/// Hands a page's text to the worker (the object is left empty)
+	void				Submit(UINT nPage, TextArea& text);
+	/// Waits for all the pages to be processed and returns the links found
+	const ANNOTATIONS&	Finish();
+
+protected:
+	// Helpers
+	/// Worker thread function
+	static DWORD WINAPI	WorkerThreadProc(LPVOID lpData);
+	/// Processes pages until told to stop
+	void				Run();
+	/// Finds the links in a page
+	void				Process(const Job& job);
+
+private:
+	/// Not copyable
+	LinkWorker(const LinkWorker&);
+	/// Not copyable
+	LinkWorker& operator=(const LinkWorker&);
+};
+
+#endif   //#define _LINKWORKER_H_
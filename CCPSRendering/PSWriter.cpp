@@ -0,0 +1,327 @@
+/**
+	@file
+	@brief PostScript stream writer used by the rendering plugin
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include <PRCOMOEM.H>
+#include "PSWriter.h"
+
+/**
+	@brief Escape table for PostScript string literals: 0 for characters that can be copied as they are,
+			or the character to write after a backslash
+*/
+static const char s_cEscape[256] =
+{
+/*        0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F */
+/* 0 */   0,   0,   0,   0,   0,   0,   0,   0, 'b', 't', 'n',   0, 'f', 'r',   0,   0,
+/* 1 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 2 */   0,   0,   0,   0,   0,   0,   0,   0, '(', ')',   0,   0,   0,   0,   0,   0,
+/* 3 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 4 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 5 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,'\\',   0,   0,   0,
+/* 6 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 7 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 8 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* 9 */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* A */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* B */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* C */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* D */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* E */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+/* F */   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+/// Hex digits used for hex strings
+static const char s_cHex[] = "0123456789abcdef";
+
+/**
+	A space is not needed after whitespace or an opening bracket
+*/
+void PSWriter::Separate()
+{
+	if (m_sBuffer.empty())
+		return;
+	switch (m_sBuffer[m_sBuffer.size() - 1])
+	{
+		case ' ':
+		case '\n':
+		case '\r':
+		case '\t':
+		case '[':
+		case '{':
+		case '(':
+		case '<':
+			// Already separated
+			break;
+		default:
+			m_sBuffer += ' ';
+			break;
+	}
+}
+
+/**
+	@param uValue The number to write
+*/
+void PSWriter::AddDigits(unsigned long uValue)
+{
+	// Write the digits backwards into a small buffer
+	char cDigits[16];
+	int nPos = sizeof(cDigits);
+	do
+	{
+		cDigits[--nPos] = (char)('0' + (uValue % 10));
+		uValue /= 10;
+	} while (uValue != 0);
+	m_sBuffer.append(cDigits + nPos, sizeof(cDigits) - nPos);
+}
+
+/**
+	@param lNumber The number to add
+	@return This object
+*/
+PSWriter& PSWriter::AddNumber(long lNumber)
+{
+	Separate();
+	if (lNumber < 0)
+	{
+		m_sBuffer += '-';
+		AddDigits(0UL - (unsigned long)lNumber);
+	}
+	else
+		AddDigits((unsigned long)lNumber);
+	return *this;
+}
+
+/**
+	@param lpName The name (without the slash)
+	@param nLen Length of the name
+	@return This object
+*/
+PSWriter& PSWriter::AddName(const char* lpName, size_t nLen)
+{
+	Separate();
+	m_sBuffer += '/';
+	m_sBuffer.append(lpName, nLen);
+	return *this;
+}
+
+/**
+	@param lpOp The operator name
+	@param nLen Length of the name
+	@return This object
+*/
+PSWriter& PSWriter::AddOp(const char* lpOp, size_t nLen)
+{
+	Separate();
+	m_sBuffer.append(lpOp, nLen);
+	return *this;
+}
+
+/**
+	@param rect The rectangle to add
+	@return This object
+*/
+PSWriter& PSWriter::AddRect(const RECTL& rect)
+{
+	Separate();
+	m_sBuffer += '[';
+	AddNumber(rect.left);
+	AddNumber(rect.top);
+	AddNumber(rect.right);
+	AddNumber(rect.bottom);
+	m_sBuffer += ']';
+	return *this;
+}
+
+/**
+	@param lpText The text to add
+	@param nLen Length of the text
+	@return This object
+*/
+PSWriter& PSWriter::AddString(const char* lpText, size_t nLen)
+{
+	Separate();
+	m_sBuffer += '(';
+	AddEscaped(lpText, nLen);
+	m_sBuffer += ')';
+	return *this;
+}
+
+/**
+	@param lpText The text to add
+	@param nLen Length of the text
+	@return This object
+
+	Runs of characters that don't need escaping are copied in one go; the special characters (backslash,
+	parentheses and control characters) are escaped through a small local block, so densely escaped text
+	doesn't cost a buffer call per character.
+*/
+PSWriter& PSWriter::AddEscaped(const char* lpText, size_t nLen)
+{
+	char cBlock[256];
+	size_t nBlock = 0;
+	const char* pEnd = lpText + nLen;
+	const char* pRun = lpText;
+	while (pRun < pEnd)
+	{
+		// Find the end of the clean run
+		const char* pPos = pRun;
+		while ((pPos < pEnd) && (s_cEscape[(BYTE)*pPos] == 0))
+			pPos++;
+
+		// Copy the clean run (short ones go through the block)
+		size_t nRun = pPos - pRun;
+		if (nBlock + nRun + 2 > sizeof(cBlock))
+		{
+			m_sBuffer.append(cBlock, nBlock);
+			nBlock = 0;
+		}
+		if (nRun + 2 > sizeof(cBlock))
+			m_sBuffer.append(pRun, nRun);
+		else
+		{
+			memcpy(cBlock + nBlock, pRun, nRun);
+			nBlock += nRun;
+		}
+		if (pPos == pEnd)
+			break;
+
+		// Escape the special character
+		cBlock[nBlock++] = '\\';
+		cBlock[nBlock++] = s_cEscape[(BYTE)*pPos];
+		pRun = pPos + 1;
+	}
+	m_sBuffer.append(cBlock, nBlock);
+	return *this;
+}
+
+/**
+	@param pData The data to add
+	@param nLen Size of the data
+	@return This object
+*/
+PSWriter& PSWriter::AddHexString(const BYTE* pData, size_t nLen)
+{
+	Separate();
+	m_sBuffer += '<';
+	AddHex(pData, nLen);
+	m_sBuffer += '>';
+	return *this;
+}
+
+/**
+	@param pData The data to add
+	@param nLen Size of the data
+	@return This object
+*/
+PSWriter& PSWriter::AddHex(const BYTE* pData, size_t nLen)
+{
+	// Convert in blocks through a local buffer
+	char cBlock[512];
+	while (nLen > 0)
+	{
+		size_t nBlock = min(nLen, sizeof(cBlock) / 2);
+		char* pOut = cBlock;
+		for (size_t i = 0; i < nBlock; i++)
+		{
+			*pOut++ = s_cHex[pData[i] >> 4];
+			*pOut++ = s_cHex[pData[i] & 0x0F];
+		}
+		m_sBuffer.append(cBlock, nBlock * 2);
+		pData += nBlock;
+		nLen -= nBlock;
+	}
+	return *this;
+}
+
+/**
+	@param pData The data to add
+	@param nLen Size of the data
+	@return This object
+
+	Every 4 bytes become 5 characters (or 'z' for 4 zero bytes), so the data only grows by a quarter
+	instead of doubling as hex digits do. Lines are kept under 80 characters.
+*/
+PSWriter& PSWriter::AddASCII85(const BYTE* pData, size_t nLen)
+{
+	char cLine[84];
+	size_t nLine = 0;
+	while (nLen > 0)
+	{
+		// Next group (a partial last group is padded with zeros, and only its first bytes + 1 characters are written)
+		size_t nGroup = min(nLen, (size_t)4);
+		DWORD dwValue = 0;
+		for (size_t i = 0; i < 4; i++)
+			dwValue = (dwValue << 8) | ((i < nGroup) ? pData[i] : 0);
+		pData += nGroup;
+		nLen -= nGroup;
+
+		if ((dwValue == 0) && (nGroup == 4))
+			cLine[nLine++] = 'z';
+		else
+		{
+			char cDigits[5];
+			for (int i = 4; i >= 0; i--)
+			{
+				cDigits[i] = (char)('!' + (dwValue % 85));
+				dwValue /= 85;
+			}
+			memcpy(cLine + nLine, cDigits, nGroup + 1);
+			nLine += nGroup + 1;
+		}
+
+		// Line full?
+		if (nLine >= 75)
+		{
+			cLine[nLine++] = '\n';
+			m_sBuffer.append(cLine, nLine);
+			nLine = 0;
+		}
+	}
+	m_sBuffer.append(cLine, nLine);
+	m_sBuffer.append("~>\n", 3);
+	return *this;
+}
+
+/**
+	@param pdevobj Pointer to the device object representing the PostScript printer
+	@param pOEMHelp Pointer to the driver helper object
+	@return true if the whole buffer was written, false if failed
+*/
+bool PSWriter::Flush(PDEVOBJ pdevobj, IPrintOemDriverPS* pOEMHelp)
+{
+	// Anything to write?
+	if (m_sBuffer.empty())
+		return true;
+
+	// Write it all in one call
+	DWORD dwResult = 0;
+	HRESULT hRes = pOEMHelp->DrvWriteSpoolBuf(pdevobj, (void*)m_sBuffer.data(), (DWORD)m_sBuffer.size(), &dwResult);
+	bool bRet = SUCCEEDED(hRes) && (dwResult == (DWORD)m_sBuffer.size());
+
+	// Keep the memory for the next write
+	Clear();
+	return bRet;
+}
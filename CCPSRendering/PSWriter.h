@@ -0,0 +1,146 @@
+/**
+	@file
+	@brief PostScript stream writer used by the rendering plugin
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _PSWRITER_H_
+#define _PSWRITER_H_
+
+#include <string>
+
+/**
+    @brief Growing buffer of PostScript code with typed append operations
+
+	The buffer has no size limit; it keeps its capacity between flushes, so a writer that is reused
+	for the whole print job stops allocating after the first few pages.
+	Numbers, names and operators are separated from the previous token automatically.
+*/
+class PSWriter
+{
+public:
+	/**
+		@brief Default constructor
+	*/
+	PSWriter() {};
+
+protected:
+	// Members
+	/// The PostScript code collected so far
+	std::string		m_sBuffer;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the collected PostScript code
+		@return Pointer to the buffer (not NULL terminated)
+	*/
+	const char*		GetData() const {return m_sBuffer.data();};
+	/**
+		@brief Returns the size of the collected PostScript code
+		@return Size of the buffer in bytes
+	*/
+	size_t			GetSize() const {return m_sBuffer.size();};
+	/**
+		@brief Checks if there's anything to write
+		@return true if the buffer is empty, false if not
+	*/
+	bool			IsEmpty() const {return m_sBuffer.empty();};
+	/**
+		@brief Empties the buffer (keeps the allocated memory)
+	*/
+	void			Clear() {m_sBuffer.erase();};
+
+	// Append operations
+	/**
+		@brief Adds literal PostScript code (compile-time length, no strlen)
+		@param lpText The code to add
+		@return This object
+	*/
+	template <size_t N>
+	PSWriter&		Add(const char (&lpText)[N]) {m_sBuffer.append(lpText, N - 1); return *this;};
+	/**
+		@brief Adds literal PostScript code
+		@param lpText The code to add
+		@param nLen Length of the code
+		@return This object
+	*/
+	PSWriter&		Add(const char* lpText, size_t nLen) {m_sBuffer.append(lpText, nLen); return *this;};
+	/**
+		@brief Adds literal PostScript code
+		@param s The code to add
+		@return This object
+	*/
+	PSWriter&		Add(const std::string& s) {m_sBuffer.append(s); return *this;};
+	/// Adds an integer number token
+	PSWriter&		AddNumber(long lNumber);
+	/// Adds a literal name token (/name)
+	PSWriter&		AddName(const char* lpName, size_t nLen);
+	/**
+		@brief Adds a literal name token (/name)
+		@param lpName The name (without the slash)
+		@return This object
+	*/
+	template <size_t N>
+	PSWriter&		AddName(const char (&lpName)[N]) {return AddName(lpName, N - 1);};
+	/// Adds an executable name token (an operator or procedure call)
+	PSWriter&		AddOp(const char* lpOp, size_t nLen);
+	/**
+		@brief Adds an executable name token (an operator or procedure call)
+		@param lpOp The operator name
+		@return This object
+	*/
+	template <size_t N>
+	PSWriter&		AddOp(const char (&lpOp)[N]) {return AddOp(lpOp, N - 1);};
+	/// Adds a rectangle as a 4-number array ([left top right bottom])
+	PSWriter&		AddRect(const RECTL& rect);
+	/// Adds the text as an escaped PostScript string literal: (text)
+	PSWriter&		AddString(const char* lpText, size_t nLen);
+	/**
+		@brief Adds the text as an escaped PostScript string literal: (text)
+		@param s The text to add
+		@return This object
+	*/
+	PSWriter&		AddString(const std::string& s) {return AddString(s.data(), s.size());};
+	/// Adds the text escaped for use inside a PostScript string literal (no parentheses)
+	PSWriter&		AddEscaped(const char* lpText, size_t nLen);
+	/// Adds binary data as a PostScript hex string: <data>
+	PSWriter&		AddHexString(const BYTE* pData, size_t nLen);
+	/// Adds binary data as hex digits (no brackets, no line breaks)
+	PSWriter&		AddHex(const BYTE* pData, size_t nLen);
+	/// Adds binary data as ASCII base-85 lines, ending with the ~> end of data marker
+	PSWriter&		AddASCII85(const BYTE* pData, size_t nLen);
+
+	// Methods
+	/// Writes the buffer into the spool file and empties it
+	bool			Flush(PDEVOBJ pdevobj, struct IPrintOemDriverPS* pOEMHelp);
+
+protected:
+	// Helpers
+	/// Adds a space if the last character does not already separate tokens
+	void			Separate();
+	/// Adds the decimal digits of a number
+	void			AddDigits(unsigned long uValue);
+};
+
+#endif   //#define _PSWRITER_H_
@@ -0,0 +1,172 @@
+/**
+	@file
+	@brief Reads the compressed image data of a PNG file without decoding it
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "PngStream.h"
+
+/// The PNG file signature
+static const BYTE s_cSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/**
+	@param pData Pointer to the 4 bytes
+	@return The number
+*/
+DWORD PngStream::ReadDWORD(const BYTE* pData)
+{
+	return ((DWORD)pData[0] << 24) | ((DWORD)pData[1] << 16) | ((DWORD)pData[2] << 8) | pData[3];
+}
+
+/**
+	
+*/
+void PngStream::Clear()
+{
+	m_nWidth = m_nHeight = m_nBitDepth = m_nColors = 0;
+	m_eColorType = CT_GRAY;
+	m_arData.clear();
+}
+
+/**
+	@return The number of samples per pixel (palette images have a single sample, the index)
+*/
+int PngStream::GetSamples() const
+{
+	switch (m_eColorType)
+	{
+		case CT_RGB:
+			return 3;
+		case CT_GRAYALPHA:
+			return 2;
+		case CT_RGBALPHA:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+/**
+	@param pData The PNG file data
+	@param nSize Size of the data
+	@return true if the image was read and can be written as a /FlateDecode image, false if not
+
+	The chunk CRCs are not checked: the data is passed on as it is, and the PostScript interpreter checks the
+	zlib stream's own checksum when it decodes it.
+*/
+bool PngStream::LoadFromBuffer(const BYTE* pData, size_t nSize)
+{
+	Clear();
+	if ((nSize < sizeof(s_cSignature)) || (memcmp(pData, s_cSignature, sizeof(s_cSignature)) != 0))
+		return false;
+
+	// Collect the chunks we need (each is length, type, data and CRC)
+	bool bHeader = false;
+	size_t nPos = sizeof(s_cSignature);
+	while (nPos + 12 <= nSize)
+	{
+		DWORD dwLength = ReadDWORD(pData + nPos);
+		const BYTE* pType = pData + nPos + 4;
+		const BYTE* pChunk = pData + nPos + 8;
+		if (dwLength > nSize - nPos - 12)
+			// Truncated
+			break;
+		nPos += 12 + dwLength;
+
+		if (memcmp(pType, "IHDR", 4) == 0)
+		{
+			if (dwLength < 13)
+				break;
+			m_nWidth = (int)ReadDWORD(pChunk);
+			m_nHeight = (int)ReadDWORD(pChunk + 4);
+			m_nBitDepth = pChunk[8];
+			m_eColorType = (ColorType)pChunk[9];
+			// Compression and filter methods must be the standard ones, and the rows can't be interlaced
+			if ((pChunk[10] != 0) || (pChunk[11] != 0) || (pChunk[12] != 0))
+				break;
+			bHeader = true;
+		}
+		else if (memcmp(pType, "PLTE", 4) == 0)
+		{
+			m_nColors = min((int)(dwLength / 3), 256);
+			memcpy(m_cPalette, pChunk, m_nColors * 3);
+		}
+		else if (memcmp(pType, "IDAT", 4) == 0)
+			m_arData.insert(m_arData.end(), pChunk, pChunk + dwLength);
+		else if (memcmp(pType, "IEND", 4) == 0)
+		{
+			// Only palette images use the palette (others may have one as a suggestion)
+			if (m_eColorType != CT_PALETTE)
+				m_nColors = 0;
+			if (!bHeader || m_arData.empty() || (m_nWidth <= 0) || (m_nHeight <= 0))
+				break;
+
+			// Check that PostScript can take this kind of image
+			switch (m_eColorType)
+			{
+				case CT_GRAY:
+					if (m_nBitDepth > 8)
+						break;
+					return true;
+				case CT_PALETTE:
+					if ((m_nBitDepth > 8) || (m_nColors == 0))
+						break;
+					return true;
+				case CT_RGB:
+				case CT_GRAYALPHA:
+				case CT_RGBALPHA:
+					if (m_nBitDepth != 8)
+						break;
+					return true;
+			}
+			break;
+		}
+	}
+
+	Clear();
+	return false;
+}
+
+/**
+	@param uResourceID ID of the resource
+	@param hModule Module that holds the resource (NULL for the current executable)
+	@param lpType Type of the resource
+	@return true if the image was read and can be written as a /FlateDecode image, false if not
+*/
+bool PngStream::LoadFromResource(UINT uResourceID, HMODULE hModule /* = NULL */, LPCTSTR lpType /* = _T("PNG") */)
+{
+	Clear();
+	HRSRC hResource = FindResource(hModule, MAKEINTRESOURCE(uResourceID), lpType);
+	if (hResource == NULL)
+		return false;
+	DWORD dwSize = SizeofResource(hModule, hResource);
+	HGLOBAL hData = LoadResource(hModule, hResource);
+	if ((dwSize == 0) || (hData == NULL))
+		return false;
+	LPVOID lpData = LockResource(hData);
+	if (lpData == NULL)
+		return false;
+
+	return LoadFromBuffer((const BYTE*)lpData, dwSize);
+}
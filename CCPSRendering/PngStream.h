@@ -0,0 +1,140 @@
+/**
+	@file
+	@brief Reads the compressed image data of a PNG file without decoding it
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _PNGSTREAM_H_
+#define _PNGSTREAM_H_
+
+#include <vector>
+
+/**
+    @brief The header, palette and compressed pixel data of a PNG image
+
+	Only the chunks needed for writing the image as a PostScript /FlateDecode image are read: the IDAT
+	chunks form a single zlib stream of filtered rows, which PostScript's FlateDecode filter with PNG
+	predictors (/Predictor 15) decodes by itself. Images PostScript cannot take this way (interlaced,
+	16 bits per sample) are refused, and should be decoded with PngImage instead.
+*/
+class PngStream
+{
+public:
+	/// PNG color types
+	enum ColorType
+	{
+		/// Grey levels
+		CT_GRAY = 0,
+		/// RGB
+		CT_RGB = 2,
+		/// Palette indices
+		CT_PALETTE = 3,
+		/// Grey levels with alpha
+		CT_GRAYALPHA = 4,
+		/// RGB with alpha
+		CT_RGBALPHA = 6
+	};
+
+	// Ctors
+	/**
+		@brief Default constructor
+	*/
+	PngStream() : m_nWidth(0), m_nHeight(0), m_nBitDepth(0), m_eColorType(CT_GRAY), m_nColors(0) {};
+
+protected:
+	// Members
+	/// Width of the image (pixels)
+	int					m_nWidth;
+	/// Height of the image (lines)
+	int					m_nHeight;
+	/// Bits per sample
+	int					m_nBitDepth;
+	/// Color type
+	ColorType			m_eColorType;
+	/// The palette (RGB triplets, for palette images)
+	BYTE				m_cPalette[256 * 3];
+	/// Number of colors in the palette
+	int					m_nColors;
+	/// The zlib stream (all the IDAT chunks' data)
+	std::vector<BYTE>	m_arData;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the image width
+		@return The image width
+	*/
+	int					GetWidth() const {return m_nWidth;};
+	/**
+		@brief Returns the image height
+		@return The image height
+	*/
+	int					GetHeight() const {return m_nHeight;};
+	/**
+		@brief Returns the number of bits in each sample
+		@return Bits per sample (1, 2, 4 or 8)
+	*/
+	int					GetBitDepth() const {return m_nBitDepth;};
+	/**
+		@brief Returns the image's color type
+		@return The color type
+	*/
+	ColorType			GetColorType() const {return m_eColorType;};
+	/// Returns the number of samples in each pixel
+	int					GetSamples() const;
+	/**
+		@brief Returns the palette
+		@return Pointer to the RGB triplets of the palette
+	*/
+	const BYTE*			GetPalette() const {return m_cPalette;};
+	/**
+		@brief Returns the number of colors in the palette
+		@return Number of colors (0 if not a palette image)
+	*/
+	int					GetColorCount() const {return m_nColors;};
+	/**
+		@brief Returns the compressed image data
+		@return Pointer to the zlib stream
+	*/
+	const BYTE*			GetData() const {return m_arData.empty() ? NULL : &m_arData[0];};
+	/**
+		@brief Returns the size of the compressed image data
+		@return Size of the zlib stream in bytes
+	*/
+	size_t				GetDataSize() const {return m_arData.size();};
+
+	// Methods
+	/// Reads the image from a PNG file in memory
+	bool				LoadFromBuffer(const BYTE* pData, size_t nSize);
+	/// Reads the image from a PNG resource
+	bool				LoadFromResource(UINT uResourceID, HMODULE hModule = NULL, LPCTSTR lpType = _T("PNG"));
+	/// Empties the object
+	void				Clear();
+
+protected:
+	// Helpers
+	/// Reads a big-endian 32 bit number
+	static DWORD		ReadDWORD(const BYTE* pData);
+};
+
+#endif   //#define _PNGSTREAM_H_
@@ -0,0 +1,159 @@
+/**
+	@file
+	@brief Driver-side text layout for the plugin's own pages: Times-Roman widths and line breaking
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "TextLayout.h"
+
+/// First character in the width table
+#define TIMES_FIRST_CHAR	32
+/// Width used for characters not in the table
+#define TIMES_DEFAULT_WIDTH	500
+
+/// Times-Roman character widths (from the Adobe AFM file) for characters 32 to 126, in 1/1000 of the font size
+static const short s_nTimesWidths[] =
+{
+/*        0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F */
+/* 2 */ 250, 333, 408, 500, 500, 833, 778, 333, 333, 333, 500, 564, 250, 333, 250, 278,
+/* 3 */ 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 278, 278, 564, 564, 564, 444,
+/* 4 */ 921, 722, 667, 667, 722, 611, 556, 722, 722, 333, 389, 722, 611, 889, 722, 722,
+/* 5 */ 556, 722, 667, 556, 611, 722, 722, 944, 722, 722, 611, 333, 278, 333, 469, 500,
+/* 6 */ 333, 444, 500, 444, 500, 444, 333, 500, 500, 278, 278, 500, 278, 778, 500, 500,
+/* 7 */ 500, 500, 333, 389, 278, 500, 500, 722, 500, 500, 444, 480, 200, 480, 541,
+};
+
+/**
+	@param c The character
+	@return The character's width, in 1/1000 of the font size
+*/
+int TextLayout::GetCharWidth(char c)
+{
+	BYTE b = (BYTE)c;
+	if (b < TIMES_FIRST_CHAR)
+		return 0;
+	if (b - TIMES_FIRST_CHAR >= (int)(sizeof(s_nTimesWidths) / sizeof(s_nTimesWidths[0])))
+		return TIMES_DEFAULT_WIDTH;
+	return s_nTimesWidths[b - TIMES_FIRST_CHAR];
+}
+
+/**
+	@param pText The text to measure
+	@param nLen Length of the text
+	@param nFontSize Size of the font
+	@return The width of the text, in device units
+*/
+long TextLayout::GetWidth(const char* pText, size_t nLen, int nFontSize)
+{
+	long lUnits = 0;
+	for (size_t i = 0; i < nLen; i++)
+		lUnits += GetCharWidth(pText[i]);
+	return ToDevice(lUnits, nFontSize);
+}
+
+/**
+	@param pText The text to break
+	@param nLen Length of the text
+	@param nFontSize Size of the font
+	@param lMaxWidth Maximal width of a line (in device units)
+	@param lines Receives the lines (any existing lines are removed)
+
+	Lines are broken greedily on the last space that fits; a word that is wider than a line by itself is broken
+	where the line is full. New line characters always end a line.
+*/
+void TextLayout::Wrap(const char* pText, size_t nLen, int nFontSize, long lMaxWidth, LINES& lines)
+{
+	lines.clear();
+	if (nFontSize <= 0)
+		return;
+	// Work in font units to avoid rounding each character
+	long lMaxUnits = (lMaxWidth * 1000) / nFontSize;
+
+	size_t nPos = 0;
+	while (nPos < nLen)
+	{
+		Line line;
+		line.nStart = nPos;
+		long lUnits = 0;
+		// Last place we can break the line on (the line's end, and the width up to it)
+		size_t nBreak = 0;
+		long lBreakUnits = 0;
+		bool bHasBreak = false;
+		size_t i = nPos;
+		for (; i < nLen; i++)
+		{
+			char c = pText[i];
+			if ((c == '\n') || (c == '\r'))
+				break;
+			if (c == ' ')
+			{
+				// Can break here (if there's something before it)
+				if (i > nPos)
+				{
+					nBreak = i;
+					lBreakUnits = lUnits;
+					bHasBreak = true;
+				}
+			}
+			else if ((lUnits + GetCharWidth(c) > lMaxUnits) && (i > nPos))
+				// Doesn't fit
+				break;
+			lUnits += GetCharWidth(c);
+		}
+
+		if ((i < nLen) && (pText[i] != '\n') && (pText[i] != '\r'))
+		{
+			// The line is full: break on the last space, or in the middle of the word if it has no spaces
+			if (bHasBreak)
+			{
+				i = nBreak;
+				lUnits = lBreakUnits;
+			}
+			line.nLen = i - nPos;
+			nPos = i;
+			// The next line starts at the next word
+			while ((nPos < nLen) && (pText[nPos] == ' '))
+				nPos++;
+		}
+		else
+		{
+			// End of the text or the paragraph
+			line.nLen = i - nPos;
+			nPos = i;
+			if ((nPos < nLen) && (pText[nPos] == '\r'))
+				nPos++;
+			if ((nPos < nLen) && (pText[nPos] == '\n'))
+				nPos++;
+		}
+
+		// Trailing spaces don't count
+		while ((line.nLen > 0) && (pText[line.nStart + line.nLen - 1] == ' '))
+		{
+			line.nLen--;
+			lUnits -= GetCharWidth(' ');
+		}
+		line.lWidth = ToDevice(lUnits, nFontSize);
+		lines.push_back(line);
+	}
+}
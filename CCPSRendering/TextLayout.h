@@ -0,0 +1,71 @@
+/**
+	@file
+	@brief Driver-side text layout for the plugin's own pages: Times-Roman widths and line breaking
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _TEXTLAYOUT_H_
+#define _TEXTLAYOUT_H_
+
+#include <vector>
+
+/**
+    @brief Measures and breaks text printed in Times-Roman (the font the plugin uses for its own text)
+
+	The widths are the Adobe Times-Roman metrics, so the text can be wrapped and centered before it is written:
+	the PostScript code just moves to each line's location and shows it, without measuring anything.
+	The text is treated as single-byte; characters outside the printable ASCII range get an average width.
+*/
+class TextLayout
+{
+public:
+	/**
+		@brief A single line of wrapped text
+	*/
+	struct Line
+	{
+		/// Offset of the line's first character in the text
+		size_t	nStart;
+		/// Number of characters in the line (without the spaces it was broken on)
+		size_t	nLen;
+		/// Width of the line (in device units)
+		long	lWidth;
+	};
+	/// Definition: list of lines
+	typedef std::vector<Line> LINES;
+
+	// Methods
+	/// Returns the width of a text (in device units)
+	static long		GetWidth(const char* pText, size_t nLen, int nFontSize);
+	/// Breaks a text into lines that fit a width
+	static void		Wrap(const char* pText, size_t nLen, int nFontSize, long lMaxWidth, LINES& lines);
+
+protected:
+	// Helpers
+	/// Returns the width of a character (in 1/1000 of the font size)
+	static int		GetCharWidth(char c);
+	/// Converts a width from 1/1000 of the font size to device units
+	static long		ToDevice(long lUnits, int nFontSize) {return (lUnits * nFontSize + 500) / 1000;};
+};
+
+#endif   //#define _TEXTLAYOUT_H_
@@ -25,407 +25,325 @@
  */
 
 #include "precomp.h"
+#include <algorithm>
 
 #include "debug.h"
 #include "TextPart.h"
 
 /**
-	@param s The sentence's text
-	@param arGlyphPos The location of each letter
-	@param pWidths The widths of each letter
-	@param nStart The first letter to use
-	@param nEnd The last letter to use
+	@brief Checks if two rectangles are on the same line
+	@param rect1 First line to check
+	@param rect2 Second line to check
+	@return true if the rectangles are more-or-less on the same line, false if not
 */
-TextWord::TextWord(const std::wstring& s, const PGLYPHPOS& arGlyphPos, const POINTQF* pWidths, std::tstring::size_type nStart, std::tstring::size_type nEnd /* = -1 */)
+bool OnSameLine(const RECTL& rect1, const RECTL& rect2)
 {
-	// Calculate the end of the word if not specified
-	if (nEnd == -1)
-		nEnd = s.size();
-	// Go over the data
-	for (; nStart < nEnd; nStart++)
-	{
-		// Add a letter object from each letter and position
-		ASSERT(s[nStart] != ' ');
-		push_back(TextLetter(s[nStart], arGlyphPos[nStart].ptl.x, pWidths[nStart].x.HighPart >> 4));
-	}
+	int nMiddle1 = (rect1.top + rect1.bottom) / 2, nMiddle2 = (rect2.top + rect2.bottom) / 2;
+	return ((nMiddle1 >= rect2.top) && (nMiddle1 <= rect2.bottom)) || ((nMiddle2 >= rect1.top) && (nMiddle2 <= rect1.bottom));
 }
 
 /**
-	@param s The sentence's text
-	@param nCharWidth The width of each glyph
-	@param nStart The first letter to use
-	@param nEnd The last letter to use
+    @brief Sort order of runs: left to right (printing order for runs that start at the same place)
 */
-TextWord::TextWord(const std::wstring& s, int nCharWidth, std::tstring::size_type nStart, std::tstring::size_type nEnd /* = -1 */)
+struct RunLeftLess
 {
-	// Calculate the end of the word if not specified
-	if (nEnd == -1)
-		nEnd = s.size();
-	// Go over the data
-	for (; nStart < nEnd; nStart++)
+	/// Constructor
+	RunLeftLess(const TextRun* pRuns) : m_pRuns(pRuns) {};
+	/// Comparison operator
+	bool operator()(size_t nRun1, size_t nRun2) const
 	{
-		// Add a letter object from each letter and position
-		ASSERT(s[nStart] != ' ');
-		push_back(TextLetter(s[nStart], (long) (nStart * nCharWidth), nCharWidth));
-	}
-}
-
-
+		long lLeft1 = m_pRuns[nRun1].rcArea.left, lLeft2 = m_pRuns[nRun2].rcArea.left;
+		return (lLeft1 < lLeft2) || ((lLeft1 == lLeft2) && (nRun1 < nRun2));
+	};
+	/// The runs
+	const TextRun*	m_pRuns;
+};
 
 /**
-	@param s The line's text
-	@param rc The line's printed location
-	@param arGlyphPos Array of glyph locations
-	@param pWidths Array of glyph widths
+	@param pText The printed text
+	@param nLen Length of the text
+	@param rc The text's printed location
+	@param arGlyphPos Array of glyph locations (NULL for a fixed-width font)
+	@param pWidths Array of glyph widths (NULL for a fixed-width font)
+	@param nCharWidth The width of each glyph (fixed-width font only)
 */
-TextLine::TextLine(const std::wstring& s, const RECTL& rc, const PGLYPHPOS& arGlyphPos, const POINTQF* pWidths) : rcArea(rc)
+void TextArea::AddRun(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths, int nCharWidth)
 {
+	size_t nFirstLetter = m_arRunLetters.size(), nFirstWord = m_arRunWords.size();
+
 	// Go over the text, break on spaces and such
-	size_t nPos = 0, nEndPos = s.find_first_of(_T(" \r\n\t"));
-	while (nEndPos != std::wstring::npos)
+	bool bInWord = false;
+	for (size_t i = 0; i < nLen; i++)
 	{
-		// Do we have something here?
-		if (nEndPos > nPos)
-			// Yes, add the word
-			push_back(TextWord(s, arGlyphPos, pWidths, nPos, nEndPos));
+		WCHAR w = pText[i];
+		if ((w == ' ') || (w == '\r') || (w == '\n') || (w == '\t'))
+		{
+			// Space: the next letter starts a new word
+			bInWord = false;
+			continue;
+		}
+
+		if (!bInWord)
+		{
+			// Start a new word
+			TextWord word;
+			word.nFirst = m_arRunLetters.size();
+			word.nCount = 0;
+			m_arRunWords.push_back(m_arena, word);
+			bInWord = true;
+		}
 
-		// Move on
-		nPos = nEndPos + 1;
-		if (nPos < s.size())
-			// Find end of space
-			nEndPos = s.find_first_of(_T(" \r\n\t"), nPos);
+		// Add the letter with its location
+		m_arRunLetters.push_back(m_arena, w);
+		if (arGlyphPos != NULL)
+		{
+			m_arRunX.push_back(m_arena, arGlyphPos[i].ptl.x);
+			m_arRunWidth.push_back(m_arena, pWidths[i].x.HighPart >> 4);
+		}
 		else
-			// Ah, finished
-			nEndPos = std::wstring::npos;
+		{
+			m_arRunX.push_back(m_arena, rc.left + (long)(i * nCharWidth));
+			m_arRunWidth.push_back(m_arena, nCharWidth);
+		}
+		m_arRunWords.back().nCount++;
 	}
-	if (nPos < s.size())
-		// Add the last word
-		push_back(TextWord(s, arGlyphPos, pWidths, nPos));
 
-	// Update the line rectangle
-	SetSides();
-}
+	// Did we have anything but spaces?
+	if (m_arRunWords.size() == nFirstWord)
+		// No, don't put in empty lines
+		return;
 
-/**
-	@param s The line's text
-	@param rc The line's printed location
-	@param nCharWidth The width of each glyph (fixed font)
-*/
-TextLine::TextLine(const std::wstring& s, const RECTL& rc, int nCharWidth) : rcArea(rc)
-{
-	// Go over the text, break on spaces and such
-	std::tstring::size_type nPos = 0, nEndPos = s.find_first_of(_T(" \r\n\t"));
-	while (nEndPos != std::wstring::npos)
+	// Create the run, getting the range from the actual letters (it could be larger)
+	TextRun run;
+	run.rcArea = rc;
+	run.rcArea.left = m_arRunX[nFirstLetter];
+	run.rcArea.right = m_arRunX[m_arRunLetters.size() - 1] + m_arRunWidth[m_arRunLetters.size() - 1];
+	run.nFirstWord = nFirstWord;
+	run.nWords = m_arRunWords.size() - nFirstWord;
+	run.nNext = NONE;
+	size_t nRun = m_arRuns.size();
+	m_arRuns.push_back(m_arena, run);
+
+	// Is there a line it's on?
+	size_t nBand = FindBand(run.rcArea);
+	if (nBand == NONE)
 	{
-		// Do we have something here?
-		if (nEndPos > nPos)
-			// Yes, add the word
-			push_back(TextWord(s, nCharWidth, nPos, nEndPos));
-
-		// Move on
-		nPos = nEndPos + 1;
-		if (nPos < s.size())
-			// Find end of space
-			nEndPos = s.find_first_of(_T(" \r\n\t"), nPos);
-		else
-			// Ah, finished
-			nEndPos = std::wstring::npos;
+		// No, start a new one
+		AddBand(nRun);
+		return;
 	}
-	if (nPos < s.size())
-		// Add the last word
-		push_back(TextWord(s, nCharWidth, nPos));
 
-	// Update the line rectangle
-	SetSides();
+	// Yes, chain it to the line (Finalize puts it in place if it's not the last line or not to the right of it)
+	TextBand& band = m_arBands[nBand];
+	if ((nBand != m_nLastBand) || (run.rcArea.left < m_arRuns[band.nLastRun].rcArea.left))
+		m_bInOrder = false;
+	m_arRuns[band.nLastRun].nNext = nRun;
+	band.nLastRun = nRun;
+	band.rcArea.left = min(band.rcArea.left, run.rcArea.left);
+	band.rcArea.right = max(band.rcArea.right, run.rcArea.right);
+	band.rcArea.top = min(band.rcArea.top, run.rcArea.top);
+	band.rcArea.bottom = max(band.rcArea.bottom, run.rcArea.bottom);
+	m_lMaxHeight = max(m_lMaxHeight, band.rcArea.bottom - band.rcArea.top);
+	m_nLastBand = nBand;
 }
 
 /**
-	@brief Checks if two rectangles are on the same line
-	@param rect1 First line to check
-	@param rect2 Second line to check
-	@return true if the rectangles are more-or-less on the same line, false if not
+	@param rc The run's area
+	@return Index of the band, or NONE if the run is not on any existing line
 */
-bool OnSameLine(const RECTL& rect1, const RECTL& rect2)
+size_t TextArea::FindBand(const RECTL& rc) const
 {
-	int nMiddle1 = (rect1.top + rect1.bottom) / 2, nMiddle2 = (rect2.top + rect2.bottom) / 2;
-	return ((nMiddle1 >= rect2.top) && (nMiddle1 <= rect2.bottom)) || ((nMiddle2 >= rect1.top) && (nMiddle2 <= rect1.bottom));
-}
-
-/**
-	@param other The text line object to check
-	@return true if the other line object's data was added to this one, false if not
-*/
-bool TextLine::AddTextSameLine(const TextLine& other)
-{
-	// Are we on the same line?
-	if (!OnSameLine(rcArea, other.rcArea))
-		// No, just leave it
-		return false;
-
-	// Same line: before or after?
-	int nOffset;
-	if (rcArea.left > other.rcArea.left)
+	// Most text is printed in order, so try the last line first
+	if ((m_nLastBand != NONE) && OnSameLine(m_arBands[m_nLastBand].rcArea, rc))
+		return m_nLastBand;
+
+	// Find the first band that is not above the run's middle
+	long lMiddle = (rc.top + rc.bottom) / 2;
+	size_t nLow = 0, nHigh = m_arBandOrder.size();
+	while (nLow < nHigh)
 	{
-		nOffset = rcArea.left - other.rcArea.left;
-		if (rcArea.left > other.rcArea.right + 2)
-		{
-			/* <other> <me> */
-			insert(begin(), other.begin(), other.end());
-		}
+		size_t nMid = (nLow + nHigh) / 2;
+		if (m_arBands[m_arBandOrder[nMid]].lMiddle < lMiddle)
+			nLow = nMid + 1;
 		else
-		{
-			/* <other><me> */
-			ASSERT(!other.empty());
-			ASSERT(!empty());
-			TextWord part(other.back());
-			part += front();
-			erase(begin());
-			push_front(part);
-			if (other.size() > 1)
-			{
-				const_iterator ci = other.end();
-				ci--;
-				insert(begin(), other.begin(), ci);
-			}
-		}
-		rcArea.left = other.rcArea.left;
+			nHigh = nMid;
 	}
-	else
+
+	// A band's middle only moves inside it, so only bands this close can be on the same line
+	long lRange = 2 * max(m_lMaxHeight, rc.bottom - rc.top);
+	size_t nBest = NONE;
+	long lBestDistance = 0;
+	for (size_t i = nLow; (i < m_arBandOrder.size()) && (m_arBands[m_arBandOrder[i]].lMiddle - lMiddle <= lRange); i++)
 	{
-		nOffset = other.rcArea.left - rcArea.left;
-		std::tstring::size_type nSize = size();
-		if (rcArea.right < other.rcArea.left - 2)
+		const TextBand& band = m_arBands[m_arBandOrder[i]];
+		long lDistance = abs((band.rcArea.top + band.rcArea.bottom) / 2 - lMiddle);
+		if (OnSameLine(band.rcArea, rc) && ((nBest == NONE) || (lDistance < lBestDistance)))
 		{
-			/* <me> <other> */
-			insert(end(), other.begin(), other.end());
+			nBest = m_arBandOrder[i];
+			lBestDistance = lDistance;
 		}
-		else
+	}
+	for (size_t i = nLow; (i-- > 0) && (lMiddle - m_arBands[m_arBandOrder[i]].lMiddle <= lRange); )
+	{
+		const TextBand& band = m_arBands[m_arBandOrder[i]];
+		long lDistance = abs((band.rcArea.top + band.rcArea.bottom) / 2 - lMiddle);
+		if (OnSameLine(band.rcArea, rc) && ((nBest == NONE) || (lDistance < lBestDistance)))
 		{
-			/* <me><other> */
-			ASSERT(!other.empty());
-			ASSERT(!empty());
-			const_iterator i = other.begin();
-			back() += (*i);
-			i++;
-			if (i != other.end())
-				insert(end(), i, other.end());
+			nBest = m_arBandOrder[i];
+			lBestDistance = lDistance;
 		}
-		rcArea.right = other.rcArea.right;
 	}
-
-	// Combine the areas
-	rcArea.top = min(rcArea.top, other.rcArea.top);
-	rcArea.bottom = max(rcArea.bottom, other.rcArea.bottom);
-	return true;
+	return nBest;
 }
 
 /**
-	
+	@param nRun Index of the band's first run
 */
-void TextLine::SetSides() 
+void TextArea::AddBand(size_t nRun)
 {
-	// Do we have any data?
-	if (empty()) 
-		// No, make it VERY small :>
-		rcArea.right = rcArea.left; 
-	else 
+	const TextRun& run = m_arRuns[nRun];
+	TextBand band;
+	band.rcArea = run.rcArea;
+	band.lMiddle = (run.rcArea.top + run.rcArea.bottom) / 2;
+	band.nFirstRun = nRun;
+	band.nLastRun = nRun;
+	size_t nBand = m_arBands.size();
+	m_arBands.push_back(m_arena, band);
+	m_lMaxHeight = max(m_lMaxHeight, run.rcArea.bottom - run.rcArea.top);
+	m_nLastBand = nBand;
+
+	// Insert it into the sorted index (after bands with the same middle)
+	size_t nLow = 0, nHigh = m_arBandOrder.size();
+	while (nLow < nHigh)
 	{
-		// Get the range from the actual words (it could be larger)
-		const TextWord& word = back(); 
-		rcArea.right = word.GetEnd(word.size() - 1);
-		rcArea.left = front().GetStart(0);
+		size_t nMid = (nLow + nHigh) / 2;
+		if (m_arBands[m_arBandOrder[nMid]].lMiddle <= band.lMiddle)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
 	}
+	size_t* pOrder = m_arBandOrder.Grow(m_arena, 1);
+	size_t* pInsert = m_arBandOrder.data() + nLow;
+	memmove(pInsert + 1, pInsert, (pOrder - pInsert) * sizeof(size_t));
+	*pInsert = nBand;
 }
 
-
-
-
-
 /**
-	@param line The line to add
+	Lines are kept in the order they were started; in each line the runs are put left to right, and a word
+	that ends where the next run starts is joined with that run's first word.
 */
-void TextArea::AddLine(const TextLine& line)
+void TextArea::Finalize()
 {
-	// Don't put in empty lines
-	if (line.empty())
+	// Start over (in case more text was added since the last time)
+	m_arLetters.Reset();
+	m_arX.Reset();
+	m_arWidth.Reset();
+	m_arWords.Reset();
+	m_arLines.Reset();
+	if (m_arRuns.empty())
 		return;
 
-	if (empty())
-		// Just put it in
-		push_back(line);
-	else
-	{
-		// Check against the previous line
-		TextLine& last = back();
-		if (!last.AddTextSameLine(line))
-			// OK, it's not on the same line, so add it
-			push_back(line);
-	}
-}
-
-/**
-	
-*/
-void TextArea::InitSearch()
-{
-	// Initialize the search location to the first line
-	m_iLine = begin();
-	if (m_iLine != end())
-		// And the first word in the line
-		m_iWord = (*m_iLine).begin();
-}
-
-/**
-	@param words The exression to search for
-	@param[put] rectArea The page location of the expression
-	@return true if found the expression, false if failed
-*/
-bool TextArea::SearchFor(const STRLIST& words, RECTL& rectArea)
-{
-	// Is there something to find?
-	if (words.empty())
-		// Nope
-		return false;
-
-	// Start searching
-	const_iterator iPrev = m_iLine;
-	std::wstring sWord;
-	std::wstring::size_type pos;
-
-	for (; m_iLine != end(); m_iLine++)
+	// Room for all the letters (words can only get joined)
+	size_t nLetters = m_arRunLetters.size();
+	m_arLetters.Grow(m_arena, nLetters);
+	m_arX.Grow(m_arena, nLetters);
+	m_arWidth.Grow(m_arena, nLetters);
+	m_arLetters.resize(0);
+	m_arX.resize(0);
+	m_arWidth.resize(0);
+
+	ArenaArray<size_t> arRuns;
+	for (size_t nBand = 0; nBand < m_arBands.size(); nBand++)
 	{
-		// Did we move to a new line?
-		if (iPrev != m_iLine)
+		const TextBand& band = m_arBands[nBand];
+
+		// Put the line's runs in order
+		arRuns.resize(0);
+		for (size_t nRun = band.nFirstRun; nRun != NONE; nRun = m_arRuns[nRun].nNext)
+			arRuns.push_back(m_arena, nRun);
+		std::sort(arRuns.data(), arRuns.data() + arRuns.size(), RunLeftLess(m_arRuns.data()));
+
+		TextLine line;
+		line.rcArea = band.rcArea;
+		line.nFirstWord = m_arWords.size();
+		long lPrevRight = 0;
+		for (size_t i = 0; i < arRuns.size(); i++)
 		{
-			// Yeah, does it have enough words to cover the expression?
-			if ((*m_iLine).size() < words.size())
-				// No, go to the next line
-				continue;
-			// Initialize the search to the first word in the line
-			m_iWord = (*m_iLine).begin();
-		}
+			const TextRun& run = m_arRuns[arRuns[i]];
+			// Does it touch the previous run?
+			bool bTouching = (i > 0) && (lPrevRight >= run.rcArea.left - 2);
+			lPrevRight = (i > 0) ? max(lPrevRight, run.rcArea.right) : run.rcArea.right;
 
-		// Go over the words in the current line
-		for (; m_iWord != (*m_iLine).end(); m_iWord++)
-		{
-			// Get the text
-			sWord = (*m_iWord).GetText();
-			if ((pos = sWord.find(words.front().c_str())) != (sWord.size() - words.front().size()))
-				// Can't be this word: didn't find the first expression's word as the end of this word
-				// This is for matching:
-				// 'and' as the end of 'wand'!
-				continue;
-
-			// Initialize the search for the rest of the expression
-			TextLine::const_iterator iTestThis = m_iWord;
-			STRLIST::const_iterator iTestWords = words.begin(), iTestWordsNext;
-			iTestWords++;
-			while (iTestWords != words.end())
+			// Copy the run's words
+			for (size_t nWord = run.nFirstWord; nWord < run.nFirstWord + run.nWords; nWord++)
 			{
-				// Get next word
-				iTestThis++;
-				if (iTestThis == (*m_iLine).end())
-					// Nothing in this line, so not found
-					break;
-				sWord = (*iTestThis).GetText();
-
-				iTestWordsNext = iTestWords;
-				iTestWordsNext++;
-				if (iTestWordsNext == words.end())
+				const TextWord& word = m_arRunWords[nWord];
+				if (bTouching)
 				{
-					// Check partial word at the end
-					if (sWord.find((*iTestWords).c_str()) != 0)
-						break;
-					// Found!
-					iTestWords = words.end();
+					// Continues the previous run's last word
+					m_arWords.back().nCount += word.nCount;
+					bTouching = false;
 				}
 				else
 				{
-					if (sWord != (*iTestWords))
-						// Not it!
-						break;
+					TextWord wordNew;
+					wordNew.nFirst = m_arLetters.size();
+					wordNew.nCount = word.nCount;
+					m_arWords.push_back(m_arena, wordNew);
 				}
-				// Go on
-				iTestWords = iTestWordsNext;
+				memcpy(m_arLetters.Grow(m_arena, word.nCount), m_arRunLetters.data() + word.nFirst, word.nCount * sizeof(WCHAR));
+				memcpy(m_arX.Grow(m_arena, word.nCount), m_arRunX.data() + word.nFirst, word.nCount * sizeof(long));
+				memcpy(m_arWidth.Grow(m_arena, word.nCount), m_arRunWidth.data() + word.nFirst, word.nCount * sizeof(int));
 			}
-
-			if (iTestWords == words.end())
-			{
-				// Found it
-				rectArea = (*m_iLine).rcArea;
-				rectArea.left = (*m_iWord).GetStart(pos);
-				rectArea.right = (*iTestThis).GetEnd((*iTestThis).size() - 1);
-				m_iWord = iTestThis;
-				m_iWord++;
-				return true;
-			}
-		}			
-		iPrev = m_iLine;
+		}
+		line.nWords = m_arWords.size() - line.nFirstWord;
+		m_arLines.push_back(m_arena, line);
 	}
-	return false;
 }
 
 /**
-	@param[out] rectArea Location of next URL
-	@param[out] sURL The URL found
-	@return true if a URL was found, false if none were found
+	
 */
-bool TextArea::SearchForURL(RECTL& rectArea, std::wstring& sURL)
+void TextArea::Reset()
 {
-	// Continue from last search
-	const_iterator iPrev = m_iLine;
-	std::wstring sWord;
-	std::tstring::size_type nStart, nEnd;
-	for (; m_iLine != end(); m_iLine++)
-	{
-		// We are gonna assume that a URL cannot have a space in it. Which is basically true.
-
-		if (iPrev != m_iLine)
-			// Start from the beginning of the next line...
-			m_iWord = (*m_iLine).begin();
-
-		// Go over the words
-		for (; m_iWord != (*m_iLine).end(); m_iWord++)
-		{
-			// Get the text
-			sWord = (*m_iWord).GetText();
-			if (sWord.size() < 8)
-				// Too short
-				continue;
-			if (_wcsnicmp(sWord.c_str(), _T("http"), 4) != 0)
-				// No http
-				continue;
-
-			nStart = 4;
-			if ((sWord[nStart] == 's') || (sWord[nStart] == 'S'))
-				// https
-				nStart++;
-			// Does it have :// now?
-			if (wcsncmp(sWord.c_str() + nStart, _T("://"), 3) != 0)
-				// Nope
-				continue;
-			nStart += 3;
-
-			// Find the end of the URL
-			nEnd = sWord.find_first_not_of(_T("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.+$-_@&+-!*\"'(),%/?"), nStart);
-			if (nEnd == std::wstring::npos)
-				nEnd = sWord.size();
-			// Remove all kinds of non-URL stuff sometimes found at the end of the URL
-			while ((nEnd > nStart) && wcschr(_T(").'\"?"), sWord[nEnd-1]) != NULL)
-				nEnd--;
-
-			// Calculate position
-			rectArea = (*m_iLine).rcArea;
-			rectArea.right = (*m_iWord).GetEnd(nEnd);
-			rectArea.left = (*m_iWord).GetStart(0);
-			sURL = sWord.substr(0, nEnd);
-
-			// Leave it pointing to the next part
-			m_iWord++;
-			return true;
-		}
-		iPrev = m_iLine;
-	}
-	return false;
+	// Forget the arrays, and reuse their memory for the next page
+	m_arLetters.Reset();
+	m_arX.Reset();
+	m_arWidth.Reset();
+	m_arWords.Reset();
+	m_arLines.Reset();
+	m_arRunLetters.Reset();
+	m_arRunX.Reset();
+	m_arRunWidth.Reset();
+	m_arRunWords.Reset();
+	m_arRuns.Reset();
+	m_arBands.Reset();
+	m_arBandOrder.Reset();
+	m_lMaxHeight = 0;
+	m_nLastBand = NONE;
+	m_bInOrder = true;
+	m_arena.Reset();
 }
 
+/**
+	@param other The object to swap with
+*/
+void TextArea::Swap(TextArea& other)
+{
+	m_arena.Swap(other.m_arena);
+	m_arLetters.Swap(other.m_arLetters);
+	m_arX.Swap(other.m_arX);
+	m_arWidth.Swap(other.m_arWidth);
+	m_arWords.Swap(other.m_arWords);
+	m_arLines.Swap(other.m_arLines);
+	m_arRunLetters.Swap(other.m_arRunLetters);
+	m_arRunX.Swap(other.m_arRunX);
+	m_arRunWidth.Swap(other.m_arRunWidth);
+	m_arRunWords.Swap(other.m_arRunWords);
+	m_arRuns.Swap(other.m_arRuns);
+	m_arBands.Swap(other.m_arBands);
+	m_arBandOrder.Swap(other.m_arBandOrder);
+	std::swap(m_lMaxHeight, other.m_lMaxHeight);
+	std::swap(m_nLastBand, other.m_nLastBand);
+	std::swap(m_bInOrder, other.m_bInOrder);
+}
@@ -28,173 +28,231 @@
 #define _TEXTPART_H_
 
 #include <string>
-#include <list>
 #include "CCTChar.h"
+#include "Arena.h"
 
-/// Definition: string list
-typedef std::list<std::tstring> STRLIST;
+/// Checks if two rectangles are on the same line
+bool OnSameLine(const RECTL& rect1, const RECTL& rect2);
 
 /**
-    @brief Helper object for location of a printed letter
+    @brief Helper object for printed word location: a range of letters in the page's letter arrays
 */
-struct TextLetter
+struct TextWord
 {
-	// Ctors
-	/**
-		@brief Default constructor
-	*/
-	TextLetter() : wLetter(0), x(0), nWidth(0) {};
-	/**
-		@brief Constructor
-		@param w The letter
-		@param pos The start location
-		@param width The width
-	*/
-	TextLetter(WCHAR w, long _x, int width) : wLetter(w), x(_x), nWidth(width) {};
-	/**
-		@brief Copy constructor
-		@param other The letter data object to copy
-	*/
-	TextLetter(const TextLetter& other) : wLetter(other.wLetter), x(other.x), nWidth(other.nWidth) {};
+	/// Index of the first letter
+	size_t						nFirst;
+	/// Amount of letters
+	size_t						nCount;
+};
 
-	// Members
-	/// The letter
-	WCHAR						wLetter;
-	/// The x-location
-	long						x;
-	/// The width
-	int							nWidth;
+/**
+    @brief Helper object for printed text line: a range of words in the page's word array
+*/
+struct TextLine
+{
+	/// The line's area
+	RECTL						rcArea;
+	/// Index of the first word
+	size_t						nFirstWord;
+	/// Amount of words
+	size_t						nWords;
+};
+
+/**
+    @brief Helper object for a printed string while the page is captured: a range of words in the capture arrays
+*/
+struct TextRun
+{
+	/// The string's area
+	RECTL						rcArea;
+	/// Index of the first word
+	size_t						nFirstWord;
+	/// Amount of words
+	size_t						nWords;
+	/// Next run on the same line (in printing order), or TextArea::NONE
+	size_t						nNext;
 };
 
 /**
-    @brief Helper object for printed word location
+    @brief Helper object for a line while the page is captured: a chain of runs in a vertical band
 */
-struct TextWord : public std::list<TextLetter>
+struct TextBand
 {
+	/// The area of all the line's runs
+	RECTL						rcArea;
+	/// Vertical middle of the first run (the band's sort key, does not change)
+	long						lMiddle;
+	/// First run of the line
+	size_t						nFirstRun;
+	/// Last run of the line
+	size_t						nLastRun;
+};
+
+/**
+    @brief Page text helper object, used to search for specific strings to find their location
+
+	While the page is printed, each string is kept as a run (its letters and words are appended to the
+	capture arrays) and chained to the line it's on. Lines are found through an index of vertical bands
+	sorted by their middle, so text printed out of order (column by column, right-aligned numbers) still
+	joins the right line with a binary search instead of starting a new one.
+	Finalize() then sorts each line's runs left to right and builds the flat arrays used for searching:
+	one entry per letter (the character, its x location and its width), words as ranges of letters and
+	lines as ranges of words. All the memory comes from a per-page arena, so Reset() must be called when
+	the page is done.
+*/
+class TextArea
+{
+public:
+	/// Marks the end of a run chain (and a missing band)
+	static const size_t NONE = (size_t)-1;
+
 	// Ctors
 	/**
 		@brief Default constructor
 	*/
-	TextWord() {};
+	TextArea() : m_lMaxHeight(0), m_nLastBand(NONE), m_bInOrder(true) {};
+
+protected:
+	// Members
+	/// The memory for all the page's text
+	PageArena					m_arena;
+	/// The letters (finalized)
+	ArenaArray<WCHAR>			m_arLetters;
+	/// The x-location of each letter (finalized)
+	ArenaArray<long>			m_arX;
+	/// The width of each letter (finalized)
+	ArenaArray<int>				m_arWidth;
+	/// The words (finalized)
+	ArenaArray<TextWord>		m_arWords;
+	/// The lines (finalized)
+	ArenaArray<TextLine>		m_arLines;
+	/// The captured letters, in printing order
+	ArenaArray<WCHAR>			m_arRunLetters;
+	/// The x-location of each captured letter
+	ArenaArray<long>			m_arRunX;
+	/// The width of each captured letter
+	ArenaArray<int>				m_arRunWidth;
+	/// The captured words
+	ArenaArray<TextWord>		m_arRunWords;
+	/// The captured runs
+	ArenaArray<TextRun>			m_arRuns;
+	/// The captured lines
+	ArenaArray<TextBand>		m_arBands;
+	/// Band indexes, sorted by the bands' middle
+	ArenaArray<size_t>			m_arBandOrder;
+	/// Height of the tallest band (limits the band search)
+	long						m_lMaxHeight;
+	/// The band the last run was added to
+	size_t						m_nLastBand;
+	/// true if every run continued the last line to the right or started a new line
+	bool						m_bInOrder;
+
+public:
+	// Data Access
+	/**
+		@brief Checks if there's any text in the page
+		@return true if no text was added, false if there's text
+	*/
+	bool			empty() const {return m_arRuns.empty();};
 	/**
-		@brief Copy constructor
-		@param other Printer work location object to copy
+		@brief Checks if the text was printed in reading order: then the lines hold the runs in printing order
+		@return true if each run continued the last line to the right of its runs or started a new line
 	*/
-	TextWord(const TextWord& other) {assign(other.begin(), other.end());};
-	/// Constructor: create from a variable-width font string
-	TextWord(const std::wstring& s, const PGLYPHPOS& arGlyphPos, const POINTQF* pWidths, std::tstring::size_type nStart, std::tstring::size_type nEnd = -1);
-	/// Constructor: create from a fixed-width font string
-	TextWord(const std::wstring& s, int nCharWidth, std::tstring::size_type nStart, std::tstring::size_type nEnd = -1);
-
-	// Data Access methods
+	bool			IsInOrder() const {return m_bInOrder;};
+	/**
+		@brief Returns the amount of lines captured so far (before Finalize)
+		@return Number of lines
+	*/
+	size_t			GetBandCount() const {return m_arBands.size();};
+	/**
+		@brief Returns the amount of text lines
+		@return Number of lines
+	*/
+	size_t			GetLineCount() const {return m_arLines.size();};
+	/**
+		@brief Returns the amount of words
+		@return Number of words
+	*/
+	size_t			GetWordCount() const {return m_arWords.size();};
+	/**
+		@brief Returns a text line
+		@param nLine Index of the line
+		@return The line data
+	*/
+	const TextLine&	GetLine(size_t nLine) const {return m_arLines[nLine];};
+	/**
+		@brief Returns a word
+		@param nWord Index of the word
+		@return The word data
+	*/
+	const TextWord&	GetWord(size_t nWord) const {return m_arWords[nWord];};
+	/**
+		@brief Returns the amount of letters
+		@return Number of letters
+	*/
+	size_t			GetLetterCount() const {return m_arLetters.size();};
+	/**
+		@brief Returns all the letters of the page (words are one after the other, without spaces)
+		@return Pointer to the first letter
+	*/
+	const WCHAR*	GetLetters() const {return m_arLetters.data();};
+	/**
+		@brief Returns the letters of a word (not NULL terminated)
+		@param word The word
+		@return Pointer to the word's first letter
+	*/
+	const WCHAR*	GetLetters(const TextWord& word) const {return m_arLetters.data() + word.nFirst;};
 	/**
 		@brief Returns the left border of the requested letter
-		@param nLetter The letter to get the location of
+		@param nLetter Index of the letter
 		@return Location of the requested letter
 	*/
-	long GetStart(size_type nLetter) const 
-	{
-		if ((nLetter < 0) || (nLetter >= size())) 
-			return 0; 
-		const_iterator i; 
-		for (i = begin(); nLetter > 0; nLetter--, i++) ; 
-		return (*i).x;
-	};
+	long			GetStart(size_t nLetter) const {return m_arX[nLetter];};
 	/**
 		@brief Returns the right border of the requested letter
-		@param nLetter The letter to get the location of
+		@param nLetter Index of the letter
 		@return Location of the requested letter
 	*/
-	long GetEnd(size_type nLetter) const 
-	{
-		if ((nLetter < 0) || (nLetter >= (int)size())) 
-			return 0; 
-		const_iterator i; 
-		for (i = begin(); nLetter > 0; nLetter--, i++) ; 
-		return (*i).x + (*i).nWidth;
-	};
+	long			GetEnd(size_t nLetter) const {return m_arX[nLetter] + m_arWidth[nLetter];};
 	/**
 		@brief Returns the word's contents
+		@param word The word
 		@return The text
 	*/
-	std::wstring GetText() const {std::wstring s; for (const_iterator i = begin(); i != end(); i++) s += (*i).wLetter; return s;};
-
-	// Operators
-	/**
-		@brief Adds another word's letters after the current letters
-		@param other The word to add
-		@return This object
-	*/
-	const TextWord& operator+=(const TextWord& other) {insert(end(), other.begin(), other.end()); return *this;};
-};
-
-/**
-    @brief Helper object for printed text line
-*/
-struct TextLine : public std::list<TextWord>
-{
-	// Ctors
-	/**
-		@brief Default constructor
-	*/
-	TextLine() {rcArea.left = 0; rcArea.top = 0; rcArea.right = 0; rcArea.bottom = 0;};
+	std::wstring	GetText(const TextWord& word) const {return std::wstring(GetLetters(word), word.nCount);};
 	/**
-		@brief Copy constructor
-		@param other The text line object to copy
+		@brief Returns the amount of heap allocations made for the text so far (steady state should not add any)
+		@return Number of allocations
 	*/
-	TextLine(const TextLine& other) {rcArea = other.rcArea; assign(other.begin(), other.end());};
-	/// Constructor: from a string of variable-width font
-	TextLine(const std::wstring& s, const RECTL& rc, const PGLYPHPOS& arGlyphPos, const POINTQF* pWidths);
-	/// Constructor: from a string of fixed-width font
-	TextLine(const std::wstring& s, const RECTL& rc, int nCharWidth);
-
-	// Members
-	/// The line's area
-	RECTL rcArea;
+	size_t			GetHeapAllocations() const {return m_arena.GetBlockAllocations();};
 
-	/// This function checks if the received line of text is on the same line as this one, and if so, adds its data to this line
-	bool AddTextSameLine(const TextLine& other);
+	/// Add a printed string of a variable-width font
+	void	AddRun(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths) {AddRun(pText, nLen, rc, arGlyphPos, pWidths, 0);};
+	/// Add a printed string of a fixed-width font
+	void	AddRun(const WCHAR* pText, size_t nLen, const RECTL& rc, int nCharWidth) {AddRun(pText, nLen, rc, NULL, NULL, nCharWidth);};
 
-protected:
-	/// Updates the line's rectangle using the word locations
-	void SetSides();
-};
+	// Methods
+	/// Builds the lines from the captured runs (call before searching)
+	void	Finalize();
+	/// Removes all the text (call when the page is done)
+	void	Reset();
+	/// Exchanges the text of two objects (no copying)
+	void	Swap(TextArea& other);
 
-/**
-    @brief Page text helper object, used to search for specific strings to find their location
-*/
-struct TextArea : public std::list<TextLine>
-{
 protected:
-	// Members (for forward-only search)
-	/// Current search line
-	const_iterator m_iLine;
-	/// Current search word
-	TextLine::const_iterator m_iWord;
-
-public:
-	// Data Access
-	/// Add a new text line to the object
-	void	AddLine(const TextLine& line);
+	// Helpers
+	/// Adds a printed string (variable-width if arGlyphPos is specified, fixed-width if not)
+	void	AddRun(const WCHAR* pText, size_t nLen, const RECTL& rc, const GLYPHPOS* arGlyphPos, const POINTQF* pWidths, int nCharWidth);
+	/// Finds the band of the line a run is printed on
+	size_t	FindBand(const RECTL& rc) const;
+	/// Adds a new band for a run
+	void	AddBand(size_t nRun);
 
-	// Methods
-	/// Start a new search
-	void	InitSearch();
-	/**
-		@brief Search for an expression (a list of words in the exact order) in the page text; must be on the same line
-		@param words The words to search for
-		@param[out] rectArea The page location in which the words were found
-		@param nRepeat The amount of times to jump over the expression before reporting success
-		@return true if the expression was found, false if not
-
-		Use the nRepeat to jump over the first nRepeat times the expression is found.
-		Note that this is a forward only search, so after the first false result, you have to re-initialize the search to start from the beginning
-	*/
-	bool	SearchFor(const STRLIST& words, RECTL& rectArea, int nRepeat) {do {if (!SearchFor(words, rectArea)) return false; nRepeat--;} while (nRepeat > 0); return true;};
-	/// Search for an expression (a list of words in the exact order) in the page text; must be on the same line
-	bool	SearchFor(const STRLIST& words, RECTL& rectArea);
-	/// Search for the next string that starts with http:// or https:// and return its location
-	bool	SearchForURL(RECTL& rectArea, std::wstring& sWord);
+private:
+	/// Not copyable
+	TextArea(const TextArea&);
+	/// Not copyable
+	TextArea& operator=(const TextArea&);
 };
 
 #endif   //#define _TEXTPART_H_
@@ -0,0 +1,245 @@
+/**
+	@file
+	@brief Binary trace file format of the rendering plugin (standard C++ only, shared with tools that read traces)
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _TRACEFORMAT_H_
+#define _TRACEFORMAT_H_
+
+#include <stdio.h>
+#include <vector>
+
+/**
+	The trace file starts with a TraceFileHeader, followed by records: each is a TraceRecordHeader followed by
+	uSize bytes of data. All the numbers are little endian, and all the strings are UTF-16 without a terminator.
+*/
+
+/// Trace file signature ('CCTR')
+#define TRACE_MAGIC		0x52544343
+/// Trace file format version
+#define TRACE_VERSION	1
+
+/// Trace record types
+enum TraceRecordType
+{
+	/// Start of the document (data: unsigned int job ID)
+	TR_STARTDOC = 1,
+	/// Start of a page (data: unsigned int page number)
+	TR_STARTPAGE = 2,
+	/// Font used by the following glyph text records (data: TraceFont)
+	TR_FONT = 3,
+	/// Text output (data: TraceText, followed by its arrays)
+	TR_TEXT = 4,
+	/// Link escape (data: unsigned int escape code, followed by the escape data)
+	TR_ESCAPE = 5,
+	/// A link loaded from the link file for the page (data: TracePageLink, followed by its strings)
+	TR_PAGELINK = 6,
+	/// End of a page (data: unsigned int page number)
+	TR_SENDPAGE = 7,
+	/// End of the document (data: unsigned int end flags)
+	TR_ENDDOC = 8
+};
+
+/// TraceText flags: glyph indices (not characters)
+#define TTF_GLYPHINDEX	0x01
+/// TraceText flags: the glyph positions follow
+#define TTF_POSITIONS	0x02
+/// TraceText flags: the advance widths follow
+#define TTF_WIDTHS		0x04
+/// TraceText flags: the translated text follows
+#define TTF_TEXT		0x08
+
+#pragma pack(push, 4)
+
+/**
+    @brief Trace file header
+*/
+struct TraceFileHeader
+{
+	/// TRACE_MAGIC
+	unsigned int	uMagic;
+	/// TRACE_VERSION
+	unsigned int	uVersion;
+};
+
+/**
+    @brief Trace record header
+*/
+struct TraceRecordHeader
+{
+	/// Record type (see TraceRecordType)
+	unsigned int	uType;
+	/// Size of the record data
+	unsigned int	uSize;
+};
+
+/**
+    @brief Font record data
+*/
+struct TraceFont
+{
+	/// Font height
+	int				nHeight;
+	/// Font weight
+	int				nWeight;
+	/// Italic flag
+	unsigned char	cItalic;
+	/// Character set
+	unsigned char	cCharSet;
+	/// Pitch and family
+	unsigned char	cPitchAndFamily;
+	/// Unused
+	unsigned char	cReserved;
+	/// Face name
+	unsigned short	sFaceName[32];
+};
+
+/**
+    @brief Text record data
+
+	Followed by uGlyphs UTF-16 characters (or glyph indices), then uGlyphs positions (2 ints each) if
+	TTF_POSITIONS is set, then uGlyphs advance widths (the 16 bytes of POINTQF each) if TTF_WIDTHS is set,
+	and then uGlyphs translated characters if TTF_TEXT is set.
+*/
+struct TraceText
+{
+	/// Background rectangle (left, top, right, bottom)
+	int				rcArea[4];
+	/// Fixed character width (0 for variable width)
+	unsigned int	uCharInc;
+	/// Number of glyphs
+	unsigned int	uGlyphs;
+	/// TTF_xxx flags
+	unsigned int	uFlags;
+};
+
+/**
+    @brief Page link record data
+
+	Followed by the text, the URL and the title strings.
+*/
+struct TracePageLink
+{
+	/// Link location (left, top, right, bottom)
+	int				rcArea[4];
+	/// Target page (internal links)
+	int				nPage;
+	/// Target X offset (internal links)
+	int				nX;
+	/// Target Y offset (internal links)
+	int				nY;
+	/// Repeat count (text links)
+	int				nRepeat;
+	/// Length of the text (0 for location links)
+	unsigned int	uTextLen;
+	/// Length of the URL
+	unsigned int	uURLLen;
+	/// Length of the title
+	unsigned int	uTitleLen;
+};
+
+#pragma pack(pop)
+
+/**
+    @brief Reads the records of a trace file one by one
+*/
+class TraceReader
+{
+public:
+	/**
+		@brief Default constructor
+	*/
+	TraceReader() : m_pFile(NULL), m_uType(0) {};
+	/**
+		@brief Destructor
+	*/
+	~TraceReader() {Close();};
+
+protected:
+	// Members
+	/// The trace file
+	FILE*						m_pFile;
+	/// Type of the current record
+	unsigned int				m_uType;
+	/// Data of the current record
+	std::vector<unsigned char>	m_arData;
+
+public:
+	// Methods
+	/**
+		@brief Opens a trace file
+		@param lpPath Path of the file
+		@return true if opened and the header is valid, false if not
+	*/
+	bool			Open(const char* lpPath)
+	{
+		Close();
+		m_pFile = fopen(lpPath, "rb");
+		if (m_pFile == NULL)
+			return false;
+		TraceFileHeader header;
+		if ((fread(&header, sizeof(header), 1, m_pFile) != 1) || (header.uMagic != TRACE_MAGIC) || (header.uVersion != TRACE_VERSION))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+	/**
+		@brief Closes the file
+	*/
+	void			Close() {if (m_pFile != NULL) fclose(m_pFile); m_pFile = NULL;};
+	/**
+		@brief Reads the next record
+		@return true if read, false at the end of the file (or if the file is truncated)
+	*/
+	bool			Next()
+	{
+		TraceRecordHeader header;
+		if ((m_pFile == NULL) || (fread(&header, sizeof(header), 1, m_pFile) != 1))
+			return false;
+		m_uType = header.uType;
+		m_arData.resize(header.uSize);
+		return (header.uSize == 0) || (fread(&m_arData[0], header.uSize, 1, m_pFile) == 1);
+	}
+
+	// Data Access
+	/**
+		@brief Returns the type of the current record
+		@return The record type (see TraceRecordType)
+	*/
+	unsigned int	GetType() const {return m_uType;};
+	/**
+		@brief Returns the data of the current record
+		@return Pointer to the data (NULL if the record is empty)
+	*/
+	const unsigned char* GetData() const {return m_arData.empty() ? NULL : &m_arData[0];};
+	/**
+		@brief Returns the size of the current record's data
+		@return Size of the data in bytes
+	*/
+	size_t			GetSize() const {return m_arData.size();};
+};
+
+#endif   //#define _TRACEFORMAT_H_
@@ -0,0 +1,263 @@
+/**
+	@file
+	@brief Records the calls the rendering plugin sees into a binary trace file
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "debug.h"
+#include "CCTChar.h"
+#include "TraceWriter.h"
+
+/// Size of waiting records that is written even before the page ends
+#define TRACE_FLUSH_SIZE	(1024 * 1024)
+
+/**
+	
+*/
+TraceWriter::TraceWriter() : m_hFile(INVALID_HANDLE_VALUE), m_bHasFont(false)
+{
+	memset(&m_font, 0, sizeof(m_font));
+}
+
+/**
+	
+*/
+TraceWriter::~TraceWriter()
+{
+	Close();
+}
+
+/**
+	@param lpFolder The folder to create the trace file in
+	@param dwJobId The print job ID (used in the file name)
+	@return true if created, false if failed
+*/
+bool TraceWriter::Open(LPCTSTR lpFolder, DWORD dwJobId)
+{
+	Close();
+
+	// Create the file: <folder>\CCTrace_<job>.cctrace
+	std::tstring sPath = lpFolder;
+	if (sPath.empty())
+		return false;
+	if (*sPath.rbegin() != '\\')
+		sPath += '\\';
+	TCHAR cName[64];
+	_stprintf_s(cName, _S(cName), _T("CCTrace_%u.cctrace"), dwJobId);
+	sPath += cName;
+	m_hFile = ::CreateFile(sPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		VERBOSE(DLLTEXT("TraceWriter: cannot create %s\r\n"), sPath.c_str());
+		return false;
+	}
+
+	// Write the header and the document start
+	TraceFileHeader header;
+	header.uMagic = TRACE_MAGIC;
+	header.uVersion = TRACE_VERSION;
+	Add(&header, sizeof(header));
+	AddNumberRecord(TR_STARTDOC, dwJobId);
+	m_bHasFont = false;
+	return Flush();
+}
+
+/**
+	
+*/
+void TraceWriter::Close()
+{
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return;
+	Flush();
+	::CloseHandle(m_hFile);
+	m_hFile = INVALID_HANDLE_VALUE;
+}
+
+/**
+	@return true if written, false if failed
+*/
+bool TraceWriter::Flush()
+{
+	if (m_sBuffer.empty())
+		return true;
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		m_sBuffer.erase();
+		return false;
+	}
+	DWORD dwWritten = 0;
+	bool bRet = ::WriteFile(m_hFile, m_sBuffer.data(), (DWORD)m_sBuffer.size(), &dwWritten, NULL) && (dwWritten == (DWORD)m_sBuffer.size());
+	// Keep the memory for the next page
+	m_sBuffer.erase();
+	return bRet;
+}
+
+/**
+	@param lf The font
+*/
+void TraceWriter::Font(const LOGFONT& lf)
+{
+	TraceFont font;
+	memset(&font, 0, sizeof(font));
+	font.nHeight = lf.lfHeight;
+	font.nWeight = lf.lfWeight;
+	font.cItalic = lf.lfItalic;
+	font.cCharSet = lf.lfCharSet;
+	font.cPitchAndFamily = lf.lfPitchAndFamily;
+	for (int i = 0; (i < LF_FACESIZE) && (lf.lfFaceName[i] != 0); i++)
+		font.sFaceName[i] = (unsigned short)lf.lfFaceName[i];
+
+	// Same as the last one?
+	if (m_bHasFont && (memcmp(&font, &m_font, sizeof(font)) == 0))
+		return;
+	m_font = font;
+	m_bHasFont = true;
+	size_t nStart = StartRecord(TR_FONT);
+	Add(&font, sizeof(font));
+	EndRecord(nStart);
+}
+
+/**
+	@param pstro The text object
+	@param pGlyphPos The glyph positions (NULL for fixed width text)
+	@param pWidths The glyph advance widths (NULL for fixed width text)
+	@param pText The translated text (NULL if not translated)
+*/
+void TraceWriter::Text(const STROBJ* pstro, const GLYPHPOS* pGlyphPos, const POINTQF* pWidths, const WCHAR* pText)
+{
+	TraceText text;
+	text.rcArea[0] = pstro->rclBkGround.left;
+	text.rcArea[1] = pstro->rclBkGround.top;
+	text.rcArea[2] = pstro->rclBkGround.right;
+	text.rcArea[3] = pstro->rclBkGround.bottom;
+	text.uCharInc = pstro->ulCharInc;
+	text.uGlyphs = pstro->cGlyphs;
+	text.uFlags = 0;
+	if ((pstro->flAccel & SO_GLYPHINDEX_TEXTOUT) != 0)
+		text.uFlags |= TTF_GLYPHINDEX;
+	if (pGlyphPos != NULL)
+		text.uFlags |= TTF_POSITIONS;
+	if (pWidths != NULL)
+		text.uFlags |= TTF_WIDTHS;
+	if ((pText != NULL) && (pText != pstro->pwszOrg))
+		text.uFlags |= TTF_TEXT;
+
+	size_t nStart = StartRecord(TR_TEXT);
+	Add(&text, sizeof(text));
+	Add(pstro->pwszOrg, pstro->cGlyphs * sizeof(WCHAR));
+	if (pGlyphPos != NULL)
+	{
+		for (ULONG i = 0; i < pstro->cGlyphs; i++)
+		{
+			int nPos[2] = {(int)pGlyphPos[i].ptl.x, (int)pGlyphPos[i].ptl.y};
+			Add(nPos, sizeof(nPos));
+		}
+	}
+	if (pWidths != NULL)
+		Add(pWidths, pstro->cGlyphs * sizeof(POINTQF));
+	if ((text.uFlags & TTF_TEXT) != 0)
+		Add(pText, pstro->cGlyphs * sizeof(WCHAR));
+	EndRecord(nStart);
+}
+
+/**
+	@param iEsc The escape code
+	@param pData The escape data
+	@param nSize Size of the data
+*/
+void TraceWriter::Escape(ULONG iEsc, const void* pData, ULONG nSize)
+{
+	size_t nStart = StartRecord(TR_ESCAPE);
+	unsigned int uEscape = iEsc;
+	Add(&uEscape, sizeof(uEscape));
+	if (pData != NULL)
+		Add(pData, nSize);
+	EndRecord(nStart);
+}
+
+/**
+	@param link The link
+*/
+void TraceWriter::PageLink(const CCPrintData::LinkData& link)
+{
+	TracePageLink data;
+	data.rcArea[0] = link.rectLocation.left;
+	data.rcArea[1] = link.rectLocation.top;
+	data.rcArea[2] = link.rectLocation.right;
+	data.rcArea[3] = link.rectLocation.bottom;
+	data.nPage = link.nPage;
+	data.nX = link.ptOffset.x;
+	data.nY = link.ptOffset.y;
+	data.nRepeat = link.nRepeat;
+	std::wstring sText = MakeWideString(link.sText), sURL = MakeWideString(link.sURL), sTitle = MakeWideString(link.sTitle);
+	data.uTextLen = (unsigned int)sText.size();
+	data.uURLLen = (unsigned int)sURL.size();
+	data.uTitleLen = (unsigned int)sTitle.size();
+
+	size_t nStart = StartRecord(TR_PAGELINK);
+	Add(&data, sizeof(data));
+	Add(sText.data(), sText.size() * sizeof(WCHAR));
+	Add(sURL.data(), sURL.size() * sizeof(WCHAR));
+	Add(sTitle.data(), sTitle.size() * sizeof(WCHAR));
+	EndRecord(nStart);
+}
+
+/**
+	@param uType The record type
+	@return Position of the record in the buffer (pass to EndRecord)
+*/
+size_t TraceWriter::StartRecord(UINT uType)
+{
+	size_t nStart = m_sBuffer.size();
+	TraceRecordHeader header;
+	header.uType = uType;
+	header.uSize = 0;
+	Add(&header, sizeof(header));
+	return nStart;
+}
+
+/**
+	@param nStart Position of the record in the buffer (returned by StartRecord)
+*/
+void TraceWriter::EndRecord(size_t nStart)
+{
+	TraceRecordHeader* pHeader = (TraceRecordHeader*)&m_sBuffer[nStart];
+	pHeader->uSize = (unsigned int)(m_sBuffer.size() - nStart - sizeof(TraceRecordHeader));
+	// Don't keep too much in memory
+	if (m_sBuffer.size() >= TRACE_FLUSH_SIZE)
+		Flush();
+}
+
+/**
+	@param uType The record type
+	@param uValue The record's number
+*/
+void TraceWriter::AddNumberRecord(UINT uType, UINT uValue)
+{
+	size_t nStart = StartRecord(uType);
+	unsigned int u = uValue;
+	Add(&u, sizeof(u));
+	EndRecord(nStart);
+}
@@ -0,0 +1,104 @@
+/**
+	@file
+	@brief Records the calls the rendering plugin sees into a binary trace file
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _TRACEWRITER_H_
+#define _TRACEWRITER_H_
+
+#include <string>
+#include "TraceFormat.h"
+#include "CCPrintData.h"
+
+/**
+    @brief Writes a trace of a print job: the text, fonts, link escapes, link file data and page boundaries
+
+	The trace holds the plugin's inputs (in the format described in TraceFormat.h), so a print job can be
+	replayed through the text and link code away from the spooler.
+	The records are collected in memory and written once per page.
+*/
+class TraceWriter
+{
+public:
+	// Ctors
+	/// Default constructor
+	TraceWriter();
+	/// Destructor
+	~TraceWriter();
+
+protected:
+	// Members
+	/// The trace file (INVALID_HANDLE_VALUE if not open)
+	HANDLE				m_hFile;
+	/// Records waiting to be written
+	std::string			m_sBuffer;
+	/// The last font written
+	TraceFont			m_font;
+	/// true if a font was written
+	bool				m_bHasFont;
+
+public:
+	// Methods
+	/// Creates the trace file for a print job
+	bool				Open(LPCTSTR lpFolder, DWORD dwJobId);
+	/// Writes the waiting records and closes the file
+	void				Close();
+	/// Writes the waiting records into the file
+	bool				Flush();
+
+	// Records
+	/// Records the start of a page
+	void				StartPage(UINT nPage) {AddNumberRecord(TR_STARTPAGE, nPage);};
+	/// Records the end of a page (and writes the page's records)
+	void				SendPage(UINT nPage) {AddNumberRecord(TR_SENDPAGE, nPage); Flush();};
+	/// Records the end of the document
+	void				EndDoc(FLONG fl) {AddNumberRecord(TR_ENDDOC, (UINT)fl);};
+	/// Records the font of the following glyph text (if it changed)
+	void				Font(const LOGFONT& lf);
+	/// Records a text output
+	void				Text(const STROBJ* pstro, const GLYPHPOS* pGlyphPos, const POINTQF* pWidths, const WCHAR* pText);
+	/// Records a link escape
+	void				Escape(ULONG iEsc, const void* pData, ULONG nSize);
+	/// Records a link loaded from the link file
+	void				PageLink(const CCPrintData::LinkData& link);
+
+protected:
+	// Helpers
+	/// Starts a record
+	size_t				StartRecord(UINT uType);
+	/// Ends a record (sets its size)
+	void				EndRecord(size_t nStart);
+	/// Adds data to the current record
+	void				Add(const void* pData, size_t nSize) {m_sBuffer.append((const char*)pData, nSize);};
+	/// Adds a record holding a single number
+	void				AddNumberRecord(UINT uType, UINT uValue);
+
+private:
+	/// Not copyable
+	TraceWriter(const TraceWriter&);
+	/// Not copyable
+	TraceWriter& operator=(const TraceWriter&);
+};
+
+#endif   //#define _TRACEWRITER_H_
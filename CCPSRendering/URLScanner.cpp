@@ -0,0 +1,381 @@
+/**
+	@file
+	@brief Finds URLs (and optionally e-mail addresses and domain names) in the page text
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#include "precomp.h"
+#include "debug.h"
+#include "URLScanner.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+/// Use SSE2 to search for the letters that start a link check
+#define URLSCANNER_SSE2
+#endif
+
+/// Character class: can be part of a URL
+#define CHAR_URL		0x01
+/// Character class: can be part of a host name
+#define CHAR_HOST		0x02
+/// Character class: can be part of the user name of an e-mail address
+#define CHAR_MAIL		0x04
+/// Character class: a letter
+#define CHAR_ALPHA		0x08
+/// Character class: punctuation that is removed from the end of a link
+#define CHAR_TRAIL		0x10
+
+#define U	CHAR_URL
+#define H	CHAR_HOST
+#define M	CHAR_MAIL
+#define A	CHAR_ALPHA
+#define T	CHAR_TRAIL
+/// Character classes of the ASCII characters (anything above is never part of a link)
+static const BYTE s_uCharClass[128] =
+{
+/*                0        1        2        3        4        5        6        7        8        9        A        B        C        D        E        F */
+/* 0 */          0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,
+/* 1 */          0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,       0,
+/* 2 */          0,     U|T,       T,       U,       U,     U|M,       U,     U|T,       U,       U,       U,     U|M,     U|T,   U|H|M, U|H|M|T,       U,
+/* 3 */      U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,   U|H|M,     U|T,     U|T,       0,       U,       0,     U|T,
+/* 4 */          U, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A,
+/* 5 */    U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A,       U,       0,       U,       0,     U|M,
+/* 6 */          0, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A,
+/* 7 */    U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A, U|H|M|A,       0,       0,       0,       U,       0,
+};
+#undef U
+#undef H
+#undef M
+#undef A
+#undef T
+
+/**
+	@brief Checks the character class of a letter
+	@param w The letter
+	@param uClass The class (or classes) to check for
+	@return true if the letter is in (one of) the class, false if not
+*/
+inline bool IsClass(WCHAR w, BYTE uClass)
+{
+	// Compared unsigned: where WCHAR is signed, a negative letter would pass a signed check
+	return ((UINT)w < 128) && ((s_uCharClass[(UINT)w] & uClass) != 0);
+}
+
+/**
+	@brief Checks if the text starts with a specific (lowercase ASCII) prefix, ignoring case
+	@param pText The text to check
+	@param nLen Length of the text
+	@param lpPrefix The prefix
+	@return Length of the prefix if the text starts with it, 0 if not
+*/
+size_t StartsWith(const WCHAR* pText, size_t nLen, const char* lpPrefix)
+{
+	size_t i;
+	for (i = 0; lpPrefix[i] != '\0'; i++)
+	{
+		if (i >= nLen)
+			return 0;
+		WCHAR w = pText[i];
+		if ((w >= 'A') && (w <= 'Z'))
+			w += 'a' - 'A';
+		if (w != (WCHAR)lpPrefix[i])
+			return 0;
+	}
+	return i;
+}
+
+/**
+	@brief Checks if a text is a valid host name (at least two parts, the last one being 2 or more letters)
+	@param pText The text to check
+	@param nLen Length of the text
+	@return true if this looks like a host name, false if not
+*/
+bool IsHostName(const WCHAR* pText, size_t nLen)
+{
+	size_t nLabel = 0, nDots = 0;
+	bool bAlphaLabel = true;
+	for (size_t i = 0; i < nLen; i++)
+	{
+		if (pText[i] == '.')
+		{
+			// No empty parts
+			if (nLabel == 0)
+				return false;
+			nDots++;
+			nLabel = 0;
+			bAlphaLabel = true;
+			continue;
+		}
+		if (!IsClass(pText[i], CHAR_HOST))
+			return false;
+		if (!IsClass(pText[i], CHAR_ALPHA))
+			bAlphaLabel = false;
+		nLabel++;
+	}
+	return (nDots > 0) && (nLabel >= 2) && bAlphaLabel;
+}
+
+#ifdef URLSCANNER_SSE2
+/**
+	@brief Checks if the processor supports SSE2
+	@return true if SSE2 can be used, false if not
+*/
+bool HasSSE2()
+{
+	static int s_nSSE2 = -1;
+	if (s_nSSE2 < 0)
+		s_nSSE2 = ::IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+	return s_nSSE2 == 1;
+}
+#endif
+
+#ifdef URLSCANNER_SSE2
+/**
+	@brief Fills a vector with a letter
+	@param w The letter
+	@return The vector
+*/
+inline __m128i SetLetters(WCHAR w)
+{
+	// WCHAR is 2 bytes on Windows, but 4 with some other compilers (the portable tests)
+	return (sizeof(WCHAR) == 2) ? _mm_set1_epi16((short)w) : _mm_set1_epi32((int)w);
+}
+
+/**
+	@brief Compares the letters of two vectors
+	@param v1 The first vector
+	@param v2 The second vector
+	@return All bits set in the equal letters, clear in the others
+*/
+inline __m128i CompareLetters(__m128i v1, __m128i v2)
+{
+	return (sizeof(WCHAR) == 2) ? _mm_cmpeq_epi16(v1, v2) : _mm_cmpeq_epi32(v1, v2);
+}
+#endif
+
+/**
+	@brief Finds the next letter that any link must contain (':', '.' or '@')
+	@param pLetters The letters
+	@param nStart Where to start searching
+	@param nEnd Where to stop searching
+	@param bVector true to use SSE2 if the processor has it, false to check one letter at a time
+	@return Location of the found letter, or nEnd if none was found
+*/
+size_t FindTrigger(const WCHAR* pLetters, size_t nStart, size_t nEnd, bool bVector)
+{
+	size_t i = nStart;
+#ifdef URLSCANNER_SSE2
+	if (bVector && HasSSE2())
+	{
+		// Compare 16 bytes of letters at a time
+		const size_t nStep = 16 / sizeof(WCHAR);
+		const __m128i vColon = SetLetters(':'), vDot = SetLetters('.'), vAt = SetLetters('@');
+		for (; i + nStep <= nEnd; i += nStep)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(pLetters + i));
+			__m128i vFound = _mm_or_si128(_mm_or_si128(CompareLetters(v, vColon), CompareLetters(v, vDot)), CompareLetters(v, vAt));
+			int nMask = _mm_movemask_epi8(vFound);
+			if (nMask != 0)
+			{
+				// One mask bit for each byte of a letter
+				while ((nMask & 1) == 0)
+				{
+					nMask >>= sizeof(WCHAR);
+					i++;
+				}
+				return i;
+			}
+		}
+	}
+#endif
+	// Check the rest one at a time
+	for (; i < nEnd; i++)
+	{
+		WCHAR w = pLetters[i];
+		if ((w == ':') || (w == '.') || (w == '@'))
+			return i;
+	}
+	return nEnd;
+}
+
+/**
+	@param text The page text to scan
+	@param uFlags Optional detection types (see Flags)
+*/
+URLScanner::URLScanner(const TextArea& text, UINT uFlags /* = 0 */) : m_text(text), m_uFlags(uFlags), m_nLetter(0), m_nWord(0), m_nLine(0)
+{
+}
+
+/**
+	@param[out] rectArea Location of the link
+	@param[out] sURL The link target
+	@return true if a link was found, false if there are no more links in the text
+*/
+bool URLScanner::Next(RECTL& rectArea, std::wstring& sURL)
+{
+	const WCHAR* pLetters = m_text.GetLetters();
+	size_t nLetters = m_text.GetLetterCount();
+	while (m_nLetter < nLetters)
+	{
+		// Find the next candidate
+		size_t nFound = FindTrigger(pLetters, m_nLetter, nLetters, (m_uFlags & SCAN_SCALAR) == 0);
+		if (nFound == nLetters)
+			break;
+
+		// Find the word (and line) it's in
+		while (m_text.GetWord(m_nWord).nFirst + m_text.GetWord(m_nWord).nCount <= nFound)
+			m_nWord++;
+		while (m_text.GetLine(m_nLine).nFirstWord + m_text.GetLine(m_nLine).nWords <= m_nWord)
+			m_nLine++;
+
+		// Only one link per word, so continue after this one next time
+		const TextWord& word = m_text.GetWord(m_nWord);
+		m_nLetter = word.nFirst + word.nCount;
+
+		size_t nStart, nEnd;
+		if (CheckWord(word, nStart, nEnd, sURL))
+		{
+			// Calculate position
+			rectArea = m_text.GetLine(m_nLine).rcArea;
+			rectArea.left = m_text.GetStart(word.nFirst + nStart);
+			rectArea.right = m_text.GetEnd(word.nFirst + nEnd - 1);
+			return true;
+		}
+	}
+	m_nLetter = nLetters;
+	return false;
+}
+
+/**
+	@param word The word to check
+	@param[out] nStart Start of the link in the word
+	@param[out] nEnd End of the link in the word
+	@param[out] sURL The link's target
+	@return true if the word holds a link, false if not
+*/
+bool URLScanner::CheckWord(const TextWord& word, size_t& nStart, size_t& nEnd, std::wstring& sURL) const
+{
+	const WCHAR* pWord = m_text.GetLetters(word);
+	size_t nLen = word.nCount;
+
+	// Skip opening brackets and quotes
+	nStart = 0;
+	while ((nStart < nLen) && ((pWord[nStart] == '(') || (pWord[nStart] == '<') || (pWord[nStart] == '[') || (pWord[nStart] == '"') || (pWord[nStart] == '\'')))
+		nStart++;
+
+	// Check for a known prefix
+	const WCHAR* pText = pWord + nStart;
+	size_t nTextLen = nLen - nStart;
+	size_t nBody;
+	const WCHAR* lpAdd = L"";
+	if (((nBody = StartsWith(pText, nTextLen, "http://")) == 0) &&
+		((nBody = StartsWith(pText, nTextLen, "https://")) == 0) &&
+		((nBody = StartsWith(pText, nTextLen, "mailto:")) == 0))
+	{
+		nBody = StartsWith(pText, nTextLen, "www.");
+		lpAdd = L"http://";
+	}
+	bool bBare = nBody == 0;
+	nBody += nStart;
+
+	// Find the end of the URL
+	nEnd = nBody;
+	while ((nEnd < nLen) && IsClass(pWord[nEnd], CHAR_URL))
+		nEnd++;
+	// Remove all kinds of non-URL stuff sometimes found at the end of the URL
+	while (nEnd > nBody)
+	{
+		WCHAR w = pWord[nEnd - 1];
+		if ((w == ')') || (w == ']'))
+		{
+			// Keep it if it closes a bracket inside the link (http://en.wikipedia.org/wiki/Link_(disambiguation))
+			WCHAR wOpen = (w == ')') ? '(' : '[';
+			int nBalance = 0;
+			for (size_t i = nBody; i < nEnd; i++)
+			{
+				if (pWord[i] == wOpen)
+					nBalance++;
+				else if (pWord[i] == w)
+					nBalance--;
+			}
+			if (nBalance >= 0)
+				break;
+		}
+		else if (!IsClass(w, CHAR_TRAIL))
+			break;
+		nEnd--;
+	}
+	if (nEnd == nBody)
+		// Nothing after the prefix
+		return false;
+
+	if (!bBare)
+	{
+		// Known prefix, we're done
+		sURL.assign(lpAdd);
+		sURL.append(pWord + nStart, nEnd - nStart);
+		return true;
+	}
+
+	// An e-mail address?
+	size_t nAt = nStart;
+	while ((nAt < nEnd) && (pWord[nAt] != '@'))
+		nAt++;
+	if (nAt < nEnd)
+	{
+		if ((m_uFlags & SCAN_EMAILS) == 0)
+			return false;
+		// Check the user name
+		if (nAt == nStart)
+			return false;
+		for (size_t i = nStart; i < nAt; i++)
+			if (!IsClass(pWord[i], CHAR_MAIL))
+				return false;
+		// And the host name (which ends the address)
+		nEnd = nAt + 1;
+		while ((nEnd < nLen) && IsClass(pWord[nEnd], CHAR_HOST))
+			nEnd++;
+		while ((nEnd > nAt + 1) && (pWord[nEnd - 1] == '.'))
+			nEnd--;
+		if (!IsHostName(pWord + nAt + 1, nEnd - nAt - 1))
+			return false;
+		sURL.assign(L"mailto:");
+		sURL.append(pWord + nStart, nEnd - nStart);
+		return true;
+	}
+
+	// A domain name?
+	if ((m_uFlags & SCAN_DOMAINS) == 0)
+		return false;
+	size_t nHostEnd = nStart;
+	while ((nHostEnd < nEnd) && IsClass(pWord[nHostEnd], CHAR_HOST))
+		nHostEnd++;
+	// The host must be followed by a path, port, query or nothing at all
+	if ((nHostEnd < nEnd) && (pWord[nHostEnd] != '/') && (pWord[nHostEnd] != ':') && (pWord[nHostEnd] != '?') && (pWord[nHostEnd] != '#'))
+		return false;
+	if (!IsHostName(pWord + nStart, nHostEnd - nStart))
+		return false;
+	sURL.assign(L"http://");
+	sURL.append(pWord + nStart, nEnd - nStart);
+	return true;
+}
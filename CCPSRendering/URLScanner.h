@@ -0,0 +1,87 @@
+/**
+	@file
+	@brief Finds URLs (and optionally e-mail addresses and domain names) in the page text
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _URLSCANNER_H_
+#define _URLSCANNER_H_
+
+#include <string>
+#include "TextPart.h"
+
+/**
+    @brief Scans the page text for link targets: http://, https://, www. and mailto: always, and
+			e-mail addresses and bare domain names (example.com) if requested
+
+	The scan is a single forward pass over the page's letters: a vectorized search finds the next letter
+	that any link must contain (':', '.' or '@'), and only the word holding it is examined.
+	A link cannot contain a space, so it is always (part of) a single word.
+*/
+class URLScanner
+{
+public:
+	/// Optional detection types
+	enum Flags
+	{
+		/// Detect e-mail addresses (linked as mailto:)
+		SCAN_EMAILS = 0x01,
+		/// Detect domain names without http:// or www. (e.g. example.com)
+		SCAN_DOMAINS = 0x02,
+		/// Don't use SSE2 to search the text (same results, for testing and measuring)
+		SCAN_SCALAR = 0x04
+	};
+
+	// Ctors
+	/// Constructor
+	URLScanner(const TextArea& text, UINT uFlags = 0);
+
+protected:
+	// Members
+	/// The text to scan
+	const TextArea&	m_text;
+	/// The optional detection flags
+	UINT			m_uFlags;
+	/// Next letter to scan from
+	size_t			m_nLetter;
+	/// Current word
+	size_t			m_nWord;
+	/// Current line
+	size_t			m_nLine;
+
+public:
+	// Methods
+	/// Finds the next link in the text
+	bool			Next(RECTL& rectArea, std::wstring& sURL);
+
+protected:
+	// Helpers
+	/// Checks if a word is (or contains) a link
+	bool			CheckWord(const TextWord& word, size_t& nStart, size_t& nEnd, std::wstring& sURL) const;
+
+private:
+	/// Not assignable
+	URLScanner& operator=(const URLScanner&);
+};
+
+#endif   //#define _URLSCANNER_H_
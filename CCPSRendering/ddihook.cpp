@@ -32,10 +32,18 @@
 #include "CCTChar.h"
 #include "CCPrintRegistry.h"
 #include "GlyphTranslator.h"
+#include "GlyphCache.h"
+#include "GlyphPrewarmer.h"
+#include "LinkWorker.h"
+#include "TextLayout.h"
+#include "TraceWriter.h"
 #include "CCPrintData.h"
+#include "LinkMatcher.h"
+#include "URLScanner.h"
 
 #include "intrface.h"
 #include "PngImage.h"
+#include "PngStream.h"
 #include "SQLiteDB.h"
 
 
@@ -80,13 +88,30 @@ UINT GetLicenseImage(const LicenseInfo& info)
 	@param pso The destination surface
 	@param pSrc The source surface (the image must be attached to it already)
 	@param rectTarget The location to draw the image at
+	@param pPalette The source palette colors (NULL if the source is not a palette image)
+	@param nColors Number of colors in the palette
 	@return TRUE if drawn successfully, FALSE if failed for any reason
 */
-BOOL DrawImage(SURFOBJ* pso, SURFOBJ* pSrc, RECTL& rectTarget)
+BOOL DrawImage(SURFOBJ* pso, SURFOBJ* pSrc, RECTL& rectTarget, const RGBQUAD* pPalette = NULL, int nColors = 0)
 {
-	// Create the translate object (empty)
+	// Create the translate object (empty, unless the source has a palette)
 	XLATEOBJ xlate;
 	memset(&xlate, 0, sizeof(xlate));
+	ULONG ulColors[256];
+	if ((pPalette != NULL) && (nColors > 0))
+	{
+		// Translate each index to its color (as a 24 bit BGR pixel value)
+		for (int i = 0; i < 256; i++)
+		{
+			const RGBQUAD& rgb = pPalette[(i < nColors) ? i : 0];
+			ulColors[i] = ((ULONG)rgb.rgbRed << 16) | ((ULONG)rgb.rgbGreen << 8) | rgb.rgbBlue;
+		}
+		xlate.flXlate = XO_TABLE;
+		xlate.iSrcType = PAL_INDEXED;
+		xlate.iDstType = PAL_BGR;
+		xlate.cEntries = 256;
+		xlate.pulXlate = ulColors;
+	}
 
 	// Create the color adjustment structure
 	COLORADJUSTMENT clr;
@@ -123,6 +148,8 @@ BOOL DrawImage(SURFOBJ* pso, SURFOBJ* pSrc, RECTL& rectTarget)
 	@param png The image to draw
 	@param rectTarget The drawing location
 	@return TRUE if drawn successfully, FALSE if failed
+
+	Palette images are drawn as 8 bit images with a color translation table, so they stay a third of the size.
 */
 BOOL DrawImage(SURFOBJ* pso, const PngImage& png, RECTL& rectTarget)
 {
@@ -151,6 +178,9 @@ BOOL DrawImage(SURFOBJ* pso, const PngImage& png, RECTL& rectTarget)
 		case 32:
 			uFormat = BMF_32BPP;
 			break;
+		default:
+			// Not a format we can draw
+			return FALSE;
 	}
 
 	HBITMAP hEngBmp = EngCreateBitmap(szBitmap, png.GetWidthInBytes(), uFormat, BMF_TOPDOWN|BMF_USERMEM, (void*)png.GetBits());
@@ -158,13 +188,43 @@ BOOL DrawImage(SURFOBJ* pso, const PngImage& png, RECTL& rectTarget)
 		return FALSE;
 
 	SURFOBJ* pSrc = EngLockSurface((HSURF)hEngBmp);
-	BOOL bRet = DrawImage(pso, pSrc, rectTarget);
+	BOOL bRet = DrawImage(pso, pSrc, rectTarget, (png.GetColorCount() > 0) ? png.GetPalette() : NULL, png.GetColorCount());
 	EngUnlockSurface(pSrc);
 	EngDeleteSurface((HSURF)hEngBmp);
 
 	return bRet;
 }
 
+/**
+	@brief This function returns the license image decoded and scaled for the device
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param uImage Resource ID of the license image
+	@param dMultiplier Scale of the image (device resolution / 72)
+	@return The scaled image, NULL if failed to load it
+
+	The image is scaled once and kept for the rest of the job, so each page only copies it instead of stretching it.
+*/
+const PngImage* GetScaledBadge(POEMPDEV pDevOEM, UINT uImage, double dMultiplier)
+{
+	// Already have it?
+	if ((pDevOEM->pBadge != NULL) && (pDevOEM->uBadge == uImage))
+		return pDevOEM->pBadge;
+
+	PngImage png;
+	if (!png.LoadFromResource(uImage, true, ghInstance, _T("PNG"), true, true))
+		return NULL;
+	if (pDevOEM->pBadge == NULL)
+		pDevOEM->pBadge = new PngImage;
+	if (!pDevOEM->pBadge->Scale(png, max(1, (int)(png.GetWidth() * dMultiplier)), max(1, (int)(png.GetHeight() * dMultiplier))))
+	{
+		delete pDevOEM->pBadge;
+		pDevOEM->pBadge = NULL;
+		return NULL;
+	}
+	pDevOEM->uBadge = uImage;
+	return pDevOEM->pBadge;
+}
+
 /**
 	@brief This function draws a loaded BITMAP image onto the received surface in the specified location
 	@param pso The surface to draw upon
@@ -200,6 +260,9 @@ BOOL DrawImage(SURFOBJ* pso, HBITMAP hBmp, RECTL& rectTarget)
 		case 32:
 			uFormat = BMF_32BPP;
 			break;
+		default:
+			// Not a format we can draw
+			return FALSE;
 	}
 
 	HBITMAP hEngBmp = EngCreateBitmap(szBitmap, bmp.bmWidthBytes, uFormat, BMF_USERMEM, (void*)bmp.bmBits);
@@ -214,118 +277,92 @@ BOOL DrawImage(SURFOBJ* pso, HBITMAP hBmp, RECTL& rectTarget)
 	return bRet;
 }
 
-/// PDFMark URL link box definition
-#define URLBOX	"\n[ /Rect [%d %d %d %d]\n\
-	/Action << /Subtype /URI /URI (%s) >>\n\
-	/Border [0 0 2]\n\
-	/Color [.7 0 0]\n\
-	/Subtype /Link\n\
-	/Title (%s)\n\
-	/ANN pdfmark\n"
-
-/// PDFMark hyperlink function definition
-#define HYPERLINK_FUNC "/cc_hyperlink { dup show stringwidth pop neg\n\
-   gsave 0 currentfont dup\n\
-      /FontInfo get /UnderlineThickness get exch\n\
-      /FontMatrix get dtransform setlinewidth 0 currentfont dup\n\
-      /FontInfo get /UnderlinePosition get exch\n\
-      /FontMatrix get dtransform rmoveto rlineto stroke\n\
-   grestore\n\
-} def\n"
-
-/// PDFMark hyperlink start definition
-#define HYPERLINK_START	"\ncurrentpoint\n\
-  %d sub\n\
-  currentcolor 0 0 128 setrgbcolor\
-  ("
-
-/// PDFMark hyperlink close definition
-#define HYPERLINK_END ") cc_hyperlink\n\
-  setcolor\n\
-  currentpoint\n\
-  [ /Rect 6 -4 roll 4 array astore\n\
-    /Action << /Subtype /URI /URI (%s) >>\n\
-    /Border [0 0 2]\n\
-    /Color [.7 0 0]\n\
-    /Subtype /Link\n\
-    /ANN pdfmark\n"
-
-/// PDFMark internal document link box definition
-#define JUMPBOX "\n[ /Rect [%d %d %d %d]\n\
+/**
+	@brief The plugin's PostScript procedures, written once per document
+
+	The procedures are defined in global VM, so the save/restore around each page doesn't remove them, and the
+	pages only have to write the operands and the procedure name:
+	- rect url cc_url, rect url title cc_urlt, rect url title page cc_urlp: URL link box
+	- rect page x y cc_jump, rect page x y title cc_jumpt: link box to a location in the document
+	- size cc_font: selects the text font
+	- x y text cc_show: writes text at a location
+	- size text url width cc_textlink: writes underlined text (from the current point) with a link on it
+	- imagedict parms cc_png: draws an image whose data follows in the file as ASCII base-85 of a zlib stream
+	  (parms are the FlateDecode parameters); the rest of the data is skipped, so the file continues after the ~>
+	- page cc_savematrix: keeps the current coordinate system of the page (in global VM, so it survives the page's restore)
+	- page cc_usematrix: switches to the coordinate system kept for the page
+	The text is measured and positioned by the driver (see TextLayout), so nothing here measures it.
+*/
+#define PS_PROCSET "\n\
+currentglobal true setglobal globaldict begin\n\
+/cc_link { /Title exch 3 -1 roll << /Subtype /URI /URI 5 -1 roll >> /Action exch 5 -1 roll /Rect exch\n\
+	/Border [0 0 2] /Color [.7 0 0] /Subtype /Link /ANN pdfmark } bind def\n\
+/cc_url { dup mark 4 1 roll cc_link } bind def\n\
+/cc_urlt { mark 4 1 roll cc_link } bind def\n\
+/cc_urlp { mark 5 1 roll /SrcPg exch 5 2 roll cc_link } bind def\n\
+/cc_jumpxyz { [/XYZ 4 2 roll 0] /View exch 3 -1 roll /Page exch 5 -1 roll /Rect exch\n\
+	/Border [0 0 2] /Color [.7 0 0] /Subtype /Link /ANN pdfmark } bind def\n\
+/cc_jump { mark 5 1 roll cc_jumpxyz } bind def\n\
+/cc_jumpt { mark 6 1 roll /Title exch 6 2 roll cc_jumpxyz } bind def\n\
+/cc_font { /Times-Roman findfont exch [ exch 0 0 2 index neg 0 0 ] makefont setfont } bind def\n\
+/cc_show { 3 1 roll moveto show } bind def\n\
+/cc_hyperlink { exch show neg\n\
+	gsave 0 currentfont dup\n\
+		/FontInfo get /UnderlineThickness get exch\n\
+		/FontMatrix get dtransform setlinewidth 0 currentfont dup\n\
+		/FontInfo get /UnderlinePosition get exch\n\
+		/FontMatrix get dtransform rmoveto rlineto stroke\n\
+	grestore\n\
+} bind def\n\
+/cc_textlink { 4 1 roll 3 1 roll exch currentpoint 3 -1 roll sub 3 -1 roll 5 -1 roll\n\
+	gsave 0 0 1 setrgbcolor cc_hyperlink currentpoint grestore moveto\n\
+	currentpoint [ /Rect 6 -4 roll 4 array astore /Action << /Subtype /URI /URI 9 -1 roll >>\n\
+	/Border [0 0 2] /Color [.7 0 0] /Subtype /Link /ANN pdfmark } bind def\n\
+/cc_png { currentfile /ASCII85Decode filter dup 4 1 roll exch /FlateDecode filter\n\
+	1 index /DataSource 3 -1 roll put image flushfile } bind def\n\
+/cc_linkmatrices 16 dict def\n\
+/cc_savematrix { currentglobal true setglobal cc_linkmatrices 3 -1 roll matrix currentmatrix put setglobal } bind def\n\
+/cc_usematrix { cc_linkmatrices exch get setmatrix } bind def\n\
+end setglobal\n"
+
+/// Switches back from a saved page coordinate system (see cc_usematrix)
+#define LINKMATRIX_END	"\ngrestore\n"
+
+/// PDFMark internal document link box definition (start, followed by the link rectangle)
+#define JUMPBOX_START "\n[ /Rect"
+/// PDFMark internal document link box definition (after the rectangle, followed by the destination name)
+#define JUMPBOX_DEST "\n\
 	/Border [0 0 2]\n\
 	/Color [.7 0 0]\n\
-	/Dest /%s\n\
-	/Title (%s)\n\
+	/Dest"
+/// PDFMark internal document link box definition (after the destination, followed by the title string)
+#define JUMPBOX_TITLE "\n\
+	/Title"
+/// PDFMark internal document link box definition end
+#define JUMPBOX_END "\n\
 	/Subtype /Link\n\
 	/ANN pdfmark\n"
 
-/// PDFMark internal document destination definition
-#define JUMPDEST "\n[ /Dest /%s\n\
+/// PDFMark internal document destination definition (followed by the destination name)
+#define JUMPDEST_START "\n[ /Dest"
+/// PDFMark internal document destination definition end
+#define JUMPDEST_END "\n\
 	/View [/Fit]\n\
 	/DEST pdfmark\n"
 
-/// PDFMark internal document link to unnamed destination
-#define JUMPINTERNAL_TITLE "\n[ /Rect [%d %d %d %d]\n\
-	/Border [0 0 2]\n\
-	/Color [.7 0 0]\n\
-	/Page %d\n\
-	/View [/XYZ %d %d 0]\n\
-	/Title (%s)\n\
-	/Subtype /Link\n\
-	/ANN pdfmark\n"
-
-/// PDFMark internal document link to unnamed destination
-#define JUMPINTERNAL "\n[ /Rect [%d %d %d %d]\n\
-	/Border [0 0 2]\n\
-	/Color [.7 0 0]\n\
-	/Page %d\n\
-	/View [/XYZ %d %d 0]\n\
-	/Subtype /Link\n\
-	/ANN pdfmark\n"
-
-/// Postscript text writing (with font) start definition
-#define PS_TEXT_START "/Times-Roman findfont [%d 0 0 -%d 0 0 ] makefont setfont\n\
-%d %d moveto\n\
-("
-/// Postscript text (with font) writing end definition
-#define PS_TEXT_END ") show\n"
-
-/// Postscript text writing start definition
-#define PS_JUSTTEXT_START "("
-/// Postscript text writing end definition
-#define PS_JUSTTEXT_END ") show \n"
-
-/// Postscript text writing (centered) helper function definition
-#define PS_TEXT_END_CENTER ")\n\
-dup stringwidth pop\n\
-%d exch sub\n\
-2 div\n\
-0 rmoveto\n\
-show\n"
-
-/// Postscript text writing (centered) start definition
-#define PS_CALC_CENTER_START "/Times-Roman findfont [%d 0 0 -%d 0 0 ] makefont setfont\n\
-%d %d moveto\n\
-("
-
-/// Postscript text writing (centered) end definition
-#define PS_CALC_CENTER_END ") stringwidth pop\n\
-%d exch sub\n\
-2 div\n\
-0 rmoveto\n"
-
-/// Postscript circle definition
-#define PS_CIRCLE "newpath %d %d %d 0 360 arc fill closepath\n"
+/// Postscript circle definition (after the X, Y and radius)
+#define PS_CIRCLE " 0 360 arc fill closepath\n"
 
 /// PostScript image start definition
-#define PS_IMAGE_START "gsave\n\
-%d %d translate\n\
-%d %d scale\n\
-%d %d %d [%d 0 0 -%d 0 %d] {<\n"
-
+#define PS_IMAGE_START "gsave\n"
 /// PostScript image end definition
 #define PS_IMAGE_END "\n>} image\n\
-grestore\n";
+grestore\n"
+/// PostScript palette image color space (after the highest index and the colors hex string)
+#define PS_INDEXED_END "] setcolorspace\n"
+/// PostScript palette image end definition
+#define PS_INDEXED_IMAGE_END "\n> >> image\n\
+grestore\n"
 
 /// 'Created by' text
 #define CREATEDBY_TEXT "The document was created by "
@@ -356,55 +393,40 @@ grestore\n";
 	/DOCINFO pdfmark\n"
 
 /**
-	@brief This function escapes text to be able to write it in PostScript 
-	@param lpString The string to fill with the escaped text
-	@param lpText The original text
-	@param dwLen Length of original text
+	@brief This function writes the collected PostScript code into the PostScript file
+	@param pdevobj Pointer to the device object representing the PostScript printer
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@return TRUE if written successfully, FALSE if failed
 */
-void AddPSText(LPSTR lpString, LPCSTR lpText, std::tstring::size_type dwLen)
+BOOL FlushPS(PDEVOBJ pdevobj, POEMPDEV pDevOEM)
 {
-	std::tstring::size_type nLoc = strlen(lpString);
-	for (std::tstring::size_type i=0;i<dwLen;i++)
-	{
-		switch (lpText[i])
-		{
-			case '\n':
-			case '\r':
-			case '\t':
-			case '\b':
-			case '\f':
-			case '\\':
-			case '(':
-			case ')':
-				lpString[nLoc++] = '\\';
-				break;
-		}
-		lpString[nLoc++] = lpText[i];
-	}
-	lpString[nLoc] = '\0';
+	pDevOEM->oStats.Add(HookStats::SC_SPOOLBYTES, pDevOEM->oPS.GetSize());
+	return pDevOEM->oPS.Flush(pdevobj, pDevOEM->pOEMHelp) ? TRUE : FALSE;
 }
 
 /**
-	@brief This function escapes text to be able to write it in PostScript 
-	@param lpString The string to fill with the escaped text
-	@param s The original string to write
+	@brief This function writes text to the PostScript file
+	@param pdevobj Pointer to the device object representing the PostScript printer
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param lpText The text to write
 */
-void AddPSText(LPSTR lpString, const std::string& s)
+void PrintPS(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpText)
 {
-	AddPSText(lpString, s.c_str(), s.size());
+	pDevOEM->oPS.Add(lpText, strlen(lpText));
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
-	@brief This function writes text to the PostScript file
-	@param pdevobj Pointer to the device object representing the PostScript printer
+	@brief This function adds the font selection code to the PostScript code (unless the font is already selected)
 	@param pDevOEM Pointer to the CC PDF Converter render plugin object
-	@param lpText The text to write
+	@param nFontSize Size of the font to select
 */
-void PrintPS(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpText)
+void AddPSFont(POEMPDEV pDevOEM, int nFontSize)
 {
-	DWORD dwResult;
-	std::tstring::size_type	dwLen = strlen(lpText);
-	pDevOEM->pOEMHelp->DrvWriteSpoolBuf(pdevobj, (void*)lpText, (DWORD)dwLen, &dwResult);
+	if (pDevOEM->nFontSize == nFontSize)
+		return;
+	pDevOEM->oPS.AddNumber((long)nFontSize).AddOp("cc_font").Add("\n");
+	pDevOEM->nFontSize = nFontSize;
 }
 
 /**
@@ -417,13 +439,13 @@ void PrintPS(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpText)
 */
 void PrintCircle(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nX, int nY, int nRadius)
 {
-	char cCircle[128];
-	sprintf_s(cCircle, _S(cCircle) , PS_CIRCLE, nX, nY, nRadius);
-	PrintPS(pdevobj, pDevOEM, cCircle);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.AddOp("newpath").AddNumber((long)nX).AddNumber((long)nY).AddNumber((long)nRadius).Add(PS_CIRCLE);
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
-	@brief This function writes a centered text string into the PostScript file
+	@brief This function moves to where a text string centered in a box starts (the text is written by the following calls)
 	@param pdevobj Pointer to the device object representing the PostScript printer
 	@param pDevOEM Pointer to the CC PDF Converter render plugin object
 	@param nFontSize Size of the font to print at
@@ -434,13 +456,10 @@ void PrintCircle(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nX, int nY, int nRadius)
 */
 void CenterText(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nFontSize, int nX, int nY, int nWidth, LPCSTR lpText)
 {
-	char cStr[1024];
-	sprintf_s(cStr, _S(cStr), PS_CALC_CENTER_START, nFontSize, nFontSize, nX, nY + nFontSize);
-	AddPSText(cStr, lpText, (DWORD)strlen(lpText));
-	char cEnd[1024];
-	sprintf_s(cEnd, _S(cEnd), PS_CALC_CENTER_END, nWidth);
-	strcat_s(cStr, _S(cStr), cEnd);
-	PrintPS(pdevobj, pDevOEM, cStr);
+	AddPSFont(pDevOEM, nFontSize);
+	long lWidth = TextLayout::GetWidth(lpText, strlen(lpText), nFontSize);
+	pDevOEM->oPS.AddNumber(nX + (nWidth - lWidth) / 2).AddNumber((long)(nY + nFontSize)).AddOp("moveto").Add("\n");
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
@@ -455,27 +474,36 @@ void PrintJumpLink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpDestination, cons
 {
 	if (lpTitle == NULL)
 		lpTitle = lpDestination;
-	char cLink[1024];
-	sprintf_s(cLink, _S(cLink), JUMPBOX, rectTarget.left, rectTarget.top, rectTarget.right, rectTarget.bottom, lpDestination, lpTitle);
-	PrintPS(pdevobj, pDevOEM, cLink);
+	pDevOEM->oStats.Add(HookStats::SC_LINKS);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.Add(JUMPBOX_START).AddRect(rectTarget);
+	ps.Add(JUMPBOX_DEST).AddName(lpDestination, strlen(lpDestination));
+	ps.Add(JUMPBOX_TITLE).AddString(lpTitle, strlen(lpTitle));
+	ps.Add(JUMPBOX_END);
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
 	@brief This function writes an unnamed inner-document link box into the PostScript file
 	@param pdevobj Pointer to the device object representing the PostScript printer
 	@param pDevOEM Pointer to the CC PDF Converter render plugin object
-	@param lpDestination Name of the link's destination
 	@param rectTarget Location of the link's box
+	@param lPage The page to link to
+	@param lX The X location to link to
+	@param lY The Y location to link to
 	@param lpTitle Title of the location (will be displayed in a tooltip in Acrobat)
 */
 void PrintInternalLink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, const RECTL& rectTarget, long lPage, long lX, long lY, LPCSTR lpTitle = NULL)
 {
-	char cLink[1024];
+	pDevOEM->oStats.Add(HookStats::SC_LINKS);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.AddRect(rectTarget).AddNumber(lPage).AddNumber(lX).AddNumber(lY);
 	if (lpTitle == NULL)
-		sprintf_s(cLink, _S(cLink), JUMPINTERNAL, rectTarget.left, rectTarget.top, rectTarget.right, rectTarget.bottom, lPage, lX, lY);
+		ps.AddOp("cc_jump");
 	else
-		sprintf_s(cLink, _S(cLink), JUMPINTERNAL_TITLE, rectTarget.left, rectTarget.top, rectTarget.right, rectTarget.bottom, lPage, lX, lY, lpTitle);
-	PrintPS(pdevobj, pDevOEM, cLink);
+		ps.AddString(lpTitle, strlen(lpTitle)).AddOp("cc_jumpt");
+	ps.Add("\n");
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
@@ -486,9 +514,35 @@ void PrintInternalLink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, const RECTL& rectTarge
 */
 void PrintJumpDestination(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpDestination)
 {
-	char cLink[1024];
-	sprintf_s(cLink, _S(cLink), JUMPDEST, lpDestination);
-	PrintPS(pdevobj, pDevOEM, cLink);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.Add(JUMPDEST_START).AddName(lpDestination, strlen(lpDestination)).Add(JUMPDEST_END);
+	FlushPS(pdevobj, pDevOEM);
+}
+
+/**
+	@brief This function adds a URL link box to the waiting PostScript code (call FlushPS to write it)
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param lpURL The target URL (must be NULL terminated)
+	@param rectTarget Location of the link's box
+	@param lpTitle The tooltip to display when the mouse is over the link (defaults to the destination URL)
+	@param nPage The page to put the link in (0 for the current page)
+*/
+void AddURLLink(POEMPDEV pDevOEM, LPCSTR lpURL, const RECTL& rectTarget, LPCSTR lpTitle = NULL, UINT nPage = 0)
+{
+	pDevOEM->oStats.Add(HookStats::SC_LINKS);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.AddRect(rectTarget).AddString(lpURL, strlen(lpURL));
+	if (nPage != 0)
+	{
+		// Explicit page: the title is always written
+		ps.AddString((lpTitle == NULL) ? lpURL : lpTitle, strlen((lpTitle == NULL) ? lpURL : lpTitle));
+		ps.AddNumber((long)nPage).AddOp("cc_urlp");
+	}
+	else if (lpTitle != NULL)
+		ps.AddString(lpTitle, strlen(lpTitle)).AddOp("cc_urlt");
+	else
+		ps.AddOp("cc_url");
+	ps.Add("\n");
 }
 
 /**
@@ -501,13 +555,107 @@ void PrintJumpDestination(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpDestinatio
 */
 void PrintURLLink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpURL, const RECTL& rectTarget, LPCSTR lpTitle = NULL)
 {
-	char cLink[1024];
-	if (lpTitle == NULL)
-		lpTitle = lpURL;
-	sprintf_s(cLink, _S(cLink), URLBOX, rectTarget.left, rectTarget.top, rectTarget.right, rectTarget.bottom, lpURL, lpTitle);
-	DWORD dwResult;
-	std::tstring::size_type dwLen = strlen(cLink);
-	pDevOEM->pOEMHelp->DrvWriteSpoolBuf(pdevobj, cLink, (DWORD)dwLen, &dwResult);
+	AddURLLink(pDevOEM, lpURL, rectTarget, lpTitle);
+	FlushPS(pdevobj, pDevOEM);
+}
+
+/**
+	@brief This function adds a link received through the \ref ESCAPE_LINK_DATA escape to the page's links
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param pData The escape data (an EscapeLinkData structure)
+	@param nSize Size of the data
+	@return true if added, false if the data is invalid
+*/
+bool AddEscapeLink(POEMPDEV pDevOEM, const void* pData, size_t nSize)
+{
+	if (nSize < sizeof(EscapeLinkData))
+		return false;
+
+	// Find the strings (they must be terminated inside the data)
+	const EscapeLinkData* pLink = (const EscapeLinkData*)pData;
+	size_t nMax = nSize - offsetof(EscapeLinkData, url);
+	const char* pEnd = (const char*)memchr(pLink->url, 0, nMax);
+	if (pEnd == NULL)
+		return false;
+	const char* pTitle = NULL;
+	size_t nTitleLen = 0;
+	if ((pLink->lTitleOffset > 0) && (pLink->lTitleOffset < nMax))
+	{
+		pTitle = pLink->url + pLink->lTitleOffset;
+		const char* pTitleEnd = (const char*)memchr(pTitle, 0, nMax - pLink->lTitleOffset);
+		if (pTitleEnd == NULL)
+			return false;
+		nTitleLen = pTitleEnd - pTitle;
+	}
+
+	RECTL rc = {pLink->left, pLink->top, pLink->right, pLink->bottom};
+	pDevOEM->oLinks.Add(rc, pLink->url, pEnd - pLink->url, pTitle, nTitleLen);
+	return true;
+}
+
+/**
+	@brief This function finds the length of a string in a \ref ESCAPE_LINK_DATA_BATCH escape
+	@param pData The escape data
+	@param nSize Size of the data
+	@param dwOffset Offset of the string in the data
+	@param nLen Receives the length of the string
+	@return true if the string is inside the data and terminated, false if not
+*/
+bool GetEscapeString(const char* pData, size_t nSize, DWORD dwOffset, size_t& nLen)
+{
+	if (dwOffset >= nSize)
+		return false;
+	const char* pEnd = (const char*)memchr(pData + dwOffset, 0, nSize - dwOffset);
+	if (pEnd == NULL)
+		return false;
+	nLen = pEnd - (pData + dwOffset);
+	return true;
+}
+
+/**
+	@brief This function adds the links received through the \ref ESCAPE_LINK_DATA_BATCH escape to the page's links
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param pData The escape data (an EscapeLinkBatch structure followed by the strings)
+	@param nSize Size of the data
+	@return true if added, false if the data is invalid (nothing is added)
+*/
+bool AddEscapeLinkBatch(POEMPDEV pDevOEM, const void* pData, size_t nSize)
+{
+	if (nSize < offsetof(EscapeLinkBatch, records))
+		return false;
+	const EscapeLinkBatch* pBatch = (const EscapeLinkBatch*)pData;
+	if (pBatch->dwCount > (nSize - offsetof(EscapeLinkBatch, records)) / sizeof(EscapeLinkRecord))
+		return false;
+
+	// Check all the records before adding anything
+	const char* pBytes = (const char*)pData;
+	size_t nStrings = 0, nLen;
+	for (DWORD i = 0; i < pBatch->dwCount; i++)
+	{
+		const EscapeLinkRecord& record = pBatch->records[i];
+		if (!GetEscapeString(pBytes, nSize, record.dwURLOffset, nLen))
+			return false;
+		nStrings += nLen + 1;
+		if (record.dwTitleOffset != 0)
+		{
+			if (!GetEscapeString(pBytes, nSize, record.dwTitleOffset, nLen))
+				return false;
+			nStrings += nLen + 1;
+		}
+	}
+
+	// Add them all
+	PageLinks& links = pDevOEM->oLinks;
+	links.Reserve(pBatch->dwCount, nStrings);
+	for (DWORD i = 0; i < pBatch->dwCount; i++)
+	{
+		const EscapeLinkRecord& record = pBatch->records[i];
+		RECTL rc = {record.left, record.top, record.right, record.bottom};
+		const char* pURL = pBytes + record.dwURLOffset;
+		const char* pTitle = (record.dwTitleOffset == 0) ? NULL : pBytes + record.dwTitleOffset;
+		links.Add(rc, pURL, strlen(pURL), pTitle, (pTitle == NULL) ? 0 : strlen(pTitle));
+	}
+	return true;
 }
 
 /**
@@ -521,42 +669,25 @@ void PrintURLLink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpURL, const RECTL&
 */
 void PrintHyperlink(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nFontSize, LPCSTR lpText, std::tstring::size_type dwLen, LPCSTR lpURL)
 {
-	char cStr[2048];
-	sprintf_s(cStr, _S(cStr), HYPERLINK_START, nFontSize);
-	AddPSText(cStr, lpText, dwLen);
-	char cEnd[1024];
-	sprintf_s(cEnd, _S(cEnd), HYPERLINK_END, lpURL);
-	strcat_s(cStr, _S(cStr), cEnd);
-	PrintPS(pdevobj, pDevOEM, cStr);
+	PSWriter& ps = pDevOEM->oPS;
+	ps.AddNumber((long)nFontSize).AddString(lpText, dwLen).AddString(lpURL, strlen(lpURL));
+	ps.AddNumber(TextLayout::GetWidth(lpText, dwLen, nFontSize)).AddOp("cc_textlink").Add("\n");
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
-	@brief This function prepares a text string so it can be written into PostScript
-	@param lpString The string to fill
+	@brief This function adds the code to write a text string to the PostScript code
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
 	@param nFontSize Size of the font to use
 	@param nX X location of the start of the text
 	@param nY Y location of the start of the text
 	@param lpText The text to write
 	@param dwLen Length of the text string
-	@param nWidth Width of the text's bounding box (-1 so it won't be centered)
-	@return The length of the new string
-
-	Note that not specifying nWidth (or setting it to -1) will write the text as it is, and specifying nWidth
-	will center the text inside a box starting at nX and being nWidth wide
 */
-size_t PrepareWriteString(LPSTR lpString, int nStringSize, int nFontSize, int nX, int nY, LPCSTR lpText, std::tstring::size_type dwLen, int nWidth = -1)
+void PrepareWriteString(POEMPDEV pDevOEM, int nFontSize, long nX, long nY, LPCSTR lpText, std::tstring::size_type dwLen)
 {
-	sprintf_s(lpString, nStringSize, PS_TEXT_START, nFontSize, nFontSize, nX, nY);
-	AddPSText(lpString, lpText, dwLen);
-	if (nWidth == -1)
-		strcat_s(lpString, nStringSize, PS_TEXT_END);
-	else
-	{
-		char c[128];
-		sprintf_s(c, _S(c), PS_TEXT_END_CENTER, nWidth);
-		strcat_s(lpString, nStringSize, c);
-	}
-	return strlen(lpString);
+	AddPSFont(pDevOEM, nFontSize);
+	pDevOEM->oPS.AddNumber(nX).AddNumber(nY).AddString(lpText, dwLen).AddOp("cc_show").Add("\n");
 }
 
 /**
@@ -567,11 +698,8 @@ size_t PrepareWriteString(LPSTR lpString, int nStringSize, int nFontSize, int nX
 */
 void PrintText(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpText)
 {
-	char cStr[1024];
-	sprintf_s(cStr, _S(cStr), PS_JUSTTEXT_START);
-	AddPSText(cStr, lpText, strlen(lpText));
-	strcat_s(cStr, _S(cStr), PS_JUSTTEXT_END);
-	PrintPS(pdevobj, pDevOEM, cStr);
+	pDevOEM->oPS.AddString(lpText, strlen(lpText)).AddOp("show").Add("\n");
+	FlushPS(pdevobj, pDevOEM);
 }
 
 /**
@@ -589,37 +717,43 @@ void PrintText(PDEVOBJ pdevobj, POEMPDEV pDevOEM, LPCSTR lpText)
 */
 int PrintText(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nFontSize, int nX, int nY, int nWidth, int nLineHeight, LPCSTR lpText, bool bCenter = false)
 {
-	char cStr[1024];
-	// Calculate how much text we can put in the width:
-	DWORD dwResult;
-	std::tstring::size_type dwWriteLen;
-	std::tstring::size_type dwLen = strlen(lpText);
+	// Break the text into lines that fit the width
+	TextLayout::LINES lines;
+	TextLayout::Wrap(lpText, strlen(lpText), nFontSize, nWidth, lines);
 	int nRet = 0;
-	while ((dwLen * nFontSize / 2) > nWidth)
+	for (TextLayout::LINES::const_iterator i = lines.begin(); i != lines.end(); i++)
 	{
-		// Find the last space we can break on:
-		DWORD dwBreak = max(1, nWidth / (nFontSize / 2));
-		while ((dwBreak > 1) && (lpText[dwBreak] != ' '))
-			dwBreak--;
-		// Write what we have
 		nRet += nLineHeight;
-		dwWriteLen = PrepareWriteString(cStr, sizeof(cStr), nFontSize, nX, nY + nRet, lpText, dwBreak, bCenter ? nWidth : -1);
-		pDevOEM->pOEMHelp->DrvWriteSpoolBuf(pdevobj, cStr, (DWORD)dwWriteLen, &dwResult);
-		lpText += dwBreak + 1;
-		dwLen -= dwBreak - 1;
-	}
-	
-	if (dwLen > 0)
-	{
-		nRet += nLineHeight;
-		dwWriteLen = PrepareWriteString(cStr, sizeof(cStr), nFontSize, nX, nY + nRet, lpText, dwLen, bCenter ? nWidth : -1);
-		dwWriteLen = strlen(cStr);
-		pDevOEM->pOEMHelp->DrvWriteSpoolBuf(pdevobj, cStr, (DWORD)dwWriteLen, &dwResult);
+		if ((*i).nLen == 0)
+			// Empty line
+			continue;
+		long lX = bCenter ? nX + (nWidth - (*i).lWidth) / 2 : nX;
+		PrepareWriteString(pDevOEM, nFontSize, lX, nY + nRet, lpText + (*i).nStart, (*i).nLen);
 	}
 
+	// Write all the lines at once
+	FlushPS(pdevobj, pDevOEM);
 	return nRet;
 }
 
+/**
+	@brief This function retrieves the palette of a bitmap
+	@param hBmp The bitmap (a DIB section)
+	@param pColors Receives the colors (room for 256)
+	@return Number of colors, 0 if the bitmap has no palette
+*/
+int GetBitmapColors(HBITMAP hBmp, RGBQUAD* pColors)
+{
+	HDC hDC = ::CreateCompatibleDC(NULL);
+	if (hDC == NULL)
+		return 0;
+	HGDIOBJ hOld = ::SelectObject(hDC, hBmp);
+	int nColors = (int)::GetDIBColorTable(hDC, 0, 256, pColors);
+	::SelectObject(hDC, hOld);
+	::DeleteDC(hDC);
+	return nColors;
+}
+
 /**
 	@brief This function writes a bitmap image directly into the PostScript file
 	@param pdevobj Pointer to the device object representing the PostScript printer
@@ -627,6 +761,8 @@ int PrintText(PDEVOBJ pdevobj, POEMPDEV pDevOEM, int nFontSize, int nX, int nY,
 	@param hBmp The bitmap to write
 	@param rectTargetArea In: Horizontal bound box, Y location of the bitmap; Out: Actual location of the bitmap
 	@return TRUE if written successfully, FALSE if failed
+
+	Palette bitmaps are written as /Indexed images, keeping their pixel size.
 */
 BOOL PrintImage(PDEVOBJ pdevobj, POEMPDEV pDevOEM, HBITMAP hBmp, RECTL& rectTargetArea)
 {
@@ -644,28 +780,139 @@ BOOL PrintImage(PDEVOBJ pdevobj, POEMPDEV pDevOEM, HBITMAP hBmp, RECTL& rectTarg
 	rectTargetArea.right = rectTargetArea.left + nDrawWidth;
 	rectTargetArea.bottom = rectTargetArea.top + nDrawHeight;
 
-	char cStr[1024];
-	sprintf_s(cStr, _S(cStr), PS_IMAGE_START, rectTargetArea.left, rectTargetArea.top, 
-		nDrawWidth, nDrawHeight, 
-		dib.dsBm.bmWidth, dib.dsBm.bmHeight, dib.dsBm.bmBitsPixel, dib.dsBm.bmWidth, dib.dsBm.bmHeight, dib.dsBm.bmHeight);
-	std::string sWrite(cStr);
+	// Image header: location, size and the image matrix
+	PSWriter& ps = pDevOEM->oPS;
+	ps.Add(PS_IMAGE_START);
+	ps.AddNumber(rectTargetArea.left).AddNumber(rectTargetArea.top).AddOp("translate\n");
+	ps.AddNumber(nDrawWidth).AddNumber(nDrawHeight).AddOp("scale\n");
 
+	RGBQUAD rgbColors[256];
+	int nBits = dib.dsBm.bmBitsPixel;
+	int nColors = (nBits <= 8) ? GetBitmapColors(hBmp, rgbColors) : 0;
+	if (nColors > 0)
+	{
+		// Palette image: the color space maps the indices to their colors
+		BYTE cPalette[256 * 3];
+		for (int i = 0; i < nColors; i++)
+		{
+			cPalette[i * 3] = rgbColors[i].rgbRed;
+			cPalette[i * 3 + 1] = rgbColors[i].rgbGreen;
+			cPalette[i * 3 + 2] = rgbColors[i].rgbBlue;
+		}
+		ps.Add("[/Indexed /DeviceRGB").AddNumber((long)nColors - 1).AddHexString(cPalette, nColors * 3).Add(PS_INDEXED_END);
+		ps.Add("<< /ImageType 1 /Width").AddNumber(dib.dsBm.bmWidth).Add(" /Height").AddNumber(dib.dsBm.bmHeight);
+		ps.Add(" /BitsPerComponent").AddNumber((long)nBits).Add(" /Decode [0").AddNumber((1L << nBits) - 1).Add("]\n");
+		ps.Add("/ImageMatrix [").AddNumber(dib.dsBm.bmWidth).Add(" 0 0").AddNumber(-dib.dsBm.bmHeight).Add(" 0").AddNumber(dib.dsBm.bmHeight).Add("] /DataSource <\n");
+
+		// Image data, one line per row (without the row padding)
+		int nRowBytes = (dib.dsBm.bmWidth * nBits + 7) / 8;
+		for (int i = 0; i < dib.dsBm.bmHeight; i++)
+		{
+			ps.AddHex(((const BYTE*)dib.dsBm.bmBits) + (i * dib.dsBm.bmWidthBytes), nRowBytes);
+			ps.Add("\n");
+		}
+
+		ps.Add(PS_INDEXED_IMAGE_END);
+		return FlushPS(pdevobj, pDevOEM);
+	}
+
+	ps.AddNumber(dib.dsBm.bmWidth).AddNumber(dib.dsBm.bmHeight).AddNumber((long)dib.dsBm.bmBitsPixel);
+	ps.Add(" [").AddNumber(dib.dsBm.bmWidth).Add(" 0 0").AddNumber(-dib.dsBm.bmHeight).Add(" 0").AddNumber(dib.dsBm.bmHeight).Add("] {<\n");
+
+	// Image data, one line per row
 	int nByteWidth = dib.dsBmih.biSizeImage / dib.dsBmih.biHeight;
 	int nRealByteWidth = dib.dsBmih.biBitCount == 0 ? 8 : (dib.dsBm.bmWidth * 8) / dib.dsBmih.biBitCount;
 	for (int i=0;i<dib.dsBm.bmHeight;i++)
 	{
-		for (int j=0;j<nRealByteWidth;j++)
-		{
-			sprintf_s(cStr, _S(cStr), "%02x", *(((unsigned char*)dib.dsBm.bmBits) + (i * nByteWidth) + j));
-			sWrite += cStr;
-		}
-		sWrite += "\n";
+		ps.AddHex(((const BYTE*)dib.dsBm.bmBits) + (i * nByteWidth), nRealByteWidth);
+		ps.Add("\n");
 	}
 
-	sWrite += PS_IMAGE_END;
-	DWORD dwWriteLen = (DWORD) sWrite.size(), dwResult;
-	DWORD dwRes = pDevOEM->pOEMHelp->DrvWriteSpoolBuf(pdevobj, (void*)sWrite.c_str(), dwWriteLen, &dwResult);
-	return (dwRes == S_OK) && (dwWriteLen == dwResult);
+	ps.Add(PS_IMAGE_END);
+	return FlushPS(pdevobj, pDevOEM);
+}
+
+/**
+	@brief This function writes a PNG image's compressed data directly into the PostScript file
+	@param pdevobj Pointer to the device object representing the PostScript printer
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+	@param png The image to write
+	@param rectTarget The drawing location
+	@return TRUE if written successfully, FALSE if failed
+
+	The image is not decoded: the PNG's zlib stream is written as it is, and the interpreter decodes it with
+	the FlateDecode filter's PNG predictors. PostScript has no alpha, so images with an alpha channel use a
+	DeviceN color space that drops it (the same as drawing the decoded image without its alpha).
+*/
+BOOL PrintImage(PDEVOBJ pdevobj, POEMPDEV pDevOEM, const PngStream& png, const RECTL& rectTarget)
+{
+	PSWriter& ps = pDevOEM->oPS;
+	ps.Add(PS_IMAGE_START);
+	ps.AddNumber(rectTarget.left).AddNumber(rectTarget.top).AddOp("translate\n");
+	ps.AddNumber(rectTarget.right - rectTarget.left).AddNumber(rectTarget.bottom - rectTarget.top).AddOp("scale\n");
+
+	// Color space
+	int nSamples = png.GetSamples();
+	switch (png.GetColorType())
+	{
+		case PngStream::CT_GRAY:
+			ps.Add("/DeviceGray setcolorspace\n");
+			break;
+		case PngStream::CT_RGB:
+			ps.Add("/DeviceRGB setcolorspace\n");
+			break;
+		case PngStream::CT_PALETTE:
+			ps.Add("[/Indexed /DeviceRGB").AddNumber((long)png.GetColorCount() - 1).AddHexString(png.GetPalette(), png.GetColorCount() * 3).Add(PS_INDEXED_END);
+			break;
+		case PngStream::CT_GRAYALPHA:
+			ps.Add("[/DeviceN [/Gray /Alpha] /DeviceGray {pop}] setcolorspace\n");
+			break;
+		case PngStream::CT_RGBALPHA:
+			ps.Add("[/DeviceN [/Red /Green /Blue /Alpha] /DeviceRGB {pop}] setcolorspace\n");
+			break;
+	}
+
+	// Image dictionary (the rows are top-down) and the filter parameters
+	ps.Add("<< /ImageType 1 /Width").AddNumber((long)png.GetWidth()).Add(" /Height").AddNumber((long)png.GetHeight());
+	ps.Add(" /BitsPerComponent").AddNumber((long)png.GetBitDepth()).Add(" /Decode [");
+	if (png.GetColorType() == PngStream::CT_PALETTE)
+		ps.AddNumber(0L).AddNumber((1L << png.GetBitDepth()) - 1);
+	else
+		for (int i = 0; i < nSamples; i++)
+			ps.AddNumber(0L).AddNumber(1L);
+	ps.Add("]\n/ImageMatrix [").AddNumber((long)png.GetWidth()).Add(" 0 0").AddNumber((long)png.GetHeight()).Add(" 0 0] >>\n");
+	ps.Add("<< /Predictor 15 /Colors").AddNumber((long)nSamples).Add(" /BitsPerComponent").AddNumber((long)png.GetBitDepth());
+	ps.Add(" /Columns").AddNumber((long)png.GetWidth()).Add(" >> cc_png\n");
+
+	// The data
+	ps.AddASCII85(png.GetData(), png.GetDataSize());
+	ps.Add("grestore\n");
+	return FlushPS(pdevobj, pDevOEM);
+}
+
+/**
+	@brief This function prepares the search for the current page's text links
+	@param pDevOEM Pointer to the CC PDF Converter render plugin object
+*/
+void PrepareTextLinks(POEMPDEV pDevOEM)
+{
+	pDevOEM->oMatcher.Clear();
+	pDevOEM->arTextLinks.clear();
+	// Test pages search the complete text at the end of the page
+	if (!pDevOEM->bLoadedData || pDevOEM->dataLinks.IsTestPage())
+		return;
+
+	// Add all the page's text links
+	const CCPrintData::PageData& data = pDevOEM->dataLinks.GetPageData(pDevOEM->nPage);
+	for (CCPrintData::PageData::const_iterator i = data.begin(); i != data.end(); i++)
+	{
+		const CCPrintData::LinkData& link = (*i);
+		if (link.IsLocation())
+			continue;
+		pDevOEM->oMatcher.AddLink(link.sText, link.nRepeat, pDevOEM->arTextLinks.size());
+		pDevOEM->arTextLinks.push_back(&link);
+	}
+	pDevOEM->oMatcher.Start();
 }
 
 /**
@@ -800,8 +1047,6 @@ BOOL DoLicensePage(SURFOBJ* pso)
 		::DeleteObject(hBmp);
 	}
 
-	// Write hyperlink function...
-	PrintPS(pdevobj, poempdev, HYPERLINK_FUNC);
 	int nTextHeight;
 
 	CenterText(pdevobj, poempdev, (nFontSize * 3) / 2, 0, nY, pso->sizlBitmap.cx, MakeAnsiString(sLicenseName).c_str());
@@ -862,7 +1107,7 @@ BOOL DoLicensePage(SURFOBJ* pso)
 	}
 
 	// Bottom of page: put a link to cc pdf converter
-	CenterText(pdevobj, poempdev, nFontSize, 0, nHeight - 2 * nLineHeight, pso->sizlBitmap.cx, CREATEDBY_TEXT CREATEDBY_LINK);
+	CenterText(pdevobj, poempdev, nFontSize, 0, nHeight - 2 * nLineHeight, pso->sizlBitmap.cx, CREATEDBY_TEXT CREATEDBY_LINK_TEXT);
 	PrintText(pdevobj, poempdev, CREATEDBY_TEXT);
 	PrintHyperlink(pdevobj, poempdev, nFontSize, CREATEDBY_LINK_TEXT, (DWORD)strlen(CREATEDBY_LINK_TEXT), CREATEDBY_LINK);
 
@@ -886,20 +1131,47 @@ BOOL APIENTRY OEMStartPage(SURFOBJ* pso)
 
     pdevobj = (PDEVOBJ)pso->dhpdev;
     poempdev = (POEMPDEV)pdevobj->pdevOEM;
+	HookTimer timer(poempdev->oStats, HookStats::ST_STARTPAGE);
 	poempdev->nPage++;
+	poempdev->oStats.Add(HookStats::SC_PAGES);
+
+	// Record the page and its loaded links
+	if (poempdev->pTrace != NULL)
+	{
+		poempdev->pTrace->StartPage(poempdev->nPage);
+		if (poempdev->bLoadedData)
+		{
+			const CCPrintData::PageData& data = poempdev->dataLinks.GetPageData(poempdev->nPage);
+			for (CCPrintData::PageData::const_iterator i = data.begin(); i != data.end(); i++)
+				poempdev->pTrace->PageLink(*i);
+		}
+	}
 
     //
     // turn around to call PS
     //
 
-	// Only get text if needed
+	// Only keep the text if needed: the matcher captures what it needs for the text links of real print jobs
 	if (poempdev->bLoadedData)
-		poempdev->bNeedText = poempdev->dataLinks.IsTestPage() || poempdev->dataLinks.GetPageData(poempdev->nPage).HasTextLink();
+	{
+		poempdev->bNeedText = poempdev->dataLinks.IsTestPage();
+		PrepareTextLinks(poempdev);
+	}
 #ifdef _DEBUG
 	poempdev->bNeedText = true;
 #endif
 
-    return (((PFN_DrvStartPage)(poempdev->pfnPS[UD_DrvStartPage]))(pso));
+    if (!((PFN_DrvStartPage)(poempdev->pfnPS[UD_DrvStartPage]))(pso))
+		return FALSE;
+
+	// Define our procedures (once per document: the driver writes its header with the first page)
+	if (!poempdev->bProcSet)
+	{
+		PrintPS(pdevobj, poempdev, PS_PROCSET);
+		poempdev->bProcSet = true;
+	}
+	poempdev->nFontSize = 0;
+	return TRUE;
 
 }
 
@@ -917,13 +1189,19 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 
     pdevobj = (PDEVOBJ)pso->dhpdev;
     poempdev = (POEMPDEV)pdevobj->pdevOEM;
+	HookTimer timer(poempdev->oStats, HookStats::ST_SENDPAGE);
+	if (poempdev->pTrace != NULL)
+		poempdev->pTrace->SendPage(poempdev->nPage);
+
+	// Time the link work done on the printing thread
+	LARGE_INTEGER liStart, liEnd, liFrequency;
+	::QueryPerformanceCounter(&liStart);
 
 	// Work with external data (i.e., links file)
 	POEMDEV pDevMode = (POEMDEV)pdevobj->pOEMDM;
 	if (poempdev->dataLinks.HasData())
 	{
 		poempdev->bUsedPrintData = true;
-		RECTL rcArea;
 
 		// Get data for this page
 		VERBOSE(DLLTEXT("Processing page %d for links\r\n"), poempdev->nPage);
@@ -940,28 +1218,34 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 				// OK, this is the real thing. Only work on the first page
 				if (poempdev->nPage == 1)
 				{
+					// Put the page's text together
+					poempdev->oText.Finalize();
+
 					// Prepare the result object
 					CCPrintData dataCompute;
 					dataCompute.SetTestPage();
 
 					// Get the link data to test for
 					const CCPrintData::PageData& data = poempdev->dataLinks.GetPageData(poempdev->nPage);
+					std::vector<const CCPrintData::LinkData*> links;
+					LinkMatcher matcher;
 					for (CCPrintData::PageData::const_iterator i = data.begin(); i != data.end(); i++)
 					{
-						// For each link, try to find it
+						// For each link, prepare to find it
 						const CCPrintData::LinkData& link = (*i);
 						ASSERT(!link.IsLocation());
 						ASSERT(link.nRepeat == 1);
-
-						// We don't know the order, so start at the beginning
-						poempdev->oText.InitSearch();
-						STRLIST words;
-						words.push_back(link.sText);
-					
-						if (poempdev->oText.SearchFor(words, rcArea, link.nRepeat))
-							// Found, add to the results
-							dataCompute.AddLink(link.sURL, rcArea, 1);
+						matcher.AddLink(link.sText, link.nRepeat, links.size());
+						links.push_back(&link);
 					}
+
+					// Find them all
+					LinkMatcher::MATCHES matches;
+					matcher.Search(poempdev->oText, matches);
+					poempdev->oStats.Add(HookStats::SC_LINKMATCHES, matches.size());
+					for (LinkMatcher::MATCHES::const_iterator i = matches.begin(); i != matches.end(); i++)
+						// Found, add to the results
+						dataCompute.AddLink(links[(*i).nLink]->sURL, (*i).rcArea, 1);
 					// OK, set it up as the results and update the file!
 					dataCompute.SetPageSize(1, pso->sizlBitmap);
 					dataCompute.UpdateProcessData(pdevobj->hPrinter);
@@ -976,8 +1260,6 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 			const CCPrintData::PageData& data = poempdev->dataLinks.GetPageData(poempdev->nPage);
 			if (!data.empty())
 			{
-				// Make sure we can search for text links
-				poempdev->oText.InitSearch();
 				for (CCPrintData::PageData::const_iterator i = data.begin(); i != data.end(); i++)
 				{
 					// Get next link
@@ -995,73 +1277,71 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 						else
 						{
 							// External link, add it to the list
-							poempdev->pLinks = new InnerEscapeLinkData(link.rectLocation, MakeAnsiString(link.sURL).c_str(), poempdev->pLinks, link.sTitle.empty() ? NULL : MakeAnsiString(link.sTitle).c_str());
+							poempdev->oLinks.Add(link.rectLocation, MakeAnsiString(link.sURL), MakeAnsiString(link.sTitle));
 							VERBOSE(DLLTEXT("Adding location-based link to %s:\r\n(%d,%d)-(%d,%d)\r\n"), link.sURL.c_str(), link.rectLocation.left, link.rectLocation.top, link.rectLocation.right, link.rectLocation.bottom);
 						}
 					}
-					else
-					{
-						// Text link: break it into words
-						std::tstring::size_type pos = link.sText.find(' '), oldpos = 0;
-						STRLIST words;
-						while ((oldpos < link.sText.size()) && (pos != std::tstring::npos))
-						{
-							if (pos > oldpos)
-								words.push_back(link.sText.substr(oldpos, pos - oldpos));
-							oldpos = pos + 1;
-							pos = link.sText.find(' ', oldpos);
-						}
-						if (oldpos < link.sText.size())
-							words.push_back(link.sText.substr(oldpos));
-
-						// Try to find the words
-						if (!poempdev->oText.SearchFor(words, rcArea, link.nRepeat))
-							break;
-						// Found, so mark the location
-						poempdev->pLinks = new InnerEscapeLinkData(rcArea, MakeAnsiString(link.sURL).c_str(), poempdev->pLinks, link.sTitle.empty() ? NULL : MakeAnsiString(link.sTitle).c_str());
-					}
+				}
+
+				// Text links were searched for while the page was printed
+				const LinkMatcher::MATCHES& matches = poempdev->oMatcher.Finish();
+				poempdev->oStats.Add(HookStats::SC_LINKMATCHES, matches.size());
+				for (LinkMatcher::MATCHES::const_iterator i = matches.begin(); i != matches.end(); i++)
+				{
+					// Found, so mark the location
+					const CCPrintData::LinkData& link = *poempdev->arTextLinks[(*i).nLink];
+					poempdev->oLinks.Add((*i).rcArea, MakeAnsiString(link.sURL), MakeAnsiString(link.sTitle));
 				}
 			}
+
+			// Done with this page's link data (drop the text link pointers into it first)
+			poempdev->oMatcher.Clear();
+			poempdev->arTextLinks.clear();
+			poempdev->dataLinks.ReleasePage(poempdev->nPage);
+		}
+	}
+	else if (pDevMode->bAutoURLs && (poempdev->pLinkWorker != NULL))
+	{
+		// Let the background thread find the URLs; the links are written at the end of the document
+		if (!poempdev->oText.empty())
+		{
+			// Keep the page's coordinate system for its links, written after the page is done
+			poempdev->oPS.Add("\n").AddNumber((long)poempdev->nPage).AddOp("cc_savematrix").Add("\n");
+			FlushPS(pdevobj, poempdev);
+			poempdev->pLinkWorker->Submit(poempdev->nPage, poempdev->oText);
 		}
 	}
 	else if (pDevMode->bAutoURLs)
 	{
 		// Find and highlight URLs if so set by the user
+		poempdev->oText.Finalize();
 		std::wstring sURL;
 		RECTL rcArea;
-		poempdev->oText.InitSearch();
-		while (poempdev->oText.SearchForURL(rcArea, sURL))
+		URLScanner scanner(poempdev->oText, poempdev->uURLFlags);
+		while (scanner.Next(rcArea, sURL))
+		{
 			// Found a URL, add it to the list of links
-			poempdev->pLinks = new InnerEscapeLinkData(rcArea, MakeAnsiString(sURL).c_str(), poempdev->pLinks);
+			poempdev->oLinks.Add(rcArea, MakeAnsiString(sURL));
+			poempdev->oStats.Add(HookStats::SC_LINKMATCHES);
+		}
 	}
-	poempdev->oText.clear();
+	VERBOSE(DLLTEXT("Text capture heap allocations so far: %d\r\n"), (int)(poempdev->oText.GetHeapAllocations() + poempdev->oScratch.GetBlockAllocations()));
+	poempdev->oText.Reset();
+	poempdev->oScratch.Reset();
 
 	// Do we have links to add to this page?
-	if (poempdev->pLinks != NULL)
+	if (!poempdev->oLinks.empty())
 	{
-		while (poempdev->pLinks != NULL)
-		{
-			// Get the link
-			InnerEscapeLinkData* pLink = (InnerEscapeLinkData*)poempdev->pLinks;
-			poempdev->pLinks = pLink->pNext;
-
-			// Prepare the necessary data
-			RECTL rectTarget;
-			rectTarget.left = pLink->pData->left;
-			rectTarget.top = pLink->pData->top;
-			rectTarget.right = pLink->pData->right;
-			rectTarget.bottom = pLink->pData->bottom;
-
-			if (pLink->pData->lTitleOffset > 0)
-				// Print with title
-				PrintURLLink(pdevobj, poempdev, pLink->pData->url, rectTarget, pLink->pData->url + pLink->pData->lTitleOffset);
-			else
-				// Print without title
-				PrintURLLink(pdevobj, poempdev, pLink->pData->url, rectTarget);
-
-			delete pLink;
-		}
+		// Write them all at once
+		const PageLinks& links = poempdev->oLinks;
+		for (size_t i = 0; i < links.size(); i++)
+			AddURLLink(poempdev, links.GetURL(i), links.GetArea(i), links.GetTitle(i));
+		FlushPS(pdevobj, poempdev);
+		poempdev->oLinks.Clear();
 	}
+	::QueryPerformanceCounter(&liEnd);
+	::QueryPerformanceFrequency(&liFrequency);
+	VERBOSE(DLLTEXT("Page %d links took %d microseconds on the printing thread\r\n"), poempdev->nPage, (int)((liEnd.QuadPart - liStart.QuadPart) * 1000000 / liFrequency.QuadPart));
 
 	// Check were we write the license info
 	bool bFirstPage = poempdev->nPage == 1;
@@ -1083,12 +1363,9 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 			case LicenseInfo::LTPublicDomain:
 				// Put a public domain license notice:
 				{
-					char c[2048];
-					sprintf_s(c, _S(c), PS_NO_LICENSE_INFO);
 					std::string sURL = MakeAnsiString(pDevMode->info.m_cURI);
-					AddPSText(c, sURL);
-					strcat_s(c, _S(c), PS_LICENSE_INFO_END);
-					PrintPS(pdevobj, poempdev, c);
+					poempdev->oPS.Add(PS_NO_LICENSE_INFO).AddEscaped(sURL.data(), sURL.size()).Add(PS_LICENSE_INFO_END);
+					FlushPS(pdevobj, poempdev);
 				}
 				break;
 			case LicenseInfo::LTNone:
@@ -1098,16 +1375,13 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 			default:
 				// Put the license information notice:
 				{
-					char c[2048];
-					sprintf_s(c, _S(c), PS_LICENSE_INFO_START);
 					std::string sURL = MakeAnsiString(pDevMode->info.m_cURI), sName = MakeAnsiString(pDevMode->info.m_cName);
-					AddPSText(c, sURL);
-					strcat_s(c, _S(c), PS_LICENSE_INFO_CONTINUE);
-					AddPSText(c, sName);
-					strcat_s(c, _S(c), " license ");
-					AddPSText(c, sURL);
-					strcat_s(c, _S(c), PS_LICENSE_INFO_END);
-					PrintPS(pdevobj, poempdev, c);
+					PSWriter& ps = poempdev->oPS;
+					ps.Add(PS_LICENSE_INFO_START).AddEscaped(sURL.data(), sURL.size());
+					ps.Add(PS_LICENSE_INFO_CONTINUE).AddEscaped(sName.data(), sName.size());
+					ps.Add(" license ").AddEscaped(sURL.data(), sURL.size());
+					ps.Add(PS_LICENSE_INFO_END);
+					FlushPS(pdevobj, poempdev);
 				}
 				break;
 		}
@@ -1120,18 +1394,30 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 		UINT uImage = GetLicenseImage(pDevMode->info);
 		if (uImage > 0)
 		{
-			// 1. Load the bitmap
-			PngImage png;
-			if (png.LoadFromResource(uImage, true, ghInstance))
+			// 1. Load the bitmap: as it is if PostScript can decode it, otherwise decoded and scaled here
+			double dMultiplier = 1.0;
+			if (pdevobj->pPublicDM->dmPrintQuality > 0)
+				dMultiplier = pdevobj->pPublicDM->dmPrintQuality / 72.0;
+			PngStream stream;
+			const PngImage* pBadge = NULL;
+			bool bStream = stream.LoadFromResource(uImage, ghInstance, _T("PNG"));
+			if (!bStream)
+				pBadge = GetScaledBadge(poempdev, uImage, dMultiplier);
+			if (bStream || (pBadge != NULL))
 			{
 				// Create the target location
 				RECTL rectTarget;
 				SIZEL szTarget;
-				double dMultiplier = 1.0;
-				if (pdevobj->pPublicDM->dmPrintQuality > 0)
-					dMultiplier = pdevobj->pPublicDM->dmPrintQuality / 72.0;
-				szTarget.cx = (long) (png.GetWidth() * dMultiplier);
-				szTarget.cy = (long) (png.GetHeight() * dMultiplier);
+				if (bStream)
+				{
+					szTarget.cx = (long) (stream.GetWidth() * dMultiplier);
+					szTarget.cy = (long) (stream.GetHeight() * dMultiplier);
+				}
+				else
+				{
+					szTarget.cx = pBadge->GetWidth();
+					szTarget.cy = pBadge->GetHeight();
+				}
 
 				POINT ptTarget = pDevMode->location.LocationForPage(bFirstPage, pso->sizlBitmap, szTarget);
 				rectTarget.left = ptTarget.x;
@@ -1139,7 +1425,10 @@ BOOL APIENTRY OEMSendPage(SURFOBJ* pso)
 				rectTarget.right = rectTarget.left + szTarget.cx;
 				rectTarget.bottom = rectTarget.top + szTarget.cy;
 
-				DrawImage(pso, png, rectTarget);
+				if (bStream)
+					PrintImage(pdevobj, poempdev, stream, rectTarget);
+				else
+					DrawImage(pso, *pBadge, rectTarget);
 
 				// Make this a link:
 				switch (pDevMode->info.m_eLicense)
@@ -1182,6 +1471,8 @@ BOOL APIENTRY OEMStartDoc(SURFOBJ* pso, PWSTR pwszDocName,DWORD dwJobId)
 
     pdevobj = (PDEVOBJ)pso->dhpdev;
     poempdev = (POEMPDEV)pdevobj->pdevOEM;
+	poempdev->oStats.Reset();
+	HookTimer timer(poempdev->oStats, HookStats::ST_STARTDOC);
 
     //
     // turn around to call PS
@@ -1196,9 +1487,42 @@ BOOL APIENTRY OEMStartDoc(SURFOBJ* pso, PWSTR pwszDocName,DWORD dwJobId)
 	POEMDEV pDevMode = (POEMDEV)pdevobj->pOEMDM;
 	std::string sFilename = MakeAnsiString(pDevMode->cFilename);
 
-	poempdev->pLinks = NULL;
+	poempdev->oLinks.Clear();
+	poempdev->bProcSet = false;
+
+	// Record the job's calls if so set (to replay them outside the spooler)
+	if (poempdev->pTrace != NULL)
+	{
+		delete poempdev->pTrace;
+		poempdev->pTrace = NULL;
+	}
+	std::tstring sTracePath = CCPrintRegistry::GetRegistryString(pdevobj->hPrinter, SETTINGS_TRACEPATH, _T(""));
+	if (!sTracePath.empty())
+	{
+		poempdev->pTrace = new TraceWriter;
+		if (!poempdev->pTrace->Open(sTracePath.c_str(), dwJobId))
+		{
+			delete poempdev->pTrace;
+			poempdev->pTrace = NULL;
+		}
+	}
 	if (poempdev->pTranslator == NULL)
 		poempdev->pTranslator = new GlyphTranslator;
+
+	// Start building the glyph tables of the last job's fonts and the usual ones, so the first page doesn't wait for them
+	// (only for actual jobs, not the information devices, and only if no other job is doing it)
+	if (poempdev->pPrewarmer == NULL)
+	{
+		std::tstring sFonts = CCPrintRegistry::GetRegistryString(pdevobj->hPrinter, SETTINGS_RECENTFONTS, _T(""));
+		sFonts += ';';
+		sFonts += CCPrintRegistry::GetRegistryString(pdevobj->hPrinter, SETTINGS_PREWARMFONTS, PREWARM_DEFAULT_FONTS);
+		poempdev->pPrewarmer = new GlyphPrewarmer;
+		if (!poempdev->pPrewarmer->Start(sFonts))
+		{
+			delete poempdev->pPrewarmer;
+			poempdev->pPrewarmer = NULL;
+		}
+	}
 	poempdev->bNeedText = pDevMode->bAutoURLs ? true : false;
 
 	// Check registry for data file for this print job
@@ -1219,6 +1543,13 @@ BOOL APIENTRY OEMStartDoc(SURFOBJ* pso, PWSTR pwszDocName,DWORD dwJobId)
 		}
 	}
 
+	// Find URLs in the background?
+	if (pDevMode->bAutoURLs && poempdev->bDeferLinks && (poempdev->pLinkWorker == NULL))
+	{
+		poempdev->pLinkWorker = new LinkWorker(poempdev->uURLFlags);
+		poempdev->pLinkWorker->Start();
+	}
+
 	// Do we know the filename we will use?
 	if (!sFilename.empty())
 	{
@@ -1228,6 +1559,7 @@ BOOL APIENTRY OEMStartDoc(SURFOBJ* pso, PWSTR pwszDocName,DWORD dwJobId)
 		std::tstring::size_type dwLen = sFilename.size();
 
 		poempdev->pOEMHelp->DrvWriteSpoolBuf(pdevobj, (LPVOID)sFilename.c_str(), (DWORD)dwLen, &dwResult);
+		poempdev->oStats.Add(HookStats::SC_SPOOLBYTES, dwResult);
 		if (dwResult != dwLen)
 			return FALSE;
 
@@ -1240,6 +1572,7 @@ BOOL APIENTRY OEMStartDoc(SURFOBJ* pso, PWSTR pwszDocName,DWORD dwJobId)
 				sFilename = "%%FileAutoOpen\r\n";
 			dwLen = (DWORD) sFilename.size();
 			poempdev->pOEMHelp->DrvWriteSpoolBuf(pdevobj, (LPVOID)sFilename.c_str(), (DWORD)dwLen, &dwResult);
+			poempdev->oStats.Add(HookStats::SC_SPOOLBYTES, dwResult);
 			if (dwResult != dwLen)
 				return FALSE;
 
@@ -1266,13 +1599,60 @@ BOOL APIENTRY OEMEndDoc(SURFOBJ* pso, FLONG fl)
     pdevobj = (PDEVOBJ)pso->dhpdev;
     poempdev = (POEMPDEV)pdevobj->pdevOEM;
 	POEMDEV pDevMode = (POEMDEV)pdevobj->pOEMDM;
+	LARGE_INTEGER liStart, liEnd, liNestedStart;
+	// Time spent in other hooks called from here (counted by them, so not by this call)
+	LONGLONG nNestedTicks = 0;
+	::QueryPerformanceCounter(&liStart);
 
 	// Clean up the translator
 	if (poempdev->pTranslator != NULL)
 	{
+		VERBOSE(DLLTEXT("Glyph cache: %d hits, %d misses, %d fonts, %d bytes\r\n"), GlyphCache::Instance().GetHits(), GlyphCache::Instance().GetMisses(), (int)GlyphCache::Instance().GetEntryCount(), (int)GlyphCache::Instance().GetSize());
+		// Keep the new tables for the next processes
+		GlyphCache::Instance().Save();
+		// And have this job's fonts ready for the next job
+		if (poempdev->pTranslator->GetFontCount() > 0)
+		{
+			std::tstring sFonts = GlyphPrewarmer::FormatFonts(*poempdev->pTranslator);
+			if (sFonts != CCPrintRegistry::GetRegistryString(pdevobj->hPrinter, SETTINGS_RECENTFONTS, _T("")))
+				CCPrintRegistry::SetRegistryString(pdevobj->hPrinter, SETTINGS_RECENTFONTS, sFonts);
+		}
 		delete poempdev->pTranslator;
 		poempdev->pTranslator = NULL;
 	}
+	// Done preparing fonts (let the next job start)
+	if (poempdev->pPrewarmer != NULL)
+	{
+		delete poempdev->pPrewarmer;
+		poempdev->pPrewarmer = NULL;
+	}
+	// Write the links found in the background, each into its page
+	if (poempdev->pLinkWorker != NULL)
+	{
+		// (the worker thread has ended once Finish returns, so its results and the statistics are ours alone)
+		const LinkWorker::ANNOTATIONS& annotations = poempdev->pLinkWorker->Finish();
+		poempdev->oStats.Add(HookStats::SC_LINKMATCHES, annotations.size());
+		if ((fl != ED_ABORTDOC) && !annotations.empty())
+		{
+			// The link boxes are in page coordinates, so use each page's coordinate system (the links are in page order)
+			UINT nMatrixPage = 0;
+			for (LinkWorker::ANNOTATIONS::const_iterator i = annotations.begin(); i != annotations.end(); i++)
+			{
+				if ((*i).nPage != nMatrixPage)
+				{
+					if (nMatrixPage != 0)
+						poempdev->oPS.Add(LINKMATRIX_END);
+					nMatrixPage = (*i).nPage;
+					poempdev->oPS.Add("\ngsave ").AddNumber((long)nMatrixPage).AddOp("cc_usematrix").Add("\n");
+				}
+				AddURLLink(poempdev, (*i).sURL.c_str(), (*i).rcArea, NULL, (*i).nPage);
+			}
+			poempdev->oPS.Add(LINKMATRIX_END);
+			FlushPS(pdevobj, poempdev);
+		}
+		delete poempdev->pLinkWorker;
+		poempdev->pLinkWorker = NULL;
+	}
 	// Clean up the link data file (only if actually printed: the printer driver is called for setting up stuff before the actual printing)
 	if (poempdev->bUsedPrintData)
 	{
@@ -1287,14 +1667,31 @@ BOOL APIENTRY OEMEndDoc(SURFOBJ* pso, FLONG fl)
 			case LicenseInfo::LTSampling:
 			case LicenseInfo::LTDevelopingNations:
 				// Add another page:
+				::QueryPerformanceCounter(&liNestedStart);
 				if (!OEMStartPage(pso))
 					return FALSE;
+				::QueryPerformanceCounter(&liEnd);
+				nNestedTicks += liEnd.QuadPart - liNestedStart.QuadPart;
 				if (!DoLicensePage(pso))
 					return FALSE;
 				break;
 		}
 	}
 
+	// Write the job's statistics for the converter (or any other collector); this call is timed up to here
+	::QueryPerformanceCounter(&liEnd);
+	poempdev->oStats.AddCall(HookStats::ST_ENDDOC, liEnd.QuadPart - liStart.QuadPart - nNestedTicks);
+	poempdev->oPS.Add(poempdev->oStats.Format());
+	FlushPS(pdevobj, poempdev);
+
+	// Done recording
+	if (poempdev->pTrace != NULL)
+	{
+		poempdev->pTrace->EndDoc(fl);
+		delete poempdev->pTrace;
+		poempdev->pTrace = NULL;
+	}
+
     //
     // turn around to call PS
     //
@@ -1325,6 +1722,7 @@ ULONG APIENTRY OEMEscape(SURFOBJ* pso, ULONG iEsc, ULONG cjIn, PVOID pvIn, ULONG
 	// Initialize stuff
 	pdevobj = (PDEVOBJ)pso->dhpdev;
 	poempdev = (POEMPDEV)pdevobj->pdevOEM;
+	HookTimer timer(poempdev->oStats, HookStats::ST_ESCAPE);
 
 	// Is this a code-support query?
 	if ((iEsc == QUERYESCSUPPORT) && (cjIn == 4))
@@ -1334,6 +1732,7 @@ ULONG APIENTRY OEMEscape(SURFOBJ* pso, ULONG iEsc, ULONG cjIn, PVOID pvIn, ULONG
 		switch (*pQuery)
 		{
 			case ESCAPE_LINK_DATA:
+			case ESCAPE_LINK_DATA_BATCH:
 			case ESCAPE_DISABLE_AUTO_URL:
 				// We support those (see oemps.h)
 				return TRUE;
@@ -1351,17 +1750,20 @@ ULONG APIENTRY OEMEscape(SURFOBJ* pso, ULONG iEsc, ULONG cjIn, PVOID pvIn, ULONG
 		}
 #endif
 
+		// Record our escapes
+		if ((poempdev->pTrace != NULL) && ((iEsc == ESCAPE_LINK_DATA) || (iEsc == ESCAPE_LINK_DATA_BATCH) || (iEsc == ESCAPE_DISABLE_AUTO_URL)))
+			poempdev->pTrace->Escape(iEsc, pvIn, cjIn);
+
 		// Check out what code is this escape
 		switch (iEsc)
 		{
 			case ESCAPE_LINK_DATA:
 				// A link escape
 				VERBOSE(DLLTEXT("OEMEscape: size(%d,%d), logpixel(%d)\r\n"), pso->sizlBitmap.cx, pso->sizlBitmap.cy, pdevobj->pPublicDM->dmLogPixels);
-				if (cjIn < sizeof(EscapeLinkData))
-					return FALSE;
-				// Do something:
-				poempdev->pLinks = new InnerEscapeLinkData((const char*)pvIn, cjIn, poempdev->pLinks);
-				return TRUE;
+				return AddEscapeLink(poempdev, pvIn, cjIn) ? TRUE : FALSE;
+			case ESCAPE_LINK_DATA_BATCH:
+				// Many links in one escape
+				return AddEscapeLinkBatch(poempdev, pvIn, cjIn) ? TRUE : FALSE;
 			case ESCAPE_DISABLE_AUTO_URL:
 				// A disable-auto-URL-linking escape
 				poempdev->bNeedText = false;
@@ -1397,9 +1799,13 @@ BOOL APIENTRY OEMTextOut(SURFOBJ *pso, STROBJ *pstro, FONTOBJ *pfo, CLIPOBJ *pco
 	// Initialize stuff
 	pdevobj = (PDEVOBJ)pso->dhpdev;
 	poempdev = (POEMPDEV)pdevobj->pdevOEM;
+	HookTimer timer(poempdev->oStats, HookStats::ST_TEXTOUT);
+	poempdev->oStats.Add(HookStats::SC_TEXTOUT);
 
 	// Do we need to save the text location for later?
-	if (poempdev->bNeedText && ((pstro->cGlyphs > 0) && (pstro->pwszOrg != NULL)))
+	bool bMatchText = !poempdev->oMatcher.IsEmpty();
+	bool bTrace = poempdev->pTrace != NULL;
+	if ((poempdev->bNeedText || bMatchText || bTrace) && ((pstro->cGlyphs > 0) && (pstro->pwszOrg != NULL)))
 	{
 		// Yes...
 		PGLYPHPOS pGlyphPos;
@@ -1415,7 +1821,7 @@ BOOL APIENTRY OEMTextOut(SURFOBJ *pso, STROBJ *pstro, FONTOBJ *pfo, CLIPOBJ *pco
 
 			if ((bRet != DDI_ERROR) && (uCount == pstro->cGlyphs))
 			{
-				pWidths = new POINTQF[uCount];
+				pWidths = (POINTQF*)poempdev->oScratch.Alloc(uCount * sizeof(POINTQF));
 				if (STROBJ_bGetAdvanceWidths(pstro, 0, uCount, pWidths))
 					bValid = true;
 			}
@@ -1426,7 +1832,7 @@ BOOL APIENTRY OEMTextOut(SURFOBJ *pso, STROBJ *pstro, FONTOBJ *pfo, CLIPOBJ *pco
 		if (bValid)
 		{
 			// OK, we can go on and read the actual text now
-			std::wstring sText;
+			const WCHAR* pText = NULL;
 			if ((pstro->flAccel & SO_GLYPHINDEX_TEXTOUT) != 0)
 			{
 				// Those are glyphs, not an actual string, so we need to translate them:
@@ -1463,55 +1869,61 @@ BOOL APIENTRY OEMTextOut(SURFOBJ *pso, STROBJ *pstro, FONTOBJ *pfo, CLIPOBJ *pco
 					lfFont.lfQuality = DEFAULT_QUALITY;
 					lfFont.lfPitchAndFamily = pifi->jWinPitchAndFamily;
 					wcsncpy_s(lfFont.lfFaceName, _S(lfFont.lfFaceName), (TCHAR*)(((char*)pifi) + (DWORD)pifi->dpwszFamilyName), LF_FACESIZE);
+					if (bTrace)
+						poempdev->pTrace->Font(lfFont);
 
 					// Get the glyph map
 					pGlyphMap = (poempdev->pTranslator == NULL) ? NULL : poempdev->pTranslator->GetFontTranslation(lfFont);
 					if (pGlyphMap != NULL)
 					{
-						// Found it
-						GlyphToText::const_iterator iChar;
-						for (unsigned int i=0;i<pstro->cGlyphs;i++)
-						{
-							// Map each glyph into a character
-							iChar = pGlyphMap->find(pstro->pwszOrg[i]);
-							if (iChar != pGlyphMap->end())
-								sText += (*iChar).second;
-							else
-								sText += (WCHAR)0x7F;
-						}
-						TRACE(DLLTEXT("%s\r\n"), sText.c_str());
+						// Found it, map all the glyphs into characters
+						WCHAR* pBuffer = (WCHAR*)poempdev->oScratch.Alloc((pstro->cGlyphs + 1) * sizeof(WCHAR));
+						pGlyphMap->Translate(pstro->pwszOrg, pstro->cGlyphs, pBuffer);
+						pBuffer[pstro->cGlyphs] = '\0';
+						pText = pBuffer;
+						TRACE(DLLTEXT("%s\r\n"), pText);
 					}
 				}
-				if (sText.empty())
+				if (pText == NULL)
 				{
 					TRACE(DLLTEXT("Could not unglyph it...\r\n"));
+					poempdev->oStats.Add(HookStats::SC_GLYPHMISSES);
 				}
 			}
 			else
 			{
-				// This is just a string, use it
-				sText.assign(pstro->pwszOrg, pstro->cGlyphs);
+				// This is just a string, use it as it is
+				pText = pstro->pwszOrg;
 				TRACE(DLLTEXT("Got the following text:\r\n"));
 			}
 
-			if (!sText.empty())
+			if (bTrace)
+				poempdev->pTrace->Text(pstro, (pstro->ulCharInc == 0) ? pGlyphPos : NULL, pWidths, pText);
+
+			if (pText != NULL)
 			{
 				// OK we have data
-				TRACE(DLLTEXT("%s [at %d,%d-%d,%d]\r\n"), sText.c_str(), pstro->rclBkGround.left, pstro->rclBkGround.top, pstro->rclBkGround.right, pstro->rclBkGround.bottom);
+				poempdev->oStats.Add(HookStats::SC_GLYPHS, pstro->cGlyphs);
+				TRACE(DLLTEXT("%.*s [at %d,%d-%d,%d]\r\n"), pstro->cGlyphs, pText, pstro->rclBkGround.left, pstro->rclBkGround.top, pstro->rclBkGround.right, pstro->rclBkGround.bottom);
 		
-				// Add to the parts
+				// Add to the parts, and/or search it for links
 				if (pstro->ulCharInc == 0)
 				{
 					// Use variable locations
 					ASSERT(pWidths != NULL);
-					poempdev->oText.AddLine(TextLine(sText, pstro->rclBkGround, pGlyphPos, pWidths));
-					delete [] pWidths;
+					if (poempdev->bNeedText)
+						poempdev->oText.AddRun(pText, pstro->cGlyphs, pstro->rclBkGround, pGlyphPos, pWidths);
+					if (bMatchText)
+						poempdev->oMatcher.Feed(pText, pstro->cGlyphs, pstro->rclBkGround, pGlyphPos, pWidths);
 				}
 				else
 				{
 					// Fixed font
 					ASSERT(pWidths == NULL);
-					poempdev->oText.AddLine(TextLine(sText, pstro->rclBkGround, pstro->ulCharInc));
+					if (poempdev->bNeedText)
+						poempdev->oText.AddRun(pText, pstro->cGlyphs, pstro->rclBkGround, (int)pstro->ulCharInc);
+					if (bMatchText)
+						poempdev->oMatcher.Feed(pText, pstro->cGlyphs, pstro->rclBkGround, (int)pstro->ulCharInc);
 				}
 			}
 		}
@@ -28,6 +28,13 @@
 #include "debug.h"
 #include "oemps.h"
 #include "GlyphTranslator.h"
+#include "GlyphPrewarmer.h"
+#include "URLScanner.h"
+#include "LinkWorker.h"
+#include "TraceWriter.h"
+#include "PngImage.h"
+#include "CCPrintRegistry.h"
+#include "CCCommon.h"
 
 
 ////////////////////////////////////////////////////////
@@ -82,10 +89,28 @@ PDEVOEM APIENTRY OEMEnablePDEV(PDEVOBJ pdevobj, PWSTR pPrinterName, ULONG cPatte
     // Fill in OEMDEV as you need
     //
 	poempdev->nPage = 0;
-	poempdev->pLinks = NULL;
 	poempdev->pTranslator = NULL;
 	POEMDEV pDevMode = (POEMDEV)pdevobj->pOEMDM;
 	poempdev->bNeedText = pDevMode->bAutoURLs ? true : false;
+	poempdev->uURLFlags = 0;
+	poempdev->bDeferLinks = false;
+	poempdev->pLinkWorker = NULL;
+	poempdev->pTrace = NULL;
+	poempdev->bProcSet = false;
+	poempdev->nFontSize = 0;
+	poempdev->pBadge = NULL;
+	poempdev->uBadge = 0;
+	poempdev->pPrewarmer = NULL;
+
+	if (pDevMode->bAutoURLs)
+	{
+		// Optional detection types (registry only, no UI)
+		if (CCPrintRegistry::GetRegistryBool(pdevobj->hPrinter, SETTINGS_AUTOEMAILS, false))
+			poempdev->uURLFlags |= URLScanner::SCAN_EMAILS;
+		if (CCPrintRegistry::GetRegistryBool(pdevobj->hPrinter, SETTINGS_AUTODOMAINS, false))
+			poempdev->uURLFlags |= URLScanner::SCAN_DOMAINS;
+		poempdev->bDeferLinks = CCPrintRegistry::GetRegistryBool(pdevobj->hPrinter, SETTINGS_DEFERREDLINKS, false);
+	}
 
     //
     // Fill in OEMDEV
@@ -130,17 +155,31 @@ VOID APIENTRY OEMDisablePDEV(PDEVOBJ pdevobj)
     //
     assert(NULL != pdevobj->pdevOEM);
     POEMPDEV poempdev = (POEMPDEV)pdevobj->pdevOEM;
-	while (poempdev->pLinks != NULL)
-	{
-		InnerEscapeLinkData* pLink = poempdev->pLinks;
-		poempdev->pLinks = pLink->pNext;
-		delete pLink;
-	}
 	if (poempdev->pTranslator != NULL)
 	{
 		delete poempdev->pTranslator;
 		poempdev->pTranslator = NULL;
 	}
+	if (poempdev->pPrewarmer != NULL)
+	{
+		delete poempdev->pPrewarmer;
+		poempdev->pPrewarmer = NULL;
+	}
+	if (poempdev->pLinkWorker != NULL)
+	{
+		delete poempdev->pLinkWorker;
+		poempdev->pLinkWorker = NULL;
+	}
+	if (poempdev->pTrace != NULL)
+	{
+		delete poempdev->pTrace;
+		poempdev->pTrace = NULL;
+	}
+	if (poempdev->pBadge != NULL)
+	{
+		delete poempdev->pBadge;
+		poempdev->pBadge = NULL;
+	}
     delete pdevobj->pdevOEM;
 }
 
@@ -164,6 +203,25 @@ BOOL APIENTRY OEMResetPDEV(PDEVOBJ pdevobjOld, PDEVOBJ pdevobjNew)
 		poempdevNew->pTranslator = poempdevOld->pTranslator;
 		poempdevOld->pTranslator = NULL;
 	}
+	// The document goes on in the new device: keep its font preparation, pages' links, trace, statistics and procedures
+	if (poempdevNew->pPrewarmer == NULL)
+	{
+		poempdevNew->pPrewarmer = poempdevOld->pPrewarmer;
+		poempdevOld->pPrewarmer = NULL;
+	}
+	if (poempdevNew->pLinkWorker == NULL)
+	{
+		poempdevNew->pLinkWorker = poempdevOld->pLinkWorker;
+		poempdevOld->pLinkWorker = NULL;
+	}
+	if (poempdevNew->pTrace == NULL)
+	{
+		poempdevNew->pTrace = poempdevOld->pTrace;
+		poempdevOld->pTrace = NULL;
+	}
+	poempdevNew->oStats = poempdevOld->oStats;
+	poempdevNew->nPage = poempdevOld->nPage;
+	poempdevNew->bProcSet = poempdevOld->bProcSet;
 
     return TRUE;
 }
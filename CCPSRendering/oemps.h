@@ -33,6 +33,9 @@
 #include "DEVMODE.H"
 #include "CCPrintData.h"
 #include "TextPart.h"
+#include "LinkMatcher.h"
+#include "PSWriter.h"
+#include "HookStats.h"
 
 /**
 	Escape code for adding a link to the current page.
@@ -41,6 +44,11 @@
 #define ESCAPE_LINK_DATA		0x667711aa
 /// Escape code: disable Auto URL link (for this print job only)
 #define ESCAPE_DISABLE_AUTO_URL	0x667711ab
+/**
+	Escape code for adding many links to the current page in one call.
+	To use, send an \ref EscapeLinkBatch structure, followed by the link strings, as the data
+*/
+#define ESCAPE_LINK_DATA_BATCH	0x667711ac
 
 ////////////////////////////////////////////////////////
 //      OEM Defines
@@ -85,59 +93,148 @@ struct EscapeLinkData
 };
 
 /**
-    @brief Class holding a single link's data for writing into the page
+    @brief Structure holding a single link in a \ref EscapeLinkBatch
+*/
+struct EscapeLinkRecord
+{
+	/// The left border of the link
+	long left;
+	/// The top border of the link
+	long top;
+	/// The right border of the link
+	long right;
+	/// The bottom border of the link
+	long bottom;
+	/// Offset of the link's null-terminated URL from the start of the escape data
+	DWORD dwURLOffset;
+	/// Offset of the link's null-terminated tooltip from the start of the escape data (0 for no tooltip)
+	DWORD dwTitleOffset;
+};
+
+/**
+    @brief Structure holding many links for the current page (sent with \ref ESCAPE_LINK_DATA_BATCH)
+
+	The records are followed by the strings they point to; all sizes are fixed, so the same data works
+	for 32 and 64 bit applications.
+*/
+struct EscapeLinkBatch
+{
+	/// Number of links in the batch
+	DWORD dwCount;
+	/// The links (dwCount records)
+	EscapeLinkRecord records[1];
+};
+
+/**
+    @brief The links waiting to be written into the current page
+
+	All the links are kept in one array, and all their strings in one buffer, so adding a link doesn't allocate
+	once the page's capacity has been reached; the memory is kept for the next pages.
 */
-struct InnerEscapeLinkData
+class PageLinks
 {
+public:
 	/**
 		@brief Default constructor
 	*/
-	InnerEscapeLinkData() : pNext(NULL), pData(NULL) {};
+	PageLinks() {};
+
+protected:
+	/**
+		@brief A single link
+	*/
+	struct Link
+	{
+		/// Location of the link on the page
+		RECTL	rcArea;
+		/// Offset of the URL in the string buffer
+		size_t	nURL;
+		/// Offset of the tooltip in the string buffer (NONE for no tooltip)
+		size_t	nTitle;
+	};
+	/// No tooltip mark
+	static const size_t NONE = (size_t)-1;
+
+	// Members
+	/// The links
+	std::vector<Link>	m_arLinks;
+	/// The links' null-terminated strings
+	std::vector<char>	m_arStrings;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the number of links
+		@return The number of links
+	*/
+	size_t		size() const {return m_arLinks.size();};
+	/**
+		@brief Checks if there are any links
+		@return true if there are no links, false if there are
+	*/
+	bool		empty() const {return m_arLinks.empty();};
+	/**
+		@brief Returns a link's location
+		@param n Index of the link
+		@return The link's location on the page
+	*/
+	const RECTL& GetArea(size_t n) const {return m_arLinks[n].rcArea;};
+	/**
+		@brief Returns a link's URL
+		@param n Index of the link
+		@return The null-terminated URL (valid until a link is added)
+	*/
+	LPCSTR		GetURL(size_t n) const {return &m_arStrings[m_arLinks[n].nURL];};
+	/**
+		@brief Returns a link's tooltip
+		@param n Index of the link
+		@return The null-terminated tooltip (valid until a link is added), or NULL if the link has none
+	*/
+	LPCSTR		GetTitle(size_t n) const {return (m_arLinks[n].nTitle == NONE) ? NULL : &m_arStrings[m_arLinks[n].nTitle];};
+
+	// Methods
 	/**
-		@brief Constructor from escape sequence data
-		@param pInData Pointer to an EscapeLinkData structure
-		@param nSize Size of the structure (including the url part)
-		@param pInNext Pointer to the next link data object
+		@brief Makes room for more links
+		@param nLinks Number of links to be added
+		@param nStrings Total size of the strings to be added (including the terminating NULLs)
 	*/
-	InnerEscapeLinkData(const char* pInData, int nSize, InnerEscapeLinkData* pInNext) : pNext(pInNext) {pData = (EscapeLinkData*)new char[nSize]; memcpy(pData, pInData, nSize);};
+	void		Reserve(size_t nLinks, size_t nStrings) {m_arLinks.reserve(m_arLinks.size() + nLinks); m_arStrings.reserve(m_arStrings.size() + nStrings);};
 	/**
-		@brief Constructor from link-file data
-		@param rect Location of the link on the page
-		@param pURL URL of the link
-		@param pInNext Pointer to the next link data object
-		@param pTitle Tooltip for the link (future use only)
+		@brief Adds a link
+		@param rc Location of the link on the page
+		@param pURL The link's URL
+		@param nURLLen Length of the URL
+		@param pTitle The link's tooltip (NULL or empty for no tooltip)
+		@param nTitleLen Length of the tooltip
 	*/
-	InnerEscapeLinkData(const RECTL& rect, const char* pURL, InnerEscapeLinkData* pInNext, const char* pTitle = NULL) : pNext(pInNext)
+	void		Add(const RECTL& rc, const char* pURL, size_t nURLLen, const char* pTitle, size_t nTitleLen)
 	{
-		// Calculate the structure's size
-		size_t nSize = sizeof(EscapeLinkData) + strlen(pURL);
-		if ((pTitle != NULL) && (strlen(pTitle) > 0))
-			nSize += strlen(pTitle) + 1;
-
-		// Create structure
-		pData = (EscapeLinkData*)new char[nSize];
-		// Populate it
-		pData->left = rect.left;
-		pData->right = rect.right;
-		pData->top = rect.top;
-		pData->bottom = rect.bottom;
-		strcpy_s(pData->url, strlen(pURL)+1, pURL);
-		if (pTitle == NULL)
-			pData->lTitleOffset = 0;
-		else
-		{
-			pData->lTitleOffset = strlen(pURL) + 1;
-			strcpy_s(pData->url + pData->lTitleOffset, strlen(pTitle), pTitle);
-		}
+		Link link;
+		link.rcArea = rc;
+		link.nURL = AddString(pURL, nURLLen);
+		link.nTitle = ((pTitle == NULL) || (nTitleLen == 0)) ? NONE : AddString(pTitle, nTitleLen);
+		m_arLinks.push_back(link);
 	}
 	/**
-		@brief Destructor
+		@brief Adds a link
+		@param rc Location of the link on the page
+		@param sURL The link's URL
+		@param sTitle The link's tooltip (empty for no tooltip)
+	*/
+	void		Add(const RECTL& rc, const std::string& sURL, const std::string& sTitle = std::string()) {Add(rc, sURL.data(), sURL.size(), sTitle.data(), sTitle.size());};
+	/**
+		@brief Removes all the links (keeps the memory)
+	*/
+	void		Clear() {m_arLinks.clear(); m_arStrings.clear();};
+
+protected:
+	/**
+		@brief Adds a null-terminated string to the string buffer
+		@param pText The string
+		@param nLen Length of the string
+		@return Offset of the string in the buffer
 	*/
-	~InnerEscapeLinkData() {delete [] pData;};
-	/// Pointer to the next link data object
-	InnerEscapeLinkData* pNext;
-	/// Pointer to the link data
-	EscapeLinkData* pData;
+	size_t		AddString(const char* pText, size_t nLen) {size_t nPos = m_arStrings.size(); m_arStrings.insert(m_arStrings.end(), pText, pText + nLen); m_arStrings.push_back(0); return nPos;};
 };
 
 /// Internal printing data object
@@ -166,18 +263,46 @@ typedef struct _OEMPDEV {
 	UINT					nPage;
 	/// Runtime glyph translation
 	class GlyphTranslator*	pTranslator;
-	/// Internal runtime information structure
-	InnerEscapeLinkData*	pLinks;
+	/// Prepares the glyph tables of the likely fonts in the background (NULL if not running)
+	class GlyphPrewarmer*	pPrewarmer;
+	/// The links to write into the current page
+	PageLinks				oLinks;
 	/// Text keeping flag: set true to remember the printed text with its location
 	bool					bNeedText;
+	/// Optional link types to detect in the text (see URLScanner::Flags)
+	UINT					uURLFlags;
+	/// Set to true to detect the links on a background thread (written at the end of the document)
+	bool					bDeferLinks;
+	/// Background link detection (NULL if not used)
+	class LinkWorker*		pLinkWorker;
+	/// Trace of the print job's calls (NULL if not tracing)
+	class TraceWriter*		pTrace;
 	/// Set to true if loaded data from a link INI file
 	bool					bLoadedData;
 	/// Current page text data
 	TextArea				oText;
+	/// Scratch memory for text capture (advance widths and translated text), reset per page
+	PageArena				oScratch;
+	/// Searches the current page's text links while the text is printed
+	LinkMatcher				oMatcher;
+	/// The current page's text links (indexed by the matcher's link IDs; point into dataLinks, cleared before the page is released)
+	std::vector<const CCPrintData::LinkData*>	arTextLinks;
 	/// link INI file data
 	CCPrintData				dataLinks;
 	/// Actual printing flag: true if data was actually printed
 	bool					bUsedPrintData;
+	/// PostScript code waiting to be written into the spool file
+	PSWriter				oPS;
+	/// Set to true once the plugin's PostScript procedures were written into the document
+	bool					bProcSet;
+	/// Size of the font last selected by the plugin's PostScript code in this page (0 if none)
+	int						nFontSize;
+	/// The print job's counters and hook timers
+	HookStats				oStats;
+	/// The license image decoded and scaled to the device resolution, when it can't be written as PNG data (NULL until needed)
+	class PngImage*			pBadge;
+	/// Resource ID of the scaled license image
+	UINT					uBadge;
 
 } OEMPDEV, *POEMPDEV;
 
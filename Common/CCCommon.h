@@ -40,6 +40,12 @@
 #define SETTINGS_WRITEPROPERTIES	_T("WriteProperties")
 #define SETTINGS_LICENSELOCATION	_T("LicenseLocation")
 #define SETTINGS_AUTOURLS			_T("AutoURLs")
+#define SETTINGS_AUTOEMAILS			_T("AutoEmails")
+#define SETTINGS_AUTODOMAINS		_T("AutoDomains")
+#define SETTINGS_DEFERREDLINKS		_T("DeferredLinks")
+#define SETTINGS_TRACEPATH			_T("Trace Path")
+#define SETTINGS_PREWARMFONTS		_T("PrewarmFonts")
+#define SETTINGS_RECENTFONTS		_T("RecentFonts")
 #define SETTINGS_CREATEASTEMP		_T("CreateAsTemp")
 
 
@@ -32,6 +32,8 @@
 #include <time.h>
 
 // File format
+// Unicode builds write binary link files (see LinkFileFormat.h); files without the binary signature are
+// read as INI files:
 /*
 [Job]
 PageCount=<page_count> // not every page HAS to appear as a section!
@@ -170,11 +172,11 @@ void CCPrintData::LinkData::CleanText()
 	@param nNum The number of the link to read the data of
 	@return true if loaded successfully, false if failed
 */
-bool CCPrintData::LinkData::FromFile(const TCHARSTR2STR& data, int nNum)
+bool CCPrintData::LinkData::FromFile(const INIKEYLIST& data, int nNum)
 {
 	// Initialize variables
 	TCHAR cName[32];
-	TCHARSTR2STR::const_iterator iKey;
+	const INIKey* pKey;
 	sText = _T("");
 	sURL = _T("");
 	sTitle = _T("");
@@ -182,20 +184,20 @@ bool CCPrintData::LinkData::FromFile(const TCHARSTR2STR& data, int nNum)
 
 	// Could be an internal link
 	_stprintf_s(cName, _S(cName), DATAFILE_LINK_PAGE, nNum);
-	if ((iKey = data.find(cName)) != data.end())
+	if ((pKey = FileINI::FindKey(data, cName)) != NULL)
 	{
 		// Internal link, read X, Y and page
-		nPage = _ttoi((*iKey).second.c_str());
+		nPage = pKey->sValue.ToInt();
 		if (nPage < 1)
 			return false;
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_OFFSET_X, nNum);
-		if ((iKey = data.find(cName)) != data.end())
-			ptOffset.x = _ttoi((*iKey).second.c_str());
+		if ((pKey = FileINI::FindKey(data, cName)) != NULL)
+			ptOffset.x = pKey->sValue.ToInt();
 		else
 			ptOffset.x = 0;
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_OFFSET_Y, nNum);
-		if ((iKey = data.find(cName)) != data.end())
-			ptOffset.y = _ttoi((*iKey).second.c_str());
+		if ((pKey = FileINI::FindKey(data, cName)) != NULL)
+			ptOffset.y = pKey->sValue.ToInt();
 		else
 			ptOffset.y = 0;
 	}
@@ -203,26 +205,26 @@ bool CCPrintData::LinkData::FromFile(const TCHARSTR2STR& data, int nNum)
 	{
 		// External link, read URL
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_URL, nNum);
-		if ((iKey = data.find(cName)) == data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) == NULL)
 			return false;
 		// This is an external link (URL)
-		sURL = (*iKey).second;
+		sURL = pKey->sValue.ToString();
 	}
 
 	// Title (if we have one)
 	_stprintf_s(cName, _S(cName), DATAFILE_LINK_TITLE, nNum);
-	if ((iKey = data.find(cName)) != data.end())
-		sTitle = (*iKey).second;
+	if ((pKey = FileINI::FindKey(data, cName)) != NULL)
+		sTitle = pKey->sValue.ToString();
 
 	_stprintf_s(cName, _S(cName), DATAFILE_LINK_TEXT, nNum);
-	if ((iKey = data.find(cName)) != data.end())
+	if ((pKey = FileINI::FindKey(data, cName)) != NULL)
 	{
 		// Text-based link, read the text and repeat count
-		sText = (*iKey).second;
+		sText = pKey->sValue.ToString();
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_REPEAT, nNum);
-		if ((iKey = data.find(cName)) != data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) != NULL)
 		{
-			int nTemp = _ttoi((*iKey).second.c_str());
+			int nTemp = pKey->sValue.ToInt();
 			if (nTemp > 0)
 				nRepeat = nTemp;
 		}
@@ -231,21 +233,21 @@ bool CCPrintData::LinkData::FromFile(const TCHARSTR2STR& data, int nNum)
 	{
 		// Location-based link, read left, right, top, bottom
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_LOC_LEFT, nNum);
-		if ((iKey = data.find(cName)) == data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) == NULL)
 			return false;
-		rectLocation.left = _ttoi((*iKey).second.c_str());
+		rectLocation.left = pKey->sValue.ToInt();
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_LOC_RIGHT, nNum);
-		if ((iKey = data.find(cName)) == data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) == NULL)
 			return false;
-		rectLocation.right = _ttoi((*iKey).second.c_str());
+		rectLocation.right = pKey->sValue.ToInt();
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_LOC_TOP, nNum);
-		if ((iKey = data.find(cName)) == data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) == NULL)
 			return false;
-		rectLocation.top = _ttoi((*iKey).second.c_str());
+		rectLocation.top = pKey->sValue.ToInt();
 		_stprintf_s(cName, _S(cName), DATAFILE_LINK_LOC_BOTTOM, nNum);
-		if ((iKey = data.find(cName)) == data.end())
+		if ((pKey = FileINI::FindKey(data, cName)) == NULL)
 			return false;
-		rectLocation.bottom = _ttoi((*iKey).second.c_str());
+		rectLocation.bottom = pKey->sValue.ToInt();
 	}
 	return true;
 }
@@ -332,20 +334,20 @@ bool CCPrintData::PageData::FromFile(class FileINI& file, int nPage)
 {
 	// Variables
 	TCHAR cName[32];
-	TCHARSTR2STR data;
-	TCHARSTR2STR::const_iterator iKey;
+	INIKEYLIST data;
+	const INIKey* pKey;
 
 	// Clean this object
 	Clear();
 
 	// Get INI key/value pairs from the page's section
 	_stprintf_s(cName, _S(cName), DATAFILE_SECTION_PAGE, nPage);
-	if (!file.GetKeys(cName, data) || ((iKey = data.find(DATAFILE_LINK_COUNT)) == data.end()))
+	if (!file.GetKeys(cName, data) || ((pKey = FileINI::FindKey(data, DATAFILE_LINK_COUNT)) == NULL))
 		// None found, just go on
 		return true;
 
 	// Get the page link count
-	int nLinkCount = _ttoi((*iKey).second.c_str());
+	int nLinkCount = pKey->sValue.ToInt();
 	if (nLinkCount < 1)
 		// This shouldn't happen
 		return false;
@@ -359,10 +361,10 @@ bool CCPrintData::PageData::FromFile(class FileINI& file, int nPage)
 	}
 
 	// Get page width and height if we found them
-	if ((iKey = data.find(DATAFILE_PAGE_WIDTH)) != data.end())
-		szPage.cx = _ttoi((*iKey).second.c_str());
-	if ((iKey = data.find(DATAFILE_PAGE_HEIGHT)) != data.end())
-		szPage.cy = _ttoi((*iKey).second.c_str());
+	if ((pKey = FileINI::FindKey(data, DATAFILE_PAGE_WIDTH)) != NULL)
+		szPage.cx = pKey->sValue.ToInt();
+	if ((pKey = FileINI::FindKey(data, DATAFILE_PAGE_HEIGHT)) != NULL)
+		szPage.cy = pKey->sValue.ToInt();
 
 	return true;
 }
@@ -426,7 +428,7 @@ bool CCPrintData::UpdateProcessData(HANDLE hPrinter)
 		// Not found, cannot update if not found
 		return false;
 
-	// Write the data to it
+	// Write the data to it (WriteToFile reads whatever is still unread from it first)
 	return WriteToFile(sFilename.c_str());
 }
 
@@ -496,35 +498,87 @@ bool CCPrintData::LoadProcessData(HANDLE hPrinter)
 	@return true if read successfully, false if failed
 */
 bool CCPrintData::ReadFromFile(LPCTSTR lpFilename)
+{
+	// Let go of any file we read before
+	ReleaseFile();
+
+	bool bBinary = false;
+#ifdef _UNICODE
+	// Map the file
+	HANDLE hFile = ::CreateFile(lpFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	DWORD dwSize = ::GetFileSize(hFile, NULL);
+	const BYTE* pView = NULL;
+	if ((dwSize != INVALID_FILE_SIZE) && (dwSize >= sizeof(LinkFileHeader)))
+	{
+		HANDLE hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap != NULL)
+		{
+			pView = (const BYTE*)::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+			::CloseHandle(hMap);
+		}
+	}
+	::CloseHandle(hFile);
+
+	if (pView != NULL)
+	{
+		bBinary = AttachBinary(pView, dwSize);
+		if (!bBinary)
+			::UnmapViewOfFile(pView);
+	}
+#endif
+
+	// Not a binary link file, read it as an INI file
+	if (!bBinary && !ReadINI(lpFilename))
+		return false;
+
+	// Test runs rewrite the same file with the results, so don't keep it open
+	if (m_bTestPage)
+		LoadAll();
+	return true;
+}
+
+/**
+	@param lpFilename Path to file to read
+	@return true if read successfully, false if failed
+*/
+bool CCPrintData::ReadINI(LPCTSTR lpFilename)
 {
 	//	Read the file
-	FileINI file;
-	if (!file.LoadINIFile(lpFilename))
+	FileINI* pFile = new FileINI;
+	if (!pFile->LoadINIFile(lpFilename))
+	{
+		delete pFile;
 		return false;
+	}
 
-	TCHARSTR2STR data;
-	TCHARSTR2STR::const_iterator iKey;
+	INIKEYLIST data;
+	const INIKey* pKey;
 
-	// Get main section
-	file.GetKeys(DATAFILE_SECTION_MAIN, data);
-	if ((iKey = data.find(DATAFILE_PAGE_TEST)) != data.end())
+	// Get main section (this indexes all the sections)
+	pFile->GetKeys(DATAFILE_SECTION_MAIN, data);
+	if ((pKey = FileINI::FindKey(data, DATAFILE_PAGE_TEST)) != NULL)
 		// Get test page value
-		m_bTestPage = _ttoi((*iKey).second.c_str()) != 0;
+		m_bTestPage = pKey->sValue.ToInt() != 0;
 
 	// Get page count
-	iKey = data.find(DATAFILE_PAGE_COUNT);
-	if (iKey != data.end())
+	pKey = FileINI::FindKey(data, DATAFILE_PAGE_COUNT);
+	if (pKey != NULL)
 	{
-		int nCount = _ttoi((*iKey).second.c_str());
+		int nCount = pKey->sValue.ToInt();
 		if (nCount > 0)
 		{
-			// Set pages array and read datas data
+			// Set pages array; the pages are read when requested
 			m_pages.resize(nCount);
-			for (int nPage = 1; nPage <= nCount; nPage++)
-				m_pages[nPage-1].FromFile(file, nPage);
+			m_arLoaded.assign(nCount, false);
+			m_pINI = pFile;
+			return true;
 		}
 	}
 
+	// Nothing to read later
+	delete pFile;
 	return true;
 }
 
@@ -591,6 +645,8 @@ void CCPrintData::CleanData(HANDLE hPrinter, DWORD dwProcessID)
 */
 void CCPrintData::CleanSaved(HANDLE hPrinter)
 {
+	// The file can't be deleted while we hold it (pages not read yet are dropped with it)
+	ReleaseFile();
 	// Clean the data for this process
 	CleanData(hPrinter, GetCurrentProcessId());
 }
@@ -604,6 +660,9 @@ bool CCPrintData::SaveProcessData(HANDLE hPrinter)
 	// Get process ID
 	DWORD	dwProcessID = GetCurrentProcessId();
 
+	// Get all the data in memory before the old file goes away
+	LoadAll();
+
 	// Remove old data for this process, if any
 	CleanData(hPrinter, dwProcessID);
 
@@ -641,11 +700,28 @@ bool CCPrintData::SaveProcessData(HANDLE hPrinter)
 	return true;
 }
 
+/**
+	@param lpFilename Name of file to write to
+	@return true if successfully written, false if failed
+*/
+bool CCPrintData::WriteToFile(LPCTSTR lpFilename)
+{
+	// We may be writing over the file we read from, so read it all first
+	LoadAll();
+
+#ifdef _UNICODE
+	return WriteBinary(lpFilename);
+#else
+	// The binary format keeps UTF-16 strings, so ANSI builds stay with the INI format
+	return WriteINI(lpFilename);
+#endif
+}
+
 /**
 	@param lpFilename Name of write to write to
 	@return true if successfully write, false if failed
 */
-bool CCPrintData::WriteToFile(LPCTSTR lpFilename)
+bool CCPrintData::WriteINI(LPCTSTR lpFilename) const
 {
 	// Variables
 	std::tstring sData;
@@ -696,11 +772,230 @@ bool CCPrintData::WriteToFile(LPCTSTR lpFilename)
 	return true;
 }
 
+#ifdef _UNICODE
+/**
+	@param sPool The string pool to add to
+	@param s The string to add
+	@param[out] str Receives the location of the string in the pool
+*/
+static void AddPoolString(std::wstring& sPool, const std::wstring& s, LinkFileString& str)
+{
+	str.uOffset = (unsigned int)sPool.size();
+	str.uLength = (unsigned int)s.size();
+	sPool += s;
+}
+
+/**
+	@param lpFilename Name of file to write to
+	@return true if successfully written, false if failed
+*/
+bool CCPrintData::WriteBinary(LPCTSTR lpFilename) const
+{
+	// Build the page table, link records and string pool
+	LinkFileHeader header;
+	header.uMagic = LINKFILE_MAGIC;
+	header.uVersion = LINKFILE_VERSION;
+	header.uFlags = m_bTestPage ? LFF_TESTPAGE : 0;
+	header.uPageCount = (unsigned int)m_pages.size();
+
+	std::vector<LinkFilePage> arPages(m_pages.size());
+	std::vector<LinkFileLink> arLinks;
+	std::wstring sPool;
+	for (size_t iPage = 0; iPage < m_pages.size(); iPage++)
+	{
+		const PageData& page = m_pages[iPage];
+		LinkFilePage& entry = arPages[iPage];
+		entry.uFirstLink = (unsigned int)arLinks.size();
+		entry.uLinkCount = (unsigned int)page.size();
+		entry.nWidth = page.szPage.cx;
+		entry.nHeight = page.szPage.cy;
+		for (PageData::const_iterator i = page.begin(); i != page.end(); i++)
+		{
+			const LinkData& link = (*i);
+			LinkFileLink rec;
+			rec.rcLocation[0] = link.rectLocation.left;
+			rec.rcLocation[1] = link.rectLocation.top;
+			rec.rcLocation[2] = link.rectLocation.right;
+			rec.rcLocation[3] = link.rectLocation.bottom;
+			rec.nPage = link.nPage;
+			rec.nX = link.ptOffset.x;
+			rec.nY = link.ptOffset.y;
+			rec.nRepeat = link.nRepeat;
+			AddPoolString(sPool, link.sText, rec.sText);
+			AddPoolString(sPool, link.sURL, rec.sURL);
+			AddPoolString(sPool, link.sTitle, rec.sTitle);
+			arLinks.push_back(rec);
+		}
+	}
+	header.uLinkCount = (unsigned int)arLinks.size();
+	header.uStringChars = (unsigned int)sPool.size();
+
+	// Now write it all
+	FILE* pFile;
+	if (NULL != _tfopen_s(&pFile, lpFilename, _T("wb")))
+		return false;
+	bool bRet = (fwrite(&header, sizeof(header), 1, pFile) == 1)
+		&& (arPages.empty() || (fwrite(&arPages[0], sizeof(LinkFilePage), arPages.size(), pFile) == arPages.size()))
+		&& (arLinks.empty() || (fwrite(&arLinks[0], sizeof(LinkFileLink), arLinks.size(), pFile) == arLinks.size()))
+		&& (sPool.empty() || (fwrite(sPool.c_str(), sizeof(WCHAR), sPool.size(), pFile) == sPool.size()));
+	fclose(pFile);
+	return bRet;
+}
+
+/**
+	@param pView The mapped file
+	@param dwSize Size of the file
+	@return true if this is a binary link file and it's now used, false if not (and the view is not used)
+
+	Only the header is checked here: the pages are read (and checked) by LoadPage when requested.
+*/
+bool CCPrintData::AttachBinary(const BYTE* pView, DWORD dwSize)
+{
+	// Is this our format?
+	const LinkFileHeader* pHeader = (const LinkFileHeader*)pView;
+	if ((dwSize < sizeof(LinkFileHeader)) || (pHeader->uMagic != LINKFILE_MAGIC) || (pHeader->uVersion != LINKFILE_VERSION))
+		return false;
+
+	// Make sure all the parts fit in the file
+	unsigned __int64 uSize = sizeof(LinkFileHeader) + (unsigned __int64)pHeader->uPageCount * sizeof(LinkFilePage) + 
+		(unsigned __int64)pHeader->uLinkCount * sizeof(LinkFileLink) + (unsigned __int64)pHeader->uStringChars * sizeof(WCHAR);
+	if (uSize > dwSize)
+		return false;
+
+	// OK, set up the (still empty) pages
+	m_pages.clear();
+	m_pages.resize(pHeader->uPageCount);
+	m_arLoaded.assign(pHeader->uPageCount, false);
+	m_bTestPage = (pHeader->uFlags & LFF_TESTPAGE) != 0;
+	m_pView = pView;
+	return true;
+}
+
+/**
+	@param pPool The string pool
+	@param uPoolChars Size of the pool, in characters
+	@param str Location of the string in the pool
+	@param[out] s Receives the string
+	@return true if the string is inside the pool, false if not
+*/
+static bool GetPoolString(const WCHAR* pPool, unsigned int uPoolChars, const LinkFileString& str, std::wstring& s)
+{
+	if ((str.uOffset > uPoolChars) || (str.uLength > uPoolChars - str.uOffset))
+		return false;
+	s.assign(pPool + str.uOffset, str.uLength);
+	return true;
+}
+#endif
+
+/**
+	@param nIndex Index of the page to read (0-based)
+*/
+void CCPrintData::LoadPage(size_t nIndex) const
+{
+	m_arLoaded[nIndex] = true;
+	if (m_pINI != NULL)
+	{
+		// Read the page's section
+		m_pages[nIndex].FromFile(*m_pINI, (int)nIndex + 1);
+		return;
+	}
+
+#ifdef _UNICODE
+	// Find the parts of the file
+	const LinkFileHeader* pHeader = (const LinkFileHeader*)m_pView;
+	const LinkFilePage* pPages = (const LinkFilePage*)(pHeader + 1);
+	const LinkFileLink* pLinks = (const LinkFileLink*)(pPages + pHeader->uPageCount);
+	const WCHAR* pPool = (const WCHAR*)(pLinks + pHeader->uLinkCount);
+
+	// Get the page entry
+	const LinkFilePage& entry = pPages[nIndex];
+	PageData& page = m_pages[nIndex];
+	page.szPage.cx = entry.nWidth;
+	page.szPage.cy = entry.nHeight;
+	if ((entry.uFirstLink > pHeader->uLinkCount) || (entry.uLinkCount > pHeader->uLinkCount - entry.uFirstLink))
+		// Bad page entry, leave it empty
+		return;
+
+	// Read its links
+	for (unsigned int i = 0; i < entry.uLinkCount; i++)
+	{
+		const LinkFileLink& rec = pLinks[entry.uFirstLink + i];
+		page.push_back(LinkData());
+		LinkData& link = page.back();
+		if (!GetPoolString(pPool, pHeader->uStringChars, rec.sText, link.sText) || 
+			!GetPoolString(pPool, pHeader->uStringChars, rec.sURL, link.sURL) || 
+			!GetPoolString(pPool, pHeader->uStringChars, rec.sTitle, link.sTitle))
+		{
+			// Bad string, skip this link
+			page.pop_back();
+			continue;
+		}
+		link.rectLocation.left = rec.rcLocation[0];
+		link.rectLocation.top = rec.rcLocation[1];
+		link.rectLocation.right = rec.rcLocation[2];
+		link.rectLocation.bottom = rec.rcLocation[3];
+		link.nPage = rec.nPage;
+		link.ptOffset.x = rec.nX;
+		link.ptOffset.y = rec.nY;
+		link.nRepeat = rec.nRepeat;
+	}
+#endif
+}
+
+/**
+	
+*/
+void CCPrintData::LoadAll()
+{
+	if (m_arLoaded.empty())
+		return;
+
+	// Read the pages we still don't have, then let go of the file
+	for (size_t i = 0; i < m_pages.size(); i++)
+		if (!m_arLoaded[i])
+			LoadPage(i);
+	ReleaseFile();
+}
+
+/**
+	
+*/
+void CCPrintData::ReleaseFile()
+{
+	if (m_pView != NULL)
+	{
+		::UnmapViewOfFile(m_pView);
+		m_pView = NULL;
+	}
+	if (m_pINI != NULL)
+	{
+		delete m_pINI;
+		m_pINI = NULL;
+	}
+	m_arLoaded.clear();
+}
+
+/**
+	@param nPage The page to release (1-based)
+
+	Only pages that can be read again from the file are released; this does nothing if all the data is in memory.
+*/
+void CCPrintData::ReleasePage(int nPage)
+{
+	if ((nPage < 1) || (nPage > (int)m_pages.size()) || m_arLoaded.empty())
+		return;
+
+	m_pages[nPage - 1].Clear();
+	m_arLoaded[nPage - 1] = false;
+}
+
 /**
 	@param nPage The page to ensure exists
 */
 void CCPrintData::EnsurePage(int nPage)
 {
+	// Changing the data, so it can't stay in the file
+	LoadAll();
 	while ((int)m_pages.size() < nPage)
 		m_pages.push_back(PageData());
 }
@@ -755,6 +1050,7 @@ void CCPrintData::AddLink(const RECTL& rect, int nPage, int nDestPage, long lX,
 */
 void CCPrintData::Dump()
 {
+	LoadAll();
 	std::tstring sData;
 	TCHAR cName[64];
 	sData += DATAFILE_SECTION_MAIN_WRITE;
@@ -28,6 +28,7 @@
 #define _CCPRINTDATA_H_
 
 #include "FileINI.h"
+#include "LinkFileFormat.h"
 #include <vector>
 
 /**
@@ -39,7 +40,11 @@ public:
 	/**
 		@brief Default constructor
 	*/
-	CCPrintData() : m_bTestPage(false) {};
+	CCPrintData() : m_bTestPage(false), m_pView(NULL), m_pINI(NULL) {};
+	/**
+		@brief Destructor
+	*/
+	~CCPrintData() {ReleaseFile();};
 
 	// Helper structures
 	/**
@@ -100,7 +105,7 @@ public:
 		/// Write the data in an INI file format
 		bool			ToFile(std::tstring& sData, int nNum) const;
 		/// Read the data from a key/value set
-		bool			FromFile(const TCHARSTR2STR& data, int nNum);
+		bool			FromFile(const INIKEYLIST& data, int nNum);
 		/**
 			@brief Check if it is a location (vs. text-based) link
 			@return true if this is a location link, false for text links
@@ -151,12 +156,18 @@ public:
 
 protected:
 	// Data
-	/// Array of pages data
-	std::vector<PageData> m_pages;
+	/// Array of pages data (pages of a link file are read on first access)
+	mutable std::vector<PageData> m_pages;
 	/// Default (empty) page data
 	PageData m_dummy;
 	/// true if this is a test run (for finding Excel factors, for example)
 	bool	m_bTestPage;
+	/// Mapped binary link file (NULL if not reading from a binary file)
+	const BYTE*	m_pView;
+	/// INI link file (NULL if not reading from an INI file)
+	FileINI*	m_pINI;
+	/// Flags for the pages already read from the file (empty if all the data is in m_pages)
+	mutable std::vector<bool> m_arLoaded;
 
 public:
 	// Data Access
@@ -179,6 +190,8 @@ public:
 	{
 		if ((nPage < 1) || (nPage > (int)m_pages.size())) 
 			return m_dummy; 
+		if (!m_arLoaded.empty() && !m_arLoaded[nPage - 1])
+			LoadPage(nPage - 1);
 		return m_pages[nPage - 1];
 	};
 
@@ -207,6 +220,7 @@ public:
 	{
 		if ((nPage < 1) || (nPage > (int)m_pages.size())) 
 			return; 
+		LoadAll();
 		m_pages[nPage - 1].szPage = sz;
 	};
 
@@ -223,10 +237,12 @@ public:
 	// Methods
 	/// Clean the file data for this process and the registry keys; also remove
 	void	CleanSaved(HANDLE hPrinter);
+	/// Release the data of a page that is no longer needed (it's read again if requested)
+	void	ReleasePage(int nPage);
 	/**
 		@brief Clean this object
 	*/
-	void	CleanThis() {m_pages.clear(); m_bTestPage = false;};
+	void	CleanThis() {ReleaseFile(); m_pages.clear(); m_bTestPage = false;};
 
 #ifdef _DEBUG
 	/// Dump the object's data
@@ -242,11 +258,33 @@ protected:
 
 	/// Write the link data to a file
 	bool	WriteToFile(LPCTSTR lpFilename);
+	/// Write the link data to an INI file
+	bool	WriteINI(LPCTSTR lpFilename) const;
 	/// Read the link data from a file
 	bool	ReadFromFile(LPCTSTR lpFilename);
+	/// Read the link data from an INI file
+	bool	ReadINI(LPCTSTR lpFilename);
+#ifdef _UNICODE
+	/// Write the link data to a binary link file
+	bool	WriteBinary(LPCTSTR lpFilename) const;
+	/// Use a mapped binary link file
+	bool	AttachBinary(const BYTE* pView, DWORD dwSize);
+#endif
+	/// Read a page from the link file
+	void	LoadPage(size_t nIndex) const;
+	/// Read all the pages not read yet from the link file, and release it
+	void	LoadAll();
+	/// Release the link file
+	void	ReleaseFile();
 
 	/// Ensure we have enough pages to put data in the requested page
 	void	EnsurePage(int nPage);
+
+private:
+	/// Not copyable (may hold the link file)
+	CCPrintData(const CCPrintData&);
+	/// Not copyable (may hold the link file)
+	CCPrintData& operator=(const CCPrintData&);
 };
 
 #endif   //#define _CCPRINTDATA_H_
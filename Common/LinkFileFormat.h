@@ -0,0 +1,122 @@
+/**
+	@file
+	@brief Binary link file format, used to pass the link data from the add-ins to the driver
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ * 
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ * 
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the 
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ * 
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope 
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. * 
+ */
+
+#ifndef _LINKFILEFORMAT_H_
+#define _LINKFILEFORMAT_H_
+
+/**
+	The link file starts with a LinkFileHeader, followed by uPageCount LinkFilePage entries, then uLinkCount
+	LinkFileLink records (each page's links are consecutive), and then the string pool: uStringChars UTF-16
+	characters, which the records point into. All the parts have a fixed size, so the reader can find any
+	page's links without reading anything else. All the numbers are little endian.
+
+	Files that don't start with the signature are INI files (the older format, see CCPrintData.cpp).
+*/
+
+/// Link file signature ('CCLK')
+#define LINKFILE_MAGIC		0x4B4C4343
+/// Link file format version
+#define LINKFILE_VERSION	1
+
+/// LinkFileHeader flags: test run (see CCPrintData::IsTestPage)
+#define LFF_TESTPAGE		0x01
+
+#pragma pack(push, 4)
+
+/**
+    @brief Link file header
+*/
+struct LinkFileHeader
+{
+	/// LINKFILE_MAGIC
+	unsigned int	uMagic;
+	/// LINKFILE_VERSION
+	unsigned int	uVersion;
+	/// LFF_xxx flags
+	unsigned int	uFlags;
+	/// Number of pages
+	unsigned int	uPageCount;
+	/// Number of links (in all the pages)
+	unsigned int	uLinkCount;
+	/// Size of the string pool, in characters
+	unsigned int	uStringChars;
+};
+
+/**
+    @brief Page table entry
+*/
+struct LinkFilePage
+{
+	/// Index of the page's first link record
+	unsigned int	uFirstLink;
+	/// Number of links in the page
+	unsigned int	uLinkCount;
+	/// Page width (returned by test runs, 0 if not known)
+	int				nWidth;
+	/// Page height (returned by test runs, 0 if not known)
+	int				nHeight;
+};
+
+/**
+    @brief A string in the string pool
+*/
+struct LinkFileString
+{
+	/// Position of the first character in the pool
+	unsigned int	uOffset;
+	/// Length in characters (there's no terminator)
+	unsigned int	uLength;
+};
+
+/**
+    @brief Link record
+
+	Text links have a text; location links have an empty text and use the location. Internal links are
+	location links with a target page.
+*/
+struct LinkFileLink
+{
+	/// Link location (left, top, right, bottom; location links only)
+	int				rcLocation[4];
+	/// Target page (internal links, 0 for URL links)
+	int				nPage;
+	/// Target X offset (internal links)
+	int				nX;
+	/// Target Y offset (internal links)
+	int				nY;
+	/// Repeat count (text links)
+	int				nRepeat;
+	/// Text to find (text links)
+	LinkFileString	sText;
+	/// URL (external links)
+	LinkFileString	sURL;
+	/// Tooltip
+	LinkFileString	sTitle;
+};
+
+#pragma pack(pop)
+
+#endif   //#define _LINKFILEFORMAT_H_
@@ -25,12 +25,10 @@
  */
 
 #include "precomp.h"
-#include "FileIni.h"
+#include "FileINI.h"
 
 #include <vector>
 #include <tchar.h>
-#include <io.h>
-#include <fcntl.h>
 
 /// Array of integers
 typedef std::vector<int>		INTARRAY;
@@ -153,19 +151,57 @@ bool IsComment(const WCHAR* pStr, std::tstring::size_type nLen, bool bUnicode)
 	return bUnicode ? ((pStr[0] == '/') && (pStr[1] == '/')) : ((((char*)pStr)[0] == (char)'/') && (((char*)pStr)[1] == (char)'/'));
 }
 
+/**
+	@brief Checks if a position is at the end of the data (the end of the buffer, or a NULL terminator)
+	@param pLine Position to check
+	@param pEnd End of the buffer
+	@param bUnicode true if this is a Unicode text, false if it's ASCII
+	@return true if there's no more data, false if there is
+*/
+bool AtEnd(const WCHAR* pLine, const char* pEnd, bool bUnicode)
+{
+	if (bUnicode)
+		return ((const char*)(pLine + 1) > pEnd) || (*pLine == '\0');
+	return ((const char*)pLine >= pEnd) || (*(const char*)pLine == '\0');
+}
+
+/**
+	@brief Returns the length of the line (up to the end of line characters or the end of the data)
+	@param pLine Start of the line
+	@param pEnd End of the buffer
+	@param bUnicode true if this is a Unicode text, false if it's ASCII
+	@return Length of the line, in characters
+*/
+std::tstring::size_type LineLength(const WCHAR* pLine, const char* pEnd, bool bUnicode)
+{
+	if (bUnicode)
+	{
+		const WCHAR* p = pLine;
+		while (!AtEnd(p, pEnd, true) && (*p != '\r') && (*p != '\n'))
+			p++;
+		return p - pLine;
+	}
+
+	const char* p = (const char*)pLine;
+	while (!AtEnd((const WCHAR*)p, pEnd, false) && (*p != '\r') && (*p != '\n'))
+		p++;
+	return p - (const char*)pLine;
+}
+
 /**
 	@param pLine [in]Position to start searching from, [out]Start of next line
 	@param nLen Number of characters to jump over
+	@param pEnd End of the buffer
 	@param bUnicode true if this is a Unicode text, false if it's ASCII
 */
-void FindNextLine(const WCHAR*& pLine, std::tstring::size_type nLen, bool bUnicode)
+void FindNextLine(const WCHAR*& pLine, std::tstring::size_type nLen, const char* pEnd, bool bUnicode)
 {
 	// Is it unicode?
 	if (bUnicode)
 	{
 		// Yes, find the end of the line (or of the text
 		pLine += nLen;
-		while ((*pLine != '\0') && (wcschr(L"\r\n", *pLine) != NULL))
+		while (!AtEnd(pLine, pEnd, true) && ((*pLine == '\r') || (*pLine == '\n')))
 			pLine++;
 		return;
 	}
@@ -173,26 +209,105 @@ void FindNextLine(const WCHAR*& pLine, std::tstring::size_type nLen, bool bUnico
 	// ASCII, so use char:
 	const char* pNext = (const char*)pLine;
 	pNext += nLen;
-	while ((*pNext != '\0') && (strchr("\r\n", *pNext) != NULL))
+	while (!AtEnd((const WCHAR*)pNext, pEnd, false) && ((*pNext == '\r') || (*pNext == '\n')))
 		pNext++;
 	// OK, convert back to the common pointer
 	pLine = (const WCHAR*)pNext;
 }
 
+/**
+	@brief Trims leading and trailing whitespace, tab, newline, or carriage-return characters off a string
+	@param[in, out] str The string to trim
+*/
+void TrimString(INIString& str)
+{
+	if (str.bUnicode)
+	{
+		const WCHAR* p = (const WCHAR*)str.pData;
+		while ((str.nLength > 0) && (wcschr(L" \t\n\r", *p) != NULL))
+		{
+			p++;
+			str.nLength--;
+		}
+		while ((str.nLength > 0) && (wcschr(L" \t\n\r", p[str.nLength-1]) != NULL))
+			str.nLength--;
+		str.pData = p;
+		return;
+	}
+
+	const char* p = (const char*)str.pData;
+	while ((str.nLength > 0) && (strchr(" \t\n\r", *p) != NULL))
+	{
+		p++;
+		str.nLength--;
+	}
+	while ((str.nLength > 0) && (strchr(" \t\n\r", p[str.nLength-1]) != NULL))
+		str.nLength--;
+	str.pData = p;
+}
 
+/**
+	@return A copy of the string
+*/
+std::tstring INIString::ToString() const
+{
+	if (bUnicode)
+		return MakeTString(std::wstring((const WCHAR*)pData, nLength));
+	return MakeTString(std::string((const char*)pData, nLength));
+}
+
+/**
+	@param lpString The string to compare to
+	@return true if the strings are the same, false if not
+*/
+bool INIString::Equals(LPCTSTR lpString) const
+{
+	// Compare the characters directly as long as they're ASCII
+	for (size_t i = 0; i < nLength; i++)
+	{
+		unsigned int c = At(i);
+		if (lpString[i] == '\0')
+			return false;
+		if ((c >= 0x80) || ((unsigned int)(std::tstring::traits_type::to_int_type(lpString[i])) >= 0x80))
+			// Let the conversion handle these
+			return ToString() == lpString;
+		if (c != (unsigned int)lpString[i])
+			return false;
+	}
+	return lpString[nLength] == '\0';
+}
+
+/**
+	@return The value of the number at the start of the string (0 if there's none)
+*/
+int INIString::ToInt() const
+{
+	// Skip whitespace, then read the sign and digits
+	size_t i = 0;
+	while ((i < nLength) && ((At(i) == ' ') || (At(i) == '\t')))
+		i++;
+	bool bNegative = false;
+	if ((i < nLength) && ((At(i) == '-') || (At(i) == '+')))
+		bNegative = At(i++) == '-';
+	int nRet = 0;
+	for (; (i < nLength) && (At(i) >= '0') && (At(i) <= '9'); i++)
+		nRet = nRet * 10 + (int)(At(i) - '0');
+	return bNegative ? -nRet : nRet;
+}
 
 /**
 	@param pData Pointer to a data buffer
 	@param dwSize Size of the data buffer
 	@param bOwn true if the buffer should be released by this object, false if not
 */
-FileINI::FileINI(char* pData, DWORD dwSize, bool bOwn /* = true */) : m_bUnicode(false), m_nOffset(0)
+FileINI::FileINI(char* pData, DWORD dwSize, bool bOwn /* = true */) : m_dwSize(dwSize), m_pView(NULL), m_bUnicode(false), m_nOffset(0), m_bIndexed(false)
 {
 	// Do we have any data?
 	if (pData == NULL)
 	{
 		// Nope, just leave it
 		m_pData = NULL;
+		m_dwSize = 0;
 		m_bOwn = false;
 		return;
 	}
@@ -218,7 +333,8 @@ FileINI::FileINI(char* pData, DWORD dwSize, bool bOwn /* = true */) : m_bUnicode
 	// Remember if it's unicode
 	m_bUnicode = TestUnicode();
 	if (m_bUnicode)
-		m_nOffset = 2;
+		// Skip the byte order mark
+		m_nOffset = sizeof(WCHAR);
 }
 
 /**
@@ -227,11 +343,12 @@ FileINI::FileINI(char* pData, DWORD dwSize, bool bOwn /* = true */) : m_bUnicode
 	@param dwSize The length of the data
 	@param bOwn true if the buffer should be released by this object, false if not
 */
-FileINI::FileINI(bool bUnicode, char* pData, DWORD dwSize, bool bOwn /* = true */) : m_bUnicode(bUnicode), m_nOffset(0)
+FileINI::FileINI(bool bUnicode, char* pData, DWORD dwSize, bool bOwn /* = true */) : m_dwSize(dwSize), m_pView(NULL), m_bUnicode(bUnicode), m_nOffset(0), m_bIndexed(false)
 {
 	if (pData == NULL)
 	{
 		m_pData = NULL;
+		m_dwSize = 0;
 		m_bOwn = false;
 		return;
 	}
@@ -261,7 +378,7 @@ FileINI::FileINI(bool bUnicode, char* pData, DWORD dwSize, bool bOwn /* = true *
 /**
 	@param lpFilename Name of file to load
 */
-FileINI::FileINI(LPCTSTR lpFilename) : m_pData(NULL), m_bOwn(false), m_bUnicode(false), m_nOffset(0)
+FileINI::FileINI(LPCTSTR lpFilename) : m_pData(NULL), m_dwSize(0), m_pView(NULL), m_bOwn(false), m_bUnicode(false), m_nOffset(0), m_bIndexed(false)
 {
 	// Just load the file
 	LoadINIFile(lpFilename);
@@ -270,75 +387,73 @@ FileINI::FileINI(LPCTSTR lpFilename) : m_pData(NULL), m_bOwn(false), m_bUnicode(
 /**
 	@param lpFilename The file to load
 	@return true if loaded successfully, false if failed
+
+	The file is mapped and parsed in place, so it stays open (for reading) as long as the object holds it.
 */
 bool FileINI::LoadINIFile(LPCTSTR lpFilename)
 {
-	// Open the file for reading, in text mode
-	FILE* pFile;		
-	if (NULL != _tfopen_s(&pFile, lpFilename, _T("rt")))
+	// Open the file for reading
+	HANDLE hFile = ::CreateFile(lpFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
 		return false;
-
-	// Clean old data
-	if ((m_pData != NULL) && m_bOwn)
+	DWORD dwSize = ::GetFileSize(hFile, NULL);
+	if (dwSize == INVALID_FILE_SIZE)
 	{
-		delete [] m_pData;
-		m_pData = NULL;
+		::CloseHandle(hFile);
+		return false;
 	}
 
-	// Find the size of the file
-	fseek(pFile, 0, SEEK_END);
-	long lSize = ftell(pFile);
-	std::tstring::size_type lReadSize;
-	fseek(pFile, 0, SEEK_SET);
-
-	// Create buffer
-	m_pData = new char[(lSize + 1) * 2];
-	m_bOwn = true;
+	// Map it (empty files can't be mapped, but there's nothing to read anyway)
+	const void* pView = NULL;
+	if (dwSize > 0)
+	{
+		HANDLE hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap != NULL)
+		{
+			pView = ::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+			::CloseHandle(hMap);
+		}
+		if (pView == NULL)
+		{
+			::CloseHandle(hFile);
+			return false;
+		}
+	}
+	::CloseHandle(hFile);
 
-	// Read the file
-	lReadSize = fread(m_pData, 1, lSize, pFile);
-	fclose(pFile);
+	// Clean old data
+	Release();
 
-	// Terminate
-	m_pData[lReadSize] = (char)'\0';
-	m_pData[lReadSize+1] = (char)'\0';
+	// Use the view
+	static char cEmpty[2] = {'\0', '\0'};
+	m_pView = pView;
+	m_pData = (pView == NULL) ? cEmpty : (char*)pView;
+	m_dwSize = dwSize;
 
 	// Set up unicode (if it is unicode)
 	m_bUnicode = TestUnicode();
-	if (m_bUnicode)
-		m_nOffset = 2;
+	m_nOffset = m_bUnicode ? sizeof(WCHAR) : 0;
 
 	return true;
 }
 
 /**
-	@param pFile Pointer to file to test
-	@return true if the file is unicode
+	
 */
-bool FileINI::TestUnicode(FILE* pFile)
+void FileINI::Release()
 {
-	// Get the two characters here
-	char c[2];
-	long lSize = (long)fread(c, sizeof(char), 2, pFile);
-	// fread might return something bigger than long... but we use it in fseek, which won't accept something bigger than long...
-	if (lSize < 2)
-	{
-		if (lSize > 0)
-			fseek(pFile, -lSize, SEEK_CUR);
-		// Weren't found, isn't Unicode by default
-		return false;
-	}
-
-	// Are those the Unicode marker? (0xFFFE)
-	if ((c[0] == (char)0xFF) && (c[1] == (char)0xFE))
-	{
-		// Yes, read as binary from here on
-		_setmode(_fileno(pFile), _O_BINARY);
-		return true;
-	}
-	// OK, move back
-	fseek(pFile, -2, SEEK_CUR);
-	return false;
+	if (m_pView != NULL)
+		::UnmapViewOfFile(m_pView);
+	else if (m_bOwn && (m_pData != NULL))
+		delete [] m_pData;
+	m_pView = NULL;
+	m_pData = NULL;
+	m_dwSize = 0;
+	m_bOwn = false;
+
+	m_bIndexed = false;
+	m_arSections.clear();
+	m_mapSections.clear();
 }
 
 /**
@@ -346,7 +461,7 @@ bool FileINI::TestUnicode(FILE* pFile)
 */
 bool FileINI::TestUnicode()
 {
-	if (m_pData == NULL)
+	if ((m_pData == NULL) || (m_dwSize < 2))
 		return false;
 	return ((m_pData[0] == (char)0xFF) && (m_pData[1] == (char)0xFE));
 }
@@ -362,77 +477,11 @@ bool FileINI::TestUnicode()
 */
 bool FileINI::GetLines(LPCTSTR pFilename, LPCTSTR pSection, TCHARSTRLIST& listLines, UINT uFlags)
 {
-	// Open the file for reading, in text mode
-	FILE* pFile;
-	if (NULL != _tfopen_s(&pFile, pFilename, _T("rt")))
+	// Load the file and read from it
+	FileINI file;
+	if (!file.LoadINIFile(pFilename))
 		return false;
-
-	// Check Unicodeness
-	bool bUnicode = TestUnicode(pFile);
-
-	// Initialize variables
-	bool bFoundSection = false, bFoundSectionNow;
-	WCHAR c[MAX_PATH + 1];
-	std::tstring::size_type nLen, nSectionLen = _tcslen(pSection);
-
-	// Keep reading lines until the end of file is reached
-	while (!feof(pFile))
-	{
-		// Read the next line from the file
-		if (bUnicode)
-		{
-			// Get the next UNICODE string
-			if (fgetws(c, MAX_PATH, pFile) == NULL)
-				break;
-
-			// Get length
-			nLen = wcslen(c);
-		}
-		else
-		{
-			// Get the next ASCII string
-			if (fgets((char*)c, MAX_PATH, pFile) == NULL)
-				break;
-		
-			// Get length
-			nLen = strlen((char*)c);
-		}
-
-		// Trim it
-		TrimLen(c, nLen, (uFlags & FILEINI_TRIM) != 0, bUnicode);
-		// Skip empty lines
-		if (nLen < 1)
-			continue;
-
-		// Check if we are in the section; bFoundSection will be updated correctly
-		bFoundSectionNow = CheckLineForSection(c, nLen, pSection, nSectionLen, bUnicode, bFoundSection);
-		if (bFoundSection && !bFoundSectionNow)
-		{
-			// Ignore comments if so specified by the flags
-			if ((uFlags & FILEINI_IGNORE_COMMENTS) && IsComment(c, nLen, bUnicode))
-				continue;
-			if (uFlags & FILEINI_TRIM)
-			{
-				// Trim the line (and make it a tstring)
-				std::tstring s = Trim(c, nLen, bUnicode);
-				if (!s.empty())
-					// OK, add it
-					listLines.push_back(s);
-			}
-			else
-			{
-				// Translate the line to something we can use
-				if (bUnicode)
-					listLines.push_back(MakeTString(std::wstring(c, nLen)));
-				else
-					listLines.push_back(MakeTString(std::string((const char*)c, nLen)));
-			}
-		}
-	}
-
-	// Cleanup
-	fclose(pFile);
-	return true;
+	return file.GetLines(pSection, listLines, uFlags);
 }
 
 /**
@@ -446,136 +495,54 @@ bool FileINI::GetLines(LPCTSTR pFilename, LPCTSTR pSection, TCHARSTRLIST& listLi
 */
 bool FileINI::GetKeys(LPCTSTR pFilename, LPCTSTR pSection, INILINELIST& listLines, UINT uFlags)
 {
-	// Open the file for reading, in text mode
-	FILE* pFile;
-	if (NULL != _tfopen_s(&pFile, pFilename, _T("rt")))
+	// Load the file and read from it
+	FileINI file;
+	if (!file.LoadINIFile(pFilename))
 		return false;
-
-	// Check Unicodeness
-	bool bUnicode = TestUnicode(pFile);
-
-	// Initialize variables
-	bool bFoundSection = false, bFoundSectionNow;
-	WCHAR c[MAX_PATH+1];
-	std::tstring::size_type nLen, nSectionLen = _tcslen(pSection);
-
-	// Keep reading lines until the end of file is reached
-	while (!feof(pFile))
-	{
-		// Read the next line from the file
-		if (bUnicode)
-		{
-			// Get the next UNICODE string
-			if (fgetws(c, MAX_PATH, pFile) == NULL)
-				break;
-
-			// Get length
-			nLen = wcslen(c);
-		}
-		else
-		{
-			// Get the next ASCII string
-			if (fgets((char*)c, MAX_PATH, pFile) == NULL)
-				break;
-
-			// Get length
-			nLen = strlen((char*)c);
-		}
-
-		// Trim it
-		TrimLen(c, nLen, (uFlags & FILEINI_TRIM) != 0, bUnicode);
-		// And skip the empty lines
-		if (nLen < 1)
-			continue;
-
-		// Check if we are in the section; bFoundSection will be updated correctly
-		bFoundSectionNow = CheckLineForSection(c, nLen, pSection, nSectionLen, bUnicode, bFoundSection);
-		if (bFoundSection && !bFoundSectionNow)
-			// Add the values pair to the list
-			DoInitLine(c, nLen, listLines, uFlags, bUnicode);
-	}
-
-	// Finished
-	fclose(pFile);
-	return true;
-}
-
-/**
-	@param pLine The line of data
-	@param nLineLen Length of line (either chars or WCHARS according to the unicode flag)
-	@param pSection The section header to look for
-	@param nSectionLen Length of section header name
-	@param bUnicode true if the data is in Unicode, false if in ASCII
-	@param[out] bFoundSection Flag updated to indicate if the line is in the section
-	@return true if this line starts the section, false otherwise
-*/
-bool FileINI::CheckLineForSection(const WCHAR* pLine, std::tstring::size_type nLineLen, LPCTSTR pSection, std::tstring::size_type nSectionLen, bool bUnicode, bool& bFoundSection)
-{
-	// First make the line into something we can use
-	std::tstring sLine;
-	if (bUnicode)
-		sLine = MakeTString(std::wstring(pLine, nLineLen));
-	else
-		sLine = MakeTString(std::string((const char*)pLine, nLineLen));
-
-	// Is this a section header?
-	if ((sLine[0] != '[') || (sLine[nLineLen-1] != ']'))
-		// No, leave it as it is
-		return false;
-	// OK, this is a section header, check it
-	if (nLineLen != nSectionLen + 2)
-		bFoundSection = false;
-	else
-		bFoundSection = _tcsnicmp(pSection, sLine.c_str() + 1, nSectionLen) == 0;
-
-	// We return true only if this is the requested section
-	return bFoundSection;
+	return file.GetKeys(pSection, listLines, uFlags);
 }
 
 /**
 	@param pLine The line to parse
 	@param nLineLen Length of line (in chars or wide chars according to the bUnicode flag)
-	@param[out] listLines List of pairs to update
 	@param uFlags Parsing flags (combination of \ref FileINIFlags)
 	@param bUnicode true if the data is in Unicode, false if in ASCII
+	@param[out] key Receives the key and value (pointing into the line)
+	@return true if the line has a key, false if it should be skipped (a comment, when ignoring comments)
 */
-void FileINI::DoInitLine(const WCHAR* pLine, std::tstring::size_type nLineLen, INILINELIST& listLines, UINT uFlags, bool bUnicode)
+bool FileINI::SplitLine(const WCHAR* pLine, std::tstring::size_type nLineLen, UINT uFlags, bool bUnicode, INIKey& key)
 {
 	// Check comment if requested
 	if ((uFlags & FILEINI_IGNORE_COMMENTS) && IsComment(pLine, nLineLen, bUnicode))
-		return;
-
-	// Translate this string into something workable
-	std::tstring sLine;
-	if (bUnicode)
-		sLine = MakeTString(std::wstring(pLine, nLineLen));
-	else
-		sLine = MakeTString(std::string((const char*)pLine, nLineLen));
+		return false;
 
 	// Find the equal sign
-	std::tstring::size_type nPos = sLine.find('=');
-	std::tstring sBefore, sAfter;
-	if (nPos == std::tstring::npos)
+	std::tstring::size_type nPos = 0;
+	if (bUnicode)
 	{
-		// Not found, just a name
-		sBefore = sLine;
-		sAfter = _T("");
+		while ((nPos < nLineLen) && (pLine[nPos] != '='))
+			nPos++;
 	}
 	else
 	{
-		// OK, found a name and a value
-		sBefore = sLine.substr(0, nPos);
-		sAfter = sLine.substr(nPos + 1);
+		while ((nPos < nLineLen) && (((const char*)pLine)[nPos] != '='))
+			nPos++;
 	}
 
+	// Split the line there (no equal sign means it's just a name)
+	key.sKey = INIString(pLine, nPos, bUnicode);
+	if (nPos < nLineLen)
+		key.sValue = INIString(bUnicode ? (const void*)(pLine + nPos + 1) : (const void*)((const char*)pLine + nPos + 1), nLineLen - nPos - 1, bUnicode);
+	else
+		key.sValue = INIString(pLine, 0, bUnicode);
+
 	// Trim if flagged
 	if (uFlags & FILEINI_TRIM)
 	{
-		sBefore = Trim(sBefore);
-		sAfter = Trim(sAfter);
+		TrimString(key.sKey);
+		TrimString(key.sValue);
 	}
-	// Add the value pair
-	listLines.push_back(INILine(sBefore, sAfter));
+	return true;
 }
 
 /**
@@ -737,7 +704,9 @@ bool ReplaceVariables(LPCTSTR pValue, const TCHARSTR2STRLIST& lVariables, TCHARS
 */
 bool FileINI::ReplaceVariables(LPCTSTR pValue, const TCHARSTR2STRLIST& lVariables, TCHARSTRLIST& lResults)
 {
-	return ::ReplaceVariables(pValue, lVariables, lVariables.begin(), lResults);
+	// (the position is passed by reference, so it can't be a temporary)
+	TCHARSTR2STRLIST::const_iterator iPos = lVariables.begin();
+	return ::ReplaceVariables(pValue, lVariables, iPos, lResults);
 }
 
 /**
@@ -747,67 +716,11 @@ bool FileINI::ReplaceVariables(LPCTSTR pValue, const TCHARSTR2STRLIST& lVariable
 */
 bool FileINI::GetAllSections(LPCTSTR pFilename, TCHARSTRLIST& lSections)
 {
-	// Open the file for reading, in text mode
-	FILE* pFile;
-	if (NULL != _tfopen_s (&pFile, pFilename, _T("rt")))
+	// Load the file and read from it
+	FileINI file;
+	if (!file.LoadINIFile(pFilename))
 		return false;
-
-	// Check Unicodeness
-	bool bUnicode = TestUnicode(pFile);
-
-	// Initialize variables
-	WCHAR c[MAX_PATH+1];
-	std::tstring::size_type nLen;
-
-	// Keep reading lines until the end of file is reached
-	while (!feof(pFile))
-	{
-		// Read the next line from the file
-		if (bUnicode)
-		{
-			// Get the next UNICODE string
-			if (fgetws(c, MAX_PATH, pFile) == NULL)
-				break;
-			
-			// Get length
-			nLen = wcslen(c);
-		}
-		else
-		{
-			// Get the next ASCII string
-			if (fgets((char*)c, MAX_PATH, pFile) == NULL)
-				break;
-			
-			// Get length
-			nLen = strlen((char*)c);
-		}
-
-		// Trim it
-		TrimLen(c, nLen, true, bUnicode);
-
-		// Skip empties
-		if (nLen < 1)
-			continue;
-
-		if (bUnicode)
-		{
-			// Is this line is a section header?
-			if ((c[0] == '[') && (c[nLen-1] == ']'))
-				// Yep, add it
-				lSections.push_back(MakeTString(std::wstring(c+1, nLen-2)));
-		}
-		else
-		{
-			// Is this line is a section header?
-			if ((((char*)c)[0] == (char)'[') && (((char*)c)[nLen-1] == (char)']'))
-				// Yep, add it
-				lSections.push_back(MakeTString(std::string(((char*)c)+1, nLen-2)));
-		}
-	}
-
-	// Clean up
-	fclose(pFile);
-	return true;
+	return file.GetAllSections(lSections);
 }
 
 /**
@@ -816,46 +729,16 @@ bool FileINI::GetAllSections(LPCTSTR pFilename, TCHARSTRLIST& lSections)
 */
 bool FileINI::GetAllSections(TCHARSTRLIST& lSections)
 {
-	// Initialize variables
-	bool bFoundSection = false;
-	std::tstring::size_type nLen, nLineLen;
-	const WCHAR* pLine = (const WCHAR*)(m_pData + m_nOffset);
-	std::tstring s;
-
-	// Keep reading lines until the end of file is reached
-	do
-	{
-		// Find the length of the line
-		if (m_bUnicode)
-			nLen = wcscspn(pLine, L"\r\n");
-		else
-			nLen = strcspn((const char*)pLine, "\r\n");
-
-		// Do we have something here?
-		if (nLen > 0)
-		{
-			// Get the trimmed length
-			nLineLen = nLen;
-			TrimLen(pLine, nLineLen, true, m_bUnicode);
+	// Do we have any data?
+	if (m_pData == NULL)
+		return false;
 
-			if (nLineLen > 1)
-			{
-				// Check if this is a section header
-				if (m_bUnicode)
-				{
-					if ((pLine[0] == '[') && (pLine[nLen-1] == ']'))
-						lSections.push_back(MakeTString(std::wstring(pLine+1, nLen-2)));
-				}
-				else
-				{
-					if ((((char*)pLine)[0] == (char)'[') && (((char*)pLine)[nLen-1] == (char)']'))
-						lSections.push_back(MakeTString(std::string(((char*)pLine)+1, nLen-2)));
-				}
-			}
-		}
-		// Jump over empty lines
-		FindNextLine(pLine, nLen, m_bUnicode);
-	} while (m_bUnicode ? ((*pLine) != '\0') : ((*((const char*)pLine)) != (char)'\0'));
+	// The index has them all, in order (headers with trailing whitespace are not listed, as they're not
+	// always headers)
+	IndexSections();
+	for (std::vector<INISection>::const_iterator i = m_arSections.begin(); i != m_arSections.end(); i++)
+		if (!(*i).bSpaced)
+			lSections.push_back((*i).sName);
 
 	return true;
 }
@@ -868,14 +751,14 @@ bool FileINI::GetAllSections(TCHARSTRLIST& lSections)
 */
 bool FileINI::GetKeys(LPCTSTR pSection, TCHARSTR2STR& mapKeys, UINT uFlags)
 {
-	// First load the section pairs in the regular way
-	INILINELIST listLines;
-	if (!GetKeys(pSection, listLines, uFlags))
+	// First find the section pairs
+	INIKEYLIST listKeys;
+	if (!GetKeys(pSection, listKeys, uFlags))
 		return false;
 
 	// Now translate this into the map
-	for (INILINELIST::iterator i = listLines.begin(); i != listLines.end(); i++)
-		mapKeys[(*i).sKey] = (*i).sValue;
+	for (INIKEYLIST::const_iterator i = listKeys.begin(); i != listKeys.end(); i++)
+		mapKeys[(*i).sKey.ToString()] = (*i).sValue.ToString();
 
 	return true;
 }
@@ -887,49 +770,75 @@ bool FileINI::GetKeys(LPCTSTR pSection, TCHARSTR2STR& mapKeys, UINT uFlags)
 	@return true if successful, false if error
 */
 bool FileINI::GetKeys(LPCTSTR pSection, INILINELIST& listLines, UINT uFlags /* = 0 */)
+{
+	// First find the section pairs
+	INIKEYLIST listKeys;
+	if (!GetKeys(pSection, listKeys, uFlags))
+		return false;
+
+	// Now copy them
+	for (INIKEYLIST::const_iterator i = listKeys.begin(); i != listKeys.end(); i++)
+		listLines.push_back(INILine((*i).sKey.ToString(), (*i).sValue.ToString()));
+
+	return true;
+}
+
+/**
+	@param pSection The section header to look for
+	@param[out] listKeys Receives the keys and values found in the specified section of the INI file (added at the end)
+	@param uFlags Any combination of \ref FileINIFlags "FileINI Flags", which modify the behaviour of this method.
+	@return true if successful, false if error
+
+	The keys and values point into this object's buffer, so they are valid only as long as it holds the data.
+*/
+bool FileINI::GetKeys(LPCTSTR pSection, INIKEYLIST& listKeys, UINT uFlags /* = 0 */)
 {
 	// Do we have any data?
 	if (m_pData == NULL)
 		return false;
 
-	// Initialize
-	bool bFoundSection = false, bFoundSectionNow;
-	std::tstring::size_type nLen, nLineLen, nSectionLen = _tcslen(pSection);
-	const WCHAR* pLine = (const WCHAR*)(m_pData + m_nOffset);
-
-	do
+	// Go over the section's lines (it may appear more than once)
+	std::tstring::size_type nLen, nLineLen;
+	INIKey key;
+	bool bTrim = (uFlags & FILEINI_TRIM) != 0;
+	for (const INISection* pRange = FindSection(pSection, bTrim); pRange != NULL; pRange = NextSection(pRange, bTrim))
 	{
-		// Get the next line length
-		if (m_bUnicode)
-			nLen = wcscspn(pLine, L"\r\n");
-		else
-			nLen = strcspn((const char*)pLine, "\r\n");
-
-		// Do we have data?
-		if (nLen > 0)
+		const WCHAR* pLine = (const WCHAR*)(m_pData + pRange->nStart);
+		const WCHAR* pEnd = (const WCHAR*)(m_pData + GetSectionEnd(pRange, bTrim));
+		while (pLine < pEnd)
 		{
+			// Get the next line length
+			nLen = LineLength(pLine, GetEnd(), m_bUnicode);
+
 			// Trim line (keep length)
 			nLineLen = nLen;
 			TrimLen(pLine, nLineLen, (uFlags & FILEINI_TRIM) != 0, m_bUnicode);
 
 			// Do we have something to work with?
-			if (nLineLen > 1)
-			{
-				// Is this the section we want?
-				bFoundSectionNow = CheckLineForSection(pLine, nLineLen, pSection, nSectionLen, m_bUnicode, bFoundSection);
-				if (bFoundSection && !bFoundSectionNow)
-					// Yes, do something with the line
-					DoInitLine(pLine, nLineLen, listLines, uFlags, m_bUnicode);
-			}
-		}
+			if ((nLineLen > 1) && SplitLine(pLine, nLineLen, uFlags, m_bUnicode, key))
+				listKeys.push_back(key);
 
-		// Go to the next line (jump over empty lines)
-		FindNextLine(pLine, nLen, m_bUnicode);
-	} while (m_bUnicode ? ((*pLine) != '\0') : ((*((const char*)pLine)) != (char)'\0'));
+			// Go to the next line (jump over empty lines)
+			FindNextLine(pLine, nLen, GetEnd(), m_bUnicode);
+		}
+	}
 
 	return true;
 }
 
+/**
+	@param listKeys The key list to search
+	@param pKey The key to look for (case sensitive)
+	@return The key's entry (the last one, if it appears more than once), or NULL if not found
+*/
+const INIKey* FileINI::FindKey(const INIKEYLIST& listKeys, LPCTSTR pKey)
+{
+	for (INIKEYLIST::const_reverse_iterator i = listKeys.rbegin(); i != listKeys.rend(); i++)
+		if ((*i).sKey.Equals(pKey))
+			return &(*i);
+	return NULL;
+}
+
 /**
 	@param pSection The name of the section, from which to return lines, without the brackets []
 	@param[out] listLines Returns the list of lines. Each line will be added as a string in this list.
@@ -944,59 +853,174 @@ bool FileINI::GetLines(LPCTSTR pSection, TCHARSTRLIST& listLines, UINT uFlags /*
 	if (m_pData == NULL)
 		return false;
 
-	// Initialize variables
-	bool bFoundSection = false, bFoundSectionNow;
-	std::tstring::size_type nLen, nLineLen, nSectionLen = _tcslen(pSection);
-	const WCHAR* pLine = (const WCHAR*)(m_pData + m_nOffset);
+	// Go over the section's lines (it may appear more than once)
+	std::tstring::size_type nLen, nLineLen;
 	std::tstring s;
-
-	// Keep reading lines until the end of file is reached
-	do
+	bool bTrim = (uFlags & FILEINI_TRIM) != 0;
+	for (const INISection* pRange = FindSection(pSection, bTrim); pRange != NULL; pRange = NextSection(pRange, bTrim))
 	{
-		// Find length of current line
-		if (m_bUnicode)
-			nLen = wcscspn(pLine, L"\r\n");
-		else
-			nLen = strcspn((const char*)pLine, "\r\n");
-
-		// Do we have anything here?
-		if (nLen > 0)
+		const WCHAR* pLine = (const WCHAR*)(m_pData + pRange->nStart);
+		const WCHAR* pEnd = (const WCHAR*)(m_pData + GetSectionEnd(pRange, bTrim));
+		while (pLine < pEnd)
 		{
+			// Find length of current line
+			nLen = LineLength(pLine, GetEnd(), m_bUnicode);
+
 			// Find the trimmed length
 			nLineLen = nLen;
 			TrimLen(pLine, nLineLen, (uFlags & FILEINI_TRIM) != 0, m_bUnicode);
 
-			// Is there anything left?
-			if (nLineLen > 1)
+			// Is there anything left (and not a comment we should ignore)?
+			if ((nLineLen > 1) && !((uFlags & FILEINI_IGNORE_COMMENTS) && IsComment(pLine, nLineLen, m_bUnicode)))
 			{
-				// Are we in the section we are looking for?
-				bFoundSectionNow = CheckLineForSection(pLine, nLineLen, pSection, nSectionLen, m_bUnicode, bFoundSection);
-				if (bFoundSection && !bFoundSectionNow)
-				{
-					// Yes; ignore comments if so specified by the flags
-					if ((uFlags & FILEINI_IGNORE_COMMENTS) && IsComment(pLine, nLineLen, m_bUnicode))
-						continue;
-
-					// Convert into something we can work with
-					if (m_bUnicode)
-						s = MakeTString(std::wstring(pLine, nLineLen));
-					else
-						s = MakeTString(std::string((const char*)pLine, nLineLen));
-
-					// Trim if wanted
-					if (uFlags & FILEINI_TRIM)
-						s = Trim(s);
-
-					// Add if not empty
-					if (!s.empty())
-						listLines.push_back(s);
-				}
+				// Convert into something we can work with
+				if (m_bUnicode)
+					s = MakeTString(std::wstring(pLine, nLineLen));
+				else
+					s = MakeTString(std::string((const char*)pLine, nLineLen));
+
+				// Trim if wanted
+				if (uFlags & FILEINI_TRIM)
+					s = Trim(s);
+
+				// Add if not empty
+				if (!s.empty())
+					listLines.push_back(s);
 			}
-		}
 
-		// Jump over empty lines
-		FindNextLine(pLine, nLen, m_bUnicode);
-	} while (m_bUnicode ? ((*pLine) != '\0') : ((*((const char*)pLine)) != (char)'\0'));
+			// Jump over empty lines
+			FindNextLine(pLine, nLen, GetEnd(), m_bUnicode);
+		}
+	}
 
 	return true;
 }
+
+/**
+	
+*/
+void FileINI::IndexSections()
+{
+	if (m_bIndexed)
+		return;
+	m_bIndexed = true;
+	m_arSections.clear();
+	m_mapSections.clear();
+
+	// One pass over the buffer, noting where each section header is
+	std::tstring::size_type nLen, nLineLen;
+	const WCHAR* pLine = (const WCHAR*)(m_pData + m_nOffset);
+	while (!AtEnd(pLine, GetEnd(), m_bUnicode))
+	{
+		// Find the length of the line
+		nLen = LineLength(pLine, GetEnd(), m_bUnicode);
+
+		// Get the trimmed length
+		nLineLen = nLen;
+		TrimLen(pLine, nLineLen, true, m_bUnicode);
+
+		// Is this a section header?
+		bool bHeader;
+		std::tstring sName;
+		if (m_bUnicode)
+		{
+			bHeader = (nLineLen > 1) && (pLine[0] == '[') && (pLine[nLineLen-1] == ']');
+			if (bHeader)
+				sName = MakeTString(std::wstring(pLine+1, nLineLen-2));
+		}
+		else
+		{
+			bHeader = (nLineLen > 1) && (((const char*)pLine)[0] == (char)'[') && (((const char*)pLine)[nLineLen-1] == (char)']');
+			if (bHeader)
+				sName = MakeTString(std::string(((const char*)pLine)+1, nLineLen-2));
+		}
+
+		if (bHeader)
+		{
+			// The previous section ends here
+			if (!m_arSections.empty())
+				m_arSections.back().nEnd = (const char*)pLine - m_pData;
+
+			// Add this one, linking it to an earlier section of the same name (if any)
+			INISection section;
+			section.sName = sName;
+			section.nHeader = (const char*)pLine - m_pData;
+			section.bSpaced = nLineLen < nLen;
+			section.nStart = section.nEnd = 0;
+			section.nNext = std::tstring::npos;
+			size_t nIndex = m_arSections.size();
+			std::pair<SECTIONMAP::iterator, bool> res = m_mapSections.insert(SECTIONMAP::value_type(sName, nIndex));
+			if (!res.second)
+			{
+				size_t nLast = (*res.first).second;
+				while (m_arSections[nLast].nNext != std::tstring::npos)
+					nLast = m_arSections[nLast].nNext;
+				m_arSections[nLast].nNext = nIndex;
+			}
+			m_arSections.push_back(section);
+
+			// Its lines start after the header
+			FindNextLine(pLine, nLen, GetEnd(), m_bUnicode);
+			m_arSections.back().nStart = (const char*)pLine - m_pData;
+			continue;
+		}
+
+		// Go on to the next line
+		FindNextLine(pLine, nLen, GetEnd(), m_bUnicode);
+	}
+
+	// The last section ends with the buffer
+	if (!m_arSections.empty())
+		m_arSections.back().nEnd = (const char*)pLine - m_pData;
+}
+
+/**
+	@param pSection The section name to look for
+	@param bTrim true if the lines are trimmed (FILEINI_TRIM)
+	@return The section's first range, or NULL if there's no such section
+*/
+const FileINI::INISection* FileINI::FindSection(LPCTSTR pSection, bool bTrim)
+{
+	IndexSections();
+	SECTIONMAP::const_iterator iFind = m_mapSections.find(pSection);
+	if (iFind == m_mapSections.end())
+		return NULL;
+	const INISection* pRange = &m_arSections[(*iFind).second];
+	// Headers with trailing whitespace only count when trimming
+	if (!bTrim && pRange->bSpaced)
+		return NextSection(pRange, bTrim);
+	return pRange;
+}
+
+/**
+	@param pSection A range returned by FindSection or NextSection
+	@param bTrim true if the lines are trimmed (FILEINI_TRIM)
+	@return The section's next range, or NULL if there are no more
+*/
+const FileINI::INISection* FileINI::NextSection(const INISection* pSection, bool bTrim) const
+{
+	while (pSection->nNext != std::tstring::npos)
+	{
+		pSection = &m_arSections[pSection->nNext];
+		if (bTrim || !pSection->bSpaced)
+			return pSection;
+	}
+	return NULL;
+}
+
+/**
+	@param pSection A range returned by FindSection or NextSection
+	@param bTrim true if the lines are trimmed (FILEINI_TRIM)
+	@return Offset of the end of the section's range in the buffer
+
+	When not trimming, the range goes on over the following headers that have trailing whitespace.
+*/
+size_t FileINI::GetSectionEnd(const INISection* pSection, bool bTrim) const
+{
+	if (bTrim)
+		return pSection->nEnd;
+	for (size_t i = (pSection - &m_arSections[0]) + 1; i < m_arSections.size(); i++)
+		if (!m_arSections[i].bSpaced)
+			return m_arSections[i].nHeader;
+	return m_arSections.back().nEnd;
+}
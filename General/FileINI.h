@@ -31,6 +31,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 #include "CCTChar.h"
 
 /// A list of strings
@@ -93,6 +94,65 @@ struct INILine
 /// A list of INILine objects, representing a group of INI file lines, in their original order
 typedef std::list<INILine> INILINELIST;
 
+/**
+    @brief A string inside the buffer of a FileINI object (not copied, so valid only while the object holds the buffer)
+*/
+struct INIString
+{
+	/**
+		@brief Default constructor
+	*/
+	INIString() : pData(NULL), nLength(0), bUnicode(false) {};
+	/**
+		@brief Standard constructor
+		@param p Start of the string in the buffer
+		@param n Length of the string, in characters
+		@param bU true if the buffer is Unicode, false if it's ASCII
+	*/
+	INIString(const void* p, size_t n, bool bU) : pData(p), nLength(n), bUnicode(bU) {};
+
+	/// Start of the string (WCHAR or char, according to bUnicode)
+	const void*	pData;
+	/// Length of the string, in characters
+	size_t		nLength;
+	/// true if the string is Unicode, false if it's ASCII
+	bool		bUnicode;
+
+	/**
+		@brief Checks if the string is empty
+		@return true if the string is empty, false if not
+	*/
+	bool		IsEmpty() const {return nLength == 0;};
+	/// Returns a copy of the string
+	std::tstring ToString() const;
+	/// Compares the string to another (case sensitive)
+	bool		Equals(LPCTSTR lpString) const;
+	/// Reads the string as an integer (like _ttoi)
+	int			ToInt() const;
+
+protected:
+	/**
+		@brief Returns a character of the string
+		@param n Index of the character
+		@return The character
+	*/
+	unsigned int At(size_t n) const {return bUnicode ? ((const WCHAR*)pData)[n] : ((const unsigned char*)pData)[n];};
+};
+
+/**
+    @brief A key-value pair inside the buffer of a FileINI object
+*/
+struct INIKey
+{
+	/// The line's key
+	INIString	sKey;
+	/// The line's value
+	INIString	sValue;
+};
+
+/// An array of INIKey objects, in the original order of the lines
+typedef std::vector<INIKey> INIKEYLIST;
+
 /**
     @brief This class, which is composed completely of static methods, can be used to read and parse INI files
 */
@@ -102,7 +162,7 @@ public:
 	/**
 		@brief Default constructor
 	*/
-	FileINI() : m_pData(NULL), m_bOwn(false), m_bUnicode(false), m_nOffset(0) {};
+	FileINI() : m_pData(NULL), m_dwSize(0), m_pView(NULL), m_bOwn(false), m_bUnicode(false), m_nOffset(0), m_bIndexed(false) {};
 	/// Load INI data from file
 	FileINI(LPCTSTR lpFilename);
 	/// Load INI data from memory buffer
@@ -112,12 +172,16 @@ public:
 	/**
 		@brief Destructor
 	*/
-	~FileINI() {if (m_bOwn && (m_pData != NULL)) delete [] m_pData;};
+	~FileINI() {Release();};
 
 protected:
 	// Members
 	/// Buffer data
 	char*		m_pData;
+	/// Size of the buffer data, in bytes
+	DWORD		m_dwSize;
+	/// Mapped file view (m_pData points into it), NULL if the data is not mapped
+	const void*	m_pView;
 	/// Buffer ownership flag (true means the buffer should be deleted with the object)
 	bool		m_bOwn;
 	/// true if this is a unicode buffer
@@ -125,6 +189,50 @@ protected:
 	/// Current offset in the buffer
 	int			m_nOffset;
 
+	/**
+	    @brief A section in the buffer (the lines after the section header, up to the next header)
+
+		A header followed by spaces or tabs is only a header when the lines are trimmed (FILEINI_TRIM);
+		otherwise it's a line of the section before it.
+	*/
+	struct INISection
+	{
+		/// Section name (without the brackets)
+		std::tstring	sName;
+		/// Offset of the section header in the buffer
+		size_t			nHeader;
+		/// true if the header has trailing whitespace
+		bool			bSpaced;
+		/// Offset of the section's first line in the buffer
+		size_t			nStart;
+		/// Offset of the end of the section in the buffer
+		size_t			nEnd;
+		/// Index of the next section with the same name (npos if none)
+		size_t			nNext;
+	};
+	/**
+	    @brief Case insensitive string compare (section names are not case sensitive)
+	*/
+	struct NoCaseLess
+	{
+		/**
+			@brief Compares two strings, ignoring case
+			@param s1 First string
+			@param s2 Second string
+			@return true if s1 comes before s2
+		*/
+		bool operator()(const std::tstring& s1, const std::tstring& s2) const {return _tcsicmp(s1.c_str(), s2.c_str()) < 0;};
+	};
+	/// Map of section name to the index of its first appearance in m_arSections
+	typedef std::map<std::tstring, size_t, NoCaseLess> SECTIONMAP;
+
+	/// true if the section index was built for the current buffer
+	bool		m_bIndexed;
+	/// All the sections in the buffer, in order
+	std::vector<INISection>	m_arSections;
+	/// Section lookup by name
+	SECTIONMAP	m_mapSections;
+
 public:
 	// Data Access
 	/**
@@ -142,8 +250,12 @@ public:
 	bool	GetKeys(LPCTSTR pSection, TCHARSTR2STR& mapKeys, UINT uFlags = 0);
 	/// Retrieves all key names and values in all of the lines in the specified section of the INI file
 	bool	GetKeys(LPCTSTR pSection, INILINELIST& listLines, UINT uFlags = 0);
+	/// Retrieves all key names and values in the specified section of the INI file, without copying them
+	bool	GetKeys(LPCTSTR pSection, INIKEYLIST& listKeys, UINT uFlags = 0);
 	/// Retrieves the list of sections inside the INI file
 	bool	GetAllSections(TCHARSTRLIST& lSections);
+	/// Finds a key in a key list
+	static const INIKey* FindKey(const INIKEYLIST& listKeys, LPCTSTR pKey);
 
 	// Static Methods
 	/// Retrieves all lines in the specified section of the INI file
@@ -162,15 +274,23 @@ public:
 
 protected:
 	// Helpers
-	/// Check if the line is the specified section header
-	static bool	CheckLineForSection(const WCHAR* pLine, std::tstring::size_type nLineLen, LPCTSTR pSection, std::tstring::size_type nSectionLen, bool bUnicode, bool& bFoundSection);
-	/// Parses a (non-section) line and adds the contents into the values pair list
-	static void DoInitLine(const WCHAR* pLine, std::tstring::size_type nLineLen, INILINELIST& list, UINT uFlags, bool bUnicode);
-	/// Check to see if the file is a unicode INI file; tested at the opened location (doesn't seek to the start!)
-	static bool TestUnicode(FILE* pFile);
+	/// Parses a (non-section) line into a key and a value
+	static bool SplitLine(const WCHAR* pLine, std::tstring::size_type nLineLen, UINT uFlags, bool bUnicode, INIKey& key);
 
 	/// Check to see if file INI file is in unicode
 	bool	TestUnicode();
+	/// Releases the buffer
+	void	Release();
+	/// Returns the end of the buffer
+	const char* GetEnd() const {return m_pData + m_dwSize;};
+	/// Builds the section index for the buffer (if not built already)
+	void	IndexSections();
+	/// Finds the first range of a section in the index
+	const INISection* FindSection(LPCTSTR pSection, bool bTrim);
+	/// Finds the next range of a section in the index (for sections that appear more than once)
+	const INISection* NextSection(const INISection* pSection, bool bTrim) const;
+	/// Returns the end of a section's range
+	size_t	GetSectionEnd(const INISection* pSection, bool bTrim) const;
 };
 
 #endif   //#define _FILEINI_H_
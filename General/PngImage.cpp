@@ -27,15 +27,12 @@
 #include "precomp.h"
 #include "PngImage.h"
 
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <io.h>
-#include <share.h>
+#include <vector>
 
 /**
 	
 */
-PngImage::PngImage() : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0)
+PngImage::PngImage() : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0), m_nColors(0)
 {
 }
 
@@ -43,7 +40,7 @@ PngImage::PngImage() : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel
 	@param lpFilename Name of file to load
 	@param bForce8Bit true to force the image to be loaded as 8-bit color image
 */
-PngImage::PngImage(LPCTSTR lpFilename, bool bForce8Bit /* = true */) : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0)
+PngImage::PngImage(LPCTSTR lpFilename, bool bForce8Bit /* = true */) : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0), m_nColors(0)
 {
 	// Call file-loading function
 	LoadFromFile(lpFilename, bForce8Bit);
@@ -55,7 +52,7 @@ PngImage::PngImage(LPCTSTR lpFilename, bool bForce8Bit /* = true */) : m_pData(N
 	@param hModule Handle of module that the resource belongs to
 	@param lpType Type of resource
 */
-PngImage::PngImage(UINT uResourceID, bool bForce8Bit /* = true */, HMODULE hModule /* = NULL */, LPCTSTR lpType /* = _T("PNG") */) : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0)
+PngImage::PngImage(UINT uResourceID, bool bForce8Bit /* = true */, HMODULE hModule /* = NULL */, LPCTSTR lpType /* = _T("PNG") */) : m_pData(NULL), m_nWidth(0), m_nHeight(0), m_nBitsPerPixel(0), m_nBytesPerRow(0), m_nColors(0)
 {
 	// Call resource-loading function
 	LoadFromResource(uResourceID, bForce8Bit, hModule, lpType);
@@ -65,49 +62,38 @@ PngImage::PngImage(UINT uResourceID, bool bForce8Bit /* = true */, HMODULE hModu
 	@param lpFilename Name of file to load
 	@param bForce8Bit true to force the image to be loaded as 8-bit color image
 	@param bLeaveGray false to force loading the image in color, true to leave as grayscale if was so
+	@param bKeepPalette true to load palette and grey images (and RGB images with few colors) as 8 bit palette images
 	@return true if loaded successfully, false if failed
 */
-bool PngImage::LoadFromFile(LPCTSTR lpFilename, bool bForce8Bit /* = true */, bool bLeaveGray /* = false */)
+bool PngImage::LoadFromFile(LPCTSTR lpFilename, bool bForce8Bit /* = true */, bool bLeaveGray /* = false */, bool bKeepPalette /* = false */)
 {
-	// Load file to memory, and call LoadFromBuffer:
-
-	// Get file size
-	struct _stat st;
-	if (_tstat(lpFilename, &st) != 0)
+	// Map the file into memory and decode it from there (no copy of the file is made)
+	HANDLE hFile = ::CreateFile(lpFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
 		// Isn't there!
 		return false;
 
-	if (st.st_mode & _S_IFDIR)
-		// Not a file
-		return false;
-
-	DWORD dwSize = st.st_size;
-
-	// Open the file itself
-	int nFile;
-	if (0 != _tsopen_s(&nFile, lpFilename, _O_BINARY | _O_RDONLY, _SH_DENYNO, _S_IREAD | _S_IWRITE))
+	DWORD dwSize = ::GetFileSize(hFile, NULL);
+	HANDLE hMapping = NULL;
+	if ((dwSize != INVALID_FILE_SIZE) && (dwSize != 0))
+		hMapping = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	// The mapping keeps the file open
+	::CloseHandle(hFile);
+	if (hMapping == NULL)
 		// Failed!
 		return false;
 
-	// Create a buffer
-	char* pBuffer = new char[dwSize];
-	// Load the data
-	if (_read(nFile, pBuffer, dwSize) != (int)dwSize)
-	{
-		// Failed!
-		delete [] pBuffer;
-		_close(nFile);
+	// The view keeps the mapping
+	const char* pData = (const char*)::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(hMapping);
+	if (pData == NULL)
 		return false;
-	}
-
-	// OK, finish up
-	_close(nFile);
 
 	// And create the image
-	bool bRet = LoadFromBuffer(pBuffer, dwSize, bForce8Bit, bLeaveGray);
+	bool bRet = LoadFromBuffer(pData, dwSize, bForce8Bit, bLeaveGray, bKeepPalette);
 
 	// Clean up
-	delete [] pBuffer;
+	::UnmapViewOfFile(pData);
 	return bRet;
 }
 
@@ -117,9 +103,10 @@ bool PngImage::LoadFromFile(LPCTSTR lpFilename, bool bForce8Bit /* = true */, bo
 	@param hModule Handle of module that the resource belongs to
 	@param lpType Type of resource
 	@param bLeaveGray false to force loading the image in color, true to leave as grayscale if was so
+	@param bKeepPalette true to load palette and grey images (and RGB images with few colors) as 8 bit palette images
 	@return true if loaded successfully, false if failed
 */
-bool PngImage::LoadFromResource(UINT uResourceID, bool bForce8Bit /* = true */, HMODULE hModule /* = NULL */, LPCTSTR lpType /* = _T("PNG") */, bool bLeaveGray /* = false */)
+bool PngImage::LoadFromResource(UINT uResourceID, bool bForce8Bit /* = true */, HMODULE hModule /* = NULL */, LPCTSTR lpType /* = _T("PNG") */, bool bLeaveGray /* = false */, bool bKeepPalette /* = false */)
 {
 	// Find the resource
 	HRSRC hResource = FindResource(hModule, MAKEINTRESOURCE(uResourceID), lpType);
@@ -141,49 +128,162 @@ bool PngImage::LoadFromResource(UINT uResourceID, bool bForce8Bit /* = true */,
 	if (lpData == NULL)
 		return false;
 
-	// OK, just create an image from the data:
-	return LoadFromBuffer((const char*)lpData, dwSize, bForce8Bit, bLeaveGray);
+	// OK, just create an image from the data (it's decoded from the resource memory, no copy is made):
+	return LoadFromBuffer((const char*)lpData, dwSize, bForce8Bit, bLeaveGray, bKeepPalette);
 }
 
 /**
-    @brief Structure containing buffer data (used in the callback
+    @brief State of a progressive read (passed to the libpng callbacks)
 */
 struct PngReadInfo
 {
 	// Ctor
 	/**
-		@param p Pointer to the data buffer
-		@param dw Size of data buffer
+		@param p The image being loaded
+		@param b8 true to force the image to be loaded as 8-bit color image
+		@param bGray true to leave grey images grey
+		@param bPalette true to keep palette and grey images as palette images
 	*/
-	PngReadInfo(const char* p, DWORD dw) : pBuffer(p), dwLen(dw) {};
+	PngReadInfo(PngImage* p, bool b8, bool bGray, bool bPalette) : pImage(p), bForce8Bit(b8), bLeaveGray(bGray), bKeepPalette(bPalette), bIndexed(false), bDone(false) {};
 
 	// Members
-	/// Pointer to the buffer
-	const char* pBuffer;
-	/// Size of remaining buffer
-	DWORD dwLen;
+	/// The image being loaded
+	PngImage* pImage;
+	/// true to force the image to be loaded as 8-bit color image
+	bool bForce8Bit;
+	/// true to leave grey images grey
+	bool bLeaveGray;
+	/// true to keep palette and grey images as palette images
+	bool bKeepPalette;
+	/// Set when the pixels are read as palette indices
+	bool bIndexed;
+	/// Set when the whole image was read
+	bool bDone;
 };
 
 /**
-	@param pPng Pointer to PNG data buffer
-	@param pBuffer Pointer to the buffer to fill
-	@param nSize Size of the buffer to fill
+	@param pPng Pointer to PNG read structure
+	@param pPngInfo Pointer to PNG info structure (everything up to the image data was read)
+
+	Sets up the transformations so the rows come out in their final layout, and creates the image buffer.
 */
-void PNGAPI PngImage::StaticRead(png_structp pPng, png_bytep pBuffer, png_size_t nSize)
+void PNGAPI PngImage::StaticInfo(png_structp pPng, png_infop pPngInfo)
 {
-	// Get the read info structure pointer:
-	PngReadInfo* pInfo = (PngReadInfo*)png_get_io_ptr(pPng);
+	PngReadInfo* pInfo = (PngReadInfo*)png_get_progressive_ptr(pPng);
 	if (pInfo == NULL)
-		png_error(pPng, "StaticRead error 1");
-	if (nSize > pInfo->dwLen)
-		png_error(pPng, "Not enough input");
+		png_error(pPng, "StaticInfo error 1");
+	PngImage* pImage = pInfo->pImage;
+
+	int bitDepth, colorType;
+	ULONG width, height;
+	png_get_IHDR(pPng, pPngInfo, &width, &height, &bitDepth, &colorType, NULL, NULL, NULL);
 
-	// OK, copy the data
-	memcpy(pBuffer, pInfo->pBuffer, nSize);
+	pImage->m_nWidth = width;
+	pImage->m_nHeight = height;  
 
-	// Move along
-	pInfo->pBuffer += nSize;
-	pInfo->dwLen -= (DWORD)nSize;
+	// Keeping the palette: palette and grey images are read as 8 bit indices (ignoring transparency, like the other images)
+	bool bForce8Bit = pInfo->bForce8Bit;
+	bool bIndexed = pInfo->bKeepPalette && ((colorType == PNG_COLOR_TYPE_PALETTE) || (colorType == PNG_COLOR_TYPE_GRAY) || (colorType == PNG_COLOR_TYPE_GRAY_ALPHA));
+	if (bIndexed)
+	{
+		if (colorType == PNG_COLOR_TYPE_PALETTE)
+		{
+			// Use the image's palette
+			png_colorp pPalette;
+			int nColors = 0;
+			png_get_PLTE(pPng, pPngInfo, &pPalette, &nColors);
+			for (int i = 0; (i < nColors) && (i < 256); i++)
+			{
+				pImage->m_rgbPalette[i].rgbRed = pPalette[i].red;
+				pImage->m_rgbPalette[i].rgbGreen = pPalette[i].green;
+				pImage->m_rgbPalette[i].rgbBlue = pPalette[i].blue;
+				pImage->m_rgbPalette[i].rgbReserved = 0;
+			}
+			pImage->m_nColors = min(nColors, 256);
+			png_set_packing(pPng);
+		}
+		else
+		{
+			// Grey levels index a grey palette
+			for (int i = 0; i < 256; i++)
+			{
+				pImage->m_rgbPalette[i].rgbRed = pImage->m_rgbPalette[i].rgbGreen = pImage->m_rgbPalette[i].rgbBlue = (BYTE)i;
+				pImage->m_rgbPalette[i].rgbReserved = 0;
+			}
+			pImage->m_nColors = 256;
+		}
+		bForce8Bit = true;
+	}
+	pInfo->bIndexed = bIndexed;
+
+	// apply filters to image so we can get proper image data format
+	if ((colorType == PNG_COLOR_TYPE_PALETTE) && !bIndexed)
+		png_set_palette_to_rgb(pPng);
+	if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
+		png_set_gray_1_2_4_to_8(pPng);
+	if (png_get_valid(pPng, pPngInfo, PNG_INFO_tRNS) && !bIndexed)
+		png_set_tRNS_to_alpha(pPng);
+
+	if (bitDepth == 16)
+	{
+		if(bForce8Bit)
+			png_set_strip_16(pPng); //make 8-bit
+		else
+			png_set_swap(pPng); //swap endian order (PNG is Big Endian)
+	}
+
+	if (bForce8Bit) // force8bit depth per channel
+		bitDepth = 8;
+
+    if (colorType & PNG_COLOR_MASK_ALPHA)
+	    png_set_strip_alpha(pPng);
+
+	if (((colorType == PNG_COLOR_TYPE_GRAY) || (colorType == PNG_COLOR_TYPE_GRAY_ALPHA)) && !pInfo->bLeaveGray && !bIndexed)
+		png_set_gray_to_rgb(pPng);
+
+	// Colors in GDI's order (BGR)
+	if (!bIndexed)
+		png_set_bgr(pPng);
+
+	// Interlaced rows are put together in the image buffer
+	png_set_interlace_handling(pPng);
+	png_read_update_info(pPng, pPngInfo);
+
+	// Now, create the actual image (rows start on 4 byte boundaries, like GDI wants them)
+	int nRowBytes = (int)png_get_rowbytes(pPng, pPngInfo);
+	pImage->m_nBitsPerPixel = (nRowBytes / pImage->m_nWidth) * bitDepth;
+	pImage->m_nBytesPerRow = (nRowBytes + 3) & ~3;
+	pImage->m_pData = new BYTE[pImage->m_nBytesPerRow * pImage->m_nHeight];
+	// Interlaced images are combined with the earlier passes' pixels, so start with something defined
+	if (png_get_interlace_type(pPng, pPngInfo) != PNG_INTERLACE_NONE)
+		memset(pImage->m_pData, 0, pImage->m_nBytesPerRow * pImage->m_nHeight);
+}
+
+/**
+	@param pPng Pointer to PNG read structure
+	@param pRow The decoded row (NULL if this pass didn't change it)
+	@param uRow The row's number
+	@param nPass The interlace pass number
+*/
+void PNGAPI PngImage::StaticRow(png_structp pPng, png_bytep pRow, png_uint_32 uRow, int nPass)
+{
+	PngReadInfo* pInfo = (PngReadInfo*)png_get_progressive_ptr(pPng);
+	if ((pInfo == NULL) || (pInfo->pImage->m_pData == NULL) || (uRow >= (png_uint_32)pInfo->pImage->m_nHeight))
+		png_error(pPng, "StaticRow error 1");
+
+	// Straight into the image
+	png_progressive_combine_row(pPng, pInfo->pImage->m_pData + uRow * pInfo->pImage->m_nBytesPerRow, pRow);
+}
+
+/**
+	@param pPng Pointer to PNG read structure
+	@param pPngInfo Pointer to PNG info structure
+*/
+void PNGAPI PngImage::StaticEnd(png_structp pPng, png_infop pPngInfo)
+{
+	PngReadInfo* pInfo = (PngReadInfo*)png_get_progressive_ptr(pPng);
+	if (pInfo != NULL)
+		pInfo->bDone = true;
 }
 
 /**
@@ -191,9 +291,13 @@ void PNGAPI PngImage::StaticRead(png_structp pPng, png_bytep pBuffer, png_size_t
 	@param dwLen Size of the image data
 	@param bForce8Bit true to force the image to be loaded as 8-bit color image
 	@param bLeaveGray false to force loading the image in color, true to leave as grayscale if was so
+	@param bKeepPalette true to load palette and grey images (and RGB images with few colors) as 8 bit palette images
 	@return true if loaded successfully, false if failed
+
+	The whole buffer is handed to libpng's progressive reader at once, so the compressed data is decoded
+	where it is (no copy is made), and the rows are written directly into the image buffer.
 */
-bool PngImage::LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit /* = true */, bool bLeaveGray /* = false */)
+bool PngImage::LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit /* = true */, bool bLeaveGray /* = false */, bool bKeepPalette /* = false */)
 {
 	// Clean up
 	clear();
@@ -204,9 +308,6 @@ bool PngImage::LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit
 	if (!png_check_sig((png_bytep)pBuffer, 8))
 		return false;
 
-	pBuffer += 8;
-	dwLen -= 8;
-
 	//create pPng and info_png
 	png_structp pPng = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if (pPng == NULL)
@@ -220,85 +321,36 @@ bool PngImage::LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit
 		return false;
 	}
 
-    png_infop pPngEndInfo = png_create_info_struct(pPng);
-    if (pPngEndInfo == NULL)
-    {
-        png_destroy_read_struct(&pPng, &pPngInfo, NULL);
-        return false;
-    }
-
 	if (setjmp(png_jmpbuf(pPng))) 
 	{
 		// problem:
-		png_destroy_read_struct(&pPng, &pPngInfo, &pPngEndInfo);
+		png_destroy_read_struct(&pPng, &pPngInfo, NULL);
+		clear();
 		return false;
 	}
 
 	try
 	{
-		// Read the buffer and create an image:
-		PngReadInfo info(pBuffer, dwLen);
-		png_set_read_fn(pPng, &info, StaticRead);
-
-		png_set_sig_bytes(pPng, 8);  // we already read the 8 signature bytes 
-		png_read_info(pPng, pPngInfo);  // read all PNG info up to image data 
-
-		int bitDepth, colorType;
-		ULONG width, height;
-		png_get_IHDR(pPng, pPngInfo, &width, &height, &bitDepth, &colorType, NULL, NULL, NULL);
-
-		m_nWidth = width;
-		m_nHeight = height;  
-
-		// apply filters to image so we can get proper image data format
-		if (colorType == PNG_COLOR_TYPE_PALETTE)
-			png_set_palette_to_rgb(pPng);
-		if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
-			png_set_gray_1_2_4_to_8(pPng);
-		if (png_get_valid(pPng, pPngInfo, PNG_INFO_tRNS))
-			png_set_tRNS_to_alpha(pPng);
-
-		if (bitDepth == 16)
+		// Read the buffer and create the image (the callbacks do the work)
+		PngReadInfo info(this, bForce8Bit, bLeaveGray, bKeepPalette);
+		png_set_progressive_read_fn(pPng, &info, StaticInfo, StaticRow, StaticEnd);
+		png_process_data(pPng, pPngInfo, (png_bytep)pBuffer, dwLen);
+		png_destroy_read_struct(&pPng, &pPngInfo, NULL);
+		if (!info.bDone)
 		{
-			if(bForce8Bit)
-				png_set_strip_16(pPng); //make 8-bit
-			else
-				png_set_swap(pPng); //swap endian order (PNG is Big Endian)
+			// The data ended before the image did
+			clear();
+			return false;
 		}
 
-		if (bForce8Bit) // force8bit depth per channel
-			bitDepth = 8;
-
-		int byteDepth = bitDepth/8;
-
-	    if (colorType & PNG_COLOR_MASK_ALPHA)
-		    png_set_strip_alpha(pPng);
-
-		if (((colorType == PNG_COLOR_TYPE_GRAY) || (colorType == PNG_COLOR_TYPE_GRAY_ALPHA)) && !bLeaveGray)
-			png_set_gray_to_rgb(pPng);
-
-		png_read_update_info(pPng, pPngInfo);
-
-		// Now, create the actual image:
-		// Calculate data
-		m_nBytesPerRow = png_get_rowbytes(pPng, pPngInfo);
-		m_nBitsPerPixel = (m_nBytesPerRow / m_nWidth) * bitDepth;
-		// Create buffers and set them up
-		m_pData = new BYTE[m_nBytesPerRow * m_nHeight];
-		BYTE** pRowPointers = new BYTE*[m_nHeight];
-		for (int i = 0;  i < m_nHeight;  ++i)
-			pRowPointers[i] = m_pData + i*m_nBytesPerRow;
-
-		// Read the data
-		png_read_image(pPng, pRowPointers);
-		png_read_end(pPng, pPngEndInfo);
-		png_destroy_read_struct(&pPng, &pPngInfo, &pPngEndInfo);
-
-		delete [] pRowPointers;
+		// An RGB image with few colors can be a palette image
+		if (bKeepPalette && !info.bIndexed && (m_nBitsPerPixel == 24))
+			IndexColors();
 	}
 	catch(...)
 	{
 		// Failed, clean up
+		png_destroy_read_struct(&pPng, &pPngInfo, NULL);
 		clear();
 		return false;
 	}
@@ -317,6 +369,62 @@ void PngImage::clear()
 		delete [] m_pData;
 		m_pData = NULL;
 	}
+	m_nColors = 0;
+}
+
+/**
+	@return true if the image was turned into a palette image, false if it has too many colors (left as it is)
+*/
+bool PngImage::IndexColors()
+{
+	// The colors found so far, in a small hash table (colors only use 24 bits, so all bits set marks a free slot)
+	const DWORD HASH_SIZE = 1024;
+	const DWORD EMPTY = 0xFFFFFFFF;
+	DWORD dwColors[HASH_SIZE];
+	BYTE cIndices[HASH_SIZE];
+	memset(dwColors, 0xFF, sizeof(dwColors));
+	int nColors = 0;
+
+	int nBytesPerRow = (m_nWidth + 3) & ~3;
+	BYTE* pIndexed = new BYTE[nBytesPerRow * m_nHeight];
+	for (int y = 0; y < m_nHeight; y++)
+	{
+		const BYTE* pPixel = m_pData + y * m_nBytesPerRow;
+		BYTE* pOut = pIndexed + y * nBytesPerRow;
+		for (int x = 0; x < m_nWidth; x++, pPixel += 3)
+		{
+			DWORD dwColor = ((DWORD)pPixel[2] << 16) | ((DWORD)pPixel[1] << 8) | pPixel[0];
+			DWORD dwSlot = ((dwColor * 2654435761UL) >> 16) & (HASH_SIZE - 1);
+			while ((dwColors[dwSlot] != dwColor) && (dwColors[dwSlot] != EMPTY))
+				dwSlot = (dwSlot + 1) & (HASH_SIZE - 1);
+			if (dwColors[dwSlot] == EMPTY)
+			{
+				// New color
+				if (nColors == 256)
+				{
+					// Too many
+					delete [] pIndexed;
+					return false;
+				}
+				dwColors[dwSlot] = dwColor;
+				cIndices[dwSlot] = (BYTE)nColors;
+				m_rgbPalette[nColors].rgbRed = pPixel[2];
+				m_rgbPalette[nColors].rgbGreen = pPixel[1];
+				m_rgbPalette[nColors].rgbBlue = pPixel[0];
+				m_rgbPalette[nColors].rgbReserved = 0;
+				nColors++;
+			}
+			*pOut++ = cIndices[dwSlot];
+		}
+	}
+
+	// Use the indices instead of the colors
+	delete [] m_pData;
+	m_pData = pIndexed;
+	m_nBytesPerRow = nBytesPerRow;
+	m_nBitsPerPixel = 8;
+	m_nColors = nColors;
+	return true;
 }
 
 /**
@@ -330,9 +438,10 @@ HBITMAP PngImage::ToBitmap(HDC hDC)
 		// Nope, nothing to create
 		return NULL;
 
-	// OK, set up the header
-	BITMAPINFO info;
-	info.bmiHeader.biSize = sizeof(info);
+	// OK, set up the header (with room for the palette)
+	BYTE cInfo[sizeof(BITMAPINFOHEADER) + 256 * sizeof(RGBQUAD)];
+	BITMAPINFO& info = *(BITMAPINFO*)cInfo;
+	info.bmiHeader.biSize = sizeof(info.bmiHeader);
 	info.bmiHeader.biWidth = m_nWidth;
 	info.bmiHeader.biHeight = -m_nHeight;
 	info.bmiHeader.biPlanes = 1;
@@ -341,8 +450,10 @@ HBITMAP PngImage::ToBitmap(HDC hDC)
 	info.bmiHeader.biSizeImage = 0;
 	info.bmiHeader.biXPelsPerMeter = (long)(72 * 100 / 2.56);
 	info.bmiHeader.biYPelsPerMeter = (long)(72 * 100 / 2.56);
-	info.bmiHeader.biClrUsed = 0;
+	info.bmiHeader.biClrUsed = m_nColors;
 	info.bmiHeader.biClrImportant = 0;
+	if (m_nColors > 0)
+		memcpy(info.bmiColors, m_rgbPalette, m_nColors * sizeof(RGBQUAD));
 
 	// Create the bitmap
 	HBITMAP hBmp = CreateCompatibleBitmap(hDC, m_nWidth, m_nHeight);
@@ -352,3 +463,183 @@ HBITMAP PngImage::ToBitmap(HDC hDC)
 	// That's it:
 	return hBmp;
 }
+
+/// Fixed point precision of the scaling weights
+#define SCALE_BITS	12
+
+/**
+    @brief A source pixel's share in a scaled pixel
+*/
+struct ScaleWeight
+{
+	/// Position of the source pixel
+	int		nSource;
+	/// Its weight (the weights of each scaled pixel add up to 1 << SCALE_BITS)
+	int		nWeight;
+};
+
+/**
+	@brief This function builds the weights for scaling one dimension of an image
+	@param nSource Source size
+	@param nTarget Target size
+	@param[out] arFirst Receives the position of each target pixel's first weight (with an extra entry for the end)
+	@param[out] arWeights Receives the weights
+
+	Shrinking averages the source pixels each target pixel covers (by how much of each it covers), enlarging
+	interpolates between the two source pixels nearest to the target pixel's center.
+*/
+static void BuildScaleWeights(int nSource, int nTarget, std::vector<int>& arFirst, std::vector<ScaleWeight>& arWeights)
+{
+	const int nOne = 1 << SCALE_BITS;
+	double dRatio = (double)nSource / nTarget;
+	arFirst.resize(nTarget + 1);
+	arWeights.clear();
+	for (int i = 0; i < nTarget; i++)
+	{
+		size_t nFirst = arWeights.size();
+		arFirst[i] = (int)nFirst;
+		ScaleWeight weight;
+		if (nTarget < nSource)
+		{
+			// Area average
+			double dStart = i * dRatio, dEnd = (i + 1) * dRatio;
+			for (int j = (int)dStart; (j < nSource) && (j < dEnd); j++)
+			{
+				double dCover = min(dEnd, (double)(j + 1)) - max(dStart, (double)j);
+				weight.nSource = j;
+				weight.nWeight = (int)(dCover * nOne / dRatio + 0.5);
+				arWeights.push_back(weight);
+			}
+		}
+		else
+		{
+			// Linear interpolation (the edges repeat the edge pixels)
+			double dPos = max(0.0, (i + 0.5) * dRatio - 0.5);
+			weight.nSource = min((int)dPos, nSource - 1);
+			int nNext = (int)((dPos - weight.nSource) * nOne + 0.5);
+			if (weight.nSource == nSource - 1)
+				nNext = 0;
+			weight.nWeight = nOne - nNext;
+			arWeights.push_back(weight);
+			if (nNext > 0)
+			{
+				weight.nSource++;
+				weight.nWeight = nNext;
+				arWeights.push_back(weight);
+			}
+		}
+
+		// Rounding may leave the sum a bit off: fix it in the largest weight
+		int nSum = 0;
+		size_t nLargest = nFirst;
+		for (size_t j = nFirst; j < arWeights.size(); j++)
+		{
+			nSum += arWeights[j].nWeight;
+			if (arWeights[j].nWeight > arWeights[nLargest].nWeight)
+				nLargest = j;
+		}
+		arWeights[nLargest].nWeight += nOne - nSum;
+	}
+	arFirst[nTarget] = (int)arWeights.size();
+}
+
+/**
+	@param source The image to scale (cannot be this image)
+	@param nWidth Width of the scaled image
+	@param nHeight Height of the scaled image
+	@return true if the image was created, false if the source is empty or has an unsupported format
+
+	The scaled image is always a 24 bit (BGR) image: palette and grey images are expanded to colors first.
+	Each dimension is scaled on its own, the rows first and then the columns.
+*/
+bool PngImage::Scale(const PngImage& source, int nWidth, int nHeight)
+{
+	clear();
+	if ((&source == this) || (source.m_pData == NULL) || (nWidth <= 0) || (nHeight <= 0))
+		return false;
+	int nSourceBytes = source.m_nBitsPerPixel / 8;
+	if ((nSourceBytes != 1) && (nSourceBytes != 3) && (nSourceBytes != 4))
+		return false;
+
+	// Source pixels as BGR
+	int nSourceWidth = source.m_nWidth, nSourceHeight = source.m_nHeight;
+	std::vector<BYTE> arSource(nSourceWidth * nSourceHeight * 3);
+	BYTE* pOut = &arSource[0];
+	for (int y = 0; y < nSourceHeight; y++)
+	{
+		const BYTE* pIn = source.m_pData + y * source.m_nBytesPerRow;
+		for (int x = 0; x < nSourceWidth; x++, pIn += nSourceBytes, pOut += 3)
+		{
+			if (nSourceBytes > 1)
+			{
+				pOut[0] = pIn[0];
+				pOut[1] = pIn[1];
+				pOut[2] = pIn[2];
+			}
+			else if (source.m_nColors > 0)
+			{
+				const RGBQUAD& rgb = source.m_rgbPalette[*pIn];
+				pOut[0] = rgb.rgbBlue;
+				pOut[1] = rgb.rgbGreen;
+				pOut[2] = rgb.rgbRed;
+			}
+			else
+				pOut[0] = pOut[1] = pOut[2] = *pIn;
+		}
+	}
+
+	// Scale the rows (into 8.8 fixed point values)
+	std::vector<int> arFirst;
+	std::vector<ScaleWeight> arWeights;
+	BuildScaleWeights(nSourceWidth, nWidth, arFirst, arWeights);
+	std::vector<WORD> arRows(nWidth * nSourceHeight * 3);
+	WORD* pRow = &arRows[0];
+	for (int y = 0; y < nSourceHeight; y++)
+	{
+		const BYTE* pIn = &arSource[y * nSourceWidth * 3];
+		for (int x = 0; x < nWidth; x++, pRow += 3)
+		{
+			int nB = 0, nG = 0, nR = 0;
+			for (int i = arFirst[x]; i < arFirst[x + 1]; i++)
+			{
+				const BYTE* pPixel = pIn + arWeights[i].nSource * 3;
+				nB += pPixel[0] * arWeights[i].nWeight;
+				nG += pPixel[1] * arWeights[i].nWeight;
+				nR += pPixel[2] * arWeights[i].nWeight;
+			}
+			pRow[0] = (WORD)((nB + (1 << (SCALE_BITS - 9))) >> (SCALE_BITS - 8));
+			pRow[1] = (WORD)((nG + (1 << (SCALE_BITS - 9))) >> (SCALE_BITS - 8));
+			pRow[2] = (WORD)((nR + (1 << (SCALE_BITS - 9))) >> (SCALE_BITS - 8));
+		}
+	}
+
+	// Scale the columns into the image
+	BuildScaleWeights(nSourceHeight, nHeight, arFirst, arWeights);
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+	m_nBitsPerPixel = 24;
+	m_nBytesPerRow = (nWidth * 3 + 3) & ~3;
+	m_pData = new BYTE[m_nBytesPerRow * nHeight];
+	const int nRound = 1 << (SCALE_BITS + 7);
+	int nValues = nWidth * 3;
+	std::vector<int> arSum(nValues);
+	for (int y = 0; y < nHeight; y++)
+	{
+		// Add the source rows one at a time (keeps to consecutive memory)
+		int* pSum = &arSum[0];
+		for (int x = 0; x < nValues; x++)
+			pSum[x] = nRound;
+		for (int i = arFirst[y]; i < arFirst[y + 1]; i++)
+		{
+			const WORD* pIn = &arRows[arWeights[i].nSource * nValues];
+			int nWeight = arWeights[i].nWeight;
+			for (int x = 0; x < nValues; x++)
+				pSum[x] += pIn[x] * nWeight;
+		}
+
+		pOut = m_pData + y * m_nBytesPerRow;
+		for (int x = 0; x < nValues; x++)
+			pOut[x] = (BYTE)min(255, pSum[x] >> (SCALE_BITS + 8));
+	}
+	return true;
+}
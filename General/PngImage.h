@@ -31,6 +31,11 @@
 
 /**
     @brief Wrapper class for loading and displaying PNG images
+
+	Images are normally loaded as RGB, with the bytes in GDI's order (BGR). When asked to keep the palette,
+	palette and grey images keep one byte per pixel (grey levels become a grey palette), and RGB images that
+	use no more than 256 colors are turned into palette images too. Rows always start on 4 byte boundaries,
+	so the data can be used as a GDI or engine bitmap as it is.
 */
 class PngImage
 {
@@ -59,6 +64,10 @@ protected:
 	int			m_nBitsPerPixel;
 	/// Number of full bytes per image line
 	int			m_nBytesPerRow;
+	/// The palette (for 8 bit palette images)
+	RGBQUAD		m_rgbPalette[256];
+	/// Number of colors in the palette (0 if the image has no palette)
+	int			m_nColors;
 
 public:
 	// Data Access
@@ -87,14 +96,24 @@ public:
 		@return The number of full bytes in each image line
 	*/
 	int			GetWidthInBytes() const {return m_nBytesPerRow;};
+	/**
+		@brief Returns the palette
+		@return Pointer to the palette colors (GetColorCount() entries)
+	*/
+	const RGBQUAD* GetPalette() const {return m_rgbPalette;};
+	/**
+		@brief Returns the number of colors in the palette
+		@return The number of colors, or 0 if the pixels are not palette indices
+	*/
+	int			GetColorCount() const {return m_nColors;};
 
 public:
 	/// Loads a PNG image from a file
-	bool		LoadFromFile(LPCTSTR lpFilename, bool bForce8Bit = true, bool bLeaveGray = false);
+	bool		LoadFromFile(LPCTSTR lpFilename, bool bForce8Bit = true, bool bLeaveGray = false, bool bKeepPalette = false);
 	/// Loads a PNG image from a resource
-	bool		LoadFromResource(UINT uResourceID, bool bForce8Bit = true, HMODULE hModule = NULL, LPCTSTR lpType = _T("PNG"), bool bLeaveGray = false);
+	bool		LoadFromResource(UINT uResourceID, bool bForce8Bit = true, HMODULE hModule = NULL, LPCTSTR lpType = _T("PNG"), bool bLeaveGray = false, bool bKeepPalette = false);
 	/// Loads a PNG image from a buffer
-	bool		LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit = true, bool bLeaveGray = false);
+	bool		LoadFromBuffer(const char* pBuffer, DWORD dwLen, bool bForce8Bit = true, bool bLeaveGray = false, bool bKeepPalette = false);
 
 	/// cleans the loaded image
 	void		clear();
@@ -102,9 +121,18 @@ public:
 	/// Returns a GDI bitmap containing the same image
 	HBITMAP		ToBitmap(HDC hDC);
 
+	/// Creates the image as a copy of another image, scaled to a new size
+	bool		Scale(const PngImage& source, int nWidth, int nHeight);
+
 protected:
-	/// PNG reader callback function
-	static void PNGAPI StaticRead(png_structp pPng, png_bytep pBuffer, png_size_t nSize);
+	/// Turns an 8 bit RGB image into a palette image, if it has few enough colors
+	bool		IndexColors();
+	/// PNG reader callback: the image header was read
+	static void PNGAPI StaticInfo(png_structp pPng, png_infop pPngInfo);
+	/// PNG reader callback: an image row was decoded
+	static void PNGAPI StaticRow(png_structp pPng, png_bytep pRow, png_uint_32 uRow, int nPass);
+	/// PNG reader callback: the whole image was read
+	static void PNGAPI StaticEnd(png_structp pPng, png_infop pPngInfo);
 };
 
 #endif   //#define _PNGIMAGE_H_
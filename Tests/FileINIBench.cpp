@@ -0,0 +1,113 @@
+/**
+	@file
+	@brief Benchmark of reading every page section of a 10k page INI link file, against the old whole-buffer scans
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "FileINI.h"
+#include "Reference/OldFileINI.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/// Pages in the link file
+#define BENCH_PAGES		10000
+/// Links in each page
+#define BENCH_LINKS		5
+/// The old reader is timed on one page in this many (it takes minutes for all of them)
+#define OLD_SAMPLE		100
+
+/**
+	@brief Creates a link file the way the add-in writes it (a Unicode INI file)
+	@param[out] data Receives the file data
+*/
+static void MakeLinkFile(std::vector<char>& data)
+{
+	std::wstring sText = L"\xFEFF[Job]\r\nPageCount=10000\r\n";
+	wchar_t cLine[256];
+	for (int nPage = 1; nPage <= BENCH_PAGES; nPage++)
+	{
+		swprintf(cLine, COUNTOF(cLine), L"[Page %d]\r\nLinkCount=%d\r\n", nPage, BENCH_LINKS);
+		sText += cLine;
+		for (int nLink = 1; nLink <= BENCH_LINKS; nLink++)
+		{
+			swprintf(cLine, COUNTOF(cLine), L"URL%d=http://www.example.com/page%d/link%d.html\r\nTitle%d=Link %d of page %d\r\n"
+				L"Text%d=see page %d item %d\r\nRepeat%d=1\r\n", nLink, nPage, nLink, nLink, nLink, nPage, nLink, nPage, nLink, nLink);
+			sText += cLine;
+		}
+	}
+	sText += L'\0';
+	data.resize(sText.size() * sizeof(WCHAR));
+	memcpy(&data[0], sText.data(), data.size());
+}
+
+/**
+	
+*/
+int main()
+{
+	std::vector<char> data;
+	MakeLinkFile(data);
+	printf("link file: %d pages, %.1f MB\n", BENCH_PAGES, data.size() / 1e6);
+	wchar_t cName[32];
+
+	// New: the first call indexes the buffer, then each page is read from its own range
+	double dBest = 0, dIndex = 0;
+	size_t nKeys = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		FileINI file(&data[0], (DWORD)data.size(), false);
+		TCHARSTRLIST sections;
+		file.GetAllSections(sections);
+		dIndex = BestTime(dIndex, timer.Elapsed());
+		nKeys = 0;
+		for (int nPage = 1; nPage <= BENCH_PAGES; nPage++)
+		{
+			swprintf(cName, COUNTOF(cName), L"Page %d", nPage);
+			INIKEYLIST keys;
+			file.GetKeys(cName, keys);
+			if (FileINI::FindKey(keys, L"LinkCount") != NULL)
+				nKeys += keys.size();
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	BenchReport("index sections", dIndex, data.size() / 1e6, "MB");
+	BenchReport("index and read all pages", dBest, BENCH_PAGES, "pages");
+	if (nKeys != BENCH_PAGES * (1 + BENCH_LINKS * 4))
+		printf("wrong key count: %d\n", (int)nKeys);
+
+	// Old: each page's read scans the whole buffer
+	Old::FileINI old(&data[0], (DWORD)data.size(), false);
+	BenchTimer timer;
+	for (int nPage = 1; nPage <= BENCH_PAGES; nPage += OLD_SAMPLE)
+	{
+		swprintf(cName, COUNTOF(cName), L"Page %d", nPage);
+		Old::TCHARSTR2STR keys;
+		old.GetKeys(cName, keys);
+	}
+	BenchReport("old, all pages (timed on 1 in 100)", timer.Elapsed() * OLD_SAMPLE, BENCH_PAGES, "pages");
+	return 0;
+}
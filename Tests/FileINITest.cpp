@@ -0,0 +1,217 @@
+/**
+	@file
+	@brief Tests for the INI file reader (FileINI): the section index against the old whole-buffer scans
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "FileINI.h"
+#include "Reference/OldFileINI.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/**
+	@brief Makes the file data of an INI text
+	@param sText The text
+	@param bUnicode true for a Unicode file (with a byte order mark), false for an ANSI one (Latin-1 text only)
+	@param bTerminate true to end the data with a NULL terminator, false to have the reader add one
+	@return The data
+*/
+static std::vector<char> MakeFile(const std::wstring& sText, bool bUnicode, bool bTerminate)
+{
+	std::vector<char> data;
+	if (bUnicode)
+	{
+		std::wstring s = L"\xFEFF" + sText;
+		if (bTerminate)
+			s += L'\0';
+		data.resize(s.size() * sizeof(WCHAR));
+		memcpy(&data[0], s.data(), data.size());
+	}
+	else
+	{
+		for (size_t i = 0; i < sText.size(); i++)
+			data.push_back((char)sText[i]);
+		if (bTerminate)
+			data.push_back('\0');
+	}
+	return data;
+}
+
+/**
+	@brief Reads a file's data with the new and the old reader, and compares everything they return
+	@param sText The file's text
+	@param arNames Section names to ask for (besides the file's own)
+	@param bUnicode true for a Unicode file, false for an ANSI one
+	@param bTerminate true to end the data with a NULL terminator
+*/
+static void CompareFile(const std::wstring& sText, const std::vector<std::wstring>& arNames, bool bUnicode, bool bTerminate)
+{
+	// (the old reader only added a one byte terminator to Unicode data, and read past it, so it's always
+	// given terminated data)
+	std::vector<char> data = MakeFile(sText, bUnicode, bTerminate), oldData = MakeFile(sText, bUnicode, bTerminate || bUnicode);
+	if (data.empty())
+		return;
+	FileINI file(&data[0], (DWORD)data.size(), false);
+	Old::FileINI old(&oldData[0], (DWORD)oldData.size(), false);
+
+	// The sections, in file order
+	TCHARSTRLIST sections, oldSections;
+	CHECK(file.GetAllSections(sections));
+	CHECK(old.GetAllSections(oldSections));
+	CHECK(sections == oldSections);
+
+	// Each section, by its own name and others, with all the flags
+	std::vector<std::wstring> arAsk(arNames);
+	arAsk.insert(arAsk.end(), sections.begin(), sections.end());
+	for (size_t nName = 0; nName < arAsk.size(); nName++)
+	{
+		LPCTSTR lpName = arAsk[nName].c_str();
+		for (UINT uFlags = 0; uFlags <= (FILEINI_IGNORE_COMMENTS | FILEINI_TRIM); uFlags++)
+		{
+			INILINELIST lines;
+			Old::INILINELIST oldLines;
+			CHECK(file.GetKeys(lpName, lines, uFlags));
+			CHECK(old.GetKeys(lpName, oldLines, uFlags));
+			CHECK_EQUAL(lines.size(), oldLines.size());
+			if (lines.size() == oldLines.size())
+			{
+				Old::INILINELIST::const_iterator j = oldLines.begin();
+				for (INILINELIST::const_iterator i = lines.begin(); i != lines.end(); i++, j++)
+				{
+					CHECK((*i).sKey == (*j).sKey);
+					CHECK((*i).sValue == (*j).sValue);
+				}
+			}
+
+			TCHARSTR2STR keys, oldKeys;
+			CHECK(file.GetKeys(lpName, keys, uFlags));
+			CHECK(old.GetKeys(lpName, oldKeys, uFlags));
+			CHECK(keys == oldKeys);
+
+			// (the old GetLines never returned when it ignored a comment)
+			if ((uFlags & FILEINI_IGNORE_COMMENTS) == 0)
+			{
+				TCHARSTRLIST list, oldList;
+				CHECK(file.GetLines(lpName, list, uFlags));
+				CHECK(old.GetLines(lpName, oldList, uFlags));
+				CHECK(list == oldList);
+			}
+		}
+	}
+}
+
+/**
+	@brief Compares a file in all its forms
+	@param sText The file's text
+	@param arNames Section names to ask for (besides the file's own)
+	@param bLatin true if the text can be an ANSI file
+*/
+static void CompareAllForms(const std::wstring& sText, const std::vector<std::wstring>& arNames, bool bLatin)
+{
+	CompareFile(sText, arNames, true, true);
+	CompareFile(sText, arNames, true, false);
+	if (bLatin)
+	{
+		CompareFile(sText, arNames, false, true);
+		CompareFile(sText, arNames, false, false);
+	}
+}
+
+/**
+	
+*/
+static void TestKnownFiles()
+{
+	std::vector<std::wstring> arNames;
+	arNames.push_back(L"Job");
+	arNames.push_back(L"JOB");
+	arNames.push_back(L"page 1");
+	arNames.push_back(L"Page 2");
+	arNames.push_back(L"Missing");
+	arNames.push_back(L"");
+
+	// A link file, as the add-in writes it
+	CompareAllForms(L"[Job]\r\nPageCount=2\r\n[Page 1]\r\nLinkCount=2\r\nURL1=http://a.b/c\r\nTitle1=A link\r\n"
+		L"Text1=click here\r\nRepeat1=1\r\nPage2=2\r\nOffsetX2=10\r\nOffsetY2=20\r\n[Page 2]\r\nLinkCount=0\r\n", arNames, true);
+
+	// Repeated and case varied sections, lines before the first section, comments, keys with no values
+	CompareAllForms(L"Orphan=1\n[Page 1]\nA=1\n// comment\n[PAGE 2]\nB = 2 \n[page 1]\nC\n=D\n[Job]\n\n\nE=F=G\n[Page 1]\r\n"
+		L"  H  =  I  \r\n\t//x\r\n", arNames, true);
+
+	// Headers with spaces around them, empty headers, and short lines
+	CompareAllForms(L"[Page 1]  \nA=1\n  [Page 2]\nB=2\n[Page 2]\t\nC=3\n[]\nD=4\n[ Job ]\nE=5\nx\n[\n]\n[Job]", arNames, true);
+
+	// Non-Latin text (only in Unicode files)
+	arNames.push_back(L"\x05D3\x05E3 1");
+	CompareAllForms(L"[\x05D3\x05E3 1]\r\nTitle1=\x05E9\x05DC\x05D5\x05DD\r\n[Page 1]\r\nURL1=http://\x00e9.fr/\r\n", arNames, false);
+
+	// A Unicode file with only the byte order mark, and an empty ANSI file
+	CompareFile(L"", arNames, true, false);
+	CompareFile(L"", arNames, false, true);
+}
+
+/**
+	
+*/
+static void TestRandomFiles()
+{
+	static const wchar_t* s_pHeaders[] = {L"[Page 1]", L"[page 1]", L"[PAGE 1]", L"[Page 2]", L"[Job]", L"[job]", L"[]",
+		L" [Page 1]", L"[Page 1] ", L"[Job]\t", L"[Page\x00e9]", L"[PAGE\x00c9]"};
+	static const wchar_t* s_pLines[] = {L"Key=Value", L" Key = Value ", L"Key", L"=Value", L"// comment", L"//", L"a",
+		L"", L"   ", L"URL1=http://x/\x00e9", L"Text1=a=b", L"\tTitle1\t=\tT\t", L"LinkCount=3"};
+	static const wchar_t* s_pEnds[] = {L"\r\n", L"\n", L"\r", L"\n\n"};
+	std::vector<std::wstring> arNames;
+	arNames.push_back(L"Page 1");
+	arNames.push_back(L"Job");
+	arNames.push_back(L"Page\x00e9");
+
+	srand(7);
+	for (int nIteration = 0; nIteration < 400; nIteration++)
+	{
+		std::wstring sText;
+		int nLines = rand() % 30;
+		for (int nLine = 0; nLine < nLines; nLine++)
+		{
+			if (rand() % 4 == 0)
+				sText += s_pHeaders[rand() % COUNTOF(s_pHeaders)];
+			else
+				sText += s_pLines[rand() % COUNTOF(s_pLines)];
+			if ((nLine < nLines - 1) || (rand() % 2 == 0))
+				sText += s_pEnds[rand() % COUNTOF(s_pEnds)];
+		}
+		CompareAllForms(sText, arNames, true);
+	}
+}
+
+/**
+	
+*/
+int main()
+{
+	TestKnownFiles();
+	TestRandomFiles();
+	return TestResult("FileINITest");
+}
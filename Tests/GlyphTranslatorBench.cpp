@@ -0,0 +1,172 @@
+/**
+	@file
+	@brief Micro-benchmark of glyph-to-Unicode translation (GlyphToText), against the old std::map lookup
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "GlyphTranslator.h"
+#include "Reference/OldGlyphTranslator.h"
+#include "TestUtil.h"
+#include "TestFonts.h"
+
+TEST_GLOBALS
+
+/// Amount of glyph strings translated in each round
+#define BENCH_STRINGS	100000
+/// Average glyphs in a string
+#define BENCH_LENGTH	40
+
+/**
+	@brief Measures building a font's table and translating strings in it
+	@param lpFace The font's face name
+	@param arChars The characters the strings are made of
+*/
+static void BenchFont(const wchar_t* lpFace, const std::vector<WCHAR>& arChars)
+{
+	char cName[64];
+	LOGFONT lf;
+	TestFonts::MakeFont(lf, lpFace);
+	HDC hDC = ::GetDC(NULL);
+
+	// Building the tables (the shim's GDI calls are cheap, unlike the real ones: see the call counts)
+	size_t nCalls = GetShimGlyphCalls();
+	BenchTimer timer;
+	Old::GlyphToText map;
+	map.Initialize(lf, hDC);
+	sprintf(cName, "build map, %ls (%d calls)", lpFace, (int)(GetShimGlyphCalls() - nCalls));
+	BenchReport(cName, timer.Elapsed(), (double)map.size() / 1e6, "M glyphs");
+	nCalls = GetShimGlyphCalls();
+	timer.Restart();
+	GlyphToText table;
+	table.Initialize(lf, hDC);
+	sprintf(cName, "build table, %ls (%d calls)", lpFace, (int)(GetShimGlyphCalls() - nCalls));
+	BenchReport(cName, timer.Elapsed(), (double)map.size() / 1e6, "M glyphs");
+	::ReleaseDC(NULL, hDC);
+
+	// The strings, as glyph indices
+	srand(5);
+	std::vector<WCHAR> arGlyphs;
+	std::vector<size_t> arLengths;
+	for (int i = 0; i < BENCH_STRINGS; i++)
+	{
+		arLengths.push_back(1 + rand() % (2 * BENCH_LENGTH));
+		for (size_t j = 0; j < arLengths.back(); j++)
+			arGlyphs.push_back(TestFonts::GlyphOf(lpFace, arChars[rand() % arChars.size()]));
+	}
+	double dGlyphs = (double)arGlyphs.size() / 1e6;
+
+	// Old: a map lookup for each glyph, appended to the string
+	double dBest = 0;
+	size_t nCheck = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		timer.Restart();
+		const WCHAR* pGlyphs = &arGlyphs[0];
+		for (size_t i = 0; i < arLengths.size(); i++)
+		{
+			std::wstring sText;
+			for (size_t j = 0; j < arLengths[i]; j++)
+			{
+				Old::GlyphToText::const_iterator iChar = map.find(pGlyphs[j]);
+				if (iChar != map.end())
+					sText += (*iChar).second;
+				else
+					sText += (WCHAR)0x7F;
+			}
+			nCheck += sText.size();
+			pGlyphs += arLengths[i];
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "map lookup, %ls", lpFace);
+	BenchReport(cName, dBest, dGlyphs, "M glyphs");
+
+	// New: a table lookup for each glyph
+	std::vector<WCHAR> arText(2 * BENCH_LENGTH);
+	dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		timer.Restart();
+		const WCHAR* pGlyphs = &arGlyphs[0];
+		for (size_t i = 0; i < arLengths.size(); i++)
+		{
+			for (size_t j = 0; j < arLengths[i]; j++)
+				arText[j] = table.Translate(pGlyphs[j]);
+			nCheck += arText[0];
+			pGlyphs += arLengths[i];
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "table lookup, %ls", lpFace);
+	BenchReport(cName, dBest, dGlyphs, "M glyphs");
+
+	// New: a whole string at a time
+	dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		timer.Restart();
+		const WCHAR* pGlyphs = &arGlyphs[0];
+		for (size_t i = 0; i < arLengths.size(); i++)
+		{
+			table.Translate(pGlyphs, arLengths[i], &arText[0]);
+			nCheck += arText[0];
+			pGlyphs += arLengths[i];
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "table bulk, %ls", lpFace);
+	BenchReport(cName, dBest, dGlyphs, "M glyphs");
+
+	// (keeps the compiler from skipping the work)
+	if (nCheck == 0)
+		printf("no text\n");
+}
+
+/**
+	
+*/
+int main()
+{
+	TestFonts fonts;
+	SetShimFonts(&fonts);
+
+	// Western text: ASCII letters and a few accented ones
+	std::vector<WCHAR> arChars;
+	for (WCHAR w = 'a'; w <= 'z'; w++)
+		arChars.insert(arChars.end(), 4, w);
+	for (WCHAR w = 0xE0; w <= 0xFF; w++)
+		arChars.push_back(w);
+	arChars.insert(arChars.end(), 20, (WCHAR)' ');
+	BenchFont(TESTFONT_TEXT, arChars);
+
+	// CJK text: common ideographs all over the range
+	arChars.clear();
+	for (WCHAR w = 0x4E01; w < 0x9FA0; w += 7)
+		arChars.push_back(w);
+	BenchFont(TESTFONT_WIDE, arChars);
+
+	SetShimFonts(NULL);
+	return 0;
+}
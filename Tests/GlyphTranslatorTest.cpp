@@ -0,0 +1,306 @@
+/**
+	@file
+	@brief Tests for the glyph-to-Unicode tables (GlyphToText) against the old std::map lookup
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "GlyphTranslator.h"
+#include "GlyphCache.h"
+#include "GlyphDiskCache.h"
+#include "Reference/OldGlyphTranslator.h"
+#include "TestUtil.h"
+#include "TestFonts.h"
+
+TEST_GLOBALS
+
+/**
+	@brief Translates a glyph the way the plugin did with the old map
+	@param map The old map
+	@param wGlyph The glyph
+	@return The character (GLYPH_UNKNOWN if not known)
+*/
+static WCHAR OldTranslate(const Old::GlyphToText& map, WORD wGlyph)
+{
+	Old::GlyphToText::const_iterator iChar = map.find(wGlyph);
+	return (iChar != map.end()) ? (*iChar).second : GLYPH_UNKNOWN;
+}
+
+/**
+	@brief Builds a font's table both ways and compares them
+	@param lpFace The font's face name
+	@param nRanges Amount of character ranges in the font
+*/
+static void TestFont(const wchar_t* lpFace, size_t nRanges)
+{
+	LOGFONT lf;
+	TestFonts::MakeFont(lf, lpFace);
+	HDC hDC = ::GetDC(NULL);
+
+	Old::GlyphToText map;
+	CHECK(map.Initialize(lf, hDC));
+	GlyphToText table;
+	size_t nCalls = GetShimGlyphCalls();
+	CHECK(table.Initialize(lf, hDC));
+	// One GetGlyphIndices call for each range
+	CHECK_EQUAL(GetShimGlyphCalls() - nCalls, nRanges);
+	::ReleaseDC(NULL, hDC);
+
+	// Every glyph translates the same (the old map also had an entry for 0xFFFF, the "no glyph" mark
+	// of GetGlyphIndices, which is never a real glyph)
+	int nDifferent = 0, nKnown = 0;
+	for (DWORD dwGlyph = 0; dwGlyph < 0xFFFF; dwGlyph++)
+	{
+		WCHAR wExpected = OldTranslate(map, (WORD)dwGlyph);
+		if (table.Translate((WORD)dwGlyph) != wExpected)
+			nDifferent++;
+		if (wExpected != GLYPH_UNKNOWN)
+			nKnown++;
+	}
+	CHECK_EQUAL(nDifferent, 0);
+	CHECK_EQUAL(table.Translate(0xFFFF), GLYPH_UNKNOWN);
+
+	// And strings, at all lengths and alignments, with known and unknown glyphs
+	srand(11);
+	std::vector<WCHAR> arGlyphs(300), arText(300);
+	nDifferent = 0;
+	for (int nIteration = 0; nIteration < 2000; nIteration++)
+	{
+		size_t nStart = rand() % 8, nCount = rand() % 200;
+		for (size_t i = 0; i < nStart + nCount; i++)
+			arGlyphs[i] = (WCHAR)((rand() % 4 == 0) ? rand() % 0xFFFF : TestFonts::GlyphOf(lpFace, (WCHAR)(0x20 + rand() % 0x5F)));
+		std::fill(arText.begin(), arText.end(), (WCHAR)0);
+		table.Translate(&arGlyphs[nStart], nCount, &arText[nStart]);
+		for (size_t i = nStart; i < nStart + nCount; i++)
+			if (arText[i] != OldTranslate(map, (WORD)arGlyphs[i]))
+				nDifferent++;
+		// Nothing written outside the string
+		for (size_t i = 0; i < nStart; i++)
+			if (arText[i] != 0)
+				nDifferent++;
+		if (arText[nStart + nCount] != 0)
+			nDifferent++;
+	}
+	CHECK_EQUAL(nDifferent, 0);
+
+	// A table attached to another one's data translates the same
+	GlyphToText attached;
+	CHECK(attached.Attach(table.GetIndex(), table.GetPages(), table.GetPageCount()));
+	nDifferent = 0;
+	for (DWORD dwGlyph = 0; dwGlyph <= 0xFFFF; dwGlyph++)
+		if (attached.Translate((WORD)dwGlyph) != table.Translate((WORD)dwGlyph))
+			nDifferent++;
+	CHECK_EQUAL(nDifferent, 0);
+}
+
+/**
+	
+*/
+static void TestAttach()
+{
+	// Bad data is not attached
+	std::vector<WORD> arIndex(256, 0);
+	std::vector<WCHAR> arPages(2 * 256, GLYPH_UNKNOWN);
+	arPages[256 + 0x41] = 'A';
+	GlyphToText table;
+	CHECK(!table.Attach(&arIndex[0], &arPages[0], 0));
+	arIndex[1] = 2;
+	CHECK(!table.Attach(&arIndex[0], &arPages[0], 2));
+	CHECK_EQUAL(table.Translate(0x141), GLYPH_UNKNOWN);
+	arIndex[1] = 1;
+	CHECK(table.Attach(&arIndex[0], &arPages[0], 2));
+	CHECK_EQUAL(table.Translate(0x141), (WCHAR)'A');
+	CHECK_EQUAL(table.Translate(0x41), GLYPH_UNKNOWN);
+	CHECK_EQUAL(table.Translate(0x241), GLYPH_UNKNOWN);
+}
+
+/**
+	
+*/
+static void TestTranslator()
+{
+	// Tables come from the process-wide cache, once per font
+	LOGFONT lf;
+	TestFonts::MakeFont(lf, TESTFONT_TEXT);
+	GlyphTranslator translator;
+	const GlyphToText* pTable = translator.GetFontTranslation(lf);
+	CHECK(pTable != NULL);
+	lf.lfHeight *= 2;
+	CHECK(translator.GetFontTranslation(lf) == pTable);
+	CHECK_EQUAL(translator.GetFontCount(), (size_t)1);
+	lf.lfWeight = 700;
+	CHECK(translator.GetFontTranslation(lf) != pTable);
+	CHECK_EQUAL(translator.GetFontCount(), (size_t)2);
+
+	// A font without characters has a table, but nothing is known
+	TestFonts::MakeFont(lf, L"No Such Font");
+	pTable = translator.GetFontTranslation(lf);
+	CHECK((pTable != NULL) && (pTable->Translate(0x41) == GLYPH_UNKNOWN));
+}
+
+/**
+	@return Amount of cache files
+*/
+static int CountCacheFiles()
+{
+	TCHAR cPath[MAX_PATH];
+	::GetTempPath(MAX_PATH, cPath);
+	_tcscat_s(cPath, MAX_PATH, _T("CCGlyphMaps.*.dat"));
+	WIN32_FIND_DATA data;
+	HANDLE hFind = ::FindFirstFile(cPath, &data);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return 0;
+	int nCount = 0;
+	do
+		nCount++;
+	while (::FindNextFile(hFind, &data));
+	::FindClose(hFind);
+	return nCount;
+}
+
+/**
+	@param disk The disk cache to search
+	@param lf The font
+	@param print The fingerprint of the font
+	@param table The table expected
+	@return true if the font's table was found and translates like the expected one
+*/
+static bool FindSame(GlyphDiskCache& disk, const LOGFONT& lf, const FontPrint& print, const GlyphToText& table)
+{
+	GlyphToText found;
+	if (!disk.Find(FontKey(lf), print, found))
+		return false;
+	for (DWORD dwGlyph = 0; dwGlyph <= 0xFFFF; dwGlyph++)
+		if (found.Translate((WORD)dwGlyph) != table.Translate((WORD)dwGlyph))
+			return false;
+	return true;
+}
+
+/**
+	
+*/
+static void TestDiskCache()
+{
+	// Each disk cache plays a process
+	LOGFONT lfText, lfWide;
+	TestFonts::MakeFont(lfText, TESTFONT_TEXT);
+	TestFonts::MakeFont(lfWide, TESTFONT_WIDE);
+	GlyphToText text, wide;
+	CHECK(text.Initialize(lfText, ::GetDC(NULL)));
+	CHECK(wide.Initialize(lfWide, ::GetDC(NULL)));
+	FontPrint print = {1000, 0x12345678, {1, 2}}, changed = {1000, 0x12345679, {1, 2}};
+
+	{
+		// The first flush writes the file, and another process uses it
+		GlyphDiskCache writer;
+		writer.Store(FontKey(lfText), print, text);
+		CHECK(writer.Flush());
+		GlyphDiskCache reader;
+		CHECK(FindSame(reader, lfText, print, text));
+		CHECK(!FindSame(reader, lfWide, print, wide));
+
+		// The next flush can't replace the mapped file, but its tables are kept too
+		writer.Store(FontKey(lfWide), print, wide);
+		CHECK(writer.Flush());
+		GlyphDiskCache next;
+		CHECK(FindSame(next, lfText, print, text));
+		CHECK(FindSame(next, lfWide, print, wide));
+		// The first reader still has what it mapped
+		CHECK(FindSame(reader, lfText, print, text));
+		CHECK_EQUAL(CountCacheFiles(), 2);
+	}
+
+	// Once nobody maps them, the older files are deleted with the next flush
+	GlyphDiskCache writer;
+	writer.Store(FontKey(lfText), changed, text);
+	CHECK(writer.Flush());
+	CHECK_EQUAL(CountCacheFiles(), 1);
+	GlyphDiskCache reader;
+	CHECK(!FindSame(reader, lfText, print, text));
+	CHECK(FindSame(reader, lfText, changed, text));
+	CHECK(FindSame(reader, lfWide, print, wide));
+
+	// Nothing new, nothing written
+	CHECK(reader.Flush());
+	CHECK_EQUAL(CountCacheFiles(), 1);
+}
+
+/**
+	@brief Test fonts whose glyphs can be made unreadable
+*/
+class FailingFonts : public TestFonts
+{
+public:
+	/// Constructor
+	FailingFonts() : m_bFail(false) {};
+
+	/// true to make GetGlyphIndices fail
+	bool			m_bFail;
+
+	virtual bool	CanReadGlyphs(const LOGFONT& lf) {return !m_bFail;};
+};
+
+/**
+	@param fonts The fonts in use
+*/
+static void TestFailure(FailingFonts& fonts)
+{
+	// A font that cannot be translated now has no table...
+	LOGFONT lf;
+	TestFonts::MakeFont(lf, TESTFONT_TEXT);
+	lf.lfWeight = 300;
+	fonts.m_bFail = true;
+	GlyphTranslator translator;
+	size_t nCalls = GetShimGlyphCalls();
+	CHECK(translator.GetFontTranslation(lf) == NULL);
+	CHECK_EQUAL(translator.GetFontCount(), (size_t)0);
+	// ...and each lookup tries again
+	CHECK(translator.GetFontTranslation(lf) == NULL);
+	CHECK(GetShimGlyphCalls() > nCalls + 1);
+
+	// Until it works
+	fonts.m_bFail = false;
+	const GlyphToText* pTable = translator.GetFontTranslation(lf);
+	CHECK((pTable != NULL) && (pTable->Translate(TestFonts::GlyphOf(TESTFONT_TEXT, 'A')) == (WCHAR)'A'));
+	CHECK_EQUAL(translator.GetFontCount(), (size_t)1);
+	GlyphTranslator other;
+	CHECK(other.GetFontTranslation(lf) == pTable);
+}
+
+/**
+	
+*/
+int main()
+{
+	FailingFonts fonts;
+	SetShimFonts(&fonts);
+	TestFont(TESTFONT_TEXT, 4);
+	TestFont(TESTFONT_WIDE, 3);
+	TestAttach();
+	TestTranslator();
+	TestFailure(fonts);
+	TestDiskCache();
+	SetShimFonts(NULL);
+	return TestResult("GlyphTranslatorTest");
+}
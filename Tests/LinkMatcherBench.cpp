@@ -0,0 +1,169 @@
+/**
+	@file
+	@brief Benchmark of the text link search (LinkMatcher) on a page with 1000 links, against the old per-link search
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "LinkMatcher.h"
+#include "Reference/OldTextPart.h"
+#include "TestUtil.h"
+#include "TestPage.h"
+
+TEST_GLOBALS
+
+/// Number of text lines in the page
+#define PAGE_LINES		80
+/// Number of words in each line
+#define LINE_WORDS		16
+/// Number of links in the page
+#define PAGE_LINKS		1000
+
+/**
+	@brief Creates a random 5 letter word
+	@return The word
+*/
+static std::wstring RandomWord()
+{
+	std::wstring s(5, ' ');
+	for (size_t i = 0; i < s.size(); i++)
+		s[i] = (wchar_t)('a' + rand() % 26);
+	return s;
+}
+
+/**
+	@brief Creates the page, each line printed in two strings, and links to words in it
+	@param page The page to fill
+	@param links The links to fill (text and repeat count)
+*/
+static void MakePage(TestPage& page, std::vector<std::pair<std::wstring, int> >& links)
+{
+	srand(1);
+	std::vector<std::vector<std::wstring> > lines(PAGE_LINES);
+	for (int nLine = 0; nLine < PAGE_LINES; nLine++)
+	{
+		std::wstring sText;
+		LONG x = 0;
+		for (int nWord = 0; nWord < LINE_WORDS; nWord++)
+		{
+			lines[nLine].push_back(RandomWord());
+			sText += lines[nLine].back() + L" ";
+			if (nWord == LINE_WORDS / 2 - 1)
+			{
+				x = page.AddRun(sText, 50, nLine * 25, true);
+				sText.erase();
+			}
+		}
+		page.AddRun(sText, x, nLine * 25, true);
+	}
+
+	// Links of 1 to 3 words of a line
+	for (int nLink = 0; nLink < PAGE_LINKS; nLink++)
+	{
+		const std::vector<std::wstring>& line = lines[rand() % PAGE_LINES];
+		int nWords = 1 + rand() % 3, nFirst = rand() % (LINE_WORDS - nWords + 1);
+		std::wstring sText = line[nFirst];
+		for (int i = 1; i < nWords; i++)
+			sText += L" " + line[nFirst + i];
+		links.push_back(std::make_pair(sText, 1));
+	}
+}
+
+/**
+	
+*/
+int main()
+{
+	TestPage page;
+	std::vector<std::pair<std::wstring, int> > links;
+	MakePage(page, links);
+	char cName[64];
+	size_t nFound;
+
+	// Old: the page text in lists, searched again for each link
+	double dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		Old::TextArea text;
+		for (size_t i = 0; i < page.GetRunCount(); i++)
+			text.AddLine(Old::TextLine(page.GetRun(i).sText, page.GetRun(i).rc, const_cast<PGLYPHPOS>(page.GetGlyphs(i)), page.GetWidths(i)));
+		nFound = 0;
+		for (size_t nLink = 0; nLink < links.size(); nLink++)
+		{
+			Old::STRLIST words;
+			const std::wstring& sText = links[nLink].first;
+			std::wstring::size_type pos = 0, end;
+			while ((end = sText.find(' ', pos)) != std::wstring::npos)
+			{
+				words.push_back(sText.substr(pos, end - pos));
+				pos = end + 1;
+			}
+			words.push_back(sText.substr(pos));
+			text.InitSearch();
+			RECTL rc;
+			if (text.SearchFor(words, rc, links[nLink].second))
+				nFound++;
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "old SearchFor per link (%d found)", (int)nFound);
+	BenchReport(cName, dBest, 1, "pages");
+
+	// New: the captured page searched once for all the links
+	LinkMatcher matcher;
+	for (size_t nLink = 0; nLink < links.size(); nLink++)
+		matcher.AddLink(links[nLink].first, links[nLink].second, nLink);
+	TextArea text;
+	LinkMatcher::MATCHES matches;
+	dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		text.Reset();
+		for (size_t i = 0; i < page.GetRunCount(); i++)
+			text.AddRun(page.GetRun(i).sText.data(), page.GetRun(i).sText.size(), page.GetRun(i).rc, page.GetGlyphs(i), page.GetWidths(i));
+		text.Finalize();
+		matches.clear();
+		matcher.Search(text, matches);
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "LinkMatcher Search (%d found)", (int)matches.size());
+	BenchReport(cName, dBest, 1, "pages");
+
+	// New: the links searched while the page is printed, without keeping its text
+	dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		matcher.Start();
+		for (size_t i = 0; i < page.GetRunCount(); i++)
+			matcher.Feed(page.GetRun(i).sText.data(), page.GetRun(i).sText.size(), page.GetRun(i).rc, page.GetGlyphs(i), page.GetWidths(i));
+		nFound = matcher.Finish().size();
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "LinkMatcher Feed (%d found)", (int)nFound);
+	BenchReport(cName, dBest, 1, "pages");
+	return 0;
+}
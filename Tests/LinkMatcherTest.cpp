@@ -0,0 +1,415 @@
+/**
+	@file
+	@brief Tests for the text link search (LinkMatcher): Search and Feed/Finish against the old TextArea::SearchFor
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "LinkMatcher.h"
+#include "Reference/OldTextPart.h"
+#include "TestUtil.h"
+#include "TestPage.h"
+
+TEST_GLOBALS
+
+/**
+	@brief Checks if two rectangles are the same
+	@param rc1 The first rectangle
+	@param rc2 The second rectangle
+	@return true if they're equal
+*/
+static bool SameRect(const RECTL& rc1, const RECTL& rc2)
+{
+	return (rc1.left == rc2.left) && (rc1.top == rc2.top) && (rc1.right == rc2.right) && (rc1.bottom == rc2.bottom);
+}
+
+/**
+	@brief Sort order of matches: document order (line, then left to right), then link number
+*/
+static bool MatchLess(const LinkMatcher::Match& match1, const LinkMatcher::Match& match2)
+{
+	if (match1.rcArea.top != match2.rcArea.top)
+		return match1.rcArea.top < match2.rcArea.top;
+	if (match1.rcArea.left != match2.rcArea.left)
+		return match1.rcArea.left < match2.rcArea.left;
+	return match1.nLink < match2.nLink;
+}
+
+/**
+	@brief Searches for the links the way the plugin did before LinkMatcher: each link on its own,
+			with a forward search from the page start
+	@param page The page
+	@param links The links (text and repeat count)
+	@return The found links
+*/
+static LinkMatcher::MATCHES OldSearch(const TestPage& page, const std::vector<std::pair<std::wstring, int> >& links)
+{
+	Old::TextArea text;
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+	{
+		const TestPage::Run& run = page.GetRun(i);
+		text.AddLine(Old::TextLine(run.sText, run.rc, const_cast<PGLYPHPOS>(page.GetGlyphs(i)), page.GetWidths(i)));
+	}
+
+	LinkMatcher::MATCHES matches;
+	for (size_t nLink = 0; nLink < links.size(); nLink++)
+	{
+		// Break the text into words
+		const std::wstring& sText = links[nLink].first;
+		Old::STRLIST words;
+		std::wstring::size_type pos = sText.find(' '), oldpos = 0;
+		while ((oldpos < sText.size()) && (pos != std::wstring::npos))
+		{
+			if (pos > oldpos)
+				words.push_back(sText.substr(oldpos, pos - oldpos));
+			oldpos = pos + 1;
+			pos = sText.find(' ', oldpos);
+		}
+		if (oldpos < sText.size())
+			words.push_back(sText.substr(oldpos));
+
+		text.InitSearch();
+		LinkMatcher::Match match;
+		if (text.SearchFor(words, match.rcArea, links[nLink].second))
+		{
+			match.nLink = nLink;
+			matches.push_back(match);
+		}
+	}
+	std::sort(matches.begin(), matches.end(), MatchLess);
+	return matches;
+}
+
+/**
+	@brief Searches a page with both LinkMatcher methods and compares them with the old search
+	@param page The page
+	@param links The links (text and repeat count)
+	@return Number of links found
+*/
+static size_t CompareSearches(const TestPage& page, const std::vector<std::pair<std::wstring, int> >& links)
+{
+	LinkMatcher matcherSearch, matcherFeed;
+	for (size_t i = 0; i < links.size(); i++)
+	{
+		matcherSearch.AddLink(links[i].first, links[i].second, i);
+		matcherFeed.AddLink(links[i].first, links[i].second, i);
+	}
+
+	// Whole page search, and streaming search while the page is "printed"
+	TextArea text;
+	matcherFeed.Start();
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+	{
+		const TestPage::Run& run = page.GetRun(i);
+		text.AddRun(run.sText.data(), run.sText.size(), run.rc, page.GetGlyphs(i), page.GetWidths(i));
+		matcherFeed.Feed(run.sText.data(), run.sText.size(), run.rc, page.GetGlyphs(i), page.GetWidths(i));
+	}
+	text.Finalize();
+	LinkMatcher::MATCHES searched, fed = matcherFeed.Finish();
+	matcherSearch.Search(text, searched);
+
+	// Both come in document order (by line; links that overlap in a line may come in a different order)
+	for (size_t i = 1; i < searched.size(); i++)
+		CHECK(searched[i - 1].rcArea.top <= searched[i].rcArea.top);
+	for (size_t i = 1; i < fed.size(); i++)
+		CHECK(fed[i - 1].rcArea.top <= fed[i].rcArea.top);
+
+	// Same links in the same places as the old search
+	LinkMatcher::MATCHES expected = OldSearch(page, links);
+	std::sort(searched.begin(), searched.end(), MatchLess);
+	std::sort(fed.begin(), fed.end(), MatchLess);
+	CHECK_EQUAL(searched.size(), expected.size());
+	CHECK_EQUAL(fed.size(), expected.size());
+	if ((searched.size() == expected.size()) && (fed.size() == expected.size()))
+	{
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			CHECK_EQUAL(searched[i].nLink, expected[i].nLink);
+			CHECK(SameRect(searched[i].rcArea, expected[i].rcArea));
+			CHECK_EQUAL(fed[i].nLink, expected[i].nLink);
+			CHECK(SameRect(fed[i].rcArea, expected[i].rcArea));
+		}
+	}
+	return expected.size();
+}
+
+/**
+	@brief Finds a single link in a page with both methods
+	@param page The page
+	@param sLink The link text
+	@param nRepeat The repeat count
+	@param[out] rc The found location
+	@return true if found (by both methods at the same place)
+*/
+static bool FindOne(const TestPage& page, const wchar_t* sLink, int nRepeat, RECTL& rc)
+{
+	std::vector<std::pair<std::wstring, int> > links;
+	links.push_back(std::make_pair(std::wstring(sLink), nRepeat));
+	if (CompareSearches(page, links) != 1)
+		return false;
+	LinkMatcher matcher;
+	matcher.AddLink(sLink, nRepeat, 0);
+	TextArea text;
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+		text.AddRun(page.GetRun(i).sText.data(), page.GetRun(i).sText.size(), page.GetRun(i).rc, page.GetGlyphs(i), page.GetWidths(i));
+	text.Finalize();
+	LinkMatcher::MATCHES matches;
+	matcher.Search(text, matches);
+	rc = matches[0].rcArea;
+	return true;
+}
+
+/**
+	
+*/
+static void TestKnownCases()
+{
+	// Letters are 10 wide in these pages
+	TestPage page;
+	page.AddRun(L"a wand the sword and the end", 0, 0);
+	page.AddRun(L"more text here", 0, 30);
+	RECTL rc;
+
+	// Partial first word: "and" ends "wand"
+	CHECK(FindOne(page, L"and the", 1, rc));
+	CHECK_EQUAL(rc.left, 30);
+	CHECK_EQUAL(rc.right, 100);
+	// Repeat count: the second appearance
+	CHECK(FindOne(page, L"and the", 2, rc));
+	CHECK_EQUAL(rc.left, 170);
+	CHECK_EQUAL(rc.right, 240);
+	// Partial last word: "swo" starts "sword" (and the link covers all of it)
+	CHECK(FindOne(page, L"the swo", 1, rc));
+	CHECK_EQUAL(rc.left, 70);
+	CHECK_EQUAL(rc.right, 160);
+	CHECK_EQUAL(rc.top, 0);
+	CHECK_EQUAL(rc.bottom, 20);
+	// Not across lines
+	std::vector<std::pair<std::wstring, int> > links;
+	links.push_back(std::make_pair(std::wstring(L"and more"), 1));
+	CHECK_EQUAL(CompareSearches(page, links), (size_t)0);
+	// Not found enough times
+	links[0] = std::make_pair(std::wstring(L"the"), 3);
+	CHECK_EQUAL(CompareSearches(page, links), (size_t)0);
+
+	// A link printed in several strings of the same line, with a word split between two of them
+	TestPage split;
+	split.AddRun(L"visit our hom", 0, 0);
+	split.AddRun(L"epage now", 130, 0);
+	split.AddRun(L"please", 240, 0);
+	CHECK(FindOne(split, L"our homepage now please", 1, rc));
+	CHECK_EQUAL(rc.left, 60);
+	CHECK_EQUAL(rc.right, 300);
+}
+
+/**
+	
+*/
+static void TestRandomPages()
+{
+	// Page words, and link words that don't run into the old search's quirks (see Reference/OldTextPart.cpp: the
+	// first word must appear once in a page word, and not be longer than the shortest page word)
+	static const wchar_t* s_pPage[] = {L"foo", L"bar", L"foobar", L"baz", L"bazfoo", L"www", L"barfoo", L"and"};
+	static const wchar_t* s_pFirst[] = {L"foo", L"bar", L"baz", L"oo", L"ar", L"az", L"and", L"nd"};
+	static const wchar_t* s_pLast[] = {L"fo", L"foo", L"ba", L"bar", L"baz", L"www", L"w", L"an"};
+	const size_t nPage = sizeof(s_pPage) / sizeof(s_pPage[0]);
+
+	srand(3);
+	size_t nFound = 0;
+	for (int nIteration = 0; nIteration < 3000; nIteration++)
+	{
+		// Lines of words, printed left to right in a few strings: a string that starts or ends with a space
+		// leaves a gap, while one that splits a word touches the next one (so the words are always page words)
+		TestPage page;
+		int nLines = 1 + rand() % 5;
+		for (int nLine = 0; nLine < nLines; nLine++)
+		{
+			std::wstring sLine;
+			if (rand() % 3 == 0)
+				sLine = L" ";
+			int nWords = 1 + rand() % 12;
+			for (int nWord = 0; nWord < nWords; nWord++)
+			{
+				if (nWord > 0)
+					sLine += L' ';
+				sLine += s_pPage[rand() % nPage];
+			}
+
+			LONG x = 15;
+			size_t nStart = 0;
+			while (nStart < sLine.size())
+			{
+				size_t nEnd = min(sLine.size(), nStart + 1 + rand() % 20);
+				bool bGap = (sLine[nEnd - 1] == ' ') || ((nEnd < sLine.size()) && (sLine[nEnd] == ' '));
+				x = page.AddRun(sLine.substr(nStart, nEnd - nStart), x, nLine * 30, true) + (bGap ? 15 : 0);
+				nStart = nEnd;
+			}
+		}
+
+		// Links of up to three words
+		std::vector<std::pair<std::wstring, int> > links;
+		int nLinks = 1 + rand() % 6;
+		for (int nLink = 0; nLink < nLinks; nLink++)
+		{
+			std::wstring s = s_pFirst[rand() % 8];
+			int nWords = 1 + rand() % 3;
+			for (int nWord = 1; nWord < nWords; nWord++)
+			{
+				s += L' ';
+				s += (nWord == nWords - 1) ? s_pLast[rand() % 8] : s_pPage[rand() % nPage];
+			}
+			links.push_back(std::make_pair(s, 1 + rand() % 3));
+		}
+		nFound += CompareSearches(page, links);
+	}
+	// Make sure the pages actually had links in them
+	CHECK(nFound > 1000);
+}
+
+/**
+	@brief Searches a page with Feed/Finish, printing its strings in the specified order
+	@param page The page
+	@param arOrder The order to print the strings in
+	@param links The links (text and repeat count)
+	@return The found links
+*/
+static LinkMatcher::MATCHES FeedPage(const TestPage& page, const std::vector<size_t>& arOrder, const std::vector<std::pair<std::wstring, int> >& links)
+{
+	LinkMatcher matcher;
+	for (size_t i = 0; i < links.size(); i++)
+		matcher.AddLink(links[i].first, links[i].second, i);
+	matcher.Start();
+	for (size_t i = 0; i < arOrder.size(); i++)
+	{
+		const TestPage::Run& run = page.GetRun(arOrder[i]);
+		matcher.Feed(run.sText.data(), run.sText.size(), run.rc, page.GetGlyphs(arOrder[i]), page.GetWidths(arOrder[i]));
+	}
+	return matcher.Finish();
+}
+
+/**
+	
+*/
+static void TestOutOfOrder()
+{
+	// A sheet printed column by column: each link is split between two cells of its row
+	TestPage page;
+	for (int nRow = 0; nRow < 3; nRow++)
+		page.AddRun(L"see our", 0, nRow * 30);
+	for (int nRow = 0; nRow < 3; nRow++)
+		page.AddRun(L"homepage now", 90, nRow * 30);
+	std::vector<size_t> arOrder;
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+		arOrder.push_back(i);
+	std::vector<std::pair<std::wstring, int> > links;
+	links.push_back(std::make_pair(std::wstring(L"our homepage"), 2));
+	links.push_back(std::make_pair(std::wstring(L"ee our home"), 3));
+	LinkMatcher::MATCHES matches = FeedPage(page, arOrder, links);
+	CHECK_EQUAL(matches.size(), (size_t)2);
+	if (matches.size() == 2)
+	{
+		// The second row's, then the third row's
+		CHECK_EQUAL(matches[0].nLink, (size_t)0);
+		CHECK_EQUAL(matches[0].rcArea.left, 40);
+		CHECK_EQUAL(matches[0].rcArea.right, 170);
+		CHECK_EQUAL(matches[0].rcArea.top, 30);
+		CHECK_EQUAL(matches[1].nLink, (size_t)1);
+		CHECK_EQUAL(matches[1].rcArea.left, 10);
+		CHECK_EQUAL(matches[1].rcArea.top, 60);
+	}
+
+	// A line printed right to left, with a word split between its strings
+	TestPage reversed;
+	reversed.AddRun(L"page now", 130, 0);
+	reversed.AddRun(L"visit our home", 0, 0);
+	arOrder.assign(1, 0);
+	arOrder.push_back(1);
+	links.assign(1, std::make_pair(std::wstring(L"our homepage now"), 1));
+	matches = FeedPage(reversed, arOrder, links);
+	CHECK_EQUAL(matches.size(), (size_t)1);
+	CHECK((matches.size() == 1) && (matches[0].rcArea.left == 60) && (matches[0].rcArea.right == 210));
+
+	// Random pages printed in random order find what a search of their merged lines finds
+	static const wchar_t* s_pWords[] = {L"foo", L"bar", L"foobar", L"baz", L"and"};
+	srand(7);
+	size_t nFound = 0;
+	for (int nIteration = 0; nIteration < 500; nIteration++)
+	{
+		// Cells of a few words, apart from each other
+		TestPage shuffled;
+		int nRows = 1 + rand() % 8, nColumns = 1 + rand() % 5;
+		for (int nRow = 0; nRow < nRows; nRow++)
+		{
+			for (int nColumn = 0; nColumn < nColumns; nColumn++)
+			{
+				std::wstring sCell = s_pWords[rand() % 5];
+				for (int nWord = rand() % 3; nWord > 0; nWord--)
+					sCell += std::wstring(L" ") + s_pWords[rand() % 5];
+				shuffled.AddRun(sCell, nColumn * 300, nRow * 30 + rand() % 3, true);
+			}
+		}
+		arOrder.clear();
+		for (size_t i = 0; i < shuffled.GetRunCount(); i++)
+			arOrder.push_back(i);
+		for (size_t i = arOrder.size(); i > 1; i--)
+			std::swap(arOrder[i - 1], arOrder[rand() % i]);
+
+		links.clear();
+		for (int nLink = 1 + rand() % 4; nLink > 0; nLink--)
+			links.push_back(std::make_pair(std::wstring(s_pWords[rand() % 5]) + L" " + s_pWords[rand() % 5], 1 + rand() % 2));
+
+		// Compare with a search of the text captured in the same order
+		LinkMatcher matcher;
+		TextArea text;
+		for (size_t i = 0; i < links.size(); i++)
+			matcher.AddLink(links[i].first, links[i].second, i);
+		for (size_t i = 0; i < arOrder.size(); i++)
+		{
+			const TestPage::Run& run = shuffled.GetRun(arOrder[i]);
+			text.AddRun(run.sText.data(), run.sText.size(), run.rc, shuffled.GetGlyphs(arOrder[i]), shuffled.GetWidths(arOrder[i]));
+		}
+		text.Finalize();
+		LinkMatcher::MATCHES searched, fed = FeedPage(shuffled, arOrder, links);
+		matcher.Search(text, searched);
+		CHECK_EQUAL(fed.size(), searched.size());
+		// (the height can differ when the page is in order: the streamed area covers the link's strings, not the whole line)
+		bool bSame = fed.size() == searched.size();
+		for (size_t i = 0; bSame && (i < fed.size()); i++)
+			bSame = (fed[i].nLink == searched[i].nLink) && (fed[i].rcArea.left == searched[i].rcArea.left) && (fed[i].rcArea.right == searched[i].rcArea.right);
+		CHECK(bSame);
+		nFound += fed.size();
+	}
+	CHECK(nFound > 200);
+}
+
+/**
+	
+*/
+int main()
+{
+	TestKnownCases();
+	TestRandomPages();
+	TestOutOfOrder();
+	return TestResult("LinkMatcherTest");
+}
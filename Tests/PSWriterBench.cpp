@@ -0,0 +1,201 @@
+/**
+	@file
+	@brief Throughput benchmark of the PostScript stream writer (PSWriter), against the code it replaced
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <PRCOMOEM.H>
+#include <vector>
+#include "PSWriter.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/**
+	@brief The text escaping of the plugin before PSWriter (appends to a NULL terminated buffer)
+	@param lpString The string to fill with the escaped text
+	@param lpText The original text
+	@param dwLen Length of original text
+*/
+static void OldAddPSText(char* lpString, const char* lpText, size_t dwLen)
+{
+	size_t nLoc = strlen(lpString);
+	for (size_t i = 0; i < dwLen; i++)
+	{
+		switch (lpText[i])
+		{
+			case '\n':
+			case '\r':
+			case '\t':
+			case '\b':
+			case '\f':
+			case '\\':
+			case '(':
+			case ')':
+				lpString[nLoc++] = '\\';
+				break;
+		}
+		lpString[nLoc++] = lpText[i];
+	}
+	lpString[nLoc] = '\0';
+}
+
+/**
+	@brief Creates benchmark text
+	@param nLen Length of the text
+	@param nSpecialEvery Put a character that needs escaping every this many characters
+	@return The text
+*/
+static std::string MakeText(size_t nLen, size_t nSpecialEvery)
+{
+	static const char cSpecial[] = "()\\\n";
+	std::string s(nLen, ' ');
+	for (size_t i = 0; i < nLen; i++)
+		s[i] = ((i % nSpecialEvery) == nSpecialEvery - 1) ? cSpecial[i % 4] : (char)('a' + (i * 7) % 26);
+	return s;
+}
+
+/**
+	@brief Measures escaping of text in pieces of a typical text output call size
+	@param lpName Name of the text kind
+	@param sText The text
+	@param nPiece Size of each piece
+*/
+static void BenchEscape(const char* lpName, const std::string& sText, size_t nPiece)
+{
+	std::string sTitle;
+
+	// Old: escape into a buffer, then copy to the output
+	{
+		std::vector<char> buffer(nPiece * 2 + 1);
+		std::string sOut;
+		double dBest = 0;
+		for (int r = 0; r < BENCH_ROUNDS; r++)
+		{
+			BenchTimer timer;
+			sOut.erase();
+			for (size_t i = 0; i < sText.size(); i += nPiece)
+			{
+				buffer[0] = '\0';
+				OldAddPSText(&buffer[0], sText.data() + i, min(nPiece, sText.size() - i));
+				sOut += &buffer[0];
+			}
+			dBest = BestTime(dBest, timer.Elapsed());
+		}
+		sTitle = std::string("escape old, ") + lpName;
+		BenchReport(sTitle.c_str(), dBest, (double)sText.size() / 1e6, "MB");
+	}
+
+	// New: escape straight into the writer
+	{
+		PSWriter ps;
+		double dBest = 0;
+		for (int r = 0; r < BENCH_ROUNDS; r++)
+		{
+			BenchTimer timer;
+			ps.Clear();
+			for (size_t i = 0; i < sText.size(); i += nPiece)
+				ps.AddEscaped(sText.data() + i, min(nPiece, sText.size() - i));
+			dBest = BestTime(dBest, timer.Elapsed());
+		}
+		sTitle = std::string("escape PSWriter, ") + lpName;
+		BenchReport(sTitle.c_str(), dBest, (double)sText.size() / 1e6, "MB");
+	}
+}
+
+/**
+	
+*/
+static void BenchHex()
+{
+	std::vector<BYTE> data(4 * 1024 * 1024);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (BYTE)(i * 31);
+
+	// Old: sprintf for each byte
+	{
+		std::string sOut;
+		char cStr[8];
+		BenchTimer timer;
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			sprintf(cStr, "%02x", data[i]);
+			sOut += cStr;
+		}
+		BenchReport("hex old (sprintf)", timer.Elapsed(), data.size() / 1e6, "MB");
+	}
+
+	PSWriter ps;
+	BenchTimer timer;
+	ps.AddHex(&data[0], data.size());
+	BenchReport("hex PSWriter", timer.Elapsed(), data.size() / 1e6, "MB");
+
+	ps.Clear();
+	timer.Restart();
+	ps.AddASCII85(&data[0], data.size());
+	BenchReport("ASCII85 PSWriter", timer.Elapsed(), data.size() / 1e6, "MB");
+}
+
+/**
+	
+*/
+static void BenchNumbers()
+{
+	const int nCount = 2000000;
+
+	// Old: sprintf of each link rectangle
+	{
+		std::string sOut;
+		char cStr[128];
+		BenchTimer timer;
+		for (int i = 0; i < nCount; i += 4)
+		{
+			sprintf(cStr, " [%d %d %d %d]", i, -i, i + 100, i * 3);
+			sOut += cStr;
+		}
+		BenchReport("numbers old (sprintf)", timer.Elapsed(), nCount / 1e6, "M numbers");
+	}
+
+	PSWriter ps;
+	BenchTimer timer;
+	for (int i = 0; i < nCount; i += 4)
+	{
+		RECTL rect = {i, -i, i + 100, i * 3};
+		ps.AddRect(rect);
+	}
+	BenchReport("numbers PSWriter", timer.Elapsed(), nCount / 1e6, "M numbers");
+}
+
+/**
+	
+*/
+int main()
+{
+	BenchEscape("clean text", MakeText(4 * 1024 * 1024, 1000000), 80);
+	BenchEscape("1 in 40 escaped", MakeText(4 * 1024 * 1024, 40), 80);
+	BenchEscape("1 in 4 escaped", MakeText(4 * 1024 * 1024, 4), 80);
+	BenchHex();
+	BenchNumbers();
+	return 0;
+}
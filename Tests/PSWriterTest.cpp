@@ -0,0 +1,322 @@
+/**
+	@file
+	@brief Tests for the PostScript stream writer (PSWriter)
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <PRCOMOEM.H>
+#include "PSWriter.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/**
+	@brief Escapes text one character at a time, as the PostScript Language Reference describes it
+	@param s The text to escape
+	@return The escaped text
+*/
+static std::string ReferenceEscape(const std::string& s)
+{
+	std::string sRet;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		switch (s[i])
+		{
+			case '\b':	sRet += "\\b"; break;
+			case '\t':	sRet += "\\t"; break;
+			case '\n':	sRet += "\\n"; break;
+			case '\f':	sRet += "\\f"; break;
+			case '\r':	sRet += "\\r"; break;
+			case '(':	sRet += "\\("; break;
+			case ')':	sRet += "\\)"; break;
+			case '\\':	sRet += "\\\\"; break;
+			default:	sRet += s[i]; break;
+		}
+	}
+	return sRet;
+}
+
+/**
+	@brief Returns what the writer has collected
+	@param ps The writer
+	@return The collected code
+*/
+static std::string Contents(const PSWriter& ps)
+{
+	return std::string(ps.GetData(), ps.GetSize());
+}
+
+/**
+	@brief Escapes text with the writer
+	@param s The text to escape
+	@return The escaped text
+*/
+static std::string Escape(const std::string& s)
+{
+	PSWriter ps;
+	ps.AddEscaped(s.data(), s.size());
+	return Contents(ps);
+}
+
+/**
+	
+*/
+static void TestEscaped()
+{
+	// Every escape class
+	CHECK_EQUAL(Escape("\b"), "\\b");
+	CHECK_EQUAL(Escape("\t"), "\\t");
+	CHECK_EQUAL(Escape("\n"), "\\n");
+	CHECK_EQUAL(Escape("\f"), "\\f");
+	CHECK_EQUAL(Escape("\r"), "\\r");
+	CHECK_EQUAL(Escape("("), "\\(");
+	CHECK_EQUAL(Escape(")"), "\\)");
+	CHECK_EQUAL(Escape("\\"), "\\\\");
+	CHECK_EQUAL(Escape("a(b)c\\d"), "a\\(b\\)c\\\\d");
+	CHECK_EQUAL(Escape("(("), "\\(\\(");
+	CHECK_EQUAL(Escape(""), "");
+
+	// Everything else is copied as is (other control characters, high characters)
+	for (int c = 0; c < 256; c++)
+	{
+		std::string s(1, (char)c);
+		CHECK_EQUAL(Escape(s), ReferenceEscape(s));
+	}
+	CHECK_EQUAL(Escape("\x01\x0B\x1B\x7F\x80\xFF"), "\x01\x0B\x1B\x7F\x80\xFF");
+
+	// Embedded NULs don't end the text
+	std::string sNul("a\0b\0(", 5);
+	CHECK_EQUAL(Escape(sNul), std::string("a\0b\0\\(", 6));
+
+	// Long clean runs, with special characters at the run edges
+	std::string sLong(100000, 'x');
+	CHECK_EQUAL(Escape(sLong), sLong);
+	sLong[0] = '(';
+	sLong[50000] = '\n';
+	sLong[sLong.size() - 1] = ')';
+	CHECK_EQUAL(Escape(sLong), ReferenceEscape(sLong));
+
+	// Every character in random text
+	srand(1);
+	for (int i = 0; i < 200; i++)
+	{
+		std::string s(rand() % 300, ' ');
+		for (size_t j = 0; j < s.size(); j++)
+			s[j] = (char)(rand() % 256);
+		CHECK_EQUAL(Escape(s), ReferenceEscape(s));
+	}
+
+	// String literals are separated from the previous token
+	PSWriter ps;
+	ps.AddNumber(12L).AddString("a(b", 3).AddString(std::string("\\"));
+	CHECK_EQUAL(Contents(ps), "12 (a\\(b) (\\\\)");
+}
+
+/**
+	@brief Writes an integer with the writer
+	@param lNumber The number
+	@return The written token
+*/
+static std::string Number(long lNumber)
+{
+	PSWriter ps;
+	ps.AddNumber(lNumber);
+	return Contents(ps);
+}
+
+/**
+	
+*/
+static void TestNumbers()
+{
+	// Integers (long is 32 bits in the plugin, so that's the range tested)
+	CHECK_EQUAL(Number(0L), "0");
+	CHECK_EQUAL(Number(7L), "7");
+	CHECK_EQUAL(Number(-7L), "-7");
+	CHECK_EQUAL(Number(1000L), "1000");
+	CHECK_EQUAL(Number(-1000L), "-1000");
+	CHECK_EQUAL(Number(2147483647L), "2147483647");
+	CHECK_EQUAL(Number(-2147483647L - 1), "-2147483648");
+	for (long l = -100000; l <= 100000; l += 7)
+	{
+		char cExpected[32];
+		sprintf(cExpected, "%ld", l);
+		CHECK_EQUAL(Number(l), cExpected);
+	}
+
+	// Numbers are separated from the previous token, but not after brackets or whitespace
+	PSWriter ps;
+	ps.AddNumber(1L).AddNumber(25L).Add("[").AddNumber(-3L).Add("\n").AddNumber(4L).AddOp("moveto");
+	CHECK_EQUAL(Contents(ps), "1 25[-3\n4 moveto");
+}
+
+/**
+	
+*/
+static void TestTokens()
+{
+	PSWriter ps;
+	RECTL rect = {10, -20, 300, 400};
+	ps.AddName("Rect").AddRect(rect).AddOp("cc_url").AddName("Title", 5).Add(" {").AddOp("pop").Add("}");
+	CHECK_EQUAL(Contents(ps), "/Rect [10 -20 300 400] cc_url /Title {pop}");
+
+	// Clear keeps nothing
+	ps.Clear();
+	CHECK(ps.IsEmpty());
+	ps.AddOp("showpage");
+	CHECK_EQUAL(Contents(ps), "showpage");
+
+	// Flushing writes everything in one go and empties the buffer
+	IPrintOemDriverPS helper;
+	CHECK(ps.Flush(NULL, &helper));
+	CHECK_EQUAL(helper.sSpool, "showpage");
+	CHECK(ps.IsEmpty());
+	CHECK(ps.Flush(NULL, &helper));
+	CHECK_EQUAL(helper.sSpool, "showpage");
+}
+
+/**
+	
+*/
+static void TestHex()
+{
+	// Every byte value, more than one conversion block
+	std::string sData;
+	std::string sExpected;
+	for (int i = 0; i < 1000; i++)
+	{
+		sData += (char)(i * 37 % 256);
+		char cHex[3];
+		sprintf(cHex, "%02x", (BYTE)sData[i]);
+		sExpected += cHex;
+	}
+	for (size_t nLen = 0; nLen <= sData.size(); nLen += (nLen < 300) ? 1 : 97)
+	{
+		PSWriter ps;
+		ps.AddHex((const BYTE*)sData.data(), nLen);
+		CHECK_EQUAL(Contents(ps), sExpected.substr(0, nLen * 2));
+	}
+
+	// Hex strings are bracketed and separated
+	PSWriter ps;
+	const BYTE cData[] = {0x00, 0x0F, 0xF0, 0xFF};
+	ps.AddOp("x").AddHexString(cData, sizeof(cData)).AddHexString(cData, 0);
+	CHECK_EQUAL(Contents(ps), "x <000ff0ff> <>");
+}
+
+/**
+	@brief Decodes ASCII base-85 data
+	@param s The encoded data (up to the ~> marker)
+	@param sOut Receives the decoded data
+	@return true if the data is valid, false if not
+*/
+static bool DecodeASCII85(const std::string& s, std::string& sOut)
+{
+	sOut.erase();
+	size_t nEnd = s.find("~>");
+	if (nEnd == std::string::npos)
+		return false;
+	DWORD dwValue = 0;
+	int nCount = 0;
+	for (size_t i = 0; i < nEnd; i++)
+	{
+		char c = s[i];
+		if (c == '\n')
+			continue;
+		if (c == 'z')
+		{
+			if (nCount != 0)
+				return false;
+			sOut.append(4, '\0');
+			continue;
+		}
+		if ((c < '!') || (c > 'u'))
+			return false;
+		dwValue = dwValue * 85 + (c - '!');
+		if (++nCount == 5)
+		{
+			for (int j = 3; j >= 0; j--)
+				sOut += (char)(dwValue >> (j * 8));
+			dwValue = 0;
+			nCount = 0;
+		}
+	}
+	if (nCount == 1)
+		return false;
+	if (nCount > 0)
+	{
+		// Partial last group: pad with the highest digit
+		for (int i = nCount; i < 5; i++)
+			dwValue = dwValue * 85 + 84;
+		for (int j = 3; j > 4 - nCount; j--)
+			sOut += (char)(dwValue >> (j * 8));
+	}
+	return true;
+}
+
+/**
+	
+*/
+static void TestASCII85()
+{
+	PSWriter ps;
+	ps.AddASCII85((const BYTE*)"Man ", 4);
+	CHECK_EQUAL(Contents(ps), "9jqo^~>\n");
+	ps.Clear();
+	ps.AddASCII85((const BYTE*)"\0\0\0\0\0", 5);
+	CHECK_EQUAL(Contents(ps), "z!!~>\n");
+
+	// Round trip, all the partial group sizes, lines under 80 characters
+	srand(2);
+	for (int i = 0; i < 100; i++)
+	{
+		std::string sData(rand() % 500, ' ');
+		for (size_t j = 0; j < sData.size(); j++)
+			sData[j] = (rand() % 4 == 0) ? '\0' : (char)(rand() % 256);
+		ps.Clear();
+		ps.AddASCII85((const BYTE*)sData.data(), sData.size());
+		std::string sCode = Contents(ps), sDecoded;
+		CHECK(DecodeASCII85(sCode, sDecoded));
+		CHECK(sDecoded == sData);
+		size_t nLine = 0;
+		for (size_t j = 0; j < sCode.size(); j++)
+		{
+			nLine = (sCode[j] == '\n') ? 0 : nLine + 1;
+			CHECK(nLine < 80);
+		}
+	}
+}
+
+/**
+	
+*/
+int main()
+{
+	TestEscaped();
+	TestNumbers();
+	TestTokens();
+	TestHex();
+	TestASCII85();
+	return TestResult("PSWriterTest");
+}
@@ -0,0 +1,126 @@
+/**
+	@file
+	@brief Benchmark of drawing the license badge: stretched on every page (the old way) against scaled once and copied
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "PngImage.h"
+#include "TestUtil.h"
+#include "TestImage.h"
+
+TEST_GLOBALS
+
+/// Pages in the benchmark's print job
+#define BENCH_PAGES		100
+
+/**
+	@brief Reads a file
+	@param lpName Name of the file in TESTIMAGE_FOLDER
+	@param[out] data Receives the file's contents
+*/
+static void ReadFile(const char* lpName, std::vector<char>& data)
+{
+	std::string sPath = std::string(TESTIMAGE_FOLDER) + lpName;
+	FILE* pFile = fopen(sPath.c_str(), "rb");
+	if (pFile == NULL)
+		return;
+	char cBuffer[4096];
+	size_t nRead;
+	while ((nRead = fread(cBuffer, 1, sizeof(cBuffer), pFile)) > 0)
+		data.insert(data.end(), cBuffer, cBuffer + nRead);
+	fclose(pFile);
+}
+
+/**
+	@brief Measures a print job's badges at a device resolution
+	@param data The badge's PNG data
+	@param nDPI The device resolution
+*/
+static void BenchJob(const std::vector<char>& data, int nDPI)
+{
+	char cName[64];
+	PngImage png;
+	png.LoadFromBuffer(&data[0], (DWORD)data.size(), true, true, true);
+	int nWidth = (int)(png.GetWidth() * nDPI / 72.0), nHeight = (int)(png.GetHeight() * nDPI / 72.0);
+
+	// Old: the badge is decoded and stretched on each page
+	std::vector<BYTE> arPage;
+	double dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		for (int nPage = 0; nPage < BENCH_PAGES; nPage++)
+		{
+			PngImage page;
+			page.LoadFromBuffer(&data[0], (DWORD)data.size(), true, true, true);
+			StretchNearest(page, nWidth, nHeight, arPage);
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "decode and stretch each page, %d dpi", nDPI);
+	BenchReport(cName, dBest, BENCH_PAGES, "pages");
+
+	// New: decoded and scaled once, copied to each page
+	dBest = 0;
+	double dScale = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		PngImage page, scaled;
+		page.LoadFromBuffer(&data[0], (DWORD)data.size(), true, true, true);
+		scaled.Scale(page, nWidth, nHeight);
+		dScale = BestTime(dScale, timer.Elapsed());
+		for (int nPage = 0; nPage < BENCH_PAGES; nPage++)
+		{
+			arPage.resize(scaled.GetWidthInBytes() * nHeight);
+			for (int y = 0; y < nHeight; y++)
+				memcpy(&arPage[y * scaled.GetWidthInBytes()], scaled.GetBits() + y * scaled.GetWidthInBytes(), nWidth * 3);
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "decode and scale once, %d dpi", nDPI);
+	BenchReport(cName, dScale, 1, "badges");
+	sprintf(cName, "scale once and copy, %d dpi", nDPI);
+	BenchReport(cName, dBest, BENCH_PAGES, "pages");
+}
+
+/**
+	
+*/
+int main()
+{
+	std::vector<char> data;
+	ReadFile("ByNcSa.png", data);
+	if (data.empty())
+	{
+		printf("no badge in %s\n", TESTIMAGE_FOLDER);
+		return 1;
+	}
+
+	BenchJob(data, 300);
+	BenchJob(data, 600);
+	BenchJob(data, 1200);
+	return 0;
+}
@@ -0,0 +1,269 @@
+/**
+	@file
+	@brief Tests for the license badge scaling (PngImage::Scale): against exact arithmetic and the EngStretchBlt stretch it replaced
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <math.h>
+#include <vector>
+#include "PngImage.h"
+#include "TestUtil.h"
+#include "TestImage.h"
+
+TEST_GLOBALS
+
+/// The license badges (General/res)
+static const char* s_pBadges[] = {"By.png", "ByNc.png", "ByNcNd.png", "ByNcSa.png", "ByNd.png", "BySa.png",
+	"Sampling.png", "SamplingPlus.png", "SamplingPlusNC.png", "Somerights.png"};
+
+/**
+    @brief A source pixel's share in a scaled pixel, in exact arithmetic
+*/
+struct ExactWeight
+{
+	/// Position of the source pixel
+	int		nSource;
+	/// Its weight
+	double	dWeight;
+};
+
+/**
+	@brief Computes the weights of one target pixel, the way PngImage::Scale is documented to: area average
+			when shrinking, linear interpolation between the nearest pixel centers when enlarging
+	@param nSource Source size
+	@param nTarget Target size
+	@param i The target pixel
+	@return The weights
+*/
+static std::vector<ExactWeight> ExactWeights(int nSource, int nTarget, int i)
+{
+	std::vector<ExactWeight> arWeights;
+	ExactWeight weight;
+	double dRatio = (double)nSource / nTarget;
+	if (nTarget < nSource)
+	{
+		double dStart = i * dRatio, dEnd = (i + 1) * dRatio;
+		for (weight.nSource = (int)dStart; (weight.nSource < nSource) && (weight.nSource < dEnd); weight.nSource++)
+		{
+			weight.dWeight = (min(dEnd, weight.nSource + 1.0) - max(dStart, (double)weight.nSource)) / dRatio;
+			arWeights.push_back(weight);
+		}
+	}
+	else
+	{
+		double dPos = max(0.0, (i + 0.5) * dRatio - 0.5);
+		weight.nSource = min((int)dPos, nSource - 1);
+		double dNext = (weight.nSource == nSource - 1) ? 0 : dPos - weight.nSource;
+		weight.dWeight = 1 - dNext;
+		arWeights.push_back(weight);
+		weight.nSource++;
+		weight.dWeight = dNext;
+		if (dNext > 0)
+			arWeights.push_back(weight);
+	}
+	return arWeights;
+}
+
+/**
+	@brief Scales an image and compares it with exact arithmetic and with the nearest pixel stretch
+	@param source The image
+	@param nWidth Width to scale to
+	@param nHeight Height to scale to
+	@return Number of pixels (in flat areas) that must be exactly the same as the stretch's
+*/
+static int CompareScale(const PngImage& source, int nWidth, int nHeight)
+{
+	PngImage scaled;
+	CHECK(scaled.Scale(source, nWidth, nHeight));
+	CHECK_EQUAL(scaled.GetWidth(), nWidth);
+	CHECK_EQUAL(scaled.GetHeight(), nHeight);
+	CHECK_EQUAL(scaled.GetBitsPerPixel(), 24);
+	CHECK_EQUAL(scaled.GetWidthInBytes() % 4, 0);
+	CHECK_EQUAL(scaled.GetColorCount(), 0);
+	std::vector<BYTE> arStretched;
+	StretchNearest(source, nWidth, nHeight, arStretched);
+
+	std::vector<std::vector<ExactWeight> > arColumns(nWidth);
+	for (int x = 0; x < nWidth; x++)
+		arColumns[x] = ExactWeights(source.GetWidth(), nWidth, x);
+	double dWorst = 0;
+	int nFlat = 0, nOutside = 0, nNotStretched = 0;
+	for (int y = 0; y < nHeight; y++)
+	{
+		std::vector<ExactWeight> arRows = ExactWeights(source.GetHeight(), nHeight, y);
+		for (int x = 0; x < nWidth; x++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				// Exact value, and the range of the source pixels it's made of
+				double dExact = 0;
+				int nMin = 255, nMax = 0;
+				for (size_t i = 0; i < arRows.size(); i++)
+				{
+					for (size_t j = 0; j < arColumns[x].size(); j++)
+					{
+						int nValue = ImagePixel(source, arColumns[x][j].nSource, arRows[i].nSource, c);
+						dExact += arRows[i].dWeight * arColumns[x][j].dWeight * nValue;
+						nMin = min(nMin, nValue);
+						nMax = max(nMax, nValue);
+					}
+				}
+
+				int nValue = ImagePixel(scaled, x, y, c);
+				dWorst = max(dWorst, fabs(nValue - dExact));
+				if ((nValue < nMin) || (nValue > nMax))
+					nOutside++;
+				// The stretch copies one of these source pixels, so where they're all the same both must be
+				if (nMin == nMax)
+				{
+					nFlat++;
+					if (nValue != arStretched[y * scaled.GetWidthInBytes() + x * 3 + c])
+						nNotStretched++;
+				}
+			}
+		}
+	}
+	// Within rounding of the exact values (12 bit weights, and 8 bits kept between the two passes)
+	CHECK(dWorst < 1.0);
+	CHECK_EQUAL(nOutside, 0);
+	CHECK_EQUAL(nNotStretched, 0);
+	return nFlat;
+}
+
+/**
+	
+*/
+static void TestBadges()
+{
+	// Scales the plugin uses (device resolution / 72), and a few shrinking ones
+	static const int s_nDPI[] = {72, 96, 150, 300, 600, 1200, 50, 36, 7};
+	for (size_t nBadge = 0; nBadge < COUNTOF(s_pBadges); nBadge++)
+	{
+		TestImage badge;
+		CHECK(badge.Load(s_pBadges[nBadge]));
+		if (badge.GetBits() == NULL)
+			continue;
+
+		// Same size: an exact copy
+		PngImage copy;
+		CHECK(copy.Scale(badge, badge.GetWidth(), badge.GetHeight()));
+		int nDifferent = 0;
+		for (int y = 0; y < badge.GetHeight(); y++)
+			for (int x = 0; x < badge.GetWidth(); x++)
+				for (int c = 0; c < 3; c++)
+					if (ImagePixel(copy, x, y, c) != ImagePixel(badge, x, y, c))
+						nDifferent++;
+		CHECK_EQUAL(nDifferent, 0);
+
+		int nFlat = 0, nPixels = 0;
+		for (size_t i = 0; i < COUNTOF(s_nDPI); i++)
+		{
+			int nWidth = max(1, (int)(badge.GetWidth() * s_nDPI[i] / 72.0)), nHeight = max(1, (int)(badge.GetHeight() * s_nDPI[i] / 72.0));
+			nFlat += CompareScale(badge, nWidth, nHeight);
+			nPixels += nWidth * nHeight * 3;
+		}
+		// Much of a badge is flat color, so a good part of it was compared with the stretch
+		CHECK(nFlat > nPixels / 4);
+	}
+}
+
+/**
+	
+*/
+static void TestPalette()
+{
+	// The palette badge scales the same whether it was loaded with its palette (like the plugin does) or as BGR
+	TestImage palette, bgr;
+	CHECK(palette.Load("Somerights.png", true));
+	CHECK(bgr.Load("Somerights.png", false));
+	CHECK(palette.GetColorCount() > 0);
+	CHECK_EQUAL(bgr.GetColorCount(), 0);
+	PngImage scaled1, scaled2;
+	CHECK(scaled1.Scale(palette, 733, 258));
+	CHECK(scaled2.Scale(bgr, 733, 258));
+	CHECK(memcmp(scaled1.GetBits(), scaled2.GetBits(), scaled1.GetWidthInBytes() * scaled1.GetHeight()) == 0);
+}
+
+/**
+	
+*/
+static void TestRandomImages()
+{
+	srand(11);
+	for (int nIteration = 0; nIteration < 200; nIteration++)
+	{
+		// Blocks of the same color, shrunk by the block size: every pixel is the stretch's
+		int nBlock = 1 + rand() % 6, nWidth = 1 + rand() % 30, nHeight = 1 + rand() % 30;
+		std::vector<BYTE> arPixels(nWidth * nBlock * nHeight * nBlock * 3);
+		for (int y = 0; y < nHeight; y++)
+		{
+			for (int x = 0; x < nWidth; x++)
+			{
+				BYTE cColor[3] = {(BYTE)rand(), (BYTE)rand(), (BYTE)rand()};
+				for (int i = 0; i < nBlock * nBlock * 3; i++)
+					arPixels[(((y * nBlock + i / (nBlock * 3)) * nWidth * nBlock) + x * nBlock) * 3 + i % (nBlock * 3)] = cColor[i % 3];
+			}
+		}
+		TestImage blocks;
+		blocks.Create(nWidth * nBlock, nHeight * nBlock, arPixels);
+		CHECK_EQUAL(CompareScale(blocks, nWidth, nHeight), nWidth * nHeight * 3);
+
+		// Noise, to any size
+		int nSourceWidth = 1 + rand() % 40, nSourceHeight = 1 + rand() % 40;
+		arPixels.resize(nSourceWidth * nSourceHeight * 3);
+		for (size_t i = 0; i < arPixels.size(); i++)
+			arPixels[i] = (BYTE)rand();
+		TestImage noise;
+		noise.Create(nSourceWidth, nSourceHeight, arPixels);
+		CompareScale(noise, 1 + rand() % 100, 1 + rand() % 100);
+	}
+}
+
+/**
+	
+*/
+static void TestFailures()
+{
+	TestImage badge;
+	CHECK(badge.Load("By.png"));
+	PngImage empty, scaled;
+	CHECK(!scaled.Scale(empty, 10, 10));
+	CHECK(!scaled.Scale(badge, 0, 10));
+	CHECK(!scaled.Scale(badge, 10, -1));
+	CHECK(scaled.Scale(badge, 10, 10));
+	CHECK(!scaled.Scale(scaled, 20, 20));
+	CHECK(scaled.GetBits() == NULL);
+}
+
+/**
+	
+*/
+int main()
+{
+	TestBadges();
+	TestPalette();
+	TestRandomImages();
+	TestFailures();
+	return TestResult("PngImageTest");
+}
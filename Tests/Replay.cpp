@@ -0,0 +1,155 @@
+/**
+	@file
+	@brief Replay tool: runs a .cctrace print job trace through the portable plugin code and reports per-stage timings and allocations
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "URLScanner.h"
+#include "TraceReplay.h"
+#include "TestUtil.h"
+
+/**
+	@brief Prints a replay's stage measurements
+	@param lpTitle Title of the measurements
+	@param results The replay results (times and allocations of each stage)
+*/
+static void PrintStages(const char* lpTitle, const TraceReplay::Results& results)
+{
+	printf("\n%s\n", lpTitle);
+	printf("%-24s %12s %12s %12s\n", "stage", "ms", "allocations", "KB");
+	TraceReplay::StageStats total = {0, 0, 0};
+	for (int i = 0; i < TraceReplay::ST_COUNT; i++)
+	{
+		const TraceReplay::StageStats& stage = results.stages[i];
+		printf("%-24s %12.3f %12u %12.1f\n", TraceReplay::GetStageName((TraceReplay::Stage)i), stage.dSeconds * 1000, (unsigned)stage.nAllocations, stage.nBytes / 1024.0);
+		total.dSeconds += stage.dSeconds;
+		total.nAllocations += stage.nAllocations;
+		total.nBytes += stage.nBytes;
+	}
+	printf("%-24s %12.3f %12u %12.1f\n", "total", total.dSeconds * 1000, (unsigned)total.nAllocations, total.nBytes / 1024.0);
+}
+
+/**
+	@brief Prints the program's usage
+*/
+static void Usage()
+{
+	fprintf(stderr, "Usage: Replay [-r rounds] [-e] [-d] [-o output.ps] trace.cctrace\n"
+		"  -r  replay the trace this many times (default %d): the first replay builds the glyph tables,\n"
+		"      and the best time of each stage in the others is reported too\n"
+		"  -e  detect e-mail addresses\n"
+		"  -d  detect domain names without http:// or www.\n"
+		"  -o  write the PostScript link code of the replay into a file\n", BENCH_ROUNDS);
+}
+
+/**
+	
+*/
+int main(int argc, char* argv[])
+{
+	int nRounds = BENCH_ROUNDS;
+	UINT uURLFlags = 0;
+	const char* lpOutput = NULL;
+	const char* lpTrace = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc))
+			nRounds = max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-e") == 0)
+			uURLFlags |= URLScanner::SCAN_EMAILS;
+		else if (strcmp(argv[i], "-d") == 0)
+			uURLFlags |= URLScanner::SCAN_DOMAINS;
+		else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+			lpOutput = argv[++i];
+		else if ((argv[i][0] != '-') && (lpTrace == NULL))
+			lpTrace = argv[i];
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+	if (lpTrace == NULL)
+	{
+		Usage();
+		return 2;
+	}
+
+	// Load the trace
+	TraceReplay replay(uURLFlags);
+	size_t nAllocations = g_nAllocations, nBytes = g_nAllocatedBytes;
+	BenchTimer timer;
+	if (!replay.Load(lpTrace))
+	{
+		fprintf(stderr, "%s: cannot read the trace (missing file, or not a valid trace)\n", lpTrace);
+		return 1;
+	}
+	printf("%s: loaded in %.3f ms (%u allocations, %.1f KB)\n", lpTrace, timer.Elapsed() * 1000, (unsigned)(g_nAllocations - nAllocations), (g_nAllocatedBytes - nBytes) / 1024.0);
+
+	// The first replay builds the glyph tables; the others show the steady state
+	TraceReplay::Results first, best, results;
+	replay.Replay(first);
+	best = first;
+	for (int nRound = 1; nRound < nRounds; nRound++)
+	{
+		replay.Replay(results);
+		for (int i = 0; i < TraceReplay::ST_COUNT; i++)
+		{
+			if (nRound == 1)
+				best.stages[i] = results.stages[i];
+			else
+			{
+				best.stages[i].dSeconds = BestTime(best.stages[i].dSeconds, results.stages[i].dSeconds);
+				best.stages[i].nAllocations = min(best.stages[i].nAllocations, results.stages[i].nAllocations);
+				best.stages[i].nBytes = min(best.stages[i].nBytes, results.stages[i].nBytes);
+			}
+		}
+	}
+
+	printf("%u pages, %u fonts, %u text outputs, %u glyphs\n", (unsigned)first.nPages, (unsigned)replay.GetFontCount(), (unsigned)first.nRuns, (unsigned)first.nGlyphs);
+	printf("%u outputs not translated, %u glyphs translated differently than recorded\n", (unsigned)first.nMisses, (unsigned)first.nMismatches);
+	printf("%u text links found, %u URLs found, %u links written (%u bytes of PostScript)\n", (unsigned)first.nTextLinks, (unsigned)first.nURLs, (unsigned)first.nLinks, (unsigned)replay.GetOutput().size());
+	PrintStages("First replay (builds the glyph tables):", first);
+	if (nRounds > 1)
+	{
+		char cTitle[128];
+		sprintf(cTitle, "Best of the other %d replays (the best time and fewest allocations of each stage):", nRounds - 1);
+		PrintStages(cTitle, best);
+	}
+
+	if (lpOutput != NULL)
+	{
+		FILE* pFile = fopen(lpOutput, "wb");
+		if ((pFile == NULL) || (fwrite(replay.GetOutput().data(), 1, replay.GetOutput().size(), pFile) != replay.GetOutput().size()))
+		{
+			fprintf(stderr, "%s: cannot write the output\n", lpOutput);
+			if (pFile != NULL)
+				fclose(pFile);
+			return 1;
+		}
+		fclose(pFile);
+	}
+	return 0;
+}
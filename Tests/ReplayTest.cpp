@@ -0,0 +1,585 @@
+/**
+	@file
+	@brief Tests for the trace replay (TraceReplay): a hand-built trace, replayed through the text, glyph, link and PostScript code
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include <unistd.h>
+#include "CCTChar.h"
+#include "URLScanner.h"
+#include "TraceReplay.h"
+#include "TestUtil.h"
+#include "TestPage.h"
+
+TEST_GLOBALS
+
+/// Escape code for adding a link to the current page (see oemps.h)
+#define ESCAPE_LINK_DATA		0x667711aa
+/// Escape code: disable Auto URL link (see oemps.h)
+#define ESCAPE_DISABLE_AUTO_URL	0x667711ab
+/// Escape code for adding many links to the current page in one call (see oemps.h)
+#define ESCAPE_LINK_DATA_BATCH	0x667711ac
+
+/// The font of the glyph text in the test traces
+#define REPLAY_FONT		L"Replay Sans"
+
+/**
+	@brief Returns the glyph of a character in the test font
+	@param wChar The character
+	@return The glyph index
+*/
+static WORD GlyphOf(WCHAR wChar)
+{
+	return (WORD)(wChar * 7 + 3);
+}
+
+/**
+    @brief Builds a trace file the way TraceWriter writes it
+*/
+class TestTrace
+{
+public:
+	/**
+		@brief Constructor: writes the file header
+	*/
+	TestTrace()
+	{
+		TraceFileHeader header = {TRACE_MAGIC, TRACE_VERSION};
+		Add(m_sData, &header, sizeof(header));
+	};
+
+protected:
+	/// The file data
+	std::string		m_sData;
+
+	/**
+		@brief Adds bytes to a buffer
+		@param s The buffer
+		@param pData The bytes
+		@param nSize Amount of bytes
+	*/
+	static void		Add(std::string& s, const void* pData, size_t nSize) {s.append((const char*)pData, nSize);};
+	/**
+		@brief Adds a UTF-16 string to a buffer
+		@param s The buffer
+		@param sText The string
+	*/
+	static void		AddUTF16(std::string& s, const std::wstring& sText)
+	{
+		for (size_t i = 0; i < sText.size(); i++)
+		{
+			s += (char)(sText[i] & 0xFF);
+			s += (char)((sText[i] >> 8) & 0xFF);
+		}
+	};
+
+public:
+	/**
+		@brief Returns the file data
+		@return The data
+	*/
+	const std::string&	GetData() const {return m_sData;};
+	/**
+		@brief Adds a record
+		@param uType The record type
+		@param sData The record data
+	*/
+	void			Record(UINT uType, const std::string& sData)
+	{
+		TraceRecordHeader header = {uType, (unsigned int)sData.size()};
+		Add(m_sData, &header, sizeof(header));
+		m_sData += sData;
+	};
+	/**
+		@brief Adds a record holding a single number
+		@param uType The record type
+		@param uValue The number
+	*/
+	void			Number(UINT uType, UINT uValue) {Record(uType, std::string((const char*)&uValue, sizeof(uValue)));};
+	/**
+		@brief Adds a font record
+		@param lpFace The face name
+		@param nWeight The font weight
+	*/
+	void			Font(const wchar_t* lpFace, int nWeight = 400)
+	{
+		TraceFont font;
+		memset(&font, 0, sizeof(font));
+		font.nHeight = -12;
+		font.nWeight = nWeight;
+		for (size_t i = 0; (lpFace[i] != 0) && (i < COUNTOF(font.sFaceName)); i++)
+			font.sFaceName[i] = (unsigned short)lpFace[i];
+		Record(TR_FONT, std::string((const char*)&font, sizeof(font)));
+	};
+	/**
+		@brief Adds the text records of a page's strings
+		@param page The strings
+		@param bGlyphs true to record them as glyph text (with the translated text), false as characters
+		@param bTranslated true if the plugin translated the glyphs (ignored for characters)
+	*/
+	void			Text(const TestPage& page, bool bGlyphs = false, bool bTranslated = true)
+	{
+		for (size_t nRun = 0; nRun < page.GetRunCount(); nRun++)
+		{
+			const TestPage::Run& run = page.GetRun(nRun);
+			TraceText text;
+			text.rcArea[0] = run.rc.left;
+			text.rcArea[1] = run.rc.top;
+			text.rcArea[2] = run.rc.right;
+			text.rcArea[3] = run.rc.bottom;
+			text.uCharInc = 0;
+			text.uGlyphs = (unsigned int)run.sText.size();
+			text.uFlags = TTF_POSITIONS | TTF_WIDTHS;
+			std::wstring sGlyphs = run.sText;
+			if (bGlyphs)
+			{
+				text.uFlags |= TTF_GLYPHINDEX | (bTranslated ? TTF_TEXT : 0);
+				for (size_t i = 0; i < sGlyphs.size(); i++)
+					sGlyphs[i] = GlyphOf(sGlyphs[i]);
+			}
+
+			std::string sData;
+			Add(sData, &text, sizeof(text));
+			AddUTF16(sData, sGlyphs);
+			for (size_t i = 0; i < run.sText.size(); i++)
+			{
+				int nPos[2] = {page.GetGlyphs(nRun)[i].ptl.x, page.GetGlyphs(nRun)[i].ptl.y};
+				Add(sData, nPos, sizeof(nPos));
+			}
+			Add(sData, page.GetWidths(nRun), run.sText.size() * sizeof(POINTQF));
+			if ((text.uFlags & TTF_TEXT) != 0)
+				AddUTF16(sData, run.sText);
+			Record(TR_TEXT, sData);
+		}
+	};
+	/**
+		@brief Adds a fixed width text record
+		@param sText The text (or glyphs)
+		@param x Left side of the text
+		@param y Top of the text
+		@param nCharInc Width of each character
+		@param lpTranslated The text the glyphs were translated into (NULL if sText is characters)
+	*/
+	void			FixedText(const std::wstring& sText, LONG x, LONG y, int nCharInc, const wchar_t* lpTranslated = NULL)
+	{
+		TraceText text = {{x, y, x + nCharInc * (int)sText.size(), y + TestPage::LineHeight}, (unsigned int)nCharInc, (unsigned int)sText.size(), 0};
+		if (lpTranslated != NULL)
+			text.uFlags = TTF_GLYPHINDEX | TTF_TEXT;
+		std::string sData;
+		Add(sData, &text, sizeof(text));
+		AddUTF16(sData, sText);
+		if (lpTranslated != NULL)
+			AddUTF16(sData, lpTranslated);
+		Record(TR_TEXT, sData);
+	};
+	/**
+		@brief Adds a page link record
+		@param rc Location of the link
+		@param sText The link's text (empty for location links)
+		@param nRepeat Repeat count (text links)
+		@param nPage Target page (internal links)
+		@param sURL The URL
+		@param sTitle The tooltip
+	*/
+	void			PageLink(const RECTL& rc, const std::wstring& sText, int nRepeat, int nPage, const std::wstring& sURL, const std::wstring& sTitle)
+	{
+		TracePageLink link = {{rc.left, rc.top, rc.right, rc.bottom}, nPage, 10, 20, nRepeat,
+			(unsigned int)sText.size(), (unsigned int)sURL.size(), (unsigned int)sTitle.size()};
+		std::string sData;
+		Add(sData, &link, sizeof(link));
+		AddUTF16(sData, sText);
+		AddUTF16(sData, sURL);
+		AddUTF16(sData, sTitle);
+		Record(TR_PAGELINK, sData);
+	};
+	/**
+		@brief Adds an ESCAPE_LINK_DATA escape record (as the 64-bit plugin gets it)
+		@param rc Location of the link
+		@param lpURL The URL
+		@param lpTitle The tooltip (NULL for none)
+	*/
+	void			LinkEscape(const RECTL& rc, const char* lpURL, const char* lpTitle)
+	{
+		std::string sData;
+		unsigned int uEscape = ESCAPE_LINK_DATA;
+		int nRect[4] = {rc.left, rc.top, rc.right, rc.bottom};
+		ULONGLONG uTitle = (lpTitle == NULL) ? 0 : strlen(lpURL) + 1;
+		Add(sData, &uEscape, sizeof(uEscape));
+		Add(sData, nRect, sizeof(nRect));
+		Add(sData, &uTitle, sizeof(uTitle));
+		Add(sData, lpURL, strlen(lpURL) + 1);
+		if (lpTitle != NULL)
+			Add(sData, lpTitle, strlen(lpTitle) + 1);
+		Record(TR_ESCAPE, sData);
+	};
+	/**
+		@brief Adds an ESCAPE_LINK_DATA_BATCH escape record
+		@param rc Location of the links (each one is moved down from the last)
+		@param nCount Amount of links
+		@param bValid false to point the last link's URL outside the data
+	*/
+	void			BatchEscape(RECTL rc, int nCount, bool bValid = true)
+	{
+		std::string sRecords, sStrings;
+		size_t nStringsOffset = 4 + nCount * 24;
+		for (int i = 0; i < nCount; i++)
+		{
+			char cURL[64];
+			sprintf(cURL, "http://batch.test/%d", i);
+			int nRecord[6] = {rc.left, rc.top + i * 30, rc.right, rc.bottom + i * 30, (int)(nStringsOffset + sStrings.size()), 0};
+			if (!bValid && (i == nCount - 1))
+				nRecord[4] = 100000;
+			Add(sRecords, nRecord, sizeof(nRecord));
+			Add(sStrings, cURL, strlen(cURL) + 1);
+		}
+		std::string sData;
+		unsigned int uEscape = ESCAPE_LINK_DATA_BATCH, uCount = nCount;
+		Add(sData, &uEscape, sizeof(uEscape));
+		Add(sData, &uCount, sizeof(uCount));
+		Record(TR_ESCAPE, sData + sRecords + sStrings);
+	};
+	/**
+		@brief Writes the trace into a temporary file
+		@param nSize Amount of bytes to write (all of them if larger than the data)
+		@return The file's path (empty if failed)
+	*/
+	std::string		Save(size_t nSize = (size_t)-1) const
+	{
+		char cPath[] = "/tmp/ReplayTestXXXXXX";
+		int nFile = mkstemp(cPath);
+		if (nFile < 0)
+			return std::string();
+		nSize = min(nSize, m_sData.size());
+		bool bRet = write(nFile, m_sData.data(), nSize) == (ssize_t)nSize;
+		close(nFile);
+		if (!bRet)
+		{
+			unlink(cPath);
+			return std::string();
+		}
+		return cPath;
+	};
+};
+
+/**
+	@brief Writes a trace into a file, and loads and replays it
+	@param trace The trace
+	@param replay The replay object
+	@param[out] results The replay results
+	@param nSize Amount of bytes of the trace to write
+	@return true if loaded
+*/
+static bool ReplayTrace(const TestTrace& trace, TraceReplay& replay, TraceReplay::Results& results, size_t nSize = (size_t)-1)
+{
+	std::string sPath = trace.Save(nSize);
+	CHECK(!sPath.empty());
+	bool bRet = replay.Load(sPath.c_str());
+	unlink(sPath.c_str());
+	if (bRet)
+		replay.Replay(results);
+	return bRet;
+}
+
+/**
+	@brief Writes the link code of the URLs in a page, the way the plugin does without the replay
+	@param page The page
+	@param ps Receives the code
+	@return Number of URLs found
+*/
+static size_t ExpectedURLs(const TestPage& page, PSWriter& ps)
+{
+	TextArea text;
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+		text.AddRun(page.GetRun(i).sText.data(), page.GetRun(i).sText.size(), page.GetRun(i).rc, page.GetGlyphs(i), page.GetWidths(i));
+	text.Finalize();
+	URLScanner scanner(text);
+	std::wstring sURL;
+	RECTL rc;
+	size_t nFound = 0;
+	while (scanner.Next(rc, sURL))
+	{
+		ps.AddRect(rc).AddString(MakeAnsiString(sURL)).AddOp("cc_url").Add("\n");
+		nFound++;
+	}
+	return nFound;
+}
+
+/**
+	@brief Counts the appearances of a string in another
+	@param s The string to search in
+	@param lpFind The string to count
+	@return Number of appearances
+*/
+static size_t Count(const std::string& s, const char* lpFind)
+{
+	size_t nCount = 0;
+	for (std::string::size_type pos = s.find(lpFind); pos != std::string::npos; pos = s.find(lpFind, pos + 1))
+		nCount++;
+	return nCount;
+}
+
+/**
+	
+*/
+static void TestAutoURLs()
+{
+	// Page 1: characters and translated glyphs, with a link escape before the page
+	TestPage page1, page1Glyphs;
+	page1.AddRun(L"visit www.example.com today", 100, 0);
+	page1.AddRun(L"or mail.example.org", 100, 30, true);
+	page1Glyphs.AddRun(L"glyphs http://glyph.test/a b", 100, 60, true);
+	TestTrace trace;
+	trace.Number(TR_STARTDOC, 7);
+	RECTL rcLink = {10, 20, 30, 40};
+	trace.LinkEscape(rcLink, "http://escape.test/", "Escape");
+	trace.Number(TR_STARTPAGE, 1);
+	trace.Text(page1);
+	trace.Font(REPLAY_FONT);
+	trace.Text(page1Glyphs, true);
+	trace.Number(TR_SENDPAGE, 1);
+	// Page 2: fixed width text and a batch of links
+	trace.Number(TR_STARTPAGE, 2);
+	trace.BatchEscape(rcLink, 3);
+	trace.BatchEscape(rcLink, 2, false);
+	trace.FixedText(L"see https://fixed.test/b now", 50, 100, 12);
+	trace.Number(TR_SENDPAGE, 2);
+	trace.Number(TR_ENDDOC, 0);
+
+	TraceReplay replay;
+	TraceReplay::Results results;
+	CHECK(ReplayTrace(trace, replay, results));
+	CHECK_EQUAL(results.nPages, (size_t)2);
+	CHECK_EQUAL(replay.GetFontCount(), (size_t)1);
+	CHECK_EQUAL(results.nRuns, (size_t)4);
+	CHECK_EQUAL(results.nMisses, (size_t)0);
+	CHECK_EQUAL(results.nMismatches, (size_t)0);
+	CHECK_EQUAL(results.nTextLinks, (size_t)0);
+	CHECK_EQUAL(results.nURLs, (size_t)3);
+	CHECK_EQUAL(results.nLinks, (size_t)7);
+
+	// Page 1's output: the escape link, then the URLs where the plugin's own search finds them
+	PSWriter expected;
+	expected.AddRect(rcLink).AddString("http://escape.test/").AddString("Escape").AddOp("cc_urlt").Add("\n");
+	TestPage page1All = page1;
+	page1All.AddRun(page1Glyphs.GetRun(0).sText, 100, 60, true);
+	CHECK_EQUAL(ExpectedURLs(page1All, expected), (size_t)2);
+	const std::string& sOutput = replay.GetOutput();
+	std::string sPage1(expected.GetData(), expected.GetSize());
+	CHECK(sOutput.compare(0, sPage1.size(), sPage1) == 0);
+	// Page 2's: the valid batch (the invalid one is dropped), then the fixed width text's URL
+	CHECK_EQUAL(Count(sOutput, "batch.test"), (size_t)3);
+	CHECK_EQUAL(Count(sOutput, "(https://fixed.test/b)"), (size_t)1);
+	RECTL rcFixed = {50 + 4 * 12, 100, 50 + 24 * 12, 100 + TestPage::LineHeight};
+	PSWriter fixed;
+	fixed.AddRect(rcFixed);
+	CHECK(sOutput.find(std::string(fixed.GetData(), fixed.GetSize())) != std::string::npos);
+	CHECK_EQUAL(Count(sOutput, "cc_url"), (size_t)7);
+
+	// The same again: the glyph tables are cached now, and the text memory is kept
+	size_t nGlyphCalls = GetShimGlyphCalls();
+	TraceReplay::Results again;
+	replay.Replay(again);
+	CHECK_EQUAL(GetShimGlyphCalls(), nGlyphCalls);
+	CHECK(replay.GetOutput() == sOutput);
+	CHECK_EQUAL(again.nURLs, results.nURLs);
+	CHECK(results.stages[TraceReplay::ST_GLYPHS].nAllocations > 0);
+	CHECK_EQUAL(again.stages[TraceReplay::ST_TEXT].nAllocations, (size_t)0);
+	CHECK(again.stages[TraceReplay::ST_URLS].nAllocations > 0);
+	for (int i = 0; i < TraceReplay::ST_COUNT; i++)
+		CHECK(again.stages[i].dSeconds > 0);
+
+	// E-mail detection
+	TraceReplay emails(URLScanner::SCAN_EMAILS);
+	TestTrace mail;
+	mail.Number(TR_STARTPAGE, 1);
+	TestPage pageMail;
+	pageMail.AddRun(L"write to someone@example.com", 0, 0);
+	mail.Text(pageMail);
+	mail.Number(TR_SENDPAGE, 1);
+	CHECK(ReplayTrace(mail, emails, results));
+	CHECK_EQUAL(results.nURLs, (size_t)1);
+	CHECK_EQUAL(Count(emails.GetOutput(), "(mailto:someone@example.com)"), (size_t)1);
+	CHECK(ReplayTrace(mail, replay, results));
+	CHECK_EQUAL(results.nURLs, (size_t)0);
+}
+
+/**
+	
+*/
+static void TestLinkFile()
+{
+	// A page with a text link, an internal link and a location URL link; the text has a URL that's not linked
+	TestPage page;
+	page.AddRun(L"an example link here", 0, 0);
+	page.AddRun(L"and www.example.com", 0, 30);
+	page.AddRun(L"an example link again", 0, 60, true);
+	RECTL rcInner = {1, 2, 3, 4}, rcOuter = {5, 6, 7, 8}, rcNone = {0, 0, 0, 0};
+	TestTrace trace;
+	trace.Number(TR_STARTPAGE, 1);
+	trace.PageLink(rcNone, L"example link", 2, 0, L"http://text.test/", L"Text");
+	trace.PageLink(rcInner, L"", 0, 3, L"", L"");
+	trace.PageLink(rcOuter, L"", 0, 0, L"http://outer.test/", L"");
+	trace.Text(page);
+	trace.Number(TR_SENDPAGE, 1);
+
+	TraceReplay replay;
+	TraceReplay::Results results;
+	CHECK(ReplayTrace(trace, replay, results));
+	CHECK_EQUAL(results.nTextLinks, (size_t)1);
+	CHECK_EQUAL(results.nURLs, (size_t)0);
+	CHECK_EQUAL(results.nLinks, (size_t)3);
+	CHECK(results.stages[TraceReplay::ST_TEXT].dSeconds == 0);
+
+	// Internal links first, then the location links, then the found text
+	PSWriter expected;
+	expected.AddRect(rcInner).AddNumber(3L).AddNumber(10L).AddNumber(20L).AddOp("cc_jump").Add("\n");
+	expected.AddRect(rcOuter).AddString("http://outer.test/").AddOp("cc_url").Add("\n");
+	LinkMatcher matcher;
+	matcher.AddLink(L"example link", 2, 0);
+	TextArea text;
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+		text.AddRun(page.GetRun(i).sText.data(), page.GetRun(i).sText.size(), page.GetRun(i).rc, page.GetGlyphs(i), page.GetWidths(i));
+	text.Finalize();
+	LinkMatcher::MATCHES matches;
+	matcher.Search(text, matches);
+	CHECK_EQUAL(matches.size(), (size_t)1);
+	if (matches.size() == 1)
+	{
+		CHECK_EQUAL(matches[0].rcArea.top, 60);
+		expected.AddRect(matches[0].rcArea).AddString("http://text.test/").AddString("Text").AddOp("cc_urlt").Add("\n");
+	}
+	CHECK(replay.GetOutput() == std::string(expected.GetData(), expected.GetSize()));
+}
+
+/**
+	
+*/
+static void TestGlyphs()
+{
+	// Glyph text before any font record, text the plugin could not translate, and a disabled URL detection
+	TestPage page;
+	page.AddRun(L"www.before.test", 0, 0);
+	TestTrace trace;
+	trace.Number(TR_STARTPAGE, 1);
+	trace.Text(page, true);
+	trace.Font(L"Replay Bold", 700);
+	trace.Text(page, true, false);
+	trace.Number(TR_SENDPAGE, 1);
+	trace.Number(TR_STARTPAGE, 2);
+	trace.Text(page);
+	trace.Record(TR_ESCAPE, std::string("\xab\x11\x77\x66", 4));
+	trace.Number(TR_SENDPAGE, 2);
+	trace.Number(TR_STARTPAGE, 3);
+	trace.Text(page);
+	trace.Number(TR_SENDPAGE, 3);
+
+	// Only the text without a font is not translated; the font's table has none of the glyphs (the trace has none)
+	TraceReplay replay;
+	TraceReplay::Results results;
+	CHECK(ReplayTrace(trace, replay, results));
+	CHECK_EQUAL(results.nRuns, (size_t)4);
+	CHECK_EQUAL(results.nMisses, (size_t)1);
+	CHECK_EQUAL(results.nMismatches, (size_t)0);
+	// The page 1 text has no URL, and the escape disables the detection from page 2 on
+	CHECK_EQUAL(results.nURLs, (size_t)0);
+
+	// A character printed with two glyphs: the replay's table only has the first one
+	TestTrace shared;
+	shared.Number(TR_STARTPAGE, 1);
+	shared.Font(L"Replay Shared");
+	std::wstring sGlyphs(2, ' ');
+	sGlyphs[0] = GlyphOf('a');
+	sGlyphs[1] = GlyphOf('b');
+	shared.FixedText(sGlyphs, 0, 0, 10, L"ab");
+	sGlyphs[1] = 999;
+	shared.FixedText(sGlyphs, 0, 30, 10, L"aa");
+	shared.Number(TR_SENDPAGE, 1);
+	CHECK(ReplayTrace(shared, replay, results));
+	CHECK_EQUAL(results.nMisses, (size_t)0);
+	CHECK_EQUAL(results.nMismatches, (size_t)1);
+}
+
+/**
+	
+*/
+static void TestInvalid()
+{
+	TraceReplay replay;
+	TraceReplay::Results results;
+	CHECK(!replay.Load("/nonexistent/trace.cctrace"));
+
+	// Not a trace
+	TestTrace trace;
+	std::string sPath = trace.Save(4);
+	CHECK(!replay.Load(sPath.c_str()));
+	unlink(sPath.c_str());
+
+	// A truncated trace is replayed up to its last complete record
+	TestPage page;
+	page.AddRun(L"http://one.test", 0, 0);
+	trace.Number(TR_STARTPAGE, 1);
+	trace.Text(page);
+	trace.Number(TR_SENDPAGE, 1);
+	size_t nFirst = trace.GetData().size();
+	trace.Number(TR_STARTPAGE, 2);
+	trace.Text(page);
+	CHECK(ReplayTrace(trace, replay, results, trace.GetData().size() - 3));
+	CHECK_EQUAL(results.nPages, (size_t)2);
+	CHECK_EQUAL(results.nRuns, (size_t)1);
+	CHECK(ReplayTrace(trace, replay, results, nFirst));
+	CHECK_EQUAL(results.nPages, (size_t)1);
+	CHECK_EQUAL(results.nURLs, (size_t)1);
+
+	// Records with the wrong size
+	TestTrace bad;
+	bad.Number(TR_STARTPAGE, 1);
+	bad.Record(TR_TEXT, std::string(sizeof(TraceText) + 1, '\0'));
+	CHECK(!ReplayTrace(bad, replay, results));
+	TestTrace badFont;
+	badFont.Record(TR_FONT, std::string(3, '\0'));
+	CHECK(!ReplayTrace(badFont, replay, results));
+	// A page link with longer strings than its data
+	TestTrace badLink;
+	TracePageLink link = {{0, 0, 0, 0}, 0, 0, 0, 1, 5, 0, 0};
+	badLink.Record(TR_PAGELINK, std::string((const char*)&link, sizeof(link)) + "ab");
+	CHECK(!ReplayTrace(badLink, replay, results));
+	// Variable width text without its positions
+	TestTrace noPos;
+	TraceText text = {{0, 0, 10, 10}, 0, 1, TTF_WIDTHS};
+	noPos.Record(TR_TEXT, std::string((const char*)&text, sizeof(text)) + std::string(2 + sizeof(POINTQF), '\0'));
+	CHECK(!ReplayTrace(noPos, replay, results));
+}
+
+/**
+	
+*/
+int main()
+{
+	TestAutoURLs();
+	TestLinkFile();
+	TestGlyphs();
+	TestInvalid();
+	return TestResult("ReplayTest");
+}
@@ -0,0 +1,690 @@
+/**
+	@file
+	@brief Win32 functions used by the portable sources, implemented for other systems
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+
+// Only what the portable tests need works: critical sections, timing, fonts from SetShimFonts and files in
+// memory. The fonts have no font file data, so the glyph translation code never uses the glyph disk cache
+// (the tests use it directly). Named mutexes are always acquired, as the tests run in one process; the
+// resource, bitmap and event functions just fail (the code that calls them handles that).
+
+/**
+	@param pcs The critical section
+*/
+void InitializeCriticalSection(CRITICAL_SECTION* pcs)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_t* pMutex = new pthread_mutex_t;
+	pthread_mutex_init(pMutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	pcs->pMutex = pMutex;
+}
+
+/**
+	@param pcs The critical section
+*/
+void DeleteCriticalSection(CRITICAL_SECTION* pcs)
+{
+	pthread_mutex_destroy((pthread_mutex_t*)pcs->pMutex);
+	delete (pthread_mutex_t*)pcs->pMutex;
+	pcs->pMutex = NULL;
+}
+
+/**
+	@param pcs The critical section
+*/
+void EnterCriticalSection(CRITICAL_SECTION* pcs)
+{
+	pthread_mutex_lock((pthread_mutex_t*)pcs->pMutex);
+}
+
+/**
+	@param pcs The critical section
+*/
+void LeaveCriticalSection(CRITICAL_SECTION* pcs)
+{
+	pthread_mutex_unlock((pthread_mutex_t*)pcs->pMutex);
+}
+
+/**
+    @brief An object behind a handle
+*/
+struct ShimHandle
+{
+	/// Destructor
+	virtual ~ShimHandle() {};
+};
+
+/**
+    @brief A named mutex (nobody else can own it)
+*/
+struct ShimMutex : public ShimHandle
+{
+};
+
+HANDLE CreateEvent(void*, BOOL, BOOL, LPCTSTR) {return NULL;}
+BOOL SetEvent(HANDLE) {return FALSE;}
+
+/**
+	@return The mutex
+*/
+HANDLE CreateMutex(void*, BOOL, LPCTSTR)
+{
+	return new ShimMutex;
+}
+
+/**
+	@param hMutex The mutex
+	@return TRUE if it's a mutex
+*/
+BOOL ReleaseMutex(HANDLE hMutex)
+{
+	return dynamic_cast<ShimMutex*>((ShimHandle*)hMutex) != NULL;
+}
+
+/**
+	@param hHandle The object to wait for
+	@return WAIT_OBJECT_0 for a mutex, WAIT_TIMEOUT for anything else
+*/
+DWORD WaitForSingleObject(HANDLE hHandle, DWORD)
+{
+	return ((hHandle != NULL) && (dynamic_cast<ShimMutex*>((ShimHandle*)hHandle) != NULL)) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+
+/**
+	@param hObject The handle
+	@return TRUE if closed
+*/
+BOOL CloseHandle(HANDLE hObject)
+{
+	if ((hObject == NULL) || (hObject == INVALID_HANDLE_VALUE))
+		return FALSE;
+	delete (ShimHandle*)hObject;
+	return TRUE;
+}
+
+/**
+	@param dwMilliseconds Time to sleep
+*/
+void Sleep(DWORD dwMilliseconds)
+{
+	usleep(dwMilliseconds * 1000);
+}
+
+/**
+	@return Milliseconds since some fixed time
+*/
+DWORD GetTickCount()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (DWORD)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+/**
+	@param uCodePage CP_ACP (Latin-1) or CP_UTF8
+	@param dwFlags Not used
+	@param lpMultiByte The string to convert
+	@param nMultiByte Length of the string, or -1 if it's NULL terminated (the terminator is converted too)
+	@param lpWide Buffer for the converted string (NULL to get the needed length)
+	@param nWide Size of the buffer
+	@return Number of characters in the converted string
+*/
+int MultiByteToWideChar(UINT uCodePage, DWORD, LPCSTR lpMultiByte, int nMultiByte, LPWSTR lpWide, int nWide)
+{
+	if (nMultiByte < 0)
+		nMultiByte = (int)strlen(lpMultiByte) + 1;
+	const BYTE* p = (const BYTE*)lpMultiByte;
+	const BYTE* pEnd = p + nMultiByte;
+	int nOut = 0;
+	while (p < pEnd)
+	{
+		WCHAR w = *p++;
+		if ((uCodePage == CP_UTF8) && (w >= 0xC0))
+		{
+			// Lead byte: its value bits, then 6 bits from each continuation byte
+			int nMore = (w >= 0xF0) ? 3 : ((w >= 0xE0) ? 2 : 1);
+			w &= 0x3F >> nMore;
+			for (; (nMore > 0) && (p < pEnd) && ((*p & 0xC0) == 0x80); nMore--)
+				w = (w << 6) | (*p++ & 0x3F);
+		}
+		if (lpWide != NULL)
+		{
+			if (nOut >= nWide)
+				return 0;
+			lpWide[nOut] = w;
+		}
+		nOut++;
+	}
+	return nOut;
+}
+
+/**
+	@param uCodePage CP_ACP (Latin-1) or CP_UTF8
+	@param dwFlags Not used
+	@param lpWide The string to convert
+	@param nWide Length of the string, or -1 if it's NULL terminated (the terminator is converted too)
+	@param lpMultiByte Buffer for the converted string (NULL to get the needed length)
+	@param nMultiByte Size of the buffer
+	@param lpDefault Not used ('?' replaces the characters Latin-1 doesn't have)
+	@param pbUsedDefault Not used
+	@return Number of bytes in the converted string
+*/
+int WideCharToMultiByte(UINT uCodePage, DWORD, LPCWSTR lpWide, int nWide, LPSTR lpMultiByte, int nMultiByte, LPCSTR, BOOL*)
+{
+	if (nWide < 0)
+		nWide = (int)wcslen(lpWide) + 1;
+	int nOut = 0;
+	for (int i = 0; i < nWide; i++)
+	{
+		unsigned int c = (unsigned int)lpWide[i];
+		BYTE cBytes[4];
+		int nBytes = 1;
+		if (uCodePage != CP_UTF8)
+			cBytes[0] = (c < 0x100) ? (BYTE)c : '?';
+		else if (c < 0x80)
+			cBytes[0] = (BYTE)c;
+		else
+		{
+			// Lead byte, then 6 bits in each continuation byte
+			nBytes = (c < 0x800) ? 2 : ((c < 0x10000) ? 3 : 4);
+			for (int j = nBytes - 1; j > 0; j--, c >>= 6)
+				cBytes[j] = (BYTE)(0x80 | (c & 0x3F));
+			cBytes[0] = (BYTE)((0xFF00 >> nBytes) | c);
+		}
+		if (lpMultiByte != NULL)
+		{
+			if (nOut + nBytes > nMultiByte)
+				return 0;
+			memcpy(lpMultiByte + nOut, cBytes, nBytes);
+		}
+		nOut += nBytes;
+	}
+	return nOut;
+}
+
+/**
+    @brief A file in memory
+*/
+struct ShimFile
+{
+	/// The file contents
+	std::vector<BYTE>	arData;
+	/// Amount of views mapping it (as on Windows, a mapped file cannot be replaced, deleted or rewritten)
+	int					nViews;
+};
+
+/**
+    @brief An open file
+*/
+struct ShimFileHandle : public ShimHandle
+{
+	/// The file
+	ShimFile*		pFile;
+	/// Current position
+	DWORD			dwPos;
+};
+
+/**
+    @brief A file mapping
+*/
+struct ShimMapping : public ShimHandle
+{
+	/// The mapped file
+	ShimFile*		pFile;
+};
+
+/**
+    @brief A file search: the names found
+*/
+struct ShimFind : public ShimHandle
+{
+	/// Names of the files found
+	std::vector<std::wstring>	arNames;
+	/// Index of the next name to return
+	size_t			nNext;
+};
+
+/// The files (by full path; there are no folders, a path just has to start with the temporary folder)
+static std::map<std::wstring, ShimFile*> s_files;
+/// The temporary folder
+static const wchar_t* s_lpTempPath = L"C:\\Temp\\";
+/// Last number used for a temporary file
+static UINT s_nTempFile = 0;
+
+/**
+	@param lpFileName Full path of the file
+	@return The file, or NULL if it doesn't exist
+*/
+static ShimFile* FindShimFile(LPCTSTR lpFileName)
+{
+	std::map<std::wstring, ShimFile*>::iterator it = s_files.find(lpFileName);
+	return (it == s_files.end()) ? NULL : it->second;
+}
+
+/**
+	@param lpMask The file name pattern (with * and ?)
+	@param lpName The file name
+	@return true if the name matches the pattern
+*/
+static bool MatchName(LPCTSTR lpMask, LPCTSTR lpName)
+{
+	if (*lpMask == '*')
+		return MatchName(lpMask + 1, lpName) || ((*lpName != '\0') && MatchName(lpMask, lpName + 1));
+	if (*lpMask == '\0')
+		return *lpName == '\0';
+	return (*lpName != '\0') && ((*lpMask == '?') || (towlower(*lpMask) == towlower(*lpName))) && MatchName(lpMask + 1, lpName + 1);
+}
+
+/**
+	@param nSize Size of the buffer in characters
+	@param lpBuffer Buffer for the path
+	@return Length of the path, or the size needed if the buffer is too small
+*/
+DWORD GetTempPath(DWORD nSize, LPTSTR lpBuffer)
+{
+	DWORD dwLen = (DWORD)wcslen(s_lpTempPath);
+	if (dwLen >= nSize)
+		return dwLen + 1;
+	wcscpy(lpBuffer, s_lpTempPath);
+	return dwLen;
+}
+
+/**
+	@param lpPath Folder of the file
+	@param lpPrefix File name prefix
+	@param uUnique Not used (always creates a new file)
+	@param lpTempFileName Buffer for the path (MAX_PATH characters)
+	@return The number used in the name, 0 if failed
+*/
+UINT GetTempFileName(LPCTSTR lpPath, LPCTSTR lpPrefix, UINT, LPTSTR lpTempFileName)
+{
+	do
+	{
+		s_nTempFile = (s_nTempFile + 1) & 0xFFFF;
+		if (swprintf(lpTempFileName, MAX_PATH, L"%ls%ls%04X.tmp", lpPath, lpPrefix, s_nTempFile) < 0)
+			return 0;
+	} while ((s_nTempFile == 0) || (FindShimFile(lpTempFileName) != NULL));
+	ShimFile* pFile = new ShimFile;
+	pFile->nViews = 0;
+	s_files[lpTempFileName] = pFile;
+	return s_nTempFile;
+}
+
+/**
+	@param lpFileName Full path of the file
+	@param dwAccess Not used
+	@param dwShareMode Not used
+	@param dwDisposition OPEN_EXISTING or CREATE_ALWAYS
+	@return Handle to the file, INVALID_HANDLE_VALUE if failed
+*/
+HANDLE CreateFile(LPCTSTR lpFileName, DWORD, DWORD, void*, DWORD dwDisposition, DWORD, HANDLE)
+{
+	ShimFile* pFile = FindShimFile(lpFileName);
+	if (dwDisposition == CREATE_ALWAYS)
+	{
+		if (pFile == NULL)
+		{
+			pFile = new ShimFile;
+			pFile->nViews = 0;
+			s_files[lpFileName] = pFile;
+		}
+		else if (pFile->nViews > 0)
+			return INVALID_HANDLE_VALUE;
+		pFile->arData.clear();
+	}
+	if (pFile == NULL)
+		return INVALID_HANDLE_VALUE;
+	ShimFileHandle* pHandle = new ShimFileHandle;
+	pHandle->pFile = pFile;
+	pHandle->dwPos = 0;
+	return pHandle;
+}
+
+/**
+	@param hFile The file
+	@param pdwSizeHigh Receives the high part of the size (0)
+	@return Size of the file
+*/
+DWORD GetFileSize(HANDLE hFile, DWORD* pdwSizeHigh)
+{
+	if (pdwSizeHigh != NULL)
+		*pdwSizeHigh = 0;
+	return (DWORD)((ShimFileHandle*)hFile)->pFile->arData.size();
+}
+
+/**
+	@param hFile The file
+	@param pBuffer Buffer for the data
+	@param dwSize Amount of bytes to read
+	@param pdwRead Receives the amount of bytes read
+	@return TRUE
+*/
+BOOL ReadFile(HANDLE hFile, void* pBuffer, DWORD dwSize, DWORD* pdwRead, void*)
+{
+	ShimFileHandle* pHandle = (ShimFileHandle*)hFile;
+	const std::vector<BYTE>& arData = pHandle->pFile->arData;
+	*pdwRead = (pHandle->dwPos >= arData.size()) ? 0 : std::min(dwSize, (DWORD)arData.size() - pHandle->dwPos);
+	if (*pdwRead > 0)
+		memcpy(pBuffer, &arData[pHandle->dwPos], *pdwRead);
+	pHandle->dwPos += *pdwRead;
+	return TRUE;
+}
+
+/**
+	@param hFile The file
+	@param pBuffer The data
+	@param dwSize Amount of bytes to write
+	@param pdwWritten Receives the amount of bytes written
+	@return TRUE if written, FALSE if the file is mapped
+*/
+BOOL WriteFile(HANDLE hFile, const void* pBuffer, DWORD dwSize, DWORD* pdwWritten, void*)
+{
+	ShimFileHandle* pHandle = (ShimFileHandle*)hFile;
+	std::vector<BYTE>& arData = pHandle->pFile->arData;
+	*pdwWritten = 0;
+	if (pHandle->pFile->nViews > 0)
+		return FALSE;
+	if (arData.size() < pHandle->dwPos + dwSize)
+		arData.resize(pHandle->dwPos + dwSize);
+	if (dwSize > 0)
+		memcpy(&arData[pHandle->dwPos], pBuffer, dwSize);
+	pHandle->dwPos += dwSize;
+	*pdwWritten = dwSize;
+	return TRUE;
+}
+
+/**
+	@param lpFileName Full path of the file
+	@return TRUE if deleted, FALSE if it doesn't exist or is mapped
+*/
+BOOL DeleteFile(LPCTSTR lpFileName)
+{
+	ShimFile* pFile = FindShimFile(lpFileName);
+	if ((pFile == NULL) || (pFile->nViews > 0))
+		return FALSE;
+	s_files.erase(lpFileName);
+	delete pFile;
+	return TRUE;
+}
+
+/**
+	@param lpExisting Full path of the file
+	@param lpNew Its new path
+	@param dwFlags MOVEFILE_REPLACE_EXISTING to replace a file with the new path (unless it's mapped)
+	@return TRUE if moved, FALSE if failed
+*/
+BOOL MoveFileEx(LPCTSTR lpExisting, LPCTSTR lpNew, DWORD dwFlags)
+{
+	ShimFile* pFile = FindShimFile(lpExisting);
+	if (pFile == NULL)
+		return FALSE;
+	if (FindShimFile(lpNew) != NULL)
+	{
+		if (((dwFlags & MOVEFILE_REPLACE_EXISTING) == 0) || !DeleteFile(lpNew))
+			return FALSE;
+	}
+	s_files.erase(lpExisting);
+	s_files[lpNew] = pFile;
+	return TRUE;
+}
+
+/**
+	@param hFile The file
+	@return Handle to the mapping, NULL if the file is empty
+*/
+HANDLE CreateFileMapping(HANDLE hFile, void*, DWORD, DWORD, DWORD, LPCTSTR)
+{
+	ShimFile* pFile = ((ShimFileHandle*)hFile)->pFile;
+	if (pFile->arData.empty())
+		return NULL;
+	ShimMapping* pMapping = new ShimMapping;
+	pMapping->pFile = pFile;
+	return pMapping;
+}
+
+/**
+	@param hMapping The mapping
+	@return The whole file contents
+*/
+void* MapViewOfFile(HANDLE hMapping, DWORD, DWORD, DWORD, size_t)
+{
+	ShimFile* pFile = ((ShimMapping*)hMapping)->pFile;
+	pFile->nViews++;
+	return &pFile->arData[0];
+}
+
+/**
+	@param pView The view
+	@return TRUE if it was mapped
+*/
+BOOL UnmapViewOfFile(const void* pView)
+{
+	for (std::map<std::wstring, ShimFile*>::iterator it = s_files.begin(); it != s_files.end(); it++)
+	{
+		ShimFile* pFile = it->second;
+		if ((pFile->nViews > 0) && (&pFile->arData[0] == pView))
+		{
+			pFile->nViews--;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+	@param lpFileName Full path pattern (with * and ? in the file name)
+	@param pData Receives the first file found
+	@return Handle to the search, INVALID_HANDLE_VALUE if no file was found
+*/
+HANDLE FindFirstFile(LPCTSTR lpFileName, WIN32_FIND_DATA* pData)
+{
+	LPCTSTR pSlash = wcsrchr(lpFileName, '\\');
+	std::wstring sFolder(lpFileName, (pSlash == NULL) ? 0 : pSlash + 1 - lpFileName);
+	LPCTSTR lpMask = lpFileName + sFolder.size();
+	ShimFind* pFind = new ShimFind;
+	pFind->nNext = 0;
+	for (std::map<std::wstring, ShimFile*>::iterator it = s_files.begin(); it != s_files.end(); it++)
+	{
+		const std::wstring& sPath = it->first;
+		if ((sPath.compare(0, sFolder.size(), sFolder) == 0) && (sPath.find('\\', sFolder.size()) == std::wstring::npos) &&
+			MatchName(lpMask, sPath.c_str() + sFolder.size()))
+			pFind->arNames.push_back(sPath.substr(sFolder.size()));
+	}
+	if (!FindNextFile(pFind, pData))
+	{
+		delete pFind;
+		return INVALID_HANDLE_VALUE;
+	}
+	return pFind;
+}
+
+/**
+	@param hFind The search
+	@param pData Receives the next file found
+	@return TRUE if found, FALSE if no more files
+*/
+BOOL FindNextFile(HANDLE hFind, WIN32_FIND_DATA* pData)
+{
+	ShimFind* pFind = (ShimFind*)hFind;
+	if ((pFind->nNext >= pFind->arNames.size()) || (pFind->arNames[pFind->nNext].size() >= MAX_PATH))
+		return FALSE;
+	memset(pData, 0, sizeof(WIN32_FIND_DATA));
+	pData->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	wcscpy(pData->cFileName, pFind->arNames[pFind->nNext++].c_str());
+	return TRUE;
+}
+
+/**
+	@param hFind The search
+	@return TRUE
+*/
+BOOL FindClose(HANDLE hFind)
+{
+	return CloseHandle(hFind);
+}
+
+HRSRC FindResource(HMODULE, LPCTSTR, LPCTSTR) {return NULL;}
+DWORD SizeofResource(HMODULE, HRSRC) {return 0;}
+HGLOBAL LoadResource(HMODULE, HRSRC) {return NULL;}
+LPVOID LockResource(HGLOBAL) {return NULL;}
+
+/**
+    @brief A font object: the description it was created with
+*/
+struct ShimFont
+{
+	/// The font description
+	LOGFONT			lf;
+};
+
+/**
+    @brief A device context: the selected font
+*/
+struct ShimDC
+{
+	/// The selected font (NULL if none)
+	ShimFont*		pFont;
+};
+
+/// The known fonts
+static ShimFonts* s_pFonts = NULL;
+/// The screen DC
+static ShimDC s_dcScreen = {NULL};
+/// Amount of GetGlyphIndices calls
+static size_t s_nGlyphCalls = 0;
+
+/**
+	@param pFonts The fonts (NULL for none)
+*/
+void SetShimFonts(ShimFonts* pFonts)
+{
+	s_pFonts = pFonts;
+}
+
+/**
+	@return Number of calls
+*/
+size_t GetShimGlyphCalls()
+{
+	return s_nGlyphCalls;
+}
+
+/**
+	@param plf The font description
+	@return The font
+*/
+HFONT CreateFontIndirect(const LOGFONT* plf)
+{
+	ShimFont* pFont = new ShimFont;
+	pFont->lf = *plf;
+	return pFont;
+}
+
+/**
+	@param hDC The device context
+	@param hObject The font to select
+	@return The previously selected font
+*/
+HGDIOBJ SelectObject(HDC hDC, HGDIOBJ hObject)
+{
+	ShimFont* pOld = hDC->pFont;
+	hDC->pFont = (ShimFont*)hObject;
+	return pOld;
+}
+
+/**
+	@param hObject The font
+	@return TRUE
+*/
+BOOL DeleteObject(HGDIOBJ hObject)
+{
+	delete (ShimFont*)hObject;
+	return TRUE;
+}
+
+HDC GetDC(HWND) {return &s_dcScreen;}
+int ReleaseDC(HWND, HDC) {return 1;}
+
+/**
+	@param hDC The device context (with the font selected)
+	@param pSet Buffer to receive the ranges (NULL to get the size needed)
+	@return Size of the data, or 0 if failed
+*/
+DWORD GetFontUnicodeRanges(HDC hDC, LPGLYPHSET pSet)
+{
+	std::vector<WCRANGE> ranges;
+	if ((s_pFonts == NULL) || (hDC->pFont == NULL) || !s_pFonts->GetRanges(hDC->pFont->lf, ranges))
+		return 0;
+	DWORD dwSize = (DWORD)(sizeof(GLYPHSET) + max((size_t)1, ranges.size()) * sizeof(WCRANGE) - sizeof(WCRANGE));
+	if (pSet != NULL)
+	{
+		pSet->cbThis = dwSize;
+		pSet->flAccel = 0;
+		pSet->cGlyphsSupported = 0;
+		pSet->cRanges = (DWORD)ranges.size();
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			pSet->ranges[i] = ranges[i];
+			pSet->cGlyphsSupported += ranges[i].cGlyphs;
+		}
+	}
+	return dwSize;
+}
+
+/**
+	@param hDC The device context (with the font selected)
+	@param lpChars The characters
+	@param nCount Amount of characters
+	@param[out] pGlyphs Buffer to receive the glyphs
+	@param dwFlags GGI_MARK_NONEXISTING_GLYPHS to get 0xFFFF for characters without a glyph (0 if not)
+	@return Amount of glyphs, or GDI_ERROR if failed
+*/
+DWORD GetGlyphIndices(HDC hDC, LPCWSTR lpChars, int nCount, WORD* pGlyphs, DWORD dwFlags)
+{
+	if ((s_pFonts == NULL) || (hDC->pFont == NULL))
+		return GDI_ERROR;
+	s_nGlyphCalls++;
+	if (!s_pFonts->CanReadGlyphs(hDC->pFont->lf))
+		return GDI_ERROR;
+	for (int i = 0; i < nCount; i++)
+	{
+		pGlyphs[i] = s_pFonts->GetGlyph(hDC->pFont->lf, lpChars[i]);
+		if ((pGlyphs[i] == 0xFFFF) && ((dwFlags & GGI_MARK_NONEXISTING_GLYPHS) == 0))
+			pGlyphs[i] = 0;
+	}
+	return (DWORD)nCount;
+}
+
+DWORD GetFontData(HDC, DWORD, DWORD, void*, DWORD) {return GDI_ERROR;}
+HBITMAP CreateCompatibleBitmap(HDC, int, int) {return NULL;}
+int SetDIBits(HDC, HBITMAP, UINT, UINT, const void*, const BITMAPINFO*, UINT) {return 0;}
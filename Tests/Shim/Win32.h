@@ -0,0 +1,253 @@
+/**
+	@file
+	@brief Win32 functions used by the glyph translation code, for building it on other systems (see Win32.cpp)
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _SHIM_WIN32_H_
+#define _SHIM_WIN32_H_
+
+#include <vector>
+
+// Included by precomp.h (after the basic types)
+
+#define MAX_PATH					260
+#define INFINITE					0xFFFFFFFF
+#define INVALID_HANDLE_VALUE		((HANDLE)(ptrdiff_t)-1)
+#define INVALID_FILE_SIZE			((DWORD)0xFFFFFFFF)
+#define GENERIC_READ				0x80000000
+#define GENERIC_WRITE				0x40000000
+#define FILE_SHARE_READ				0x00000001
+#define FILE_SHARE_DELETE			0x00000004
+#define CREATE_ALWAYS				2
+#define OPEN_EXISTING				3
+#define FILE_ATTRIBUTE_NORMAL		0x00000080
+#define PAGE_READONLY				0x02
+#define FILE_MAP_READ				0x0004
+#define MOVEFILE_REPLACE_EXISTING	0x00000001
+#define WAIT_OBJECT_0				0
+#define WAIT_ABANDONED				0x00000080
+#define WAIT_TIMEOUT				258
+
+// Strings
+#define _tcsrchr					wcsrchr
+inline int _tcscpy_s(wchar_t* lpDest, size_t nSize, const wchar_t* lpSrc) {if (wcslen(lpSrc) >= nSize) return 1; wcscpy(lpDest, lpSrc); return 0;}
+inline int _tcscat_s(wchar_t* lpDest, size_t nSize, const wchar_t* lpSrc) {if (wcslen(lpDest) + wcslen(lpSrc) >= nSize) return 1; wcscat(lpDest, lpSrc); return 0;}
+
+// Interlocked operations
+inline LONG InterlockedIncrement(volatile LONG* p) {return __sync_add_and_fetch(p, 1);}
+inline LONG InterlockedDecrement(volatile LONG* p) {return __sync_sub_and_fetch(p, 1);}
+inline LONG InterlockedExchange(volatile LONG* p, LONG l) {__sync_synchronize(); return __sync_lock_test_and_set(p, l);}
+inline PVOID InterlockedExchangePointer(PVOID volatile* p, PVOID pv) {__sync_synchronize(); return __sync_lock_test_and_set(p, pv);}
+
+// Threads
+/// A critical section (a recursive mutex)
+struct CRITICAL_SECTION {void* pMutex;};
+void InitializeCriticalSection(CRITICAL_SECTION* pcs);
+void DeleteCriticalSection(CRITICAL_SECTION* pcs);
+void EnterCriticalSection(CRITICAL_SECTION* pcs);
+void LeaveCriticalSection(CRITICAL_SECTION* pcs);
+HANDLE CreateEvent(void* pAttributes, BOOL bManualReset, BOOL bInitialState, LPCTSTR lpName);
+BOOL SetEvent(HANDLE hEvent);
+HANDLE CreateMutex(void* pAttributes, BOOL bInitialOwner, LPCTSTR lpName);
+BOOL ReleaseMutex(HANDLE hMutex);
+DWORD WaitForSingleObject(HANDLE hHandle, DWORD dwMilliseconds);
+BOOL CloseHandle(HANDLE hObject);
+void Sleep(DWORD dwMilliseconds);
+DWORD GetTickCount();
+
+// Text conversion (the ANSI code page is Latin-1 here)
+#define CP_ACP						0
+#define CP_UTF8						65001
+#define WC_COMPOSITECHECK			0x00000200
+#define WC_DEFAULTCHAR				0x00000040
+
+int MultiByteToWideChar(UINT uCodePage, DWORD dwFlags, LPCSTR lpMultiByte, int nMultiByte, LPWSTR lpWide, int nWide);
+int WideCharToMultiByte(UINT uCodePage, DWORD dwFlags, LPCWSTR lpWide, int nWide, LPSTR lpMultiByte, int nMultiByte, LPCSTR lpDefault, BOOL* pbUsedDefault);
+
+// Files
+DWORD GetTempPath(DWORD nSize, LPTSTR lpBuffer);
+UINT GetTempFileName(LPCTSTR lpPath, LPCTSTR lpPrefix, UINT uUnique, LPTSTR lpTempFileName);
+HANDLE CreateFile(LPCTSTR lpFileName, DWORD dwAccess, DWORD dwShareMode, void* pSecurity, DWORD dwDisposition, DWORD dwFlags, HANDLE hTemplate);
+DWORD GetFileSize(HANDLE hFile, DWORD* pdwSizeHigh);
+BOOL ReadFile(HANDLE hFile, void* pBuffer, DWORD dwSize, DWORD* pdwRead, void* pOverlapped);
+BOOL WriteFile(HANDLE hFile, const void* pBuffer, DWORD dwSize, DWORD* pdwWritten, void* pOverlapped);
+BOOL DeleteFile(LPCTSTR lpFileName);
+BOOL MoveFileEx(LPCTSTR lpExisting, LPCTSTR lpNew, DWORD dwFlags);
+HANDLE CreateFileMapping(HANDLE hFile, void* pAttributes, DWORD dwProtect, DWORD dwSizeHigh, DWORD dwSizeLow, LPCTSTR lpName);
+void* MapViewOfFile(HANDLE hMapping, DWORD dwAccess, DWORD dwOffsetHigh, DWORD dwOffsetLow, size_t nSize);
+BOOL UnmapViewOfFile(const void* pView);
+
+/// A file found by FindFirstFile
+struct WIN32_FIND_DATA
+{
+	DWORD		dwFileAttributes;
+	DWORD		nFileSizeHigh;
+	DWORD		nFileSizeLow;
+	TCHAR		cFileName[MAX_PATH];
+};
+
+HANDLE FindFirstFile(LPCTSTR lpFileName, WIN32_FIND_DATA* pData);
+BOOL FindNextFile(HANDLE hFind, WIN32_FIND_DATA* pData);
+BOOL FindClose(HANDLE hFind);
+
+// Resources
+typedef void*						HMODULE;
+typedef void*						HRSRC;
+typedef void*						HGLOBAL;
+#define MAKEINTRESOURCE(i)			((LPCTSTR)(size_t)(WORD)(i))
+
+HRSRC FindResource(HMODULE hModule, LPCTSTR lpName, LPCTSTR lpType);
+DWORD SizeofResource(HMODULE hModule, HRSRC hResource);
+HGLOBAL LoadResource(HMODULE hModule, HRSRC hResource);
+LPVOID LockResource(HGLOBAL hData);
+
+// GDI
+#define LF_FACESIZE					32
+#define GDI_ERROR					0xFFFFFFFF
+#define GGI_MARK_NONEXISTING_GLYPHS	0x0001
+
+typedef struct ShimDC*				HDC;
+typedef struct ShimFont*			HFONT;
+typedef void*						HGDIOBJ;
+typedef void*						HWND;
+
+/// Font description
+struct LOGFONT
+{
+	LONG		lfHeight;
+	LONG		lfWidth;
+	LONG		lfEscapement;
+	LONG		lfOrientation;
+	LONG		lfWeight;
+	BYTE		lfItalic;
+	BYTE		lfUnderline;
+	BYTE		lfStrikeOut;
+	BYTE		lfCharSet;
+	BYTE		lfOutPrecision;
+	BYTE		lfClipPrecision;
+	BYTE		lfQuality;
+	BYTE		lfPitchAndFamily;
+	WCHAR		lfFaceName[LF_FACESIZE];
+};
+
+/// A range of characters in a font
+struct WCRANGE
+{
+	WCHAR		wcLow;
+	WORD		cGlyphs;
+};
+
+/// The characters of a font
+typedef struct tagGLYPHSET
+{
+	DWORD		cbThis;
+	DWORD		flAccel;
+	DWORD		cGlyphsSupported;
+	DWORD		cRanges;
+	WCRANGE		ranges[1];
+} GLYPHSET, *LPGLYPHSET;
+
+/// A palette color
+struct RGBQUAD
+{
+	BYTE		rgbBlue;
+	BYTE		rgbGreen;
+	BYTE		rgbRed;
+	BYTE		rgbReserved;
+};
+
+/// Device independent bitmap description
+struct BITMAPINFOHEADER
+{
+	DWORD		biSize;
+	LONG		biWidth;
+	LONG		biHeight;
+	WORD		biPlanes;
+	WORD		biBitCount;
+	DWORD		biCompression;
+	DWORD		biSizeImage;
+	LONG		biXPelsPerMeter;
+	LONG		biYPelsPerMeter;
+	DWORD		biClrUsed;
+	DWORD		biClrImportant;
+};
+
+/// Device independent bitmap description with its palette
+struct BITMAPINFO
+{
+	BITMAPINFOHEADER	bmiHeader;
+	RGBQUAD				bmiColors[1];
+};
+
+#define BI_RGB						0
+#define DIB_RGB_COLORS				0
+typedef void*						HBITMAP;
+
+HFONT CreateFontIndirect(const LOGFONT* plf);
+HGDIOBJ SelectObject(HDC hDC, HGDIOBJ hObject);
+BOOL DeleteObject(HGDIOBJ hObject);
+HDC GetDC(HWND hWnd);
+int ReleaseDC(HWND hWnd, HDC hDC);
+DWORD GetFontUnicodeRanges(HDC hDC, LPGLYPHSET pSet);
+DWORD GetGlyphIndices(HDC hDC, LPCWSTR lpChars, int nCount, WORD* pGlyphs, DWORD dwFlags);
+DWORD GetFontData(HDC hDC, DWORD dwTable, DWORD dwOffset, void* pBuffer, DWORD dwSize);
+HBITMAP CreateCompatibleBitmap(HDC hDC, int nWidth, int nHeight);
+int SetDIBits(HDC hDC, HBITMAP hBitmap, UINT uStart, UINT uLines, const void* pBits, const BITMAPINFO* pInfo, UINT uUsage);
+
+/**
+    @brief The fonts the GDI functions know: set by the program (see SetShimFonts)
+*/
+class ShimFonts
+{
+public:
+	/// Destructor
+	virtual ~ShimFonts() {};
+	/**
+		@brief Returns the characters of a font
+		@param lf The font
+		@param[out] ranges The character ranges (first character and amount of characters)
+		@return true if the font exists, false if not
+	*/
+	virtual bool	GetRanges(const LOGFONT& lf, std::vector<WCRANGE>& ranges) = 0;
+	/**
+		@brief Returns the glyph of a character
+		@param lf The font
+		@param wChar The character
+		@return The glyph index, or 0xFFFF if the font has no glyph for it
+	*/
+	virtual WORD	GetGlyph(const LOGFONT& lf, WCHAR wChar) = 0;
+	/**
+		@brief Checks if the glyphs of a font can be read now
+		@param lf The font
+		@return false to make GetGlyphIndices fail
+	*/
+	virtual bool	CanReadGlyphs(const LOGFONT& lf) {return true;};
+};
+
+/// Sets the fonts used by the GDI functions (none are known until this is called)
+void SetShimFonts(ShimFonts* pFonts);
+/// Returns the amount of GetGlyphIndices calls made so far
+size_t GetShimGlyphCalls();
+
+#endif   //#define _SHIM_WIN32_H_
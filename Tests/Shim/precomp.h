@@ -0,0 +1,140 @@
+/**
+	@file
+	@brief Minimal Win32 definitions for building the portable sources and their tests on other systems
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+// This header is included before every source (see the Makefile), and uses the same include guard as the
+// plugin's precomp.h, so the Windows headers are never included. Only what the tested sources use is here.
+#ifndef _PRECOMP_H
+#define _PRECOMP_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <algorithm>
+#include <string>
+
+// Windows' min and max are macros, so the sources mix long and LONG (which is int here) in them
+using std::min;
+using std::max;
+inline long min(long a, long b) {return (a < b) ? a : b;}
+inline long max(long a, long b) {return (a > b) ? a : b;}
+
+// Basic types
+typedef unsigned char		BYTE;
+typedef unsigned short		WORD;
+typedef unsigned int		DWORD;
+typedef unsigned int		UINT;
+typedef int					BOOL;
+typedef int					LONG;
+typedef unsigned int		ULONG;
+typedef long long			LONGLONG;
+typedef unsigned long long	ULONGLONG;
+typedef long				HRESULT;
+typedef unsigned int		FLONG;
+typedef void*				PVOID;
+typedef void*				LPVOID;
+typedef void*				HANDLE;
+typedef wchar_t				WCHAR;
+typedef WCHAR*				PWSTR;
+typedef WCHAR*				LPWSTR;
+typedef const WCHAR*		LPCWSTR;
+typedef char				CHAR;
+typedef const char*			LPCSTR;
+typedef const char*			PCSTR;
+typedef char*				LPSTR;
+typedef ULONG				HGLYPH;
+typedef WORD*				LPWORD;
+
+/// 64-bit integer with access to its halves
+union LARGE_INTEGER
+{
+	struct
+	{
+		DWORD		LowPart;
+		LONG		HighPart;
+	};
+	LONGLONG	QuadPart;
+};
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+#define SUCCEEDED(h)	((HRESULT)(h) >= 0)
+
+// Generic text (the plugin is a Unicode build)
+#ifndef _UNICODE
+#define _UNICODE
+#endif
+typedef wchar_t				TCHAR;
+typedef TCHAR*				LPTSTR;
+typedef const TCHAR*		LPCTSTR;
+#define _T(x)		L##x
+
+// GDI structures
+struct RECTL {LONG left, top, right, bottom;};
+typedef RECTL RECT;
+struct POINTL {LONG x, y;};
+struct SIZEL {LONG cx, cy;};
+
+/// A glyph's location in a printed string
+typedef struct _GLYPHPOS
+{
+	HGLYPH		hg;
+	void*		pgdf;
+	POINTL		ptl;
+} GLYPHPOS, *PGLYPHPOS;
+/// A glyph's advance (28.4 fixed point in the high parts)
+struct POINTQF {LARGE_INTEGER x, y;};
+
+// Device objects (only passed through)
+typedef struct _DEVOBJ* PDEVOBJ;
+typedef void*				PPUBLISHERINFO;
+typedef void*				POEMDMPARAM;
+typedef void*				PPROPSHEETUI_INFO;
+
+// Debug output (see debug.h) is not needed
+#define KERNEL_MODE
+#define __TEXT(s)			L##s
+#define NOP_FUNCTION(...)	((void)0)
+#define _wcsnicmp			wcsncasecmp
+#define _wcsicmp			wcscasecmp
+
+// Processor features (the compiler only defines __SSE2__ where it's always there)
+#define PF_XMMI64_INSTRUCTIONS_AVAILABLE	10
+inline BOOL IsProcessorFeaturePresent(DWORD) {return TRUE;}
+
+#define COUNTOF(p)	(sizeof(p)/sizeof(*(p)))
+
+// The plugin is built with libpng 1.2: a name it uses that later versions dropped
+#define png_set_gray_1_2_4_to_8		png_set_expand_gray_1_2_4_to_8
+
+#include "tchar.h"
+#include "Win32.h"
+
+#endif
@@ -0,0 +1,41 @@
+/**
+	@file
+	@brief Generic text (TCHAR) functions of the Unicode build, for building the portable sources on other systems
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _SHIM_TCHAR_H_
+#define _SHIM_TCHAR_H_
+
+// The plugin is a Unicode build, so these are the wide character functions
+#define _tcslen			wcslen
+#define _tcscmp			wcscmp
+#define _tcsicmp		wcscasecmp
+#define _tcsnicmp		wcsncasecmp
+#define _tcsstr			wcsstr
+#define _tcschr			wcschr
+#define _ttoi(s)		((int)wcstol((s), NULL, 10))
+#define _tcstoul		wcstoul
+#define _stprintf_s		swprintf
+
+#endif   //#define _SHIM_TCHAR_H_
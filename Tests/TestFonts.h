@@ -0,0 +1,115 @@
+/**
+	@file
+	@brief Synthetic fonts for the glyph translation tests and benchmarks (see ShimFonts)
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _TESTFONTS_H_
+#define _TESTFONTS_H_
+
+#include <vector>
+
+/// A text font: ASCII, Latin-1, Cyrillic and punctuation, with some glyphs shared and some missing
+#define TESTFONT_TEXT		L"Test Sans"
+/// A large font: ASCII, CJK punctuation and CJK ideographs, with glyphs spread over all the glyph pages
+#define TESTFONT_WIDE		L"Test CJK"
+
+/**
+    @brief The fonts known to the shim's GDI functions in the tests
+*/
+class TestFonts : public ShimFonts
+{
+public:
+	/**
+		@brief Fills a font description
+		@param[out] lf The font description
+		@param lpFace The face name
+	*/
+	static void		MakeFont(LOGFONT& lf, const wchar_t* lpFace)
+	{
+		memset(&lf, 0, sizeof(lf));
+		lf.lfHeight = -12;
+		lf.lfWeight = 400;
+		wcsncpy(lf.lfFaceName, lpFace, LF_FACESIZE - 1);
+	};
+	/**
+		@brief Returns the glyph of a character
+		@param lpFace The font's face name
+		@param wChar The character
+		@return The glyph index, or 0xFFFF if the font has no glyph for it (or there's no such font)
+	*/
+	static WORD		GlyphOf(const wchar_t* lpFace, WCHAR wChar)
+	{
+		if (wcscasecmp(lpFace, TESTFONT_TEXT) == 0)
+		{
+			if ((wChar >= 0x20) && (wChar < 0x7F))
+				return (WORD)(3 + wChar - 0x20);
+			if (wChar == 0xA0)
+				// Same as the space
+				return 3;
+			if ((wChar > 0xA0) && (wChar <= 0xFF))
+				return (WORD)(100 + wChar - 0xA0);
+			if ((wChar >= 0x400) && (wChar < 0x500))
+				return ((wChar % 7) == 0) ? 0xFFFF : (WORD)(300 + wChar - 0x400);
+			if ((wChar >= 0x2000) && (wChar <= 0x200A))
+				return 3;
+			if ((wChar > 0x200A) && (wChar < 0x2070))
+				return (WORD)(600 + wChar - 0x2000);
+			return 0xFFFF;
+		}
+		if (wcscasecmp(lpFace, TESTFONT_WIDE) == 0)
+		{
+			if ((wChar >= 0x20) && (wChar < 0x7F))
+				return (WORD)(3 + wChar - 0x20);
+			if (((wChar >= 0x3000) && (wChar < 0x3100)) || ((wChar >= 0x4E00) && (wChar < 0xA000)))
+			{
+				if ((wChar % 13) == 0)
+					return 0xFFFF;
+				if ((wChar % 50) == 0)
+					// Same as the previous character
+					wChar--;
+				// Scattered over all the pages (without hitting the ASCII glyphs)
+				return (WORD)max(200U, (unsigned)(wChar * 40503) & 0xFFFF);
+			}
+			return 0xFFFF;
+		}
+		return 0xFFFF;
+	};
+
+	// ShimFonts
+	virtual bool	GetRanges(const LOGFONT& lf, std::vector<WCRANGE>& ranges)
+	{
+		static const WCRANGE s_text[] = {{0x20, 0x5F}, {0xA0, 0x60}, {0x400, 0x100}, {0x2000, 0x70}};
+		static const WCRANGE s_wide[] = {{0x20, 0x5F}, {0x3000, 0x100}, {0x4E00, 0x5200}};
+		if (wcscasecmp(lf.lfFaceName, TESTFONT_TEXT) == 0)
+			ranges.assign(s_text, s_text + COUNTOF(s_text));
+		else if (wcscasecmp(lf.lfFaceName, TESTFONT_WIDE) == 0)
+			ranges.assign(s_wide, s_wide + COUNTOF(s_wide));
+		else
+			return false;
+		return true;
+	};
+	virtual WORD	GetGlyph(const LOGFONT& lf, WCHAR wChar) {return GlyphOf(lf.lfFaceName, wChar);};
+};
+
+#endif   //#define _TESTFONTS_H_
@@ -0,0 +1,138 @@
+/**
+	@file
+	@brief Images for the PngImage tests and benchmark: the license badges, synthetic images and a nearest pixel stretch
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _TESTIMAGE_H_
+#define _TESTIMAGE_H_
+
+#include <vector>
+#include "PngImage.h"
+
+/// Folder of the license badges, relative to the tests' folder
+#define TESTIMAGE_FOLDER	"../General/res/"
+
+/**
+    @brief A PngImage that can also be loaded from a file, or created from pixels
+*/
+class TestImage : public PngImage
+{
+public:
+	/**
+		@brief Loads a PNG file the way the plugin loads the license badge resource
+		@param lpName Name of the file in TESTIMAGE_FOLDER
+		@param bKeepPalette true to keep palette images as they are (like the plugin), false to load them as BGR
+		@return true if loaded
+	*/
+	bool		Load(const char* lpName, bool bKeepPalette = true)
+	{
+		std::string sPath = std::string(TESTIMAGE_FOLDER) + lpName;
+		FILE* pFile = fopen(sPath.c_str(), "rb");
+		if (pFile == NULL)
+			return false;
+		std::vector<char> data;
+		char cBuffer[4096];
+		size_t nRead;
+		while ((nRead = fread(cBuffer, 1, sizeof(cBuffer), pFile)) > 0)
+			data.insert(data.end(), cBuffer, cBuffer + nRead);
+		fclose(pFile);
+		return !data.empty() && LoadFromBuffer(&data[0], (DWORD)data.size(), true, true, bKeepPalette);
+	};
+	/**
+		@brief Creates a 24 bit image
+		@param nWidth Width of the image
+		@param nHeight Height of the image
+		@param arBGR The pixels (3 bytes each, with no row padding)
+	*/
+	void		Create(int nWidth, int nHeight, const std::vector<BYTE>& arBGR)
+	{
+		clear();
+		m_nWidth = nWidth;
+		m_nHeight = nHeight;
+		m_nBitsPerPixel = 24;
+		m_nBytesPerRow = (nWidth * 3 + 3) & ~3;
+		m_pData = new BYTE[m_nBytesPerRow * nHeight];
+		for (int y = 0; y < nHeight; y++)
+			memcpy(m_pData + y * m_nBytesPerRow, &arBGR[y * nWidth * 3], nWidth * 3);
+	};
+};
+
+/**
+	@brief Returns a color component of an image's pixel (palette and grey pixels are expanded)
+	@param image The image
+	@param x Column of the pixel
+	@param y Row of the pixel
+	@param c The component: 0 for blue, 1 for green, 2 for red
+	@return The component's value
+*/
+inline BYTE ImagePixel(const PngImage& image, int x, int y, int c)
+{
+	const BYTE* pRow = image.GetBits() + y * image.GetWidthInBytes();
+	if (image.GetBitsPerPixel() == 8)
+	{
+		if (image.GetColorCount() == 0)
+			return pRow[x];
+		const RGBQUAD& rgb = image.GetPalette()[pRow[x]];
+		return (c == 0) ? rgb.rgbBlue : ((c == 1) ? rgb.rgbGreen : rgb.rgbRed);
+	}
+	return pRow[x * (image.GetBitsPerPixel() / 8) + c];
+}
+
+/**
+	@brief Stretches an image the way EngStretchBlt does with COLORONCOLOR: each target pixel is a copy of the
+			source pixel its center falls in
+	@param image The image
+	@param nWidth Width of the stretched image
+	@param nHeight Height of the stretched image
+	@param[out] arBGR Receives the stretched pixels (3 bytes each, with rows padded to 4 bytes like a bitmap's)
+*/
+inline void StretchNearest(const PngImage& image, int nWidth, int nHeight, std::vector<BYTE>& arBGR)
+{
+	// Source pixels as BGR (with no row padding)
+	int nSourceWidth = image.GetWidth(), nSourceHeight = image.GetHeight();
+	std::vector<BYTE> arSource(nSourceWidth * nSourceHeight * 3);
+	for (int y = 0; y < nSourceHeight; y++)
+		for (int x = 0; x < nSourceWidth; x++)
+			for (int c = 0; c < 3; c++)
+				arSource[(y * nSourceWidth + x) * 3 + c] = ImagePixel(image, x, y, c);
+
+	int nBytesPerRow = (nWidth * 3 + 3) & ~3;
+	arBGR.resize(nBytesPerRow * nHeight);
+	std::vector<int> arColumns(nWidth);
+	for (int x = 0; x < nWidth; x++)
+		arColumns[x] = (int)((x + 0.5) * nSourceWidth / nWidth) * 3;
+	for (int y = 0; y < nHeight; y++)
+	{
+		const BYTE* pIn = &arSource[(int)((y + 0.5) * nSourceHeight / nHeight) * nSourceWidth * 3];
+		BYTE* pOut = &arBGR[y * nBytesPerRow];
+		for (int x = 0; x < nWidth; x++, pOut += 3)
+		{
+			pOut[0] = pIn[arColumns[x]];
+			pOut[1] = pIn[arColumns[x] + 1];
+			pOut[2] = pIn[arColumns[x] + 2];
+		}
+	}
+}
+
+#endif   //#define _TESTIMAGE_H_
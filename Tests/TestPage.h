@@ -0,0 +1,112 @@
+/**
+	@file
+	@brief A synthetic printed page for the text search tests and benchmarks: strings with their glyph positions
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _TESTPAGE_H_
+#define _TESTPAGE_H_
+
+#include <vector>
+#include <string>
+
+/**
+    @brief A page of printed strings, with the glyph locations and widths the driver would get for them
+*/
+class TestPage
+{
+public:
+	/**
+		@brief A printed string
+	*/
+	struct Run
+	{
+		/// The text
+		std::wstring	sText;
+		/// Printed location
+		RECTL			rc;
+		/// Index of the first glyph in the page arrays
+		size_t			nFirst;
+	};
+
+	/// Height of each string
+	enum {LineHeight = 20};
+
+protected:
+	/// Definition: list of strings
+	typedef std::vector<Run> RUNS;
+
+	/// The printed strings
+	RUNS					m_runs;
+	/// Glyph locations of all the strings
+	std::vector<GLYPHPOS>	m_arGlyphs;
+	/// Glyph widths of all the strings
+	std::vector<POINTQF>	m_arWidths;
+
+public:
+	/**
+		@brief Adds a printed string
+		@param sText The text
+		@param x Left side of the string
+		@param y Top of the string
+		@param bVaryWidth true to give letters different widths, false to make all letters 10 wide
+		@return The right side of the string
+	*/
+	LONG			AddRun(const std::wstring& sText, LONG x, LONG y, bool bVaryWidth = false)
+	{
+		Run run;
+		run.sText = sText;
+		run.nFirst = m_arGlyphs.size();
+		run.rc.left = x;
+		run.rc.top = y;
+		run.rc.bottom = y + LineHeight;
+		for (size_t i = 0; i < sText.size(); i++)
+		{
+			GLYPHPOS pos = {0, NULL, {x, y}};
+			POINTQF width;
+			LONG lWidth = bVaryWidth ? 8 + (LONG)(sText[i] % 5) : 10;
+			width.x.LowPart = 0;
+			width.x.HighPart = lWidth << 4;
+			width.y.QuadPart = 0;
+			m_arGlyphs.push_back(pos);
+			m_arWidths.push_back(width);
+			x += lWidth;
+		}
+		run.rc.right = x;
+		m_runs.push_back(run);
+		return x;
+	};
+
+	/// Returns the number of printed strings
+	size_t			GetRunCount() const {return m_runs.size();};
+	/// Returns a printed string
+	const Run&		GetRun(size_t n) const {return m_runs[n];};
+	/// Returns the glyph locations of a printed string
+	const GLYPHPOS*	GetGlyphs(size_t n) const {return &m_arGlyphs[m_runs[n].nFirst];};
+	/// Returns the glyph widths of a printed string
+	const POINTQF*	GetWidths(size_t n) const {return &m_arWidths[m_runs[n].nFirst];};
+	/// Removes all the strings
+	void			Clear() {m_runs.clear(); m_arGlyphs.clear(); m_arWidths.clear();};
+};
+
+#endif   //#define _TESTPAGE_H_
@@ -0,0 +1,123 @@
+/**
+	@file
+	@brief Checks and timing helpers shared by the portable tests and benchmarks
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _TESTUTIL_H_
+#define _TESTUTIL_H_
+
+#include <stdio.h>
+#include <time.h>
+#include <string>
+
+/// Number of failed checks in this test program
+extern int g_nFailures;
+/// Number of checks made in this test program
+extern int g_nChecks;
+
+/**
+	@brief Reports a failed check
+	@param lpFile Source file of the check
+	@param nLine Source line of the check
+	@param lpText The failed condition
+*/
+inline void TestFailed(const char* lpFile, int nLine, const char* lpText)
+{
+	fprintf(stderr, "%s(%d): check failed: %s\n", lpFile, nLine, lpText);
+	g_nFailures++;
+}
+
+/// Checks a condition (the test goes on if it fails)
+#define CHECK(cond)				do {g_nChecks++; if (!(cond)) TestFailed(__FILE__, __LINE__, #cond);} while (0)
+/// Checks that two values are equal (the test goes on if they're not)
+#define CHECK_EQUAL(a, b)		do {g_nChecks++; if (!((a) == (b))) TestFailed(__FILE__, __LINE__, #a " == " #b);} while (0)
+
+/// Defines the check counters (once per test program)
+#define TEST_GLOBALS			int g_nFailures = 0; int g_nChecks = 0;
+
+/**
+	@brief Prints the test program's summary
+	@param lpName Name of the test program
+	@return The program's exit code: 0 if all the checks passed, 1 if not
+*/
+inline int TestResult(const char* lpName)
+{
+	printf("%s: %d checks, %d failed\n", lpName, g_nChecks, g_nFailures);
+	return (g_nFailures == 0) ? 0 : 1;
+}
+
+/**
+    @brief Measures elapsed (wall clock) time for benchmarks
+*/
+class BenchTimer
+{
+public:
+	/**
+		@brief Constructor: starts timing
+	*/
+	BenchTimer() {Restart();};
+
+protected:
+	/// Start time
+	timespec		m_tStart;
+
+public:
+	/**
+		@brief Starts timing again
+	*/
+	void			Restart() {clock_gettime(CLOCK_MONOTONIC, &m_tStart);};
+	/**
+		@brief Returns the time since the start
+		@return Elapsed time in seconds
+	*/
+	double			Elapsed() const {timespec tNow; clock_gettime(CLOCK_MONOTONIC, &tNow); return (tNow.tv_sec - m_tStart.tv_sec) + (tNow.tv_nsec - m_tStart.tv_nsec) / 1e9;};
+};
+
+/// Times each benchmark is repeated (the best time is reported, to filter out the noise of other processes)
+#define BENCH_ROUNDS		7
+
+/**
+	@brief Keeps the best of benchmark repeats
+	@param dBest The best time so far (0 if none)
+	@param dTime The time of the last repeat
+	@return The best time
+*/
+inline double BestTime(double dBest, double dTime)
+{
+	return ((dBest == 0) || (dTime < dBest)) ? dTime : dBest;
+}
+
+/**
+	@brief Prints a benchmark result line
+	@param lpName What was measured
+	@param dSeconds Time it took
+	@param dAmount Amount of work done (items, bytes...)
+	@param lpUnit Name of the work unit
+*/
+inline void BenchReport(const char* lpName, double dSeconds, double dAmount, const char* lpUnit)
+{
+	printf("%-40s %10.3f ms %12.1f %s/s\n", lpName, dSeconds * 1000, (dSeconds > 0) ? dAmount / dSeconds : 0, lpUnit);
+}
+
+#endif   //#define _TESTUTIL_H_
@@ -0,0 +1,130 @@
+/**
+	@file
+	@brief Benchmark of the page text capture (TextArea) on dense spreadsheet pages, against the old line list
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "TextPart.h"
+#include "Reference/OldTextPart.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/// Rows in each page
+#define SHEET_ROWS		80
+/// Columns in each page
+#define SHEET_COLUMNS	20
+/// Pages printed in each round
+#define SHEET_PAGES		50
+/// Width of each letter
+#define LETTER_WIDTH	10
+
+/**
+    @brief A spreadsheet cell as printed
+*/
+struct Cell
+{
+	/// The text
+	std::wstring	sText;
+	/// Printed location
+	RECTL			rc;
+};
+
+/**
+	@brief Creates a page of cells the way a spreadsheet prints it: column by column, with right-aligned
+			numbers in every third column and rows slightly off between columns
+	@param nPage The page number (changes the numbers)
+	@return The cells in printing order
+*/
+static std::vector<Cell> MakeSheet(int nPage)
+{
+	std::vector<Cell> cells;
+	for (int nColumn = 0; nColumn < SHEET_COLUMNS; nColumn++)
+		for (int nRow = 0; nRow < SHEET_ROWS; nRow++)
+		{
+			wchar_t cText[32];
+			swprintf(cText, 32, L"%d.%02d", nRow * nColumn + nPage, nColumn);
+			Cell cell;
+			cell.sText = cText;
+			LONG lWidth = (LONG)cell.sText.size() * LETTER_WIDTH;
+			cell.rc.left = nColumn * 120 + ((nColumn % 3 == 0) ? 100 - lWidth : 0);
+			cell.rc.top = nRow * 25 + (nColumn % 2);
+			cell.rc.right = cell.rc.left + lWidth;
+			cell.rc.bottom = cell.rc.top + 20;
+			cells.push_back(cell);
+		}
+	return cells;
+}
+
+/**
+	
+*/
+int main()
+{
+	std::vector<std::vector<Cell> > pages;
+	for (int nPage = 0; nPage < SHEET_PAGES; nPage++)
+		pages.push_back(MakeSheet(nPage));
+	char cName[64];
+
+	// Old: a run can only join the last line
+	double dBest = 0;
+	size_t nLines = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		nLines = 0;
+		for (size_t nPage = 0; nPage < pages.size(); nPage++)
+		{
+			Old::TextArea text;
+			for (size_t i = 0; i < pages[nPage].size(); i++)
+				text.AddLine(Old::TextLine(pages[nPage][i].sText, pages[nPage][i].rc, LETTER_WIDTH));
+			nLines += text.size();
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "old line list (%d lines/page)", (int)(nLines / pages.size()));
+	BenchReport(cName, dBest, (double)pages.size(), "pages");
+
+	// New: runs join their line through the band index, and are sorted when the page is done
+	TextArea text;
+	dBest = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		nLines = 0;
+		for (size_t nPage = 0; nPage < pages.size(); nPage++)
+		{
+			for (size_t i = 0; i < pages[nPage].size(); i++)
+				text.AddRun(pages[nPage][i].sText.data(), pages[nPage][i].sText.size(), pages[nPage][i].rc, LETTER_WIDTH);
+			text.Finalize();
+			nLines += text.GetLineCount();
+			text.Reset();
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "TextArea bands (%d lines/page)", (int)(nLines / pages.size()));
+	BenchReport(cName, dBest, (double)pages.size(), "pages");
+	return 0;
+}
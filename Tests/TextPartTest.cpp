@@ -0,0 +1,303 @@
+/**
+	@file
+	@brief Tests for the page text capture (TextArea): out-of-order strings merged into their lines
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "TextPart.h"
+#include "TestUtil.h"
+#include "TestPage.h"
+
+TEST_GLOBALS
+
+/// Width of each letter in the test strings
+#define LETTER_WIDTH	10
+
+/**
+	@brief Adds a string of a fixed-width font
+	@param text The page text
+	@param lpText The string
+	@param x Left side of the string
+	@param y Top of the string
+*/
+static void AddCell(TextArea& text, const wchar_t* lpText, LONG x, LONG y)
+{
+	size_t nLen = wcslen(lpText);
+	RECTL rc = {x, y, x + (LONG)nLen * LETTER_WIDTH, y + 20};
+	text.AddRun(lpText, nLen, rc, LETTER_WIDTH);
+}
+
+/**
+	@brief Adds a right-aligned string of a fixed-width font
+	@param text The page text
+	@param lpText The string
+	@param x Right side of the string
+	@param y Top of the string
+*/
+static void AddRightCell(TextArea& text, const wchar_t* lpText, LONG x, LONG y)
+{
+	AddCell(text, lpText, x - (LONG)wcslen(lpText) * LETTER_WIDTH, y);
+}
+
+/**
+	@brief Returns a line's words separated by spaces
+	@param text The page text
+	@param nLine Index of the line
+	@return The line's text
+*/
+static std::wstring LineText(const TextArea& text, size_t nLine)
+{
+	const TextLine& line = text.GetLine(nLine);
+	std::wstring s;
+	for (size_t nWord = line.nFirstWord; nWord < line.nFirstWord + line.nWords; nWord++)
+	{
+		if (!s.empty())
+			s += L' ';
+		s += text.GetText(text.GetWord(nWord));
+	}
+	return s;
+}
+
+/**
+	@brief Checks that a line's letters are left to right
+	@param text The page text
+	@param nLine Index of the line
+	@return true if they are
+*/
+static bool LineSorted(const TextArea& text, size_t nLine)
+{
+	const TextLine& line = text.GetLine(nLine);
+	const TextWord& first = text.GetWord(line.nFirstWord), & last = text.GetWord(line.nFirstWord + line.nWords - 1);
+	for (size_t nLetter = first.nFirst + 1; nLetter < last.nFirst + last.nCount; nLetter++)
+		if (text.GetStart(nLetter) < text.GetEnd(nLetter - 1))
+			return false;
+	return true;
+}
+
+/**
+	
+*/
+static void TestColumns()
+{
+	// A small sheet drawn column by column: names, right-aligned numbers, and a text column; the rows
+	// are a bit off each other like cells of different fonts
+	static const wchar_t* s_pCells[4][3] = {
+		{L"Apples", L"12", L"fresh"},
+		{L"Pears", L"7", L"ripe and sweet"},
+		{L"Plums", L"1024", L"dried"},
+		{L"Figs", L"33", L"none left"}};
+	TextArea text;
+	for (int nColumn = 0; nColumn < 3; nColumn++)
+		for (int nRow = 0; nRow < 4; nRow++)
+		{
+			LONG y = nRow * 25 + nColumn;
+			if (nColumn == 1)
+				AddRightCell(text, s_pCells[nRow][nColumn], 150, y);
+			else
+				AddCell(text, s_pCells[nRow][nColumn], nColumn * 100, y);
+		}
+	text.Finalize();
+
+	// One line per row, in the order they were first printed
+	CHECK_EQUAL(text.GetLineCount(), (size_t)4);
+	if (text.GetLineCount() == 4)
+	{
+		CHECK(LineText(text, 0) == L"Apples 12 fresh");
+		CHECK(LineText(text, 1) == L"Pears 7 ripe and sweet");
+		CHECK(LineText(text, 2) == L"Plums 1024 dried");
+		CHECK(LineText(text, 3) == L"Figs 33 none left");
+		for (size_t nLine = 0; nLine < 4; nLine++)
+		{
+			CHECK(LineSorted(text, nLine));
+			// The line covers all its cells
+			CHECK_EQUAL(text.GetLine(nLine).rcArea.left, 0);
+			CHECK_EQUAL(text.GetLine(nLine).rcArea.top, (LONG)nLine * 25);
+			CHECK_EQUAL(text.GetLine(nLine).rcArea.bottom, (LONG)nLine * 25 + 22);
+		}
+		CHECK_EQUAL(text.GetLine(1).rcArea.right, 340);
+	}
+}
+
+/**
+	
+*/
+static void TestRightToLeft()
+{
+	// Right-aligned numbers printed from the right, and a word printed in two pieces, second piece first
+	TextArea text;
+	AddRightCell(text, L"300", 300, 0);
+	AddRightCell(text, L"20", 200, 1);
+	AddRightCell(text, L"1", 100, 0);
+	AddCell(text, L"total", 0, 30);
+	AddCell(text, L"ber", 140, 30);
+	AddCell(text, L"num", 110, 31);
+	text.Finalize();
+
+	CHECK_EQUAL(text.GetLineCount(), (size_t)2);
+	if (text.GetLineCount() == 2)
+	{
+		CHECK(LineText(text, 0) == L"1 20 300");
+		// The touching pieces make one word after sorting
+		CHECK(LineText(text, 1) == L"total number");
+		CHECK(LineSorted(text, 0));
+		CHECK(LineSorted(text, 1));
+		CHECK_EQUAL(text.GetLine(1).rcArea.right, 170);
+	}
+
+	// Finalize again after adding more text: the new text joins its line
+	AddCell(text, L"0", 0, 0);
+	text.Finalize();
+	CHECK_EQUAL(text.GetLineCount(), (size_t)2);
+	if (text.GetLineCount() == 2)
+		CHECK(LineText(text, 0) == L"0 1 20 300");
+
+	// Reset starts an empty page
+	text.Reset();
+	text.Finalize();
+	CHECK(text.empty());
+	CHECK_EQUAL(text.GetLineCount(), (size_t)0);
+}
+
+/**
+	
+*/
+static void TestShuffledSheet()
+{
+	// Sheets with their cells printed in random order, and rows close enough to make the band search work
+	srand(5);
+	for (int nIteration = 0; nIteration < 200; nIteration++)
+	{
+		int nRows = 1 + rand() % 60, nColumns = 1 + rand() % 12;
+		std::vector<std::pair<int, int> > cells;
+		for (int nRow = 0; nRow < nRows; nRow++)
+			for (int nColumn = 0; nColumn < nColumns; nColumn++)
+				cells.push_back(std::make_pair(nRow, nColumn));
+		for (size_t i = cells.size(); i > 1; i--)
+			std::swap(cells[i - 1], cells[rand() % i]);
+
+		TextArea text;
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			wchar_t cCell[32];
+			swprintf(cCell, 32, L"r%dc%d", cells[i].first, cells[i].second);
+			LONG y = cells[i].first * 21 + rand() % 3;
+			if (cells[i].second % 2)
+				AddRightCell(text, cCell, cells[i].second * 100 + 90, y);
+			else
+				AddCell(text, cCell, cells[i].second * 100, y);
+		}
+		text.Finalize();
+
+		CHECK_EQUAL(text.GetLineCount(), (size_t)nRows);
+		for (size_t nLine = 0; nLine < text.GetLineCount(); nLine++)
+		{
+			// Which row is it?
+			std::wstring s = LineText(text, nLine);
+			int nRow = (int)wcstol(s.c_str() + 1, NULL, 10);
+			std::wstring sExpected;
+			for (int nColumn = 0; nColumn < nColumns; nColumn++)
+			{
+				wchar_t cCell[32];
+				swprintf(cCell, 32, (nColumn > 0) ? L" r%dc%d" : L"r%dc%d", nRow, nColumn);
+				sExpected += cCell;
+			}
+			CHECK(s == sExpected);
+			CHECK(LineSorted(text, nLine));
+		}
+	}
+}
+
+/**
+	@brief Captures a page the way the driver does: the strings and widths go through the scratch arena
+	@param text The page text
+	@param scratch The scratch arena
+	@param page The page
+*/
+static void CapturePage(TextArea& text, PageArena& scratch, const TestPage& page)
+{
+	for (size_t i = 0; i < page.GetRunCount(); i++)
+	{
+		const TestPage::Run& run = page.GetRun(i);
+		WCHAR* pText = (WCHAR*)scratch.Alloc((run.sText.size() + 1) * sizeof(WCHAR));
+		memcpy(pText, run.sText.c_str(), (run.sText.size() + 1) * sizeof(WCHAR));
+		POINTQF* pWidths = (POINTQF*)scratch.Alloc(run.sText.size() * sizeof(POINTQF));
+		memcpy(pWidths, page.GetWidths(i), run.sText.size() * sizeof(POINTQF));
+		text.AddRun(pText, run.sText.size(), run.rc, page.GetGlyphs(i), pWidths);
+	}
+	text.Finalize();
+}
+
+/**
+	
+*/
+static void TestSteadyState()
+{
+	// A full page of words, the cells of each row printed from right to left
+	TestPage page;
+	for (int nRow = 0; nRow < 60; nRow++)
+	{
+		for (int nColumn = 7; nColumn >= 0; nColumn--)
+		{
+			wchar_t cCell[32];
+			swprintf(cCell, 32, L"cell%d-%d value%d", nRow, nColumn, nRow * nColumn);
+			page.AddRun(cCell, nColumn * 200, nRow * (TestPage::LineHeight + 2), true);
+		}
+	}
+
+	// The first page allocates the memory...
+	TextArea text;
+	PageArena scratch;
+	CapturePage(text, scratch, page);
+	size_t nLines = text.GetLineCount(), nWords = text.GetWordCount();
+	CHECK_EQUAL(nLines, (size_t)60);
+	CHECK(text.GetHeapAllocations() > 0);
+	CHECK(scratch.GetBlockAllocations() > 0);
+
+	// ...and the same page again reuses it
+	for (int nPage = 0; nPage < 3; nPage++)
+	{
+		size_t nHeap = text.GetHeapAllocations(), nScratch = scratch.GetBlockAllocations();
+		text.Reset();
+		scratch.Reset();
+		CHECK(text.empty());
+		CapturePage(text, scratch, page);
+		CHECK_EQUAL(text.GetLineCount(), nLines);
+		CHECK_EQUAL(text.GetWordCount(), nWords);
+		CHECK_EQUAL(text.GetHeapAllocations(), nHeap);
+		CHECK_EQUAL(scratch.GetBlockAllocations(), nScratch);
+	}
+}
+
+/**
+	
+*/
+int main()
+{
+	TestColumns();
+	TestRightToLeft();
+	TestShuffledSheet();
+	TestSteadyState();
+	return TestResult("TextPartTest");
+}
@@ -0,0 +1,743 @@
+/**
+	@file
+	@brief Replays a recorded print job trace through the text, glyph, link and PostScript code, measuring each stage
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <map>
+#include <new>
+#include "CCTChar.h"
+#include "GlyphTranslator.h"
+#include "GlyphCache.h"
+#include "URLScanner.h"
+#include "TraceReplay.h"
+#include "TestUtil.h"
+
+/// Escape code for adding a link to the current page (see oemps.h)
+#define ESCAPE_LINK_DATA		0x667711aa
+/// Escape code: disable Auto URL link (see oemps.h)
+#define ESCAPE_DISABLE_AUTO_URL	0x667711ab
+/// Escape code for adding many links to the current page in one call (see oemps.h)
+#define ESCAPE_LINK_DATA_BATCH	0x667711ac
+
+// The escape data is recorded as the 64-bit plugin gets it: long is 4 bytes and size_t is 8 (see EscapeLinkData
+// and EscapeLinkBatch in oemps.h)
+/// Offset of the tooltip offset in ESCAPE_LINK_DATA data
+#define ESCAPE_TITLE_OFFSET		16
+/// Offset of the URL in ESCAPE_LINK_DATA data
+#define ESCAPE_URL_OFFSET		24
+/// Offset of the first record in ESCAPE_LINK_DATA_BATCH data
+#define BATCH_RECORDS_OFFSET	4
+/// Size of each record in ESCAPE_LINK_DATA_BATCH data
+#define BATCH_RECORD_SIZE		24
+
+size_t g_nAllocations = 0;
+size_t g_nAllocatedBytes = 0;
+
+// All the program's heap allocations are counted (the replay runs on a single thread)
+void* operator new(size_t nSize)
+{
+	g_nAllocations++;
+	g_nAllocatedBytes += nSize;
+	void* p = malloc((nSize == 0) ? 1 : nSize);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t nSize)
+{
+	return operator new(nSize);
+}
+
+void operator delete(void* p)
+{
+	free(p);
+}
+
+void operator delete[](void* p)
+{
+	free(p);
+}
+
+/**
+    @brief The GDI fonts of a replayed trace: each font has the glyphs of the characters the plugin translated
+
+	A character printed with more than one glyph only keeps the first one, so the other glyphs are not
+	translated in the replay (they are counted as mismatches).
+*/
+class TraceFonts : public ShimFonts
+{
+protected:
+	/**
+	    @brief A font's known glyphs
+	*/
+	struct Font
+	{
+		/// Constructor
+		Font(const LOGFONT& lf) : key(lf) {};
+
+		/// The font's identity
+		FontKey						key;
+		/// The glyph of each character
+		std::map<WCHAR, WORD>		glyphs;
+	};
+
+	// Members
+	/// The fonts
+	std::vector<Font>	m_arFonts;
+
+	/**
+		@brief Finds a font
+		@param lf The font description
+		@return The font, or NULL if there's no such font
+	*/
+	const Font*			Find(const LOGFONT& lf) const
+	{
+		FontKey key(lf);
+		for (size_t i = 0; i < m_arFonts.size(); i++)
+			if (m_arFonts[i].key == key)
+				return &m_arFonts[i];
+		return NULL;
+	};
+
+public:
+	/**
+		@brief Adds the glyphs of a translated string
+		@param lf The font description
+		@param sGlyphs The glyphs
+		@param sText The characters the plugin translated them into
+	*/
+	void				Add(const LOGFONT& lf, const std::wstring& sGlyphs, const std::wstring& sText)
+	{
+		Font* pFont = const_cast<Font*>(Find(lf));
+		if (pFont == NULL)
+		{
+			m_arFonts.push_back(Font(lf));
+			pFont = &m_arFonts.back();
+		}
+		for (size_t i = 0; i < sGlyphs.size(); i++)
+			if (sText[i] != GLYPH_UNKNOWN)
+				pFont->glyphs.insert(std::make_pair((WCHAR)sText[i], (WORD)sGlyphs[i]));
+	};
+
+	// ShimFonts
+	virtual bool		GetRanges(const LOGFONT& lf, std::vector<WCRANGE>& ranges)
+	{
+		const Font* pFont = Find(lf);
+		if (pFont == NULL)
+			return false;
+		ranges.clear();
+		for (std::map<WCHAR, WORD>::const_iterator i = pFont->glyphs.begin(); i != pFont->glyphs.end(); i++)
+		{
+			if (!ranges.empty() && (ranges.back().wcLow + ranges.back().cGlyphs == (*i).first) && (ranges.back().cGlyphs < 0xFFFF))
+				ranges.back().cGlyphs++;
+			else
+			{
+				WCRANGE range = {(*i).first, 1};
+				ranges.push_back(range);
+			}
+		}
+		return true;
+	};
+	virtual WORD		GetGlyph(const LOGFONT& lf, WCHAR wChar)
+	{
+		const Font* pFont = Find(lf);
+		if (pFont == NULL)
+			return 0xFFFF;
+		std::map<WCHAR, WORD>::const_iterator i = pFont->glyphs.find(wChar);
+		return (i == pFont->glyphs.end()) ? 0xFFFF : (*i).second;
+	};
+};
+
+/**
+    @brief Measures a replay stage: the time and the heap allocations from construction to destruction
+*/
+class StageTimer
+{
+public:
+	/**
+		@brief Constructor: starts measuring
+		@param stats The stage's measurements (added to when done)
+	*/
+	StageTimer(TraceReplay::StageStats& stats) : m_stats(stats), m_nAllocations(g_nAllocations), m_nBytes(g_nAllocatedBytes) {};
+	/**
+		@brief Destructor: adds the measurements to the stage's
+	*/
+	~StageTimer()
+	{
+		m_stats.dSeconds += m_timer.Elapsed();
+		m_stats.nAllocations += g_nAllocations - m_nAllocations;
+		m_stats.nBytes += g_nAllocatedBytes - m_nBytes;
+	};
+
+protected:
+	/// The stage's measurements
+	TraceReplay::StageStats&	m_stats;
+	/// Allocations at the start
+	size_t						m_nAllocations;
+	/// Allocated bytes at the start
+	size_t						m_nBytes;
+	/// The timer (started last, so it doesn't time the constructor)
+	BenchTimer					m_timer;
+};
+
+/**
+	@brief Reads a number from trace data
+	@param pData The data
+	@return The number
+*/
+static unsigned int ReadNumber(const unsigned char* pData)
+{
+	unsigned int u;
+	memcpy(&u, pData, sizeof(u));
+	return u;
+}
+
+/**
+	@brief Reads a UTF-16 string from trace data (each code unit becomes a character, so the glyphs stay aligned)
+	@param pData The string's data
+	@param nLen Length of the string (in characters)
+	@return The string
+*/
+static std::wstring ReadString(const unsigned char* pData, size_t nLen)
+{
+	std::wstring s(nLen, ' ');
+	for (size_t i = 0; i < nLen; i++)
+		s[i] = (WCHAR)(pData[i * 2] | (pData[i * 2 + 1] << 8));
+	return s;
+}
+
+/**
+	@brief Finds a null-terminated string in escape data
+	@param pData The escape data
+	@param nSize Size of the data
+	@param nOffset Offset of the string in the data
+	@param[out] s The string
+	@return true if the string is inside the data and terminated, false if not
+*/
+static bool ReadEscapeString(const unsigned char* pData, size_t nSize, size_t nOffset, std::string& s)
+{
+	if (nOffset >= nSize)
+		return false;
+	const char* pStart = (const char*)pData + nOffset;
+	const char* pEnd = (const char*)memchr(pStart, 0, nSize - nOffset);
+	if (pEnd == NULL)
+		return false;
+	s.assign(pStart, pEnd);
+	return true;
+}
+
+/**
+	@param uURLFlags Link types to find (see URLScanner::Flags)
+*/
+TraceReplay::TraceReplay(UINT uURLFlags /* = 0 */) : m_uURLFlags(uURLFlags), m_pFonts(new TraceFonts), m_bLinkData(false)
+{
+}
+
+/**
+	
+*/
+TraceReplay::~TraceReplay()
+{
+	delete m_pFonts;
+}
+
+/**
+	@param eStage The stage
+	@return The stage's name
+*/
+const char* TraceReplay::GetStageName(Stage eStage)
+{
+	static const char* s_pNames[ST_COUNT] = {"glyph translation", "text capture", "text link search", "URL detection", "PostScript output"};
+	return s_pNames[eStage];
+}
+
+/**
+	@param lpPath Path of the trace file
+	@return true if loaded, false if the file could not be opened or has invalid records
+
+	A truncated file (such as the trace of a job that is still printing) is loaded up to its last complete record.
+*/
+bool TraceReplay::Load(const char* lpPath)
+{
+	m_arPages.clear();
+	m_arFonts.clear();
+	delete m_pFonts;
+	m_pFonts = new TraceFonts;
+	m_bLinkData = false;
+
+	TraceReader reader;
+	if (!reader.Open(lpPath))
+		return false;
+
+	// Link escapes sent between pages are for the next page
+	std::vector<Link> arPending;
+	Page* pPage = NULL;
+	bool bAutoURLs = true;
+	size_t nFont = NONE;
+	while (reader.Next())
+	{
+		const unsigned char* pData = reader.GetData();
+		size_t nSize = reader.GetSize();
+		switch (reader.GetType())
+		{
+			case TR_STARTPAGE:
+				if (nSize < sizeof(unsigned int))
+					return false;
+				m_arPages.push_back(Page());
+				pPage = &m_arPages.back();
+				pPage->nPage = ReadNumber(pData);
+				pPage->bAutoURLs = bAutoURLs;
+				pPage->arEscapeLinks.swap(arPending);
+				break;
+			case TR_SENDPAGE:
+				pPage = NULL;
+				break;
+			case TR_FONT:
+				{
+					if (nSize != sizeof(TraceFont))
+						return false;
+					TraceFont font;
+					memcpy(&font, pData, sizeof(font));
+					LOGFONT lf;
+					memset(&lf, 0, sizeof(lf));
+					lf.lfHeight = font.nHeight;
+					lf.lfWeight = font.nWeight;
+					lf.lfItalic = font.cItalic;
+					lf.lfCharSet = font.cCharSet;
+					lf.lfPitchAndFamily = font.cPitchAndFamily;
+					for (int i = 0; (i < LF_FACESIZE - 1) && (i < (int)COUNTOF(font.sFaceName)) && (font.sFaceName[i] != 0); i++)
+						lf.lfFaceName[i] = font.sFaceName[i];
+					// Fonts used again are recorded again
+					for (nFont = 0; nFont < m_arFonts.size(); nFont++)
+						if (memcmp(&m_arFonts[nFont], &lf, sizeof(lf)) == 0)
+							break;
+					if (nFont == m_arFonts.size())
+						m_arFonts.push_back(lf);
+				}
+				break;
+			case TR_TEXT:
+				{
+					Run run;
+					if (!ReadText(pData, nSize, run))
+						return false;
+					if (pPage == NULL)
+						break;
+					if ((run.uFlags & TTF_GLYPHINDEX) != 0)
+					{
+						run.nFont = nFont;
+						// The plugin's translation tells us the font's glyphs
+						if ((nFont != NONE) && ((run.uFlags & TTF_TEXT) != 0))
+							m_pFonts->Add(m_arFonts[nFont], run.sGlyphs, run.sText);
+					}
+					pPage->arRuns.push_back(run);
+				}
+				break;
+			case TR_PAGELINK:
+				{
+					Link link;
+					if (!ReadPageLink(pData, nSize, link))
+						return false;
+					// Any page link means the job has a link file
+					m_bLinkData = true;
+					if (pPage != NULL)
+						pPage->arPageLinks.push_back(link);
+				}
+				break;
+			case TR_ESCAPE:
+				if (!ReadEscape(pData, nSize, (pPage == NULL) ? arPending : pPage->arEscapeLinks, bAutoURLs))
+					return false;
+				if (pPage != NULL)
+					pPage->bAutoURLs = bAutoURLs;
+				break;
+			default:
+				// Document start and end: nothing to replay
+				break;
+		}
+	}
+	return true;
+}
+
+/**
+	@param pData The record data
+	@param nSize Size of the data
+	@param[out] run The text output
+	@return true if read, false if the record is invalid
+*/
+bool TraceReplay::ReadText(const unsigned char* pData, size_t nSize, Run& run)
+{
+	if (nSize < sizeof(TraceText))
+		return false;
+	TraceText text;
+	memcpy(&text, pData, sizeof(text));
+	size_t nGlyphs = text.uGlyphs;
+	// Each glyph takes 2 bytes at least
+	if (nGlyphs > (nSize - sizeof(text)) / 2)
+		return false;
+	size_t nExpected = sizeof(text) + nGlyphs * 2;
+	if ((text.uFlags & TTF_POSITIONS) != 0)
+		nExpected += nGlyphs * 2 * sizeof(int);
+	// POINTQF is 16 bytes here too
+	if ((text.uFlags & TTF_WIDTHS) != 0)
+		nExpected += nGlyphs * sizeof(POINTQF);
+	if ((text.uFlags & TTF_TEXT) != 0)
+		nExpected += nGlyphs * 2;
+	if (nExpected != nSize)
+		return false;
+	// Variable width text is only captured with its positions and widths
+	if ((text.uCharInc == 0) && ((text.uFlags & (TTF_POSITIONS|TTF_WIDTHS)) != (TTF_POSITIONS|TTF_WIDTHS)))
+		return false;
+
+	run.rc.left = text.rcArea[0];
+	run.rc.top = text.rcArea[1];
+	run.rc.right = text.rcArea[2];
+	run.rc.bottom = text.rcArea[3];
+	run.nCharInc = (int)text.uCharInc;
+	run.uFlags = text.uFlags;
+	run.nFont = NONE;
+	pData += sizeof(text);
+	run.sGlyphs = ReadString(pData, nGlyphs);
+	pData += nGlyphs * 2;
+	if ((text.uFlags & TTF_POSITIONS) != 0)
+	{
+		run.arPos.resize(nGlyphs);
+		for (size_t i = 0; i < nGlyphs; i++)
+		{
+			int nPos[2];
+			memcpy(nPos, pData, sizeof(nPos));
+			pData += sizeof(nPos);
+			run.arPos[i].hg = (HGLYPH)run.sGlyphs[i];
+			run.arPos[i].pgdf = NULL;
+			run.arPos[i].ptl.x = nPos[0];
+			run.arPos[i].ptl.y = nPos[1];
+		}
+	}
+	if ((text.uFlags & TTF_WIDTHS) != 0)
+	{
+		run.arWidths.resize(nGlyphs);
+		memcpy(&run.arWidths[0], pData, nGlyphs * sizeof(POINTQF));
+		pData += nGlyphs * sizeof(POINTQF);
+	}
+	if ((text.uFlags & TTF_TEXT) != 0)
+		run.sText = ReadString(pData, nGlyphs);
+	return true;
+}
+
+/**
+	@param pData The record data
+	@param nSize Size of the data
+	@param[out] link The link
+	@return true if read, false if the record is invalid
+*/
+bool TraceReplay::ReadPageLink(const unsigned char* pData, size_t nSize, Link& link)
+{
+	if (nSize < sizeof(TracePageLink))
+		return false;
+	TracePageLink data;
+	memcpy(&data, pData, sizeof(data));
+	size_t nStrings = (nSize - sizeof(data)) / 2;
+	if (((nSize - sizeof(data)) % 2 != 0) || (data.uTextLen > nStrings) || (data.uURLLen > nStrings) || (data.uTitleLen > nStrings) ||
+		(data.uTextLen + data.uURLLen + data.uTitleLen != nStrings))
+		return false;
+
+	link.rc.left = data.rcArea[0];
+	link.rc.top = data.rcArea[1];
+	link.rc.right = data.rcArea[2];
+	link.rc.bottom = data.rcArea[3];
+	link.nPage = data.nPage;
+	link.ptOffset.x = data.nX;
+	link.ptOffset.y = data.nY;
+	link.nRepeat = data.nRepeat;
+	pData += sizeof(data);
+	link.sText = ReadString(pData, data.uTextLen);
+	pData += data.uTextLen * 2;
+	link.sURL = MakeAnsiString(ReadString(pData, data.uURLLen));
+	pData += data.uURLLen * 2;
+	link.sTitle = MakeAnsiString(ReadString(pData, data.uTitleLen));
+	return true;
+}
+
+/**
+	@param pData The record data
+	@param nSize Size of the data
+	@param[in,out] links The page's escape links (the escape's links are added)
+	@param[in,out] bAutoURLs Automatic URL detection flag (cleared by the disable escape)
+	@return true if read, false if the record is invalid (escapes the plugin rejects are ignored)
+*/
+bool TraceReplay::ReadEscape(const unsigned char* pData, size_t nSize, std::vector<Link>& links, bool& bAutoURLs)
+{
+	if (nSize < sizeof(unsigned int))
+		return false;
+	unsigned int uEscape = ReadNumber(pData);
+	pData += sizeof(unsigned int);
+	nSize -= sizeof(unsigned int);
+
+	Link link;
+	link.nPage = 0;
+	link.ptOffset.x = link.ptOffset.y = 0;
+	link.nRepeat = 0;
+	switch (uEscape)
+	{
+		case ESCAPE_LINK_DATA:
+			{
+				if (nSize <= ESCAPE_URL_OFFSET)
+					break;
+				int nRect[4];
+				memcpy(nRect, pData, sizeof(nRect));
+				ULONGLONG uTitle;
+				memcpy(&uTitle, pData + ESCAPE_TITLE_OFFSET, sizeof(uTitle));
+				if (!ReadEscapeString(pData, nSize, ESCAPE_URL_OFFSET, link.sURL))
+					break;
+				if ((uTitle > 0) && (uTitle < nSize - ESCAPE_URL_OFFSET) && !ReadEscapeString(pData, nSize, ESCAPE_URL_OFFSET + (size_t)uTitle, link.sTitle))
+					break;
+				link.rc.left = nRect[0];
+				link.rc.top = nRect[1];
+				link.rc.right = nRect[2];
+				link.rc.bottom = nRect[3];
+				links.push_back(link);
+			}
+			break;
+		case ESCAPE_LINK_DATA_BATCH:
+			{
+				if (nSize < BATCH_RECORDS_OFFSET)
+					break;
+				unsigned int uCount = ReadNumber(pData);
+				if (uCount > (nSize - BATCH_RECORDS_OFFSET) / BATCH_RECORD_SIZE)
+					break;
+				// The plugin adds none of the links if any of them is invalid
+				std::vector<Link> batch(uCount, link);
+				size_t n;
+				for (n = 0; n < uCount; n++)
+				{
+					int nRecord[6];
+					memcpy(nRecord, pData + BATCH_RECORDS_OFFSET + n * BATCH_RECORD_SIZE, sizeof(nRecord));
+					batch[n].rc.left = nRecord[0];
+					batch[n].rc.top = nRecord[1];
+					batch[n].rc.right = nRecord[2];
+					batch[n].rc.bottom = nRecord[3];
+					if (!ReadEscapeString(pData, nSize, (unsigned int)nRecord[4], batch[n].sURL))
+						break;
+					if ((nRecord[5] != 0) && !ReadEscapeString(pData, nSize, (unsigned int)nRecord[5], batch[n].sTitle))
+						break;
+				}
+				if (n == uCount)
+					links.insert(links.end(), batch.begin(), batch.end());
+			}
+			break;
+		case ESCAPE_DISABLE_AUTO_URL:
+			bAutoURLs = false;
+			break;
+	}
+	return true;
+}
+
+/**
+	@param[out] results The replay's measurements and counts
+
+	The glyph cache is kept by the process, so the glyph tables are only built in the first replay.
+*/
+void TraceReplay::Replay(Results& results)
+{
+	memset(&results, 0, sizeof(results));
+	m_sOutput.erase();
+	SetShimFonts(m_pFonts);
+	{
+		// A print job's translator
+		GlyphTranslator translator;
+		for (size_t i = 0; i < m_arPages.size(); i++)
+			ReplayPage(m_arPages[i], translator, results);
+	}
+	SetShimFonts(NULL);
+	results.nPages = m_arPages.size();
+}
+
+/**
+	@param page The page
+	@param translator The print job's glyph translator
+	@param[in,out] results The replay's measurements and counts (added to)
+*/
+void TraceReplay::ReplayPage(const Page& page, GlyphTranslator& translator, Results& results)
+{
+	// OEMStartPage: the text links are searched while the page is printed, and the text is only kept for the
+	// automatic URLs
+	bool bNeedText = !m_bLinkData && page.bAutoURLs;
+	{
+		StageTimer timer(results.stages[ST_MATCH]);
+		m_matcher.Clear();
+		size_t nLink = 0;
+		for (std::vector<Link>::const_iterator i = page.arPageLinks.begin(); i != page.arPageLinks.end(); i++, nLink++)
+			if (!(*i).IsLocation())
+				m_matcher.AddLink((*i).sText, (*i).nRepeat, nLink);
+		m_matcher.Start();
+	}
+	bool bMatchText = !m_matcher.IsEmpty();
+
+	// OEMTextOut: translate the glyphs
+	m_arTexts.resize(page.arRuns.size());
+	{
+		StageTimer timer(results.stages[ST_GLYPHS]);
+		for (size_t i = 0; i < page.arRuns.size(); i++)
+		{
+			const Run& run = page.arRuns[i];
+			m_arTexts[i] = NULL;
+			if ((run.uFlags & TTF_GLYPHINDEX) == 0)
+				m_arTexts[i] = run.sGlyphs.data();
+			else if (run.nFont != NONE)
+			{
+				const GlyphToText* pGlyphMap = translator.GetFontTranslation(m_arFonts[run.nFont]);
+				if (pGlyphMap != NULL)
+				{
+					WCHAR* pBuffer = (WCHAR*)m_scratch.Alloc((run.sGlyphs.size() + 1) * sizeof(WCHAR));
+					pGlyphMap->Translate(run.sGlyphs.data(), run.sGlyphs.size(), pBuffer);
+					pBuffer[run.sGlyphs.size()] = '\0';
+					m_arTexts[i] = pBuffer;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < page.arRuns.size(); i++)
+	{
+		const Run& run = page.arRuns[i];
+		results.nRuns++;
+		results.nGlyphs += run.sGlyphs.size();
+		if (m_arTexts[i] == NULL)
+			results.nMisses++;
+		else if ((run.uFlags & TTF_TEXT) != 0)
+		{
+			for (size_t j = 0; j < run.sText.size(); j++)
+				if (m_arTexts[i][j] != run.sText[j])
+					results.nMismatches++;
+		}
+	}
+
+	// OEMTextOut: keep the text, and/or search it for links
+	if (bNeedText)
+	{
+		StageTimer timer(results.stages[ST_TEXT]);
+		for (size_t i = 0; i < page.arRuns.size(); i++)
+		{
+			const Run& run = page.arRuns[i];
+			if (m_arTexts[i] == NULL)
+				continue;
+			if (run.nCharInc == 0)
+				m_text.AddRun(m_arTexts[i], run.sGlyphs.size(), run.rc, &run.arPos[0], &run.arWidths[0]);
+			else
+				m_text.AddRun(m_arTexts[i], run.sGlyphs.size(), run.rc, run.nCharInc);
+		}
+		if (!m_text.empty())
+			m_text.Finalize();
+	}
+	const LinkMatcher::MATCHES* pMatches = NULL;
+	if (bMatchText)
+	{
+		StageTimer timer(results.stages[ST_MATCH]);
+		for (size_t i = 0; i < page.arRuns.size(); i++)
+		{
+			const Run& run = page.arRuns[i];
+			if (m_arTexts[i] == NULL)
+				continue;
+			if (run.nCharInc == 0)
+				m_matcher.Feed(m_arTexts[i], run.sGlyphs.size(), run.rc, &run.arPos[0], &run.arWidths[0]);
+			else
+				m_matcher.Feed(m_arTexts[i], run.sGlyphs.size(), run.rc, run.nCharInc);
+		}
+		pMatches = &m_matcher.Finish();
+		results.nTextLinks += pMatches->size();
+	}
+
+	// OEMSendPage: find the URLs
+	m_arURLs.clear();
+	if (bNeedText && !m_text.empty())
+	{
+		StageTimer timer(results.stages[ST_URLS]);
+		std::wstring sURL;
+		RECTL rcArea;
+		URLScanner scanner(m_text, m_uURLFlags);
+		while (scanner.Next(rcArea, sURL))
+			m_arURLs.push_back(std::make_pair(rcArea, MakeAnsiString(sURL)));
+		results.nURLs += m_arURLs.size();
+	}
+
+	// OEMSendPage: write the links (internal links first, then the page's links in the order they were added)
+	{
+		StageTimer timer(results.stages[ST_PS]);
+		m_ps.Clear();
+		for (std::vector<Link>::const_iterator i = page.arPageLinks.begin(); i != page.arPageLinks.end(); i++)
+		{
+			if ((*i).IsLocation() && ((*i).nPage != 0))
+			{
+				m_ps.AddRect((*i).rc).AddNumber((long)(*i).nPage).AddNumber((long)(*i).ptOffset.x).AddNumber((long)(*i).ptOffset.y).AddOp("cc_jump").Add("\n");
+				results.nLinks++;
+			}
+		}
+		for (std::vector<Link>::const_iterator i = page.arEscapeLinks.begin(); i != page.arEscapeLinks.end(); i++, results.nLinks++)
+			AddURLLink((*i).rc, (*i).sURL, (*i).sTitle);
+		for (std::vector<Link>::const_iterator i = page.arPageLinks.begin(); i != page.arPageLinks.end(); i++)
+		{
+			if ((*i).IsLocation() && ((*i).nPage == 0))
+			{
+				AddURLLink((*i).rc, (*i).sURL, (*i).sTitle);
+				results.nLinks++;
+			}
+		}
+		if (pMatches != NULL)
+		{
+			for (LinkMatcher::MATCHES::const_iterator i = pMatches->begin(); i != pMatches->end(); i++, results.nLinks++)
+			{
+				const Link& link = page.arPageLinks[(*i).nLink];
+				AddURLLink((*i).rcArea, link.sURL, link.sTitle);
+			}
+		}
+		for (size_t i = 0; i < m_arURLs.size(); i++, results.nLinks++)
+			AddURLLink(m_arURLs[i].first, m_arURLs[i].second, std::string());
+	}
+	m_sOutput.append(m_ps.GetData(), m_ps.GetSize());
+
+	// Done with the page
+	if (bNeedText)
+	{
+		StageTimer timer(results.stages[ST_TEXT]);
+		m_text.Reset();
+	}
+	{
+		StageTimer timer(results.stages[ST_GLYPHS]);
+		m_scratch.Reset();
+	}
+}
+
+/**
+	@param rc Location of the link
+	@param sURL The target URL
+	@param sTitle The tooltip (empty for none)
+*/
+void TraceReplay::AddURLLink(const RECTL& rc, const std::string& sURL, const std::string& sTitle)
+{
+	m_ps.AddRect(rc).AddString(sURL);
+	if (sTitle.empty())
+		m_ps.AddOp("cc_url");
+	else
+		m_ps.AddString(sTitle).AddOp("cc_urlt");
+	m_ps.Add("\n");
+}
@@ -0,0 +1,261 @@
+/**
+	@file
+	@brief Replays a recorded print job trace through the text, glyph, link and PostScript code, measuring each stage
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#ifndef _TRACEREPLAY_H_
+#define _TRACEREPLAY_H_
+
+#include <string>
+#include <vector>
+#include "TraceFormat.h"
+#include "TextPart.h"
+#include "LinkMatcher.h"
+#include "PSWriter.h"
+
+/// Number of heap allocations (operator new calls) made by the program so far
+extern size_t g_nAllocations;
+/// Number of bytes allocated by the program so far
+extern size_t g_nAllocatedBytes;
+
+/**
+    @brief Replays a print job trace (see TraceFormat.h) through the plugin's portable code
+
+	The trace is loaded into memory first, and then each page is replayed the way OEMTextOut and OEMSendPage
+	handle it: the glyph text is translated with GlyphTranslator, the text is captured into a TextArea and/or
+	fed to the LinkMatcher, the page text is scanned for URLs, and the page's links are written with PSWriter.
+	The glyph tables are built by the shim's GDI functions from the glyph/character pairs in the trace.
+	Each stage is timed separately, and the heap allocations made in it are counted.
+
+	Only the work done by the plugin's code is replayed: the escape data is parsed when loading, and the
+	automatic URL scan is done in place (the plugin can do it on a background thread; the work is the same).
+*/
+class TraceReplay
+{
+public:
+	/// Replay stages
+	enum Stage
+	{
+		/// Glyph index translation (GlyphTranslator)
+		ST_GLYPHS,
+		/// Text capture (TextArea::AddRun and Finalize)
+		ST_TEXT,
+		/// Text link search (LinkMatcher)
+		ST_MATCH,
+		/// Automatic URL detection (URLScanner)
+		ST_URLS,
+		/// Link output (PSWriter)
+		ST_PS,
+
+		ST_COUNT
+	};
+
+	/**
+	    @brief The measurements of a single stage
+	*/
+	struct StageStats
+	{
+		/// Time spent in the stage
+		double			dSeconds;
+		/// Heap allocations made in the stage
+		size_t			nAllocations;
+		/// Bytes allocated in the stage
+		size_t			nBytes;
+	};
+
+	/**
+	    @brief The results of a replay
+	*/
+	struct Results
+	{
+		/// The stages' measurements
+		StageStats		stages[ST_COUNT];
+		/// Pages replayed
+		size_t			nPages;
+		/// Text outputs replayed
+		size_t			nRuns;
+		/// Glyphs (and characters) replayed
+		size_t			nGlyphs;
+		/// Glyph text that could not be translated
+		size_t			nMisses;
+		/// Translated glyphs that are not the character the plugin recorded
+		size_t			nMismatches;
+		/// Text links found
+		size_t			nTextLinks;
+		/// URLs found
+		size_t			nURLs;
+		/// Links written
+		size_t			nLinks;
+	};
+
+	// Ctors
+	/// Constructor
+	TraceReplay(UINT uURLFlags = 0);
+	/// Destructor
+	~TraceReplay();
+
+protected:
+	/**
+	    @brief A recorded text output
+	*/
+	struct Run
+	{
+		/// Background rectangle
+		RECTL					rc;
+		/// Fixed character width (0 for variable width)
+		int						nCharInc;
+		/// TTF_xxx flags
+		UINT					uFlags;
+		/// Index of the font (NONE if there was no font record)
+		size_t					nFont;
+		/// The characters or glyph indices
+		std::wstring			sGlyphs;
+		/// The text the plugin translated the glyphs into (empty if not recorded)
+		std::wstring			sText;
+		/// The glyph positions (variable width only)
+		std::vector<GLYPHPOS>	arPos;
+		/// The glyph advance widths (variable width only)
+		std::vector<POINTQF>	arWidths;
+	};
+
+	/**
+	    @brief A link written into a page
+	*/
+	struct Link
+	{
+		/// Location of the link
+		RECTL					rc;
+		/// Target page (internal links only)
+		int						nPage;
+		/// Target offset (internal links only)
+		POINTL					ptOffset;
+		/// The link's text (text links only)
+		std::wstring			sText;
+		/// Repeat count (text links only)
+		int						nRepeat;
+		/// Target URL
+		std::string				sURL;
+		/// Tooltip (empty for none)
+		std::string				sTitle;
+
+		/**
+			@brief Checks if this is a location link
+			@return true if the link has a location, false if its text must be found
+		*/
+		bool					IsLocation() const {return sText.empty();};
+	};
+
+	/**
+	    @brief A recorded page
+	*/
+	struct Page
+	{
+		/// The page number
+		UINT					nPage;
+		/// false if automatic URL detection was disabled (from this page on)
+		bool					bAutoURLs;
+		/// The text outputs
+		std::vector<Run>		arRuns;
+		/// The links loaded from the link file
+		std::vector<Link>		arPageLinks;
+		/// The links received through escapes
+		std::vector<Link>		arEscapeLinks;
+	};
+
+	/// No font mark
+	static const size_t NONE = (size_t)-1;
+
+	// Members
+	/// Link types to find (see URLScanner::Flags)
+	UINT						m_uURLFlags;
+	/// The pages
+	std::vector<Page>			m_arPages;
+	/// The fonts
+	std::vector<LOGFONT>		m_arFonts;
+	/// The GDI fonts made of the trace's glyphs
+	class TraceFonts*			m_pFonts;
+	/// true if the job had a link file (text links are searched, no automatic URLs)
+	bool						m_bLinkData;
+	/// The page text
+	TextArea					m_text;
+	/// The text link search
+	LinkMatcher					m_matcher;
+	/// The translated text
+	PageArena					m_scratch;
+	/// The text of each output in the page (NULL if not translated)
+	std::vector<const WCHAR*>	m_arTexts;
+	/// The URLs found in the page
+	std::vector<std::pair<RECTL, std::string> >	m_arURLs;
+	/// The page's link output
+	PSWriter					m_ps;
+	/// The output of all the pages
+	std::string					m_sOutput;
+
+public:
+	// Data Access
+	/**
+		@brief Returns the amount of pages loaded
+		@return Number of pages
+	*/
+	size_t						GetPageCount() const {return m_arPages.size();};
+	/**
+		@brief Returns the amount of fonts loaded
+		@return Number of fonts
+	*/
+	size_t						GetFontCount() const {return m_arFonts.size();};
+	/**
+		@brief Returns the PostScript written by the last replay
+		@return The link code of all the pages
+	*/
+	const std::string&			GetOutput() const {return m_sOutput;};
+	/// Returns a stage's name
+	static const char*			GetStageName(Stage eStage);
+
+	// Methods
+	/// Loads a trace file
+	bool						Load(const char* lpPath);
+	/// Replays the loaded trace
+	void						Replay(Results& results);
+
+protected:
+	// Helpers
+	/// Reads a text record
+	bool						ReadText(const unsigned char* pData, size_t nSize, Run& run);
+	/// Reads a page link record
+	bool						ReadPageLink(const unsigned char* pData, size_t nSize, Link& link);
+	/// Reads a link escape record
+	bool						ReadEscape(const unsigned char* pData, size_t nSize, std::vector<Link>& links, bool& bAutoURLs);
+	/// Replays a page
+	void						ReplayPage(const Page& page, class GlyphTranslator& translator, Results& results);
+	/// Writes a URL link
+	void						AddURLLink(const RECTL& rc, const std::string& sURL, const std::string& sTitle);
+
+private:
+	/// Not copyable
+	TraceReplay(const TraceReplay&);
+	/// Not copyable
+	TraceReplay& operator=(const TraceReplay&);
+};
+
+#endif   //#define _TRACEREPLAY_H_
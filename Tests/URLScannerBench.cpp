@@ -0,0 +1,151 @@
+/**
+	@file
+	@brief Benchmark of the URL detection (URLScanner), scalar and SSE2, against the old TextArea::SearchForURL
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "URLScanner.h"
+#include "Reference/OldTextPart.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/// Lines in each page
+#define PAGE_LINES		120
+/// Words in each line
+#define LINE_WORDS		14
+/// Pages scanned in each round
+#define PAGES			100
+/// Width of each letter
+#define LETTER_WIDTH	10
+
+/**
+	@brief Creates the lines of a page
+	@param nURLEvery Put a URL every this many words (0 for none)
+	@param bNumbers true for a page of numbers (a printed spreadsheet: many dots, few links), false for prose
+	@return The lines
+*/
+static std::vector<std::wstring> MakePage(int nURLEvery, bool bNumbers)
+{
+	static const wchar_t* s_pWords[] = {L"the", L"quarterly", L"report", L"shows", L"that", L"sales", L"grew,", L"while", L"costs", L"(mostly", L"freight)", L"fell."};
+	std::vector<std::wstring> lines;
+	int nWord = 0;
+	for (int nLine = 0; nLine < PAGE_LINES; nLine++)
+	{
+		std::wstring sLine;
+		for (int i = 0; i < LINE_WORDS; i++, nWord++)
+		{
+			if (i > 0)
+				sLine += L' ';
+			wchar_t cWord[64];
+			if ((nURLEvery > 0) && (nWord % nURLEvery == nURLEvery - 1))
+				swprintf(cWord, 64, L"http://www.example%d.com/page?id=%d", nWord % 7, nWord);
+			else if (bNumbers)
+				swprintf(cWord, 64, L"%d.%02d", nWord * 37 % 10000, nWord % 100);
+			else
+				wcscpy(cWord, s_pWords[nWord % COUNTOF(s_pWords)]);
+			sLine += cWord;
+		}
+		lines.push_back(sLine);
+	}
+	return lines;
+}
+
+/**
+	@brief Measures the URL detection on a kind of page
+	@param lpName Name of the page kind
+	@param lines The page's lines
+*/
+static void BenchPage(const char* lpName, const std::vector<std::wstring>& lines)
+{
+	size_t nLetters = 0;
+	for (size_t i = 0; i < lines.size(); i++)
+		nLetters += lines[i].size();
+	double dMLetters = (double)nLetters * PAGES / 1e6;
+	char cName[128];
+	std::wstring sURL;
+	RECTL rc;
+
+	// Old: each word copied into a string, and compared with the prefixes
+	Old::TextArea oldText;
+	TextArea text;
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		RECTL rcLine = {0, (LONG)i * 30, (LONG)lines[i].size() * LETTER_WIDTH, (LONG)i * 30 + 20};
+		oldText.AddLine(Old::TextLine(lines[i], rcLine, LETTER_WIDTH));
+		text.AddRun(lines[i].data(), lines[i].size(), rcLine, LETTER_WIDTH);
+	}
+	text.Finalize();
+	double dBest = 0;
+	size_t nFound = 0;
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+	{
+		BenchTimer timer;
+		nFound = 0;
+		for (int nPage = 0; nPage < PAGES; nPage++)
+		{
+			oldText.InitSearch();
+			while (oldText.SearchForURL(rc, sURL))
+				nFound++;
+		}
+		dBest = BestTime(dBest, timer.Elapsed());
+	}
+	sprintf(cName, "old, %s (%d found)", lpName, (int)(nFound / PAGES));
+	BenchReport(cName, dBest, dMLetters, "M letters");
+
+	// New: the scanner, with the scalar and the SSE2 letter search
+	static const UINT s_uFlags[] = {URLScanner::SCAN_SCALAR, 0};
+	static const char* s_pNames[] = {"scalar", "SSE2"};
+	for (int nMethod = 0; nMethod < 2; nMethod++)
+	{
+		dBest = 0;
+		for (int r = 0; r < BENCH_ROUNDS; r++)
+		{
+			BenchTimer timer;
+			nFound = 0;
+			for (int nPage = 0; nPage < PAGES; nPage++)
+			{
+				URLScanner scanner(text, s_uFlags[nMethod]);
+				while (scanner.Next(rc, sURL))
+					nFound++;
+			}
+			dBest = BestTime(dBest, timer.Elapsed());
+		}
+		sprintf(cName, "%s, %s (%d found)", s_pNames[nMethod], lpName, (int)(nFound / PAGES));
+		BenchReport(cName, dBest, dMLetters, "M letters");
+	}
+}
+
+/**
+	
+*/
+int main()
+{
+	BenchPage("no links", MakePage(0, false));
+	BenchPage("1 link in 50", MakePage(50, false));
+	BenchPage("1 link in 5", MakePage(5, false));
+	BenchPage("numbers", MakePage(0, true));
+	return 0;
+}
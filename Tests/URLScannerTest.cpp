@@ -0,0 +1,287 @@
+/**
+	@file
+	@brief Tests for the page link detection (URLScanner): link types, trimming, flags, and SSE2 against scalar search
+*/
+
+/*
+ * CC PDF Converter: Windows PDF Printer with Creative Commons license support
+ * Excel to PDF Converter: Excel PDF printing addin, keeping hyperlinks AND Creative Commons license support
+ * Copyright (C) 2007-2010 Guy Hachlili <hguy@cogniview.com>, Cogniview LTD.
+ *
+ * This file is part of CC PDF Converter / Excel to PDF Converter
+ *
+ * CC PDF Converter and Excel to PDF Converter are free software;
+ * you can redistribute them and/or modify them under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * CC PDF Converter and Excel to PDF Converter are is distributed in the hope
+ * that they will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ */
+
+#include "precomp.h"
+#include <vector>
+#include "URLScanner.h"
+#include "TestUtil.h"
+
+TEST_GLOBALS
+
+/// Width of each letter in the test strings
+#define LETTER_WIDTH	10
+
+/**
+    @brief A found link
+*/
+struct Found
+{
+	/// The link target
+	std::wstring	sURL;
+	/// Its location
+	RECTL			rc;
+
+	/// Compares two found links
+	bool operator==(const Found& other) const {return (sURL == other.sURL) && (rc.left == other.rc.left) && (rc.top == other.rc.top) && (rc.right == other.rc.right) && (rc.bottom == other.rc.bottom);};
+};
+
+/// Definition: list of found links
+typedef std::vector<Found> FOUNDLIST;
+
+/**
+	@brief Adds a line of text, printed at the left margin
+	@param text The page text
+	@param sLine The line
+	@param nLine The line number
+*/
+static void AddLine(TextArea& text, const std::wstring& sLine, int nLine)
+{
+	RECTL rc = {0, nLine * 30, (LONG)sLine.size() * LETTER_WIDTH, nLine * 30 + 20};
+	text.AddRun(sLine.data(), sLine.size(), rc, LETTER_WIDTH);
+}
+
+/**
+	@brief Finds all the links in the text
+	@param text The (finalized) page text
+	@param uFlags The scanner's flags
+	@return The found links
+*/
+static FOUNDLIST ScanAll(const TextArea& text, UINT uFlags)
+{
+	FOUNDLIST found;
+	URLScanner scanner(text, uFlags);
+	Found link;
+	while (scanner.Next(link.rc, link.sURL))
+		found.push_back(link);
+	return found;
+}
+
+/**
+	@brief Scans a single line, with both search methods
+	@param sLine The text line
+	@param uFlags The scanner's flags
+	@return The found links (if both methods found the same)
+*/
+static FOUNDLIST ScanLine(const std::wstring& sLine, UINT uFlags)
+{
+	TextArea text;
+	AddLine(text, sLine, 0);
+	text.Finalize();
+	FOUNDLIST found = ScanAll(text, uFlags);
+	CHECK(ScanAll(text, uFlags | URLScanner::SCAN_SCALAR) == found);
+	return found;
+}
+
+/**
+	@brief Checks the link found in a line
+	@param lpLine The text line
+	@param uFlags The scanner's flags
+	@param lpURL The expected link target, or NULL if no link should be found
+	@return true if the line had the expected link (and nothing else)
+*/
+static bool FindsURL(const wchar_t* lpLine, UINT uFlags, const wchar_t* lpURL)
+{
+	FOUNDLIST found = ScanLine(lpLine, uFlags);
+	if (lpURL == NULL)
+		return found.empty();
+	return (found.size() == 1) && (found[0].sURL == lpURL);
+}
+
+/**
+	
+*/
+static void TestPrefixes()
+{
+	CHECK(FindsURL(L"see http://example.com/page for more", 0, L"http://example.com/page"));
+	CHECK(FindsURL(L"HTTPS://Example.com/Path?a=1&b=2#top", 0, L"HTTPS://Example.com/Path?a=1&b=2#top"));
+	CHECK(FindsURL(L"www.example.com", 0, L"http://www.example.com"));
+	CHECK(FindsURL(L"WWW.example.com/index.html", 0, L"http://WWW.example.com/index.html"));
+	CHECK(FindsURL(L"write to mailto:joe@example.com", 0, L"mailto:joe@example.com"));
+	// Nothing after the prefix
+	CHECK(FindsURL(L"http:// www. mailto:", 0, NULL));
+	// Not a link
+	CHECK(FindsURL(L"ratio 3:4 at 10.30, see notes.txt", 0, NULL));
+	// Stops at letters that can't be in a link
+	CHECK(FindsURL(L"http://example.com/caf\x00e9", 0, L"http://example.com/caf"));
+	CHECK(FindsURL(L"http://example.com/a|b", 0, L"http://example.com/a"));
+	// Letters that are negative where WCHAR is signed (here), and the largest UTF-16 unit
+	std::wstring sLine = L"http://example.com/a";
+	sLine += (WCHAR)-40;
+	sLine += L"b www.example.org";
+	sLine += (WCHAR)0xFFFF;
+	FOUNDLIST found = ScanLine(sLine, URLScanner::SCAN_EMAILS | URLScanner::SCAN_DOMAINS);
+	CHECK_EQUAL(found.size(), (size_t)2);
+	if (found.size() == 2)
+	{
+		CHECK(found[0].sURL == L"http://example.com/a");
+		CHECK(found[1].sURL == L"http://www.example.org");
+	}
+}
+
+/**
+	
+*/
+static void TestTrimming()
+{
+	// Trailing punctuation
+	CHECK(FindsURL(L"http://example.com/page.", 0, L"http://example.com/page"));
+	CHECK(FindsURL(L"http://example.com/page?!", 0, L"http://example.com/page"));
+	CHECK(FindsURL(L"www.example.com,", 0, L"http://www.example.com"));
+	CHECK(FindsURL(L"mailto:joe@example.com;", 0, L"mailto:joe@example.com"));
+	CHECK(FindsURL(L"http://example.com/it's", 0, L"http://example.com/it's"));
+	CHECK(FindsURL(L"http://example.com/quoted'\"", 0, L"http://example.com/quoted"));
+
+	// Brackets and quotes around the link
+	CHECK(FindsURL(L"(http://example.com/a)", 0, L"http://example.com/a"));
+	CHECK(FindsURL(L"[https://example.org/b],", 0, L"https://example.org/b"));
+	CHECK(FindsURL(L"<www.example.com>", 0, L"http://www.example.com"));
+	CHECK(FindsURL(L"\"http://example.com/q\".", 0, L"http://example.com/q"));
+	// Brackets that are part of the link stay
+	CHECK(FindsURL(L"http://en.wikipedia.org/wiki/Link_(disambiguation)", 0, L"http://en.wikipedia.org/wiki/Link_(disambiguation)"));
+	CHECK(FindsURL(L"(http://en.wikipedia.org/wiki/Link_(disambiguation)).", 0, L"http://en.wikipedia.org/wiki/Link_(disambiguation)"));
+	CHECK(FindsURL(L"http://example.com/a[1]", 0, L"http://example.com/a[1]"));
+
+	// The link's location doesn't include what was trimmed
+	FOUNDLIST found = ScanLine(L"go (http://a.com).", 0);
+	CHECK_EQUAL(found.size(), (size_t)1);
+	if (found.size() == 1)
+	{
+		CHECK_EQUAL(found[0].rc.left, 4 * LETTER_WIDTH);
+		CHECK_EQUAL(found[0].rc.right, 16 * LETTER_WIDTH);
+		CHECK_EQUAL(found[0].rc.top, 0);
+		CHECK_EQUAL(found[0].rc.bottom, 20);
+	}
+}
+
+/**
+	
+*/
+static void TestFlags()
+{
+	const UINT uEmails = URLScanner::SCAN_EMAILS, uDomains = URLScanner::SCAN_DOMAINS;
+
+	// E-mail addresses only when asked for
+	CHECK(FindsURL(L"joe@example.com", 0, NULL));
+	CHECK(FindsURL(L"joe@example.com", uDomains, NULL));
+	CHECK(FindsURL(L"joe@example.com", uEmails, L"mailto:joe@example.com"));
+	CHECK(FindsURL(L"<joe.smith+news@mail.example.co.uk>.", uEmails, L"mailto:joe.smith+news@mail.example.co.uk"));
+	CHECK(FindsURL(L"joe@example.com/path", uEmails, L"mailto:joe@example.com"));
+	// Not addresses
+	CHECK(FindsURL(L"@example.com", uEmails, NULL));
+	CHECK(FindsURL(L"joe@localhost", uEmails, NULL));
+	CHECK(FindsURL(L"joe@example.c", uEmails, NULL));
+	CHECK(FindsURL(L"joe@10.0.0.1", uEmails, NULL));
+	CHECK(FindsURL(L"jo/e@example.com", uEmails, NULL));
+
+	// Domain names only when asked for
+	CHECK(FindsURL(L"example.com", 0, NULL));
+	CHECK(FindsURL(L"example.com", uEmails, NULL));
+	CHECK(FindsURL(L"example.com", uDomains, L"http://example.com"));
+	CHECK(FindsURL(L"(example.com/path?x=1).", uDomains, L"http://example.com/path?x=1"));
+	CHECK(FindsURL(L"example.com:8080", uDomains, L"http://example.com:8080"));
+	// Not domain names
+	CHECK(FindsURL(L"version 1.5", uDomains, NULL));
+	CHECK(FindsURL(L"e.g. this", uDomains, NULL));
+	CHECK(FindsURL(L"end. Next", uDomains, NULL));
+	CHECK(FindsURL(L"example..com", uDomains, NULL));
+	CHECK(FindsURL(L"example.com=1", uDomains, NULL));
+	// An address isn't a domain
+	CHECK(FindsURL(L"joe@example.com", uEmails | uDomains, L"mailto:joe@example.com"));
+	CHECK(FindsURL(L"joe@example.com", uDomains, NULL));
+
+	// Several links, in order, over several lines
+	TextArea text;
+	AddLine(text, L"mail joe@example.com or see www.example.com", 0);
+	AddLine(text, L"and example.org, http://example.net.", 1);
+	text.Finalize();
+	FOUNDLIST found = ScanAll(text, uEmails | uDomains);
+	CHECK_EQUAL(found.size(), (size_t)4);
+	if (found.size() == 4)
+	{
+		CHECK(found[0].sURL == L"mailto:joe@example.com");
+		CHECK_EQUAL(found[0].rc.left, 5 * LETTER_WIDTH);
+		CHECK(found[1].sURL == L"http://www.example.com");
+		CHECK(found[2].sURL == L"http://example.org");
+		CHECK_EQUAL(found[2].rc.top, 30);
+		CHECK(found[3].sURL == L"http://example.net");
+	}
+	CHECK_EQUAL(ScanAll(text, 0).size(), (size_t)2);
+}
+
+/**
+	
+*/
+static void TestVectorSearch()
+{
+	// Random text with few link letters, so the vector search goes over long stretches and finds them at
+	// every position in the vector
+	static const wchar_t* s_pParts[] = {L"http://", L"www.", L"mailto:", L"@", L".", L":", L"/", L"(", L")", L",", L"com", L"x"};
+	srand(7);
+	size_t nFound = 0;
+	for (int nIteration = 0; nIteration < 2000; nIteration++)
+	{
+		TextArea text;
+		int nLines = 1 + rand() % 4;
+		for (int nLine = 0; nLine < nLines; nLine++)
+		{
+			std::wstring sLine;
+			size_t nLen = rand() % 200;
+			while (sLine.size() < nLen)
+			{
+				int n = rand() % 100;
+				if (n < 8)
+					sLine += L' ';
+				else if (n < 20)
+					sLine += s_pParts[rand() % COUNTOF(s_pParts)];
+				else
+					sLine += (wchar_t)('a' + rand() % 26);
+			}
+			AddLine(text, sLine, nLine);
+		}
+		text.Finalize();
+
+		for (UINT uFlags = 0; uFlags <= (URLScanner::SCAN_EMAILS | URLScanner::SCAN_DOMAINS); uFlags++)
+		{
+			FOUNDLIST found = ScanAll(text, uFlags);
+			CHECK(ScanAll(text, uFlags | URLScanner::SCAN_SCALAR) == found);
+			nFound += found.size();
+		}
+	}
+	// Make sure there were links to find
+	CHECK(nFound > 1000);
+}
+
+/**
+	
+*/
+int main()
+{
+	TestPrefixes();
+	TestTrimming();
+	TestFlags();
+	TestVectorSearch();
+	return TestResult("URLScannerTest");
+}